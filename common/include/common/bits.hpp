@@ -0,0 +1,61 @@
+#ifndef RL_COMMON_BITS_HPP_
+#define RL_COMMON_BITS_HPP_
+
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace rl::common::bits
+{
+inline int ctz64(uint64_t x)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return static_cast<int>(idx);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+inline int popcount64(uint64_t x)
+{
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(x));
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+/// @brief number of 64 bit words holding n_bits bits
+constexpr int n_words(int n_bits)
+{
+    return (n_bits + 63) / 64;
+}
+
+inline void set_bit(uint64_t* words, int bit)
+{
+    words[bit >> 6] |= 1ULL << (bit & 63);
+}
+
+inline bool test_bit(const uint64_t* words, int bit)
+{
+    return (words[bit >> 6] >> (bit & 63)) & 1ULL;
+}
+
+/// @brief calls f(bit) for every set bit, lowest first
+template <typename F>
+inline void for_each_bit(const uint64_t* words, int n_words, F f)
+{
+    for (int w = 0; w < n_words; w++)
+    {
+        for (uint64_t b = words[w]; b; b &= b - 1)
+        {
+            f(w * 64 + ctz64(b));
+        }
+    }
+}
+} // namespace rl::common::bits
+
+#endif
@@ -1,32 +1,81 @@
 #ifndef RL_COMMON_CONCURRENT_MATCH_HPP_
 #define RL_COMMON_CONCURRENT_MATCH_HPP_
 
+#include <array>
+#include <functional>
 #include <memory>
 #include <tuple>
 #include <vector>
 #include "state.hpp"
 #include "concurrent_player.hpp"
+#include "opening_suite.hpp"
 
 
 namespace rl::common
 {
+using ConcurrentPlayerFactory = std::function<std::unique_ptr<IConcurrentPlayer>()>;
+
+struct ConcurrentMatchStats
+{
+    double games_per_second = 0.0;
+    // how long a game waited for each of its moves, the choose_actions call that chose it
+    double move_latency_p50_ms = 0.0;
+    double move_latency_p90_ms = 0.0;
+    double move_latency_p99_ms = 0.0;
+    long long n_moves = 0;
+};
+
 class ConcurrentMatch
 {
 private:
     std::unique_ptr<IState> initial_state_ptr_;
     std::vector<IConcurrentPlayer*> players_ptrs_{};
+    std::array<ConcurrentPlayerFactory, 2> players_factories_{};
 
     int n_sets_;
     int batch_size_;
+    int n_threads_{ 1 };
+    const OpeningSuite* opening_suite_{ nullptr };
+    int first_opening_{ 0 };
+    // the state each pair of sets starts from, built by play_sets
+    std::vector<std::unique_ptr<IState>> pairs_initial_states_{};
     float play_sets();
 
+    // what one shard of the sets adds up to
+    struct ShardResult
+    {
+        float player_1_total_rewards = 0.0f;
+        float ingame_p0_total_rewards = 0.0f;
+        int n_games_ended = 0;
+        std::vector<float> move_latencies_ms{};
+    };
+    void play_shard(IConcurrentPlayer* player_1_ptr, IConcurrentPlayer* player_2_ptr, const std::vector<int>& set_ids, int batch_size, ShardResult& result);
+
+    // player 1's reward in each set, by set index
+    std::vector<float> set_rewards_{};
+    ConcurrentMatchStats stats_{};
+
     float ingame_p0_total_rewards_ = 0.0f;
     int total_finished_games_ = 0;
     bool track_ingame_stats_ = true; // Toggle as needed
 public:
     ConcurrentMatch(const std::unique_ptr<IState>& initial_state_ptr, IConcurrentPlayer* player_1_ptr, IConcurrentPlayer* player_2_ptr, int n_sets, int batch_size);
+    /// @brief plays on n_threads workers, each with its own pair of players from the
+    ///     factories and its own share of the sets and of the batch_size games in flight.
+    ///     Players built on copies of one batching evaluator still share its batches
+    ConcurrentMatch(const std::unique_ptr<IState>& initial_state_ptr, ConcurrentPlayerFactory player_1_factory, ConcurrentPlayerFactory player_2_factory, int n_sets, int batch_size, int n_threads);
     float start();
     ~ConcurrentMatch();
+    /// @brief sets 2k and 2k + 1 start from opening (first_opening + k) % size instead of
+    ///     the initial state, so each opening is played from both sides. The suite must
+    ///     outlive the match; nullptr goes back to the initial state
+    /// @throws std::invalid_argument when the suite is empty or for another game
+    void set_opening_suite(const OpeningSuite* opening_suite, int first_opening = 0);
+    /// @brief player 1's reward in every set of the last start(), by set index. Sets
+    ///     2k and 2k + 1 start from the same state with the players swapped
+    const std::vector<float>& get_set_rewards() const;
+    /// @brief throughput and move latencies of the last start()
+    const ConcurrentMatchStats& get_stats() const;
 
     float get_ingame_p0_winrate() const {
         if (total_finished_games_ == 0) return 0.0f;
@@ -35,4 +84,4 @@ public:
 };
 } // namespace rl::common
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,46 @@
+#ifndef RL_COMMON_LARGE_PAGES_HPP_
+#define RL_COMMON_LARGE_PAGES_HPP_
+
+#include <cstddef>
+
+namespace rl::common
+{
+/// @brief Zeroed memory for a big table that is probed at random, such as a transposition
+///     table. On Linux it is mapped anonymously, aligned to 2 MB and advised MADV_HUGEPAGE,
+///     so the kernel can back it with transparent huge pages and a probe no longer misses
+///     the TLB as well as the cache. Anywhere else, or when the mapping fails, it is plain
+///     64-byte aligned heap memory.
+class LargePageBuffer
+{
+public:
+    static constexpr size_t HUGE_PAGE_BYTES = size_t{ 2 } << 20;
+
+    LargePageBuffer() = default;
+    /// @param use_huge_pages false to ask for ordinary pages, to measure what huge pages buy
+    /// @throws std::bad_alloc when no memory at all can be had
+    explicit LargePageBuffer(size_t bytes, bool use_huge_pages = true);
+    ~LargePageBuffer();
+    LargePageBuffer(LargePageBuffer&& other) noexcept;
+    LargePageBuffer& operator=(LargePageBuffer&& other) noexcept;
+    LargePageBuffer(const LargePageBuffer&) = delete;
+    LargePageBuffer& operator=(const LargePageBuffer&) = delete;
+
+    void* data() const;
+    size_t size() const;
+    /// @brief the kernel accepted the huge page advice. It still decides page by page
+    ///     whether a huge page is free to back the memory, see AnonHugePages in
+    ///     /proc/self/smaps
+    bool huge_pages() const;
+
+private:
+    void* data_{ nullptr };
+    size_t size_{ 0 };
+    // bytes actually mapped, 0 when data_ came from the heap
+    size_t mapped_bytes_{ 0 };
+    bool huge_pages_{ false };
+
+    void release();
+};
+} // namespace rl::common
+
+#endif
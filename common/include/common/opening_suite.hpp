@@ -0,0 +1,45 @@
+#ifndef RL_COMMON_OPENING_SUITE_HPP_
+#define RL_COMMON_OPENING_SUITE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "state.hpp"
+
+namespace rl::common
+{
+/// @brief Starting positions for matches, each stored as the actions that lead to it
+///     from the game's initial state, so a suite works for any IState.
+///
+///     The file is little endian: the magic "RLOS", a uint32 version, the game name as
+///     a uint32 length and its bytes, a uint32 opening count, then every opening as a
+///     uint16 ply count followed by that many uint16 actions.
+class OpeningSuite
+{
+public:
+    explicit OpeningSuite(std::string game_name);
+
+    /// @throws std::runtime_error when the file is missing, not a suite or truncated
+    static OpeningSuite load(const std::string& path);
+    void save(const std::string& path) const;
+
+    void add(const std::vector<int>& actions);
+    size_t size() const;
+    const std::string& game_name() const;
+    const std::vector<int>& actions(size_t opening) const;
+    /// @throws std::invalid_argument when the suite was made for another game than state's.
+    ///     Either name being empty means unknown and passes
+    void check_game(const IState& state) const;
+    /// @brief initial_state with the opening's actions applied
+    /// @throws std::runtime_error when an action is illegal or the opening ends the game,
+    ///     both signs the suite is for another game
+    std::unique_ptr<IState> play(const IState& initial_state, size_t opening) const;
+
+private:
+    std::string game_name_;
+    std::vector<std::vector<int>> openings_{};
+};
+} // namespace rl::common
+
+#endif
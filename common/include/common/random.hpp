@@ -16,7 +16,9 @@ inline std::mt19937 generate()
     return std::mt19937{ ss };
 }
 
-inline std::mt19937 mt{ generate() };
+// One engine per thread: searches run on worker threads now, and a shared
+// std::mt19937 is a data race. Each thread seeds its own on first use.
+inline thread_local std::mt19937 mt{ generate() };
 
 
 /// @brief Generate random int number [min,max)
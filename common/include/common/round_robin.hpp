@@ -3,11 +3,16 @@
 
 #include <memory>
 #include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <vector>
 #include <string>
 #include "state.hpp"
 #include "player.hpp"
 #include "observer.hpp"
+#include "opening_suite.hpp"
 
 namespace rl::common
 {
@@ -16,6 +21,9 @@ struct PlayerInfo
 {
     IPlayer* player_ptr;
     std::string player_name;
+    // builds an independent copy of the player, every worker thread plays with its own.
+    // Required when the tournament runs on more than one thread
+    std::function<std::unique_ptr<IPlayer>()> player_factory{};
 };
 
 struct MatchInfo
@@ -36,9 +44,19 @@ class RoundRobin
 {
 
 public:
-    RoundRobin(std::unique_ptr<IState> initial_state_ptr, const std::vector<PlayerInfo>& players_info, int n_sets, bool render);
+    /// @param n_threads worker threads the games are spread over. With more than one,
+    ///     every set is a task of its own played by copies from the player factories,
+    ///     games are not rendered whatever render says, the events are delivered from a
+    ///     single reporter thread, and matchinfo_changed_event carries a copy of the state
+    ///     that is only valid during the notification
+    RoundRobin(std::unique_ptr<IState> initial_state_ptr, const std::vector<PlayerInfo>& players_info, int n_sets, bool render, int n_threads = 1);
     ~RoundRobin();
     std::pair<std::vector<std::array<int, 3>>, std::vector<int>> start();
+    /// @brief every scheduled game becomes a pair from the next opening of the suite,
+    ///     one game with each player moving first, doubling the games played. The suite
+    ///     must outlive the tournament; nullptr goes back to the initial state
+    /// @throws std::invalid_argument when the suite is empty or for another game
+    void set_opening_suite(const OpeningSuite* opening_suite);
 
     // events
     Subject<MatchInfo> matchinfo_changed_event;
@@ -52,11 +70,43 @@ private:
 
     int n_sets_;
     bool render_;
+    int n_threads_;
+    const OpeningSuite* opening_suite_{ nullptr };
     std::vector<std::array<int, 3>> scores_;
     std::vector<std::vector<std::array<int, 3>>> scores_table_;
     std::vector<int> indices_;
 
-    void execute_match_(int first_player_index, int second_player_index);
+    // what the workers report, a state to show or, with no state, a finished match and
+    // the scores right after it
+    struct ReportEvent
+    {
+        std::unique_ptr<IState> state_ptr;
+        int player_1_index;
+        int player_2_index;
+        std::vector<std::array<int, 3>> scores;
+    };
+    // guards the scores while the workers play
+    std::mutex scores_mutex_{};
+    std::deque<ReportEvent> events_{};
+    std::mutex events_mutex_{};
+    std::condition_variable events_cv_{};
+    bool are_workers_done_{ false };
+
+    // a scheduled game, the players and the opening it starts from, -1 for the initial state
+    struct ScheduledMatch
+    {
+        int first_player_index;
+        int second_player_index;
+        int opening;
+    };
+    void execute_match_(int first_player_index, int second_player_index, int opening);
+    void execute_matches_parallel_(const std::vector<ScheduledMatch>& matches);
+    void play_set_(std::vector<std::unique_ptr<IPlayer>>& worker_players, int first_player_index, int second_player_index, int opening);
+    std::unique_ptr<IState> get_opening_state_(int opening) const;
+    void report_(ReportEvent event);
+    void run_reporter_();
+    void notify_scores_(const std::vector<std::array<int, 3>>& scores);
+    void render_scores_(const std::vector<std::array<int, 3>>& scores_to_render);
     void set_score_(int first_player_index, int second_player_index, const std::array<int, 3>& result);
     void get_rankings_out_(std::vector<int>& rankings_out);
     bool compare_predicate_(const std::tuple<int, int, int>& first, const std::tuple<int, int, int>& second) const;
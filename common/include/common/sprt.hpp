@@ -0,0 +1,59 @@
+#ifndef RL_COMMON_SPRT_HPP_
+#define RL_COMMON_SPRT_HPP_
+
+#include <array>
+#include <utility>
+
+namespace rl::common
+{
+enum class SprtStatus
+{
+    CONTINUE,
+    // the first player is no stronger than elo0
+    ACCEPT_H0,
+    // the first player is at least elo1 stronger
+    ACCEPT_H1
+};
+
+/// @brief Sequential probability ratio test on game pairs, the two games of a pair
+///     start from the same position with colors swapped. The pentanomial counts of
+///     the pair scores feed a generalized SPRT (normal approximation of the log
+///     likelihood ratio), which stops as soon as the games so far decide between
+///     elo0 and elo1 with error rates alpha and beta.
+class Sprt
+{
+public:
+    Sprt(double elo0, double elo1, double alpha, double beta);
+
+    /// @param pair_score what the first player scored over both games, a win counting
+    ///     1 and a draw 0.5, so one of 0, 0.5, 1, 1.5 or 2
+    void add_pair(double pair_score);
+    SprtStatus status() const;
+    double llr() const;
+    /// @brief the llr at or below which H0 is accepted
+    double lower_bound() const;
+    /// @brief the llr at or above which H1 is accepted
+    double upper_bound() const;
+    int n_pairs() const;
+    /// @brief the first player's mean score per game, 0.5 when no pair was played
+    double score() const;
+    /// @brief the elo difference the score amounts to, and its confidence interval from
+    ///     the pair variance; z = 1.96 is the 95% interval
+    double elo() const;
+    std::pair<double, double> elo_interval(double z = 1.96) const;
+    /// @brief pairs that scored 0, 0.5, 1, 1.5 and 2
+    const std::array<int, 5>& pentanomial() const;
+
+    static double elo_to_score(double elo);
+    static double score_to_elo(double score);
+
+private:
+    double elo0_;
+    double elo1_;
+    double lower_bound_;
+    double upper_bound_;
+    std::array<int, 5> pentanomial_{};
+};
+} // namespace rl::common
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef RL_COMMON_SPRT_MATCH_HPP_
+#define RL_COMMON_SPRT_MATCH_HPP_
+
+#include <array>
+#include <memory>
+#include <string>
+#include "concurrent_match.hpp"
+#include "opening_suite.hpp"
+#include "sprt.hpp"
+#include "state.hpp"
+
+namespace rl::common
+{
+struct SprtMatchConfig
+{
+    double elo0 = 0.0;
+    double elo1 = 10.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+    // the match stops undecided after this many game pairs
+    int max_pairs = 1000;
+    // game pairs a worker plays side by side before reporting them
+    int pairs_per_round = 8;
+    int n_threads = 1;
+};
+
+struct SprtMatchResult
+{
+    SprtStatus status = SprtStatus::CONTINUE;
+    int n_pairs = 0;
+    std::array<int, 5> pentanomial{};
+    double score = 0.5;
+    double elo = 0.0;
+    double elo_lower = 0.0;
+    double elo_upper = 0.0;
+    double llr = 0.0;
+    double lower_bound = 0.0;
+    double upper_bound = 0.0;
+    double games_per_second = 0.0;
+    SprtMatchConfig config{};
+
+    /// @brief a single line JSON object with every field above
+    std::string to_json() const;
+};
+
+/// @brief Plays player 1 against player 2 in game pairs, the two games of a pair start
+///     from the same state with colors swapped, until the SPRT accepts one of its
+///     hypotheses or max_pairs pairs were played. Every worker builds its own pair of
+///     players from the factories and keeps them, and their trees, for the whole match.
+class SprtMatch
+{
+public:
+    SprtMatch(const std::unique_ptr<IState>& initial_state_ptr, ConcurrentPlayerFactory player_1_factory, ConcurrentPlayerFactory player_2_factory, const SprtMatchConfig& config);
+    ~SprtMatch();
+    SprtMatchResult start();
+    /// @brief pair k starts from opening k % size, both games of the pair from the same
+    ///     opening. The suite must outlive the match
+    /// @throws std::invalid_argument when the suite is empty or for another game
+    void set_opening_suite(const OpeningSuite* opening_suite);
+
+private:
+    std::unique_ptr<IState> initial_state_ptr_;
+    ConcurrentPlayerFactory player_1_factory_;
+    ConcurrentPlayerFactory player_2_factory_;
+    SprtMatchConfig config_;
+    const OpeningSuite* opening_suite_{ nullptr };
+};
+} // namespace rl::common
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef RL_COMMON_STATE_HPP_
 #define RL_COMMON_STATE_HPP_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
@@ -14,6 +16,11 @@ public:
     /// @return a unique_ptr of the next state
     virtual std::unique_ptr<IState> step(int action) const = 0;
 
+    /// @brief in place counterpart of step, turns this state into the next state.
+    ///     Rollouts clone once and apply every ply instead of allocating a state per ply
+    /// @param action the action performed by the player to transition the state to the next state
+    virtual void apply(int action) = 0;
+
     /// @brief returns an initial state
     /// @return
     virtual std::unique_ptr<IState> reset() const = 0;
@@ -33,10 +40,34 @@ public:
     /// @return gets a copy of the observation for the state
     virtual std::vector<float> get_observation() const = 0;
 
+    /// @brief writes the observation into a caller buffer, so batches are assembled in place.
+    ///     The default copies get_observation()
+    /// @param out at least the product of get_observation_shape() floats, all of them are overwritten
+    virtual void write_observation(float* out) const;
+
     /// @brief short observation , used as a hashkey for maps
     /// @return a string
     virtual std::string to_short() const = 0;
 
+    /// @brief 64 bit key identifying the position, equal states have equal keys.
+    ///     The default hashes to_short()
+    /// @return
+    virtual uint64_t hash() const;
+
+    /// @brief true when other is the same position. Equal hashes can still be a collision,
+    ///     so whatever found a match by hash confirms it with this.
+    ///     The default compares hash() then to_short()
+    virtual bool equals(const IState& other) const;
+
+    /// @brief bytes one state takes, itself and whatever it owns. Search trees that keep
+    ///     a state per node count it against their memory budget.
+    ///     The default guesses a byte per observation cell and per action
+    virtual size_t memory_bytes() const;
+
+    /// @brief name the game goes by in files made for it, such as opening suites.
+    ///     The default is empty, a game nothing can be checked against
+    virtual std::string game_name() const;
+
     /// @brief
     /// @return
     virtual std::array<int, 3> get_observation_shape() const = 0;
@@ -47,6 +78,15 @@ public:
 
     virtual std::vector<bool> actions_mask() const = 0;
 
+    /// @brief writes the legal actions as a packed bitset, bit a % 64 of word a / 64 is set
+    ///     when action a is legal. The default packs actions_mask()
+    /// @param out_words at least rl::common::bits::n_words(get_n_actions()) words, all of them are overwritten
+    virtual void legal_actions_bitset(uint64_t* out_words) const;
+
+    /// @brief clears out_actions then fills it with the legal actions in increasing order.
+    ///     The default walks legal_actions_bitset() so games only need to override that one
+    virtual void legal_actions(std::vector<int>& out_actions) const;
+
     /// @brief should return a deep copy for the current state , modifying the copy should not change the original state
     /// @return
     virtual std::unique_ptr<IState> clone() const = 0;
@@ -59,6 +99,16 @@ public:
     /// @param out_actions_distribution gets cleared then all the symmetric distributions get added to this out parameter
     virtual void get_symmetrical_obs_and_actions(std::vector<float> const& obs, std::vector<float> const& actions_distribution, std::vector<std::vector<float>>& out_syms, std::vector<std::vector<float>>& out_actions_distribution) const = 0;
 
+    /// @brief number of symmetries get_symmetrical_obs_and_actions outputs, 0 when the game has none
+    virtual int n_symmetries() const;
+
+    /// @brief buffer counterpart of get_symmetrical_obs_and_actions for a single symmetry.
+    ///     The default goes through the vector version
+    /// @param symmetry from 0 to n_symmetries() - 1, in the order get_symmetrical_obs_and_actions outputs them
+    /// @param out_obs observation sized, overwritten
+    /// @param out_actions_distribution get_n_actions() sized, overwritten
+    virtual void write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const;
+
     virtual ~IState();
 };
 
@@ -0,0 +1,33 @@
+#ifndef RL_COMMON_ZOBRIST_HPP_
+#define RL_COMMON_ZOBRIST_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace rl::common::zobrist
+{
+constexpr uint64_t splitmix64(uint64_t& state)
+{
+    state += 0x9e3779b97f4a7c15ULL;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/// @brief N Zobrist keys generated at compile time, so there is no initialisation
+///     order to worry about. Each game uses its own seed.
+template <std::size_t N>
+constexpr std::array<uint64_t, N> make_keys(uint64_t seed)
+{
+    std::array<uint64_t, N> keys{};
+    for (std::size_t i = 0; i < N; i++)
+    {
+        keys[i] = splitmix64(seed);
+    }
+    return keys;
+}
+} // namespace rl::common::zobrist
+
+#endif
@@ -1,6 +1,12 @@
 #include <common/concurrent_match.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 namespace rl::common
 {
@@ -14,6 +20,23 @@ ConcurrentMatch::ConcurrentMatch(const std::unique_ptr<IState>& initial_state_pt
     players_ptrs_.push_back(player_2_ptr);
 }
 
+ConcurrentMatch::ConcurrentMatch(const std::unique_ptr<IState>& initial_state_ptr, ConcurrentPlayerFactory player_1_factory, ConcurrentPlayerFactory player_2_factory, int n_sets, int batch_size, int n_threads)
+    : initial_state_ptr_{ initial_state_ptr->clone() },
+    players_factories_{ std::move(player_1_factory), std::move(player_2_factory) },
+    n_sets_{ n_sets },
+    batch_size_{ batch_size },
+    n_threads_{ std::max(1, n_threads) }
+{
+    if (!players_factories_.at(0) || !players_factories_.at(1))
+    {
+        throw std::invalid_argument("a concurrent match needs a factory for both players");
+    }
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    // no threads to start in a browser build without pthreads
+    n_threads_ = 1;
+#endif
+}
+
 float common::ConcurrentMatch::start()
 {
     return play_sets();
@@ -21,32 +44,160 @@ float common::ConcurrentMatch::start()
 
 ConcurrentMatch::~ConcurrentMatch() = default;
 
+void ConcurrentMatch::set_opening_suite(const OpeningSuite* opening_suite, int first_opening)
+{
+    if (opening_suite != nullptr && opening_suite->size() == 0)
+    {
+        throw std::invalid_argument("an opening suite for a match cannot be empty");
+    }
+    if (opening_suite != nullptr)
+    {
+        opening_suite->check_game(*initial_state_ptr_);
+    }
+    opening_suite_ = opening_suite;
+    first_opening_ = first_opening;
+}
+
+const std::vector<float>& ConcurrentMatch::get_set_rewards() const
+{
+    return set_rewards_;
+}
+
+const ConcurrentMatchStats& ConcurrentMatch::get_stats() const
+{
+    return stats_;
+}
+
 float rl::common::ConcurrentMatch::play_sets()
 {
-    std::vector<bool> are_players_swapped{};
-    float player_1_total_rewards = 0;
-    are_players_swapped.reserve(n_sets_);
-    for (int i = 0;i < n_sets_; i++)
+    auto match_start = std::chrono::steady_clock::now();
+    set_rewards_.assign(n_sets_, 0.0f);
+    // built up front, the workers only clone them
+    pairs_initial_states_.clear();
+    for (int pair = 0; pair < (n_sets_ + 1) / 2; pair++)
     {
-        are_players_swapped.push_back(i % 2 == 0);
+        if (opening_suite_ == nullptr)
+        {
+            pairs_initial_states_.push_back(initial_state_ptr_->clone());
+        }
+        else
+        {
+            size_t opening = static_cast<size_t>(first_opening_ + pair) % opening_suite_->size();
+            pairs_initial_states_.push_back(opening_suite_->play(*initial_state_ptr_, opening));
+        }
+    }
+    const int n_workers = std::max(1, std::min(n_threads_, n_sets_));
+    // set i goes to worker i % n_workers, so both sets of a swapped pair run side by side
+    std::vector<std::vector<int>> shards(n_workers);
+    for (int set_id = 0; set_id < n_sets_; set_id++)
+    {
+        shards.at(set_id % n_workers).push_back(set_id);
+    }
+    std::vector<ShardResult> results(n_workers);
+    if (players_ptrs_.size() == 2)
+    {
+        play_shard(players_ptrs_.at(0), players_ptrs_.at(1), shards.at(0), batch_size_, results.at(0));
+    }
+    else
+    {
+        // an exception must not escape a std::thread, so the first one is carried
+        // back and rethrown here once every worker has stopped
+        std::exception_ptr error{ nullptr };
+        std::mutex error_mutex{};
+        const int shard_batch_size = std::max(1, batch_size_ / n_workers);
+        auto work = [&](int worker)
+            {
+                try
+                {
+                    std::unique_ptr<IConcurrentPlayer> player_1_ptr = players_factories_.at(0)();
+                    std::unique_ptr<IConcurrentPlayer> player_2_ptr = players_factories_.at(1)();
+                    play_shard(player_1_ptr.get(), player_2_ptr.get(), shards.at(worker), shard_batch_size, results.at(worker));
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+            };
+        if (n_workers == 1)
+        {
+            work(0);
+        }
+        else
+        {
+            std::vector<std::thread> threads{};
+            for (int worker = 0; worker < n_workers; worker++)
+            {
+                threads.emplace_back(work, worker);
+            }
+            for (auto& t : threads)
+            {
+                t.join();
+            }
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    float player_1_total_rewards = 0.0f;
+    int n_games_ended = 0;
+    std::vector<float> move_latencies_ms{};
+    for (ShardResult& result : results)
+    {
+        player_1_total_rewards += result.player_1_total_rewards;
+        n_games_ended += result.n_games_ended;
+        if (track_ingame_stats_)
+        {
+            ingame_p0_total_rewards_ += result.ingame_p0_total_rewards;
+            total_finished_games_ += result.n_games_ended;
+        }
+        move_latencies_ms.insert(move_latencies_ms.end(), result.move_latencies_ms.begin(), result.move_latencies_ms.end());
     }
 
+    std::chrono::duration<double> match_duration = std::chrono::steady_clock::now() - match_start;
+    stats_ = ConcurrentMatchStats{};
+    stats_.games_per_second = n_games_ended / std::max(match_duration.count(), 1e-9);
+    stats_.n_moves = static_cast<long long>(move_latencies_ms.size());
+    if (!move_latencies_ms.empty())
+    {
+        std::sort(move_latencies_ms.begin(), move_latencies_ms.end());
+        auto percentile = [&move_latencies_ms](double p)
+            { return static_cast<double>(move_latencies_ms.at(static_cast<size_t>(p * (move_latencies_ms.size() - 1)))); };
+        stats_.move_latency_p50_ms = percentile(0.5);
+        stats_.move_latency_p90_ms = percentile(0.9);
+        stats_.move_latency_p99_ms = percentile(0.99);
+    }
+    return player_1_total_rewards / static_cast<float>(n_games_ended);
+}
+
+void ConcurrentMatch::play_shard(IConcurrentPlayer* player_1_ptr, IConcurrentPlayer* player_2_ptr, const std::vector<int>& set_ids, int batch_size, ShardResult& result)
+{
+    const int n_shard_sets = static_cast<int>(set_ids.size());
+    float player_1_total_rewards = 0;
     int n_games_ended = 0;
+    int n_games_started = 0;
 
     std::vector<std::unique_ptr<rl::common::IState>> current_states{};
     std::vector<int> current_are_players_swapped{};
+    std::vector<int> current_set_ids{};
     std::vector<int> current_players{};
     std::vector<const IState*> player_1_states{};
     std::vector<const IState*> player_2_states{};
     std::vector<int> player_1_indices{};
     std::vector<int> player_2_indices{};
-    while (n_games_ended < n_sets_)
+    while (n_games_ended < n_shard_sets)
     {
-        while ((current_states.size() < batch_size_) && (current_states.size() + n_games_ended < n_sets_))
+        while ((current_states.size() < batch_size) && (current_states.size() + n_games_ended < n_shard_sets))
         {
-            int current_idx = n_games_ended + current_states.size();
-            current_states.push_back(initial_state_ptr_->clone());
-            current_are_players_swapped.push_back(are_players_swapped.at(current_idx));
+            int current_idx = set_ids.at(n_games_started++);
+            current_states.push_back(pairs_initial_states_.at(current_idx / 2)->clone());
+            current_are_players_swapped.push_back(current_idx % 2 == 0);
+            current_set_ids.push_back(current_idx);
 
         }
 
@@ -76,10 +227,20 @@ float rl::common::ConcurrentMatch::play_sets()
             }
         }
 
-        auto player_1_actions = players_ptrs_.at(0)->choose_actions(player_1_states);
+        // every game in a call waits for the whole call, that is its move's latency
+        auto record_latency = [&result](std::chrono::steady_clock::time_point call_start, size_t n_moves)
+            {
+                std::chrono::duration<float, std::milli> latency = std::chrono::steady_clock::now() - call_start;
+                result.move_latencies_ms.insert(result.move_latencies_ms.end(), n_moves, latency.count());
+            };
+        auto call_start = std::chrono::steady_clock::now();
+        auto player_1_actions = player_1_ptr->choose_actions(player_1_states);
+        record_latency(call_start, player_1_states.size());
         assert(player_1_actions.size() == player_1_indices.size());
         assert(player_1_actions.size() == player_1_states.size());
-        auto player_2_actions = players_ptrs_.at(1)->choose_actions(player_2_states);
+        call_start = std::chrono::steady_clock::now();
+        auto player_2_actions = player_2_ptr->choose_actions(player_2_states);
+        record_latency(call_start, player_2_states.size());
         assert(player_2_actions.size() == player_2_indices.size());
         assert(player_2_actions.size() == player_2_states.size());
         std::vector<int> current_actions(current_states.size(), -1);
@@ -133,16 +294,14 @@ float rl::common::ConcurrentMatch::play_sets()
                 // If it's P1's turn and they got 'reward', P0 got '-reward'
                 float p0_ingame_reward = (ingame_player == 0) ? raw_reward : -raw_reward;
 
-                if (track_ingame_stats_) {
-                    ingame_p0_total_rewards_ += p0_ingame_reward;
-                    total_finished_games_++;
-                }
+                result.ingame_p0_total_rewards += p0_ingame_reward;
 
                 // 2. Perspective of the "Outside" Player 1 (the first agent)
                 // If swapped, the agent's reward is the opposite of the in-game perspective
                 float agent_1_reward = is_swapped ? -p0_ingame_reward : p0_ingame_reward;
 
                 player_1_total_rewards += agent_1_reward;
+                set_rewards_.at(current_set_ids.at(i)) = agent_1_reward;
                 n_games_ended++;
             }
         }
@@ -167,6 +326,7 @@ float rl::common::ConcurrentMatch::play_sets()
 
         auto states_it = current_states.begin();
         auto is_swapped_it = current_are_players_swapped.begin();
+        auto set_id_it = current_set_ids.begin();
 
         while (states_it != current_states.end())
         {
@@ -175,17 +335,19 @@ float rl::common::ConcurrentMatch::play_sets()
                 // erase returns the iterator to the next element
                 states_it = current_states.erase(states_it);
                 is_swapped_it = current_are_players_swapped.erase(is_swapped_it);
+                set_id_it = current_set_ids.erase(set_id_it);
             }
             else
             {
                 ++states_it;
                 ++is_swapped_it;
+                ++set_id_it;
             }
         }
     }
 
-    return player_1_total_rewards / static_cast<float>(n_games_ended);
-
+    result.player_1_total_rewards = player_1_total_rewards;
+    result.n_games_ended = n_games_ended;
 }
 
 } // namespace rl::common
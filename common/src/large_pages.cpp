@@ -0,0 +1,122 @@
+#include <common/large_pages.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#include <sys/mman.h>
+#define RL_LARGE_PAGES_MMAP 1
+#endif
+
+namespace rl::common
+{
+namespace
+{
+constexpr size_t HEAP_ALIGNMENT = 64;
+
+size_t round_up(size_t bytes, size_t to)
+{
+    return (bytes + to - 1) / to * to;
+}
+} // namespace
+
+LargePageBuffer::LargePageBuffer(size_t bytes, bool use_huge_pages) : size_(bytes)
+{
+    if (bytes == 0)
+    {
+        return;
+    }
+#ifdef RL_LARGE_PAGES_MMAP
+    if (use_huge_pages)
+    {
+        // one huge page of slack, so the start can be moved up to a 2 MB boundary and
+        // the unused head and tail handed back
+        const size_t length = round_up(bytes, HUGE_PAGE_BYTES);
+        const size_t reserved = length + HUGE_PAGE_BYTES;
+        void* mapping = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping != MAP_FAILED)
+        {
+            const uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+            const uintptr_t aligned = round_up(start, HUGE_PAGE_BYTES);
+            const size_t head = aligned - start;
+            const size_t tail = reserved - head - length;
+            if (head > 0)
+            {
+                munmap(mapping, head);
+            }
+            if (tail > 0)
+            {
+                munmap(reinterpret_cast<void*>(aligned + length), tail);
+            }
+            data_ = reinterpret_cast<void*>(aligned);
+            mapped_bytes_ = length;
+            huge_pages_ = madvise(data_, length, MADV_HUGEPAGE) == 0;
+            return;
+        }
+    }
+#else
+    (void)use_huge_pages;
+#endif
+    data_ = ::operator new(bytes, std::align_val_t{ HEAP_ALIGNMENT });
+    std::memset(data_, 0, bytes);
+}
+
+LargePageBuffer::~LargePageBuffer()
+{
+    release();
+}
+
+LargePageBuffer::LargePageBuffer(LargePageBuffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+    mapped_bytes_(std::exchange(other.mapped_bytes_, 0)), huge_pages_(std::exchange(other.huge_pages_, false))
+{
+}
+
+LargePageBuffer& LargePageBuffer::operator=(LargePageBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        mapped_bytes_ = std::exchange(other.mapped_bytes_, 0);
+        huge_pages_ = std::exchange(other.huge_pages_, false);
+    }
+    return *this;
+}
+
+void* LargePageBuffer::data() const
+{
+    return data_;
+}
+
+size_t LargePageBuffer::size() const
+{
+    return size_;
+}
+
+bool LargePageBuffer::huge_pages() const
+{
+    return huge_pages_;
+}
+
+void LargePageBuffer::release()
+{
+    if (data_ == nullptr)
+    {
+        return;
+    }
+#ifdef RL_LARGE_PAGES_MMAP
+    if (mapped_bytes_ > 0)
+    {
+        munmap(data_, mapped_bytes_);
+        data_ = nullptr;
+        return;
+    }
+#endif
+    ::operator delete(data_, std::align_val_t{ HEAP_ALIGNMENT });
+    data_ = nullptr;
+}
+} // namespace rl::common
@@ -30,7 +30,8 @@ std::tuple<float, float> Match::start()
 std::tuple<float, float> Match::play_set(int starting_player)
 {
     std::array<float, 3> result{};
-    auto state_ptr = initial_state_ptr_->reset();
+    // a clone, not a reset, so a set can start from an opening
+    auto state_ptr = initial_state_ptr_->clone();
 
     state_changed_event.notify(state_ptr.get());
 
@@ -0,0 +1,191 @@
+#include <common/opening_suite.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace rl::common
+{
+namespace
+{
+constexpr char MAGIC[4] = { 'R', 'L', 'O', 'S' };
+constexpr uint32_t VERSION = 1;
+// game names are short, a longer length is a corrupt file rather than an allocation to attempt
+constexpr uint32_t MAX_GAME_NAME_BYTES = 256;
+// an opening takes at least its uint16 ply count
+constexpr uint64_t MIN_OPENING_BYTES = 2;
+
+void write_u16(std::ostream& out, uint16_t value)
+{
+    char bytes[2] = { static_cast<char>(value & 0xff), static_cast<char>(value >> 8) };
+    out.write(bytes, 2);
+}
+
+void write_u32(std::ostream& out, uint32_t value)
+{
+    char bytes[4];
+    for (int i = 0; i < 4; i++)
+    {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+    out.write(bytes, 4);
+}
+
+uint16_t read_u16(std::istream& in)
+{
+    unsigned char bytes[2]{};
+    in.read(reinterpret_cast<char*>(bytes), 2);
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+uint32_t read_u32(std::istream& in)
+{
+    unsigned char bytes[4]{};
+    in.read(reinterpret_cast<char*>(bytes), 4);
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+} // namespace
+
+OpeningSuite::OpeningSuite(std::string game_name)
+    : game_name_{ std::move(game_name) }
+{
+}
+
+OpeningSuite OpeningSuite::load(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("cannot open opening suite " + path);
+    }
+    char magic[4]{};
+    in.read(magic, 4);
+    if (!in || !std::equal(magic, magic + 4, MAGIC) || read_u32(in) != VERSION)
+    {
+        throw std::runtime_error(path + " is not an opening suite");
+    }
+    const uint32_t game_name_size = read_u32(in);
+    if (!in || game_name_size > MAX_GAME_NAME_BYTES)
+    {
+        throw std::runtime_error(path + " is not an opening suite");
+    }
+    std::string game_name(game_name_size, '\0');
+    in.read(game_name.data(), static_cast<std::streamsize>(game_name.size()));
+    const uint32_t n_openings = read_u32(in);
+    if (!in)
+    {
+        throw std::runtime_error(path + " is truncated");
+    }
+    // the count is checked against what is left of the file before anything is reserved for it
+    const std::streampos header_end = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::streamoff remaining = in.tellg() - header_end;
+    in.seekg(header_end);
+    if (!in || static_cast<uint64_t>(n_openings) * MIN_OPENING_BYTES > static_cast<uint64_t>(remaining))
+    {
+        throw std::runtime_error(path + " is truncated");
+    }
+    OpeningSuite suite(game_name);
+    suite.openings_.reserve(n_openings);
+    for (uint32_t i = 0; i < n_openings; i++)
+    {
+        std::vector<int> actions(read_u16(in));
+        for (int& action : actions)
+        {
+            action = read_u16(in);
+        }
+        if (!in)
+        {
+            throw std::runtime_error(path + " is truncated");
+        }
+        suite.openings_.push_back(std::move(actions));
+    }
+    return suite;
+}
+
+void OpeningSuite::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        throw std::runtime_error("cannot write opening suite " + path);
+    }
+    out.write(MAGIC, 4);
+    write_u32(out, VERSION);
+    write_u32(out, static_cast<uint32_t>(game_name_.size()));
+    out.write(game_name_.data(), static_cast<std::streamsize>(game_name_.size()));
+    write_u32(out, static_cast<uint32_t>(openings_.size()));
+    for (const std::vector<int>& actions : openings_)
+    {
+        write_u16(out, static_cast<uint16_t>(actions.size()));
+        for (int action : actions)
+        {
+            write_u16(out, static_cast<uint16_t>(action));
+        }
+    }
+}
+
+void OpeningSuite::add(const std::vector<int>& actions)
+{
+    if (actions.size() > std::numeric_limits<uint16_t>::max())
+    {
+        throw std::invalid_argument("an opening is longer than a suite can store");
+    }
+    for (int action : actions)
+    {
+        if (action < 0 || action > std::numeric_limits<uint16_t>::max())
+        {
+            throw std::invalid_argument("an opening action does not fit a suite");
+        }
+    }
+    openings_.push_back(actions);
+}
+
+size_t OpeningSuite::size() const
+{
+    return openings_.size();
+}
+
+const std::string& OpeningSuite::game_name() const
+{
+    return game_name_;
+}
+
+const std::vector<int>& OpeningSuite::actions(size_t opening) const
+{
+    return openings_.at(opening);
+}
+
+void OpeningSuite::check_game(const IState& state) const
+{
+    const std::string state_game_name = state.game_name();
+    if (!game_name_.empty() && !state_game_name.empty() && game_name_ != state_game_name)
+    {
+        throw std::invalid_argument("opening suite is for " + game_name_ + ", not " + state_game_name);
+    }
+}
+
+std::unique_ptr<IState> OpeningSuite::play(const IState& initial_state, size_t opening) const
+{
+    std::unique_ptr<IState> state_ptr = initial_state.clone();
+    for (int action : openings_.at(opening))
+    {
+        if (state_ptr->is_terminal() || action >= state_ptr->get_n_actions() || !state_ptr->actions_mask().at(action))
+        {
+            throw std::runtime_error("opening suite for " + game_name_ + " has an illegal action for this game");
+        }
+        state_ptr->apply(action);
+    }
+    if (state_ptr->is_terminal())
+    {
+        throw std::runtime_error("opening suite for " + game_name_ + " has an opening that ends the game");
+    }
+    return state_ptr;
+}
+} // namespace rl::common
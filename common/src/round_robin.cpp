@@ -1,7 +1,11 @@
 #include <common/round_robin.hpp>
 #include <algorithm>
+#include <atomic>
 #include <common/random.hpp>
 #include <common/match.hpp>
+#include <exception>
+#include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <functional>
 #include <sstream>
@@ -9,8 +13,9 @@
 namespace rl::common
 {
 
-RoundRobin::RoundRobin(std::unique_ptr<IState> initial_state_ptr, const std::vector<PlayerInfo>& players_info, int n_sets, bool render)
+RoundRobin::RoundRobin(std::unique_ptr<IState> initial_state_ptr, const std::vector<PlayerInfo>& players_info, int n_sets, bool render, int n_threads)
     : initial_state_ptr_{ std::move(initial_state_ptr) }, players_info_(players_info.begin(), players_info.end()), n_sets_{ n_sets }, render_{ render },
+    n_threads_{ std::max(1, n_threads) },
     scores_(players_info.size(), std::array<int, 3>({ 0, 0, 0 })),
     scores_table_(players_info.size(), std::vector<std::array<int, 3>>(players_info.size(), { 0, 0, 0 })),
     indices_()
@@ -21,6 +26,20 @@ RoundRobin::RoundRobin(std::unique_ptr<IState> initial_state_ptr, const std::vec
         indices_.emplace_back(i);
     }
     std::shuffle(indices_.begin(), indices_.end(), rl::common::mt);
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    // no threads to start in a browser build without pthreads
+    n_threads_ = 1;
+#endif
+    if (n_threads_ > 1)
+    {
+        for (const PlayerInfo& info : players_info_)
+        {
+            if (!info.player_factory)
+            {
+                throw std::invalid_argument("a round robin on several threads needs a player factory for " + info.player_name);
+            }
+        }
+    }
 }
 
 RoundRobin::~RoundRobin()
@@ -90,9 +109,31 @@ std::pair<std::vector<std::array<int, 3>>, std::vector<int>> RoundRobin::start()
         }
     }
 
+    std::vector<ScheduledMatch> scheduled_matches{};
+    int next_opening = 0;
     for (auto [first_player_id, second_player_id] : matches)
     {
-        execute_match_(first_player_id, second_player_id);
+        bool is_bye = players_info_.at(first_player_id).player_ptr == nullptr || players_info_.at(second_player_id).player_ptr == nullptr;
+        if (opening_suite_ == nullptr || is_bye)
+        {
+            scheduled_matches.push_back({ first_player_id, second_player_id, -1 });
+            continue;
+        }
+        int opening = static_cast<int>(next_opening++ % opening_suite_->size());
+        scheduled_matches.push_back({ first_player_id, second_player_id, opening });
+        scheduled_matches.push_back({ second_player_id, first_player_id, opening });
+    }
+
+    if (n_threads_ > 1)
+    {
+        execute_matches_parallel_(scheduled_matches);
+    }
+    else
+    {
+        for (const ScheduledMatch& match : scheduled_matches)
+        {
+            execute_match_(match.first_player_index, match.second_player_index, match.opening);
+        }
     }
 
     if (!is_even)
@@ -108,15 +149,42 @@ std::pair<std::vector<std::array<int, 3>>, std::vector<int>> RoundRobin::start()
     return std::make_pair(scores_, rankings);
 }
 
+void RoundRobin::set_opening_suite(const OpeningSuite* opening_suite)
+{
+    if (opening_suite != nullptr && opening_suite->size() == 0)
+    {
+        throw std::invalid_argument("an opening suite for a round robin cannot be empty");
+    }
+    if (opening_suite != nullptr)
+    {
+        opening_suite->check_game(*initial_state_ptr_);
+    }
+    opening_suite_ = opening_suite;
+}
+
+std::unique_ptr<IState> RoundRobin::get_opening_state_(int opening) const
+{
+    if (opening < 0)
+    {
+        return initial_state_ptr_->clone();
+    }
+    return opening_suite_->play(*initial_state_ptr_, static_cast<size_t>(opening));
+}
+
 void RoundRobin::render_scores()
+{
+    render_scores_(scores_);
+}
+
+void RoundRobin::render_scores_(const std::vector<std::array<int, 3>>& scores_to_render)
 {
     std::stringstream ss{};
     ss << "\n";
     ss << "****************\n";
     ss << "****************\n";
-    for (int i = 0;i < scores_.size();i++)
+    for (int i = 0;i < scores_to_render.size();i++)
     {
-        auto& scores = scores_.at(i);
+        auto& scores = scores_to_render.at(i);
         int wins = std::get<0>(scores);
         int draws = std::get<1>(scores);
         int losses = std::get<2>(scores);
@@ -131,7 +199,7 @@ void RoundRobin::render_scores()
     std::cout << ss.str() << std::endl;
 
 }
-void RoundRobin::execute_match_(int first_player_index, int second_player_index)
+void RoundRobin::execute_match_(int first_player_index, int second_player_index, int opening)
 {
     PlayerInfo p1info = players_info_.at(first_player_index);
     PlayerInfo p2info = players_info_.at(second_player_index);
@@ -139,7 +207,7 @@ void RoundRobin::execute_match_(int first_player_index, int second_player_index)
     {
         return;
     }
-    rl::common::Match m{ initial_state_ptr_->clone(), p1info.player_ptr, p2info.player_ptr, 1, render_ };
+    rl::common::Match m{ get_opening_state_(opening), p1info.player_ptr, p2info.player_ptr, 1, render_ };
     std::function<void(const IState*)> fn = std::bind(&RoundRobin::on_state_changed_, this, std::placeholders::_1, first_player_index, second_player_index);
     state_observer_ptr_ = m.state_changed_event.subscribe(fn);
     auto [p1, p2] = m.start();
@@ -160,6 +228,161 @@ void RoundRobin::execute_match_(int first_player_index, int second_player_index)
     render_scores();
 }
 
+void RoundRobin::execute_matches_parallel_(const std::vector<ScheduledMatch>& matches)
+{
+    {
+        std::lock_guard<std::mutex> lock(events_mutex_);
+        are_workers_done_ = false;
+    }
+    std::thread reporter(&RoundRobin::run_reporter_, this);
+
+    // every match is a single set, the workers take them in schedule order
+    std::atomic<size_t> next_match{ 0 };
+    std::atomic<bool> stop{ false };
+    // an exception must not escape a std::thread, so the first one is carried
+    // back and rethrown here once every worker has stopped
+    std::exception_ptr error{ nullptr };
+    std::mutex error_mutex{};
+    auto work = [&]()
+        {
+            try
+            {
+                // clones are built the first time the worker needs them
+                std::vector<std::unique_ptr<IPlayer>> worker_players(players_info_.size());
+                size_t match_index;
+                while (!stop.load(std::memory_order_relaxed) && (match_index = next_match.fetch_add(1, std::memory_order_relaxed)) < matches.size())
+                {
+                    const ScheduledMatch& match = matches.at(match_index);
+                    play_set_(worker_players, match.first_player_index, match.second_player_index, match.opening);
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                stop.store(true, std::memory_order_relaxed);
+            }
+        };
+    const int n_workers = static_cast<int>(std::min<size_t>(n_threads_, std::max<size_t>(1, matches.size())));
+    std::vector<std::thread> threads{};
+    for (int worker = 0; worker < n_workers; worker++)
+    {
+        threads.emplace_back(work);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(events_mutex_);
+        are_workers_done_ = true;
+    }
+    events_cv_.notify_all();
+    reporter.join();
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void RoundRobin::play_set_(std::vector<std::unique_ptr<IPlayer>>& worker_players, int first_player_index, int second_player_index, int opening)
+{
+    const PlayerInfo& p1info = players_info_.at(first_player_index);
+    const PlayerInfo& p2info = players_info_.at(second_player_index);
+    if (p1info.player_ptr == nullptr || p2info.player_ptr == nullptr)
+    {
+        return;
+    }
+    for (int index : { first_player_index, second_player_index })
+    {
+        if (worker_players.at(index) == nullptr)
+        {
+            worker_players.at(index) = players_info_.at(index).player_factory();
+        }
+    }
+    // workers never render, boards from several games would interleave on the console;
+    // the reporter thread prints the scores
+    rl::common::Match m{ get_opening_state_(opening), worker_players.at(first_player_index).get(), worker_players.at(second_player_index).get(), 1, false };
+    // the worker moves on at once, the reporter gets a copy of the state
+    std::function<void(const IState*)> fn = [this, first_player_index, second_player_index](const IState* state_ptr)
+        { report_(ReportEvent{ state_ptr->clone(), first_player_index, second_player_index, {} }); };
+    auto state_observer_ptr = m.state_changed_event.subscribe(fn);
+    auto [p1, p2] = m.start();
+    std::array<int, 3> p1_score{ 0, 0, 0 };
+    if (p1 > p2)
+    {
+        p1_score = { 1, 0, 0 };
+    }
+    else if (p2 > p1)
+    {
+        p1_score = { 0, 0, 1 };
+    }
+    else
+    {
+        p1_score = { 0, 1, 0 };
+    }
+    // the table as this result left it, so every finished match is reported once and
+    // with its own scores, whatever the other workers record in the meantime
+    std::vector<std::array<int, 3>> scores{};
+    {
+        std::lock_guard<std::mutex> lock(scores_mutex_);
+        set_score_(first_player_index, second_player_index, p1_score);
+        scores = scores_;
+    }
+    report_(ReportEvent{ nullptr, first_player_index, second_player_index, std::move(scores) });
+}
+
+void RoundRobin::report_(ReportEvent event)
+{
+    {
+        std::lock_guard<std::mutex> lock(events_mutex_);
+        events_.push_back(std::move(event));
+    }
+    events_cv_.notify_one();
+}
+
+void RoundRobin::run_reporter_()
+{
+    std::unique_lock<std::mutex> lock(events_mutex_);
+    while (true)
+    {
+        events_cv_.wait(lock, [this] { return !events_.empty() || are_workers_done_; });
+        if (events_.empty())
+        {
+            return;
+        }
+        ReportEvent event = std::move(events_.front());
+        events_.pop_front();
+        // subscribers run without the lock, so the workers never wait on them
+        lock.unlock();
+        if (event.state_ptr != nullptr)
+        {
+            on_state_changed_(event.state_ptr.get(), event.player_1_index, event.player_2_index);
+        }
+        else
+        {
+            notify_scores_(event.scores);
+        }
+        lock.lock();
+    }
+}
+
+void RoundRobin::notify_scores_(const std::vector<std::array<int, 3>>& scores)
+{
+    std::vector<PlayerScore> players_scores{};
+    for (int i = 0; i < static_cast<int>(scores.size()); i++)
+    {
+        const auto& score = scores.at(i);
+        players_scores.push_back(PlayerScore{ i, score.at(0), score.at(1), score.at(2) });
+    }
+    render_scores_(scores);
+    players_scores_changed_event.notify(players_scores);
+}
+
 void RoundRobin::set_score_(int first_player_index, int second_player_index, const std::array<int, 3>& result)
 {
     std::array<int, 3>& first_player_score_ref = scores_.at(first_player_index);
@@ -0,0 +1,159 @@
+#include <common/sprt.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace rl::common
+{
+// added to every pentanomial count, a quarter pair per bin has mean 0.5 and the
+// variance of two decisive games between equals, so a few identical pairs cannot
+// stop the test on a variance of zero
+constexpr double PRIOR_COUNT = 0.25;
+
+Sprt::Sprt(double elo0, double elo1, double alpha, double beta)
+    : elo0_{ elo0 },
+    elo1_{ elo1 },
+    lower_bound_{ std::log(beta / (1.0 - alpha)) },
+    upper_bound_{ std::log((1.0 - beta) / alpha) }
+{
+    if (!(elo0 < elo1))
+    {
+        throw std::invalid_argument("sprt needs elo0 < elo1");
+    }
+    if (alpha <= 0.0 || alpha >= 1.0 || beta <= 0.0 || beta >= 1.0)
+    {
+        throw std::invalid_argument("sprt error rates must be in (0, 1)");
+    }
+}
+
+void Sprt::add_pair(double pair_score)
+{
+    int bin = static_cast<int>(std::lround(pair_score * 2.0));
+    if (bin < 0 || bin > 4)
+    {
+        throw std::invalid_argument("a pair score must be in [0, 2]");
+    }
+    pentanomial_.at(bin)++;
+}
+
+SprtStatus Sprt::status() const
+{
+    double current_llr = llr();
+    if (current_llr >= upper_bound_)
+    {
+        return SprtStatus::ACCEPT_H1;
+    }
+    if (current_llr <= lower_bound_)
+    {
+        return SprtStatus::ACCEPT_H0;
+    }
+    return SprtStatus::CONTINUE;
+}
+
+double Sprt::llr() const
+{
+    int n = n_pairs();
+    if (n == 0)
+    {
+        return 0.0;
+    }
+    // per pair score scaled to [0, 1], its mean and variance over the regularized counts
+    double total = 0.0;
+    double mean = 0.0;
+    for (int bin = 0; bin < 5; bin++)
+    {
+        double count = pentanomial_.at(bin) + PRIOR_COUNT;
+        total += count;
+        mean += count * bin / 4.0;
+    }
+    mean /= total;
+    double variance = 0.0;
+    for (int bin = 0; bin < 5; bin++)
+    {
+        double count = pentanomial_.at(bin) + PRIOR_COUNT;
+        double deviation = bin / 4.0 - mean;
+        variance += count * deviation * deviation;
+    }
+    variance /= total;
+    double score0 = elo_to_score(elo0_);
+    double score1 = elo_to_score(elo1_);
+    return n * (score1 - score0) * (2.0 * mean - score0 - score1) / (2.0 * variance);
+}
+
+double Sprt::lower_bound() const
+{
+    return lower_bound_;
+}
+
+double Sprt::upper_bound() const
+{
+    return upper_bound_;
+}
+
+int Sprt::n_pairs() const
+{
+    int n = 0;
+    for (int count : pentanomial_)
+    {
+        n += count;
+    }
+    return n;
+}
+
+double Sprt::score() const
+{
+    int n = n_pairs();
+    if (n == 0)
+    {
+        return 0.5;
+    }
+    double points = 0.0;
+    for (int bin = 0; bin < 5; bin++)
+    {
+        points += pentanomial_.at(bin) * bin / 4.0;
+    }
+    return points / n;
+}
+
+double Sprt::elo() const
+{
+    return score_to_elo(score());
+}
+
+std::pair<double, double> Sprt::elo_interval(double z) const
+{
+    int n = n_pairs();
+    if (n == 0)
+    {
+        return { score_to_elo(0.0), score_to_elo(1.0) };
+    }
+    // the per game score is the mean of the pairs', each scaled to [0, 1]
+    double mean = score();
+    double variance = 0.0;
+    for (int bin = 0; bin < 5; bin++)
+    {
+        double deviation = bin / 4.0 - mean;
+        variance += pentanomial_.at(bin) * deviation * deviation;
+    }
+    variance /= n;
+    double margin = z * std::sqrt(variance / n);
+    return { score_to_elo(mean - margin), score_to_elo(mean + margin) };
+}
+
+const std::array<int, 5>& Sprt::pentanomial() const
+{
+    return pentanomial_;
+}
+
+double Sprt::elo_to_score(double elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double Sprt::score_to_elo(double score)
+{
+    score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+} // namespace rl::common
@@ -0,0 +1,168 @@
+#include <common/sprt_match.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace rl::common
+{
+std::string SprtMatchResult::to_json() const
+{
+    const char* status_name = status == SprtStatus::ACCEPT_H1 ? "H1" : status == SprtStatus::ACCEPT_H0 ? "H0" : "inconclusive";
+    std::ostringstream ss{};
+    ss << "{\"status\":\"" << status_name << "\""
+        << ",\"pairs\":" << n_pairs
+        << ",\"games\":" << 2 * n_pairs
+        << ",\"pentanomial\":[" << pentanomial.at(0) << "," << pentanomial.at(1) << "," << pentanomial.at(2) << "," << pentanomial.at(3) << "," << pentanomial.at(4) << "]"
+        << ",\"score\":" << score
+        << ",\"elo\":" << elo
+        << ",\"elo_95\":[" << elo_lower << "," << elo_upper << "]"
+        << ",\"llr\":" << llr
+        << ",\"llr_bounds\":[" << lower_bound << "," << upper_bound << "]"
+        << ",\"games_per_second\":" << games_per_second
+        << ",\"elo0\":" << config.elo0
+        << ",\"elo1\":" << config.elo1
+        << ",\"alpha\":" << config.alpha
+        << ",\"beta\":" << config.beta
+        << ",\"max_pairs\":" << config.max_pairs
+        << ",\"threads\":" << config.n_threads
+        << "}";
+    return ss.str();
+}
+
+SprtMatch::SprtMatch(const std::unique_ptr<IState>& initial_state_ptr, ConcurrentPlayerFactory player_1_factory, ConcurrentPlayerFactory player_2_factory, const SprtMatchConfig& config)
+    : initial_state_ptr_{ initial_state_ptr->clone() },
+    player_1_factory_{ std::move(player_1_factory) },
+    player_2_factory_{ std::move(player_2_factory) },
+    config_{ config }
+{
+    if (!player_1_factory_ || !player_2_factory_)
+    {
+        throw std::invalid_argument("an sprt match needs a factory for both players");
+    }
+    config_.max_pairs = std::max(1, config_.max_pairs);
+    config_.pairs_per_round = std::max(1, config_.pairs_per_round);
+    config_.n_threads = std::max(1, config_.n_threads);
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    // no threads to start in a browser build without pthreads
+    config_.n_threads = 1;
+#endif
+}
+
+SprtMatch::~SprtMatch() = default;
+
+void SprtMatch::set_opening_suite(const OpeningSuite* opening_suite)
+{
+    if (opening_suite != nullptr && opening_suite->size() == 0)
+    {
+        throw std::invalid_argument("an opening suite for a match cannot be empty");
+    }
+    if (opening_suite != nullptr)
+    {
+        opening_suite->check_game(*initial_state_ptr_);
+    }
+    opening_suite_ = opening_suite;
+}
+
+SprtMatchResult SprtMatch::start()
+{
+    auto match_start = std::chrono::steady_clock::now();
+    Sprt sprt(config_.elo0, config_.elo1, config_.alpha, config_.beta);
+    std::mutex sprt_mutex{};
+    std::atomic<int> next_pair{ 0 };
+    std::atomic<bool> stop{ false };
+    // an exception must not escape a std::thread, so the first one is carried
+    // back and rethrown here once every worker has stopped
+    std::exception_ptr error{ nullptr };
+    std::mutex error_mutex{};
+    auto work = [&]()
+        {
+            try
+            {
+                std::unique_ptr<IConcurrentPlayer> player_1_ptr = player_1_factory_();
+                std::unique_ptr<IConcurrentPlayer> player_2_ptr = player_2_factory_();
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    int first_pair = next_pair.fetch_add(config_.pairs_per_round, std::memory_order_relaxed);
+                    if (first_pair >= config_.max_pairs)
+                    {
+                        break;
+                    }
+                    int round_pairs = std::min(config_.pairs_per_round, config_.max_pairs - first_pair);
+                    ConcurrentMatch m(initial_state_ptr_, player_1_ptr.get(), player_2_ptr.get(), 2 * round_pairs, 2 * round_pairs);
+                    m.set_opening_suite(opening_suite_, first_pair);
+                    m.start();
+                    const std::vector<float>& rewards = m.get_set_rewards();
+                    std::lock_guard<std::mutex> lock(sprt_mutex);
+                    // rounds that finish after the decision would only move the llr back inside its bounds
+                    if (stop.load(std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                    for (int pair = 0; pair < round_pairs; pair++)
+                    {
+                        // rewards are in [-1, 1] per game, a pair scores 0 to 2
+                        sprt.add_pair((rewards.at(2 * pair) + rewards.at(2 * pair + 1) + 2.0f) / 2.0f);
+                    }
+                    if (sprt.status() != SprtStatus::CONTINUE)
+                    {
+                        stop.store(true, std::memory_order_relaxed);
+                    }
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                stop.store(true, std::memory_order_relaxed);
+            }
+        };
+    const int n_rounds = (config_.max_pairs + config_.pairs_per_round - 1) / config_.pairs_per_round;
+    const int n_workers = std::min(config_.n_threads, n_rounds);
+    if (n_workers == 1)
+    {
+        work();
+    }
+    else
+    {
+        std::vector<std::thread> threads{};
+        for (int worker = 0; worker < n_workers; worker++)
+        {
+            threads.emplace_back(work);
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - match_start;
+    SprtMatchResult result{};
+    result.status = sprt.status();
+    result.n_pairs = sprt.n_pairs();
+    result.pentanomial = sprt.pentanomial();
+    result.score = sprt.score();
+    result.elo = sprt.elo();
+    std::tie(result.elo_lower, result.elo_upper) = sprt.elo_interval();
+    result.llr = sprt.llr();
+    result.lower_bound = sprt.lower_bound();
+    result.upper_bound = sprt.upper_bound();
+    result.games_per_second = 2 * result.n_pairs / std::max(duration.count(), 1e-9);
+    result.config = config_;
+    return result;
+}
+} // namespace rl::common
@@ -1,6 +1,94 @@
 #include <common/state.hpp>
+#include <common/bits.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
 
 namespace rl::common
 {
 rl::common::IState::~IState() = default;
+
+uint64_t IState::hash() const
+{
+    return static_cast<uint64_t>(std::hash<std::string>{}(to_short()));
+}
+
+bool IState::equals(const IState& other) const
+{
+    return hash() == other.hash() && to_short() == other.to_short();
+}
+
+void IState::legal_actions_bitset(uint64_t* out_words) const
+{
+    std::vector<bool> mask = actions_mask();
+    int n_words = bits::n_words(static_cast<int>(mask.size()));
+    std::fill(out_words, out_words + n_words, 0ULL);
+    for (int action = 0; action < static_cast<int>(mask.size()); action++)
+    {
+        if (mask[action])
+        {
+            bits::set_bit(out_words, action);
+        }
+    }
+}
+
+void IState::legal_actions(std::vector<int>& out_actions) const
+{
+    // enough for every game in games/ without touching the heap
+    constexpr int MAX_STACK_WORDS = 16;
+    int n_words = bits::n_words(get_n_actions());
+    std::array<uint64_t, MAX_STACK_WORDS> stack_words{};
+    std::vector<uint64_t> heap_words{};
+    uint64_t* words = stack_words.data();
+    if (n_words > MAX_STACK_WORDS)
+    {
+        heap_words.resize(n_words);
+        words = heap_words.data();
+    }
+    legal_actions_bitset(words);
+    out_actions.clear();
+    bits::for_each_bit(words, n_words, [&out_actions](int action) { out_actions.push_back(action); });
+}
+
+void IState::write_observation(float* out) const
+{
+    std::vector<float> observation = get_observation();
+    std::copy(observation.begin(), observation.end(), out);
+}
+
+static int observation_size(const IState& state)
+{
+    auto shape = state.get_observation_shape();
+    return shape[0] * shape[1] * shape[2];
+}
+
+size_t IState::memory_bytes() const
+{
+    return sizeof(IState) + static_cast<size_t>(observation_size(*this) + get_n_actions());
+}
+
+std::string IState::game_name() const
+{
+    return "";
+}
+
+int IState::n_symmetries() const
+{
+    std::vector<std::vector<float>> syms{};
+    std::vector<std::vector<float>> actions_distributions{};
+    get_symmetrical_obs_and_actions(std::vector<float>(observation_size(*this)), std::vector<float>(get_n_actions()), syms, actions_distributions);
+    return static_cast<int>(syms.size());
+}
+
+void IState::write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const
+{
+    std::vector<float> obs_vec(obs, obs + observation_size(*this));
+    std::vector<float> actions_distribution_vec(actions_distribution, actions_distribution + get_n_actions());
+    std::vector<std::vector<float>> syms{};
+    std::vector<std::vector<float>> actions_distributions{};
+    get_symmetrical_obs_and_actions(obs_vec, actions_distribution_vec, syms, actions_distributions);
+    std::copy(syms.at(symmetry).begin(), syms.at(symmetry).end(), out_obs);
+    std::copy(actions_distributions.at(symmetry).begin(), actions_distributions.at(symmetry).end(), out_actions_distribution);
+}
 } // namespace rl::common
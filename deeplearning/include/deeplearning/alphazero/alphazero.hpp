@@ -1,7 +1,10 @@
 #ifndef RL_DEEPLEARNING_ALPHAZERO_HPP_
 #define RL_DEEPLEARNING_ALPHAZERO_HPP_
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <torch/torch.h>
 #include <functional>
 #include "networks/az.hpp"
@@ -9,6 +12,7 @@
 #include <players/bandits/amcts2/amcts2.hpp>
 #include <players/bandits/amcts2/concurrent_amcts.hpp>
 #include "alphazero_config.hpp"
+#include "replay_buffer.hpp"
 namespace rl::deeplearning::alphazero
 {
 
@@ -34,6 +38,26 @@ private:
     const int MINIMUM_STEPS = 30;
     // MCTS CPUCT
     const float CPUCT = 2.5f;
+    // Worker threads for data collection, each owns every N_COLLECTION_THREADS-th subtree
+    const int N_COLLECTION_THREADS = 1;
+    // How long the shared evaluator holds a batch open for the other workers' leaves
+    const std::chrono::microseconds COLLECTION_BATCH_DELAY{ 2000 };
+    // Training samples the replay buffer holds, allocated up front
+    const int64_t REPLAY_CAPACITY = 1 << 18;
+    // Iterations of samples the network trains on, the latest one included
+    const int REPLAY_WINDOW = 1;
+    // Store replayed observations as float16
+    const bool REPLAY_HALF_OBSERVATIONS = false;
+    // Iterations between two gating matches, the last iteration always gates
+    const int GATING_INTERVAL = 1;
+    // The gate stops once the SPRT tells a candidate no stronger than GATING_ELO0 from one
+    // GATING_ELO1 stronger, or after n_testing_episodes games
+    const double GATING_ELO0 = 0.0;
+    const double GATING_ELO1 = 30.0;
+    const double GATING_ALPHA = 0.05;
+    const double GATING_BETA = 0.05;
+    // Game pairs a gating worker plays side by side before reporting them to the SPRT
+    const int GATING_PAIRS_PER_ROUND = 8;
 
     std::unique_ptr<rl::common::IState> initial_state_ptr_;
     std::unique_ptr<rl::common::IState> test_state_ptr_;
@@ -51,9 +75,9 @@ private:
     torch::DeviceType dev_;
     std::string load_path_;
     std::string save_name_;
-    std::vector<float> all_observations_{};
-    std::vector<float> all_probabilities_{};
-    std::vector<float> all_wdls_{};
+    std::unique_ptr<ReplayBuffer> replay_buffer_;
+    // collection workers finish episodes into the replay buffer one at a time
+    std::mutex replay_mutex_{};
     std::vector<std::unique_ptr<rl::common::IState>> states_ptrs_{};
     std::vector<std::vector<float>> episode_obsevations_{};
     std::vector<std::vector<float>> episode_probs_{};
@@ -62,11 +86,16 @@ private:
     std::vector<float> episode_steps_{};
 
     int choose_action(std::vector<float>& probs);
-    void train_network(std::unique_ptr<IAlphazeroNetwork>& network, torch::optim::Optimizer& optimizer_ref, std::vector<float>& observations, std::vector<float>& probabilities, std::vector<float>& wdls);
-    static torch::Tensor cross_entropy_loss_(torch::Tensor& target, torch::Tensor& prediction);
+    void train_network(std::unique_ptr<IAlphazeroNetwork>& network, torch::optim::Optimizer& optimizer_ref, const ReplayBuffer& replay_buffer);
+    /// @brief mean over the valid_rows only
+    static torch::Tensor cross_entropy_loss_(torch::Tensor& target, torch::Tensor& prediction, torch::Tensor& valid_rows);
     void collect_data();
+    void collect_shard(const std::vector<int>& tree_ids, std::unique_ptr<players::IEvaluator> ev_ptr, std::atomic<int>& completed_episodes, std::atomic<bool>& stop);
     void end_subtree(int subtree_id, int last_player, float result);
-    std::unique_ptr<players::ConcurrentAmcts> get_new_concurrent_tree_ptr();
+    /// @brief plays candidate against strongest in game pairs on N_COLLECTION_THREADS workers
+    /// @return true when candidate should replace strongest
+    bool gate(IAlphazeroNetwork& candidate, IAlphazeroNetwork& strongest);
+    std::unique_ptr<players::ConcurrentAmcts> get_new_concurrent_tree_ptr(std::unique_ptr<players::IEvaluator> ev_ptr);
     void initialize_subtrees();
 
 
@@ -0,0 +1,76 @@
+#ifndef RL_DEEPLEARNING_ALPHAZERO_MINIBATCH_LOADER_HPP_
+#define RL_DEEPLEARNING_ALPHAZERO_MINIBATCH_LOADER_HPP_
+
+#include <array>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <torch/torch.h>
+#include "replay_buffer.hpp"
+
+namespace rl::deeplearning::alphazero
+{
+/// @brief Gathers the minibatches of a training run on a background thread, so the
+///     next one is shuffled, gathered and smoothed while the current step runs. Each
+///     epoch is a new shuffle of the replay buffer, cut into n_batches batches of
+///     batch_size samples.
+///
+///     Batches are written into N_SLOTS buffers allocated once. A batch next()
+///     returns stays valid until the following call to next(), which hands its
+///     buffer back to the loader.
+class MinibatchLoader
+{
+public:
+    struct Batch
+    {
+        // float32 [batch_size, channels, rows, cols]
+        torch::Tensor observations;
+        // [batch_size, n_actions], smoothed by eps and renormalized
+        torch::Tensor probabilities;
+        // [batch_size, 3], smoothed by eps and renormalized
+        torch::Tensor wdls;
+    };
+
+    /// @param eps added to every target before renormalizing, so no target is exactly 0 or 1
+    MinibatchLoader(const ReplayBuffer& replay_buffer, int batch_size, int n_batches, int n_epochs, float eps);
+    ~MinibatchLoader();
+    MinibatchLoader(const MinibatchLoader&) = delete;
+    MinibatchLoader& operator=(const MinibatchLoader&) = delete;
+
+    /// @brief waits for the next batch; rethrows whatever stopped the loader.
+    ///     Throws std::out_of_range past the last of the n_steps() batches
+    const Batch& next();
+    /// @brief n_batches * n_epochs
+    int n_steps() const;
+
+private:
+    static constexpr int N_SLOTS = 2;
+
+    const ReplayBuffer& replay_buffer_;
+    int batch_size_;
+    int n_batches_;
+    int n_epochs_;
+    float eps_;
+    // views of the replay buffer, read by the loader thread only
+    torch::Tensor observations_;
+    torch::Tensor probabilities_;
+    torch::Tensor wdls_;
+    std::array<Batch, N_SLOTS> slots_{};
+    std::array<bool, N_SLOTS> is_filled_{};
+    // the slot next() hands out next, and the one the caller still holds
+    int next_slot_{ 0 };
+    int held_slot_{ -1 };
+    int n_taken_{ 0 };
+    bool stop_{ false };
+    std::exception_ptr error_{ nullptr };
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+    std::thread worker_{};
+
+    void run();
+    void fill(Batch& batch, const torch::Tensor& sample_ids);
+};
+} // namespace rl::deeplearning::alphazero
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef RL_DEEPLEARNING_ALPHAZERO_REPLAY_BUFFER_HPP_
+#define RL_DEEPLEARNING_ALPHAZERO_REPLAY_BUFFER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <torch/torch.h>
+
+namespace rl::deeplearning::alphazero
+{
+/// @brief Training samples of the last few iterations in fixed size slabs allocated
+///     once, so the memory training takes is known up front instead of growing with
+///     every iteration. Once full, a new sample overwrites the oldest one.
+///
+///     The slabs are exposed as tensors over the buffer's own memory, without a copy.
+///     Their first dimension is the capacity, not the size: rows are ring slots, and
+///     the ones that hold a sample come from shuffled_slots(). The views are only
+///     valid while the buffer lives and must not be written through.
+///
+///     Not thread safe, samples are added from one thread.
+class ReplayBuffer
+{
+public:
+    /// @param capacity samples the buffer can hold
+    /// @param window_iterations how many iterations of samples are kept, the current one
+    ///     included
+    /// @param half_observations store observations as float16, halving the largest slab
+    ReplayBuffer(const std::array<int, 3>& observation_shape, int n_actions, int64_t capacity, int window_iterations, bool half_observations);
+
+    /// @brief starts a new iteration, dropping the samples of the one that falls out
+    ///     of the window
+    void begin_iteration();
+    /// @brief appends n samples, n observations, n * n_actions probabilities and
+    ///     n * 3 win draw loss targets, back to back. A sample with a NaN or infinite
+    ///     value anywhere is dropped and counted in n_rejected()
+    void add(const float* observations, const float* probabilities, const float* wdls, int64_t n);
+
+    int64_t size() const;
+    /// @brief samples add() dropped since the buffer was built
+    int64_t n_rejected() const;
+    int64_t capacity() const;
+    /// @brief what the slabs take, allocated in the constructor
+    size_t bytes() const;
+
+    /// @brief [capacity, channels, rows, cols], float16 if half_observations
+    torch::Tensor observations() const;
+    /// @brief [capacity, n_actions]
+    torch::Tensor probabilities() const;
+    /// @brief [capacity, 3]
+    torch::Tensor wdls() const;
+    /// @brief the slots of every held sample in random order, int64
+    torch::Tensor shuffled_slots() const;
+
+private:
+    std::array<int, 3> observation_shape_;
+    int64_t observation_size_;
+    int n_actions_;
+    int64_t capacity_;
+    int window_iterations_;
+    bool half_observations_;
+    std::vector<float> observations_{};
+    std::vector<c10::Half> half_observations_slab_{};
+    std::vector<float> probabilities_{};
+    std::vector<float> wdls_{};
+    // the slot the next sample goes to
+    int64_t head_{ 0 };
+    int64_t size_{ 0 };
+    int64_t n_rejected_{ 0 };
+    // samples added in each iteration of the window, oldest first
+    std::deque<int64_t> iteration_sizes_{};
+};
+} // namespace rl::deeplearning::alphazero
+
+#endif
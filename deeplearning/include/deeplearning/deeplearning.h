@@ -47,6 +47,16 @@ struct AzTrainParameters
     float no_resign_threshold = -0.8f;
     // Players are not allowed to resign if the number of steps is below this number
     int no_resign_steps = 30;
+    // Worker threads for data collection, each runs its own share of the subtrees
+    int n_collection_threads = 1;
+    // Training samples the replay buffer holds, its memory is allocated once up front
+    int replay_capacity = 1 << 18;
+    // Iterations of samples the network trains on, the latest one included
+    int replay_window_iterations = 1;
+    // Store replayed observations as float16, halving their memory
+    bool replay_half_observations = false;
+    // Iterations between two gating matches of the trained network against the strongest
+    int gating_interval = 1;
 };
 
 
@@ -23,6 +23,11 @@
 #define AZ_COMPLETE_TO_END_RATIO 0.25f
 #define AZ_NO_RESIGN_THRESHOLD -0.8f
 #define AZ_NO_RESIGN_STEPS 30
+#define AZ_N_COLLECTION_THREADS 1
+#define AZ_REPLAY_CAPACITY 262144
+#define AZ_REPLAY_WINDOW_ITERATIONS 1
+#define AZ_REPLAY_HALF_OBSERVATIONS false
+#define AZ_GATING_INTERVAL 1
 
 
 
@@ -1,6 +1,7 @@
 #ifndef RL_DEEPLEARNING_NETWORK_EVALUATOR_HPP_
 #define RL_DEEPLEARNING_NETWORK_EVALUATOR_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <torch/torch.h>
@@ -8,12 +9,21 @@
 #include <deeplearning/alphazero/networks/az.hpp>
 namespace rl::deeplearning
 {
+/// @brief IEvaluator over an alphazero network. Not reentrant: evaluate() writes the
+///     batch into the instance's scratch buffers, so one instance must never be called
+///     from two threads at once. Every thread takes its own with copy(), which shares
+///     the network's weights, or clone(), which copies them.
 class NetworkEvaluator : public rl::players::IEvaluator
 {
 private:
     std::unique_ptr<rl::deeplearning::alphazero::IAlphazeroNetwork> network_ptr_;
     int n_actions_;
     std::array<int, 3> observation_shape_;
+    // Scratch the batch is written into and the input tensors wrap, reused so a
+    // search stops allocating once the batch size settles.
+    std::vector<float> observations_;
+    std::vector<float> actions_mask_;
+    std::vector<uint64_t> legal_words_;
     void evaluate(const std::vector<const rl::common::IState*>& state_ptrs_vec, std::vector<float>& probs_out, std::vector<float>& values_out);
 
 public:
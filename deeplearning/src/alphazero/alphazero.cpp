@@ -1,20 +1,27 @@
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <filesystem>
 #include <tuple>
 #include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include <common/random.hpp>
 #include <common/utils.hpp>
 #include <players/amcts_player.hpp>
 #include <players/amcts.hpp>
 #include <players/amcts2_player.hpp>
 #include <players/bandits/amcts2/amcts2.hpp>
+#include <players/batching_evaluator.hpp>
 #include <players/random_rollout_evaluator.hpp>
 #include <deeplearning/network_evaluator.hpp>
 #include <common/match.hpp>
 #include <common/concurrent_match.hpp>
+#include <common/sprt_match.hpp>
 #include <deeplearning/alphazero/alphazero.hpp>
+#include <deeplearning/alphazero/minibatch_loader.hpp>
 
 namespace rl::deeplearning::alphazero
 {
@@ -59,6 +66,7 @@ AlphaZero::AlphaZero(
     {
         base_network_ptr_->load(load_path);
     }
+    replay_buffer_ = std::make_unique<ReplayBuffer>(initial_state_ptr_->get_observation_shape(), n_game_actions_, REPLAY_CAPACITY, REPLAY_WINDOW, REPLAY_HALF_OBSERVATIONS);
     initialize_subtrees();
 }
 
@@ -95,7 +103,12 @@ AlphaZero::AlphaZero(
     N_COMPLETE_TO_END{ static_cast<int>(config.n_subtrees * config.complete_to_end_ratio) },
     NO_RESIGN_THRESHOLD{ config.no_resign_threshold },
     MINIMUM_STEPS{ config.no_resign_steps },
-    CPUCT{ config.cpuct }
+    CPUCT{ config.cpuct },
+    N_COLLECTION_THREADS{ config.n_collection_threads },
+    REPLAY_CAPACITY{ config.replay_capacity },
+    REPLAY_WINDOW{ config.replay_window_iterations },
+    REPLAY_HALF_OBSERVATIONS{ config.replay_half_observations },
+    GATING_INTERVAL{ config.gating_interval }
 {
     base_network_ptr_->to(dev_);
     tiny_network_ptr_->to(dev_);
@@ -103,6 +116,7 @@ AlphaZero::AlphaZero(
     {
         base_network_ptr_->load(load_path_);
     }
+    replay_buffer_ = std::make_unique<ReplayBuffer>(initial_state_ptr_->get_observation_shape(), n_game_actions_, REPLAY_CAPACITY, REPLAY_WINDOW, REPLAY_HALF_OBSERVATIONS);
     initialize_subtrees();
 }
 
@@ -137,16 +151,11 @@ void AlphaZero::train()
         }
     }
 
-    auto s = initial_state_ptr_->get_observation_shape();
     auto strongest = base_network_ptr_->deepcopy();
     strongest->to(dev_);
     torch::optim::AdamW optimizer(base_network_ptr_->parameters(), torch::optim::AdamWOptions{ lr_ }.eps(1e-8).weight_decay(1e-4));
     // torch::optim::SGD optimizer(base_network_ptr_->parameters(), torch::optim::SGDOptions{ lr_ }.momentum(0.9).dampening(0.9).weight_decay(1e-4));
-    auto observation_shape = initial_state_ptr_->get_observation_shape();
-    int channels = observation_shape.at(0);
-    int rows = observation_shape.at(1);
-    int cols = observation_shape.at(2);
-    int observation_size = channels * rows * cols;
+    std::cout << "Replay buffer holds " << replay_buffer_->capacity() << " samples in " << replay_buffer_->bytes() / (1024 * 1024) << " MB" << std::endl;
     int iteration{ 0 };
     while (iteration < n_iterations_)
     {
@@ -160,61 +169,71 @@ void AlphaZero::train()
         auto collection_duration_in_seconds = (collection_duration) / std::chrono::seconds(1);
         std::cout << "Collection phase ended , took " << collection_duration_in_seconds << " s " << std::endl;
 
-        int n_examples = all_observations_.size() / observation_size;
-        if (n_examples * observation_size != all_observations_.size())
-        {
-            std::runtime_error("observations number is wrong");
-        }
-        else if (n_examples != all_probabilities_.size() / n_game_actions_)
-        {
-            std::runtime_error("probabilities examples count are different from observations");
-        }
-        else if (n_examples != all_wdls_.size() / 3)
-        {
-            std::runtime_error("wdls examples count are different from observations");
-        }
-
-        std::cout << "Training phase using " << n_examples << " examples..." << std::endl;
+        int64_t n_examples = replay_buffer_->size();
+        std::cout << "Training phase using " << n_examples << " examples, " << replay_buffer_->n_rejected() << " rejected for NaN so far..." << std::endl;
         auto training_start = std::chrono::high_resolution_clock::now();
-        train_network(base_network_ptr_, optimizer, all_observations_, all_probabilities_, all_wdls_);
+        train_network(base_network_ptr_, optimizer, *replay_buffer_);
         auto training_end = std::chrono::high_resolution_clock::now();
         auto training_duration = training_end - training_start;
         auto training_duration_in_seconds = training_duration / std::chrono::seconds(1);
         std::cout << "Training Phase Ended : took" << training_duration_in_seconds << " s" << std::endl;
         iteration++;
 
-        if (iteration % 20 == 0 /*|| iteration == 1*/ || iteration == n_iterations_)
+        if (iteration % std::max(1, GATING_INTERVAL) == 0 || iteration == n_iterations_)
         {
-            auto evaluation_start = std::chrono::high_resolution_clock::now();
-            torch::NoGradGuard nograd;
-            std::cout << "Evaluation Phase" << std::endl;
-            std::chrono::duration<int, std::milli> zero_duration{ 0 };
-            std::unique_ptr<rl::players::IEvaluator> ev1_ptr{ std::make_unique<rl::deeplearning::NetworkEvaluator>(base_network_ptr_->copy(), n_game_actions_, observation_shape) };
-
-            auto p1_ptr = std::make_unique<rl::players::ConcurrentPlayer>(n_game_actions_, std::move(ev1_ptr), n_sims_, zero_duration, 0.5, CPUCT, N_ASYNC, DIRICHLET_EPSILON, DIRICHLET_ALPHA, N_VISITS, N_WINS);
-            std::unique_ptr<rl::players::IEvaluator> ev2_ptr{ std::make_unique<rl::deeplearning::NetworkEvaluator>(strongest->copy(), n_game_actions_, observation_shape) };
-            auto p2_ptr = std::make_unique<rl::players::ConcurrentPlayer>(n_game_actions_, std::move(ev2_ptr), n_sims_, zero_duration, 0.5, CPUCT, N_ASYNC, DIRICHLET_EPSILON, DIRICHLET_ALPHA, N_VISITS, N_WINS);
-            rl::common::ConcurrentMatch m(test_state_ptr_->reset(), p1_ptr.get(), p2_ptr.get(), n_testing_episodes_, n_testing_episodes_);
-            float p1_score_average = m.start();
-            float ratio = static_cast<float>(p1_score_average + 1.0f) / (2.0f);
-            auto duration = std::chrono::high_resolution_clock::now() - evaluation_start;
-            auto duration_in_seconds = duration / std::chrono::seconds(1);
-            std::cout << "Evaluation Phase Ended : Win ratio is " << ratio << " took " << duration_in_seconds << " s" << std::endl;
-            if (ratio > 0.5)
+            if (gate(*base_network_ptr_, *strongest))
             {
                 strongest = base_network_ptr_->deepcopy();
             }
         }
 
-        all_observations_.clear();
-        all_probabilities_.clear();
-        all_wdls_.clear();
         base_network_ptr_->save(file_path.string());
         strongest->save(strongest_path.string());
         tiny_network_ptr_->save(tiny_path.string());
     }
 }
 
+bool AlphaZero::gate(IAlphazeroNetwork& candidate, IAlphazeroNetwork& strongest)
+{
+    auto evaluation_start = std::chrono::high_resolution_clock::now();
+    std::cout << "Evaluation Phase" << std::endl;
+    auto observation_shape = initial_state_ptr_->get_observation_shape();
+    const int n_pairs = std::max(1, n_testing_episodes_ / 2);
+    const int n_workers = std::max(1, std::min(N_COLLECTION_THREADS, (n_pairs + GATING_PAIRS_PER_ROUND - 1) / GATING_PAIRS_PER_ROUND));
+    std::unique_ptr<rl::players::IEvaluator> candidate_ev_ptr{ std::make_unique<rl::deeplearning::NetworkEvaluator>(candidate.copy(), n_game_actions_, observation_shape) };
+    std::unique_ptr<rl::players::IEvaluator> strongest_ev_ptr{ std::make_unique<rl::deeplearning::NetworkEvaluator>(strongest.copy(), n_game_actions_, observation_shape) };
+    if (n_workers > 1)
+    {
+        // one server per network. About half of a worker's games wait on each network at
+        // a time, the server holds a batch open for that many searches from every worker
+        int max_batch_size = std::max(1, n_workers * GATING_PAIRS_PER_ROUND * N_ASYNC);
+        candidate_ev_ptr = std::make_unique<players::BatchingEvaluator>(std::move(candidate_ev_ptr), max_batch_size, COLLECTION_BATCH_DELAY);
+        strongest_ev_ptr = std::make_unique<players::BatchingEvaluator>(std::move(strongest_ev_ptr), max_batch_size, COLLECTION_BATCH_DELAY);
+    }
+
+    std::chrono::duration<int, std::milli> zero_duration{ 0 };
+    rl::common::ConcurrentPlayerFactory candidate_factory = [&]()
+        { return std::make_unique<rl::players::ConcurrentPlayer>(n_game_actions_, candidate_ev_ptr->copy(), n_sims_, zero_duration, 0.5, CPUCT, N_ASYNC, DIRICHLET_EPSILON, DIRICHLET_ALPHA, N_VISITS, N_WINS); };
+    rl::common::ConcurrentPlayerFactory strongest_factory = [&]()
+        { return std::make_unique<rl::players::ConcurrentPlayer>(n_game_actions_, strongest_ev_ptr->copy(), n_sims_, zero_duration, 0.5, CPUCT, N_ASYNC, DIRICHLET_EPSILON, DIRICHLET_ALPHA, N_VISITS, N_WINS); };
+    rl::common::SprtMatchConfig config{};
+    config.elo0 = GATING_ELO0;
+    config.elo1 = GATING_ELO1;
+    config.alpha = GATING_ALPHA;
+    config.beta = GATING_BETA;
+    config.max_pairs = n_pairs;
+    config.pairs_per_round = GATING_PAIRS_PER_ROUND;
+    config.n_threads = n_workers;
+    rl::common::SprtMatch match(test_state_ptr_->reset(), candidate_factory, strongest_factory, config);
+    rl::common::SprtMatchResult result = match.start();
+
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - evaluation_start;
+    std::cout << "Evaluation Phase Ended : Win ratio is " << result.score << " over " << 2 * result.n_pairs << " games, took " << duration.count() << " s" << std::endl;
+    std::cout << result.to_json() << std::endl;
+    // an undecided gate falls back to the plain score, as the fixed length match did
+    return result.status == rl::common::SprtStatus::ACCEPT_H1 || (result.status == rl::common::SprtStatus::CONTINUE && result.score > 0.5);
+}
+
 int AlphaZero::choose_action(std::vector<float>& probs)
 {
     float p = rl::common::get();
@@ -229,110 +248,79 @@ int AlphaZero::choose_action(std::vector<float>& probs)
     return action;
 }
 
-void AlphaZero::train_network(std::unique_ptr<IAlphazeroNetwork>& network_ptr, torch::optim::Optimizer& optimizer_ref, std::vector<float>& observations, std::vector<float>& probabilities, std::vector<float>& wdls)
+void AlphaZero::train_network(std::unique_ptr<IAlphazeroNetwork>& network_ptr, torch::optim::Optimizer& optimizer_ref, const ReplayBuffer& replay_buffer)
 {
     // torch::optim::AdamW optimizer(base_network_ptr_->parameters(), torch::optim::AdamWOptions{ lr_ }.eps(1e-8).weight_decay(1e-4));
     // torch::optim::SGD optimizer(base_network_ptr_->parameters(), torch::optim::SGDOptions{ lr_ }.momentum(0.9).dampening(0.9).weight_decay(1e-4));
     // auto& optimizer_ref = optimizer;
-    std::array<int, 3> observation_shape = initial_state_ptr_->get_observation_shape();
-    int channels = observation_shape.at(0);
-    int rows = observation_shape.at(1);
-    int cols = observation_shape.at(2);
-    int n_examples = observations.size() / (channels * rows * cols);
+    int n_examples = static_cast<int>(replay_buffer.size());
     int batch_size = n_examples / n_batches_;
     // batch_size = 64;
     const int max_batch_size = 2048;
+    batch_size = std::min(batch_size, max_batch_size);
     // n_batches_ = n_examples / batch_size;
-
-    std::vector<float> total_losses{};
-    std::vector<float> actor_losses{};
-    std::vector<float> critic_losses{};
-
-    torch::Tensor observations_tensor = torch::tensor(observations, torch::kFloat32).reshape({ n_examples, channels, rows, cols });
-    torch::Tensor probabilities_tensor = torch::tensor(probabilities, torch::kFloat32).reshape({ n_examples, n_game_actions_ });
-    torch::Tensor wdl_tensor = torch::tensor(wdls, torch::kFloat32).reshape({ n_examples, 3 });
-
-    // Avoid extreme prob values like 1 or 0
-    probabilities_tensor = probabilities_tensor + EPS;
-    probabilities_tensor = probabilities_tensor / probabilities_tensor.sum(-1, true);
-    wdl_tensor = wdl_tensor + EPS;
-    wdl_tensor = wdl_tensor / wdl_tensor.sum(-1, true);
-
-    bool nan_found_in_obs = false;
-    bool nan_found_in_pred_probs = false;
-    bool nan_found_in_pred_wdls = false;
-    bool nan_found_in_loss = false;
-
-    for (int epoch{ 0 }; epoch < n_epoches_; epoch++)
+    if (batch_size == 0)
     {
-        torch::Tensor indices = torch::randperm(n_examples);
-        for (int batch{ 0 }; batch < n_batches_; batch++)
-        {
-            int current_batch_size = batch_size > max_batch_size ? max_batch_size : batch_size;
-            int batch_start = batch * current_batch_size;
-            int batch_end = batch_start + current_batch_size;
-            torch::Tensor sample_ids = indices.index({ torch::indexing::Slice(batch_start, batch_end) });
-            torch::Tensor observations_batch = observations_tensor.index({ sample_ids }).to(dev_);
-            torch::Tensor target_probs_batch = probabilities_tensor.index({ sample_ids }).to(dev_);
-            torch::Tensor target_wdl_batch = wdl_tensor.index({ sample_ids }).to(dev_);
-
-            std::tuple predicted = network_ptr->forward(observations_batch);
-            torch::Tensor predicted_probs = std::get<0>(predicted);
-            torch::Tensor predicted_wdls = std::get<1>(predicted);
-
-            // To remove nan if it exist....
-            torch::Tensor filter_0 = torch::any(torch::isnan(predicted_probs), -1) == 0;
-            torch::Tensor filter_1 = torch::any(torch::isnan(target_probs_batch), -1) == 0;
-            torch::Tensor filter_2 = torch::any(torch::isnan(predicted_wdls), -1) == 0;
-            torch::Tensor filter_3 = torch::any(torch::isnan(target_wdl_batch), -1) == 0;
-
-            if (!nan_found_in_pred_wdls && torch::any(torch::isnan(predicted_wdls)).item<bool>())
-                nan_found_in_pred_wdls = true;
-
-
-            if (!nan_found_in_pred_probs && torch::any(torch::isnan(predicted_probs)).item<bool>())
-                nan_found_in_pred_probs = true;
-            torch::Tensor filter = filter_0 * filter_1 * filter_2 * filter_3;
-
-            predicted_probs = predicted_probs.index({ filter });
-            target_probs_batch = target_probs_batch.index({ filter });
-            predicted_wdls = predicted_wdls.index({ filter });
-            target_wdl_batch = target_wdl_batch.index({ filter });
-
-            torch::Tensor actor_loss = cross_entropy_loss_(target_probs_batch, predicted_probs);
-            torch::Tensor critic_loss = cross_entropy_loss_(target_wdl_batch, predicted_wdls);
-
-            torch::Tensor total_loss = actor_loss + critic_loss * critic_ceof_;
-            optimizer_ref.zero_grad();
-
-            if (!nan_found_in_loss && torch::any(torch::isnan(total_loss)).item<bool>())
-            {
-                nan_found_in_loss = true;
-            }
-            total_loss.backward();
+        std::cout << "Not enough examples for " << n_batches_ << " batches, skipping training" << std::endl;
+        return;
+    }
 
-            torch::nn::utils::clip_grad_value_(network_ptr->parameters(), 10000);
-            torch::nn::utils::clip_grad_norm_(network_ptr->parameters(), 10, 2.0, true);
+    // the next batch is gathered on the loader's thread while this one trains
+    MinibatchLoader loader(replay_buffer, batch_size, n_batches_, n_epoches_, EPS);
 
-            optimizer_ref.step();
-            actor_losses.push_back(actor_loss.detach().cpu().item<float>());
-            critic_losses.push_back(critic_loss.detach().cpu().item<float>());
-            total_losses.push_back(total_loss.detach().cpu().item<float>());
+    // losses and NaN counts stay on the device until the end, so no step waits on a copy back
+    torch::Tensor actor_sum = torch::zeros({ 1 }, torch::TensorOptions().device(dev_));
+    torch::Tensor critic_sum = torch::zeros({ 1 }, torch::TensorOptions().device(dev_));
+    torch::Tensor total_sum = torch::zeros({ 1 }, torch::TensorOptions().device(dev_));
+    torch::Tensor nan_pred_probs = torch::zeros({ 1 }, torch::TensorOptions().dtype(torch::kInt64).device(dev_));
+    torch::Tensor nan_pred_wdls = torch::zeros({ 1 }, torch::TensorOptions().dtype(torch::kInt64).device(dev_));
 
-        }
-    }
-    float actor_sum = 0;
-    float critic_sum = 0;
-    float total_sum = 0;
-    for (int i = 0; i < actor_losses.size(); i++)
+    auto training_start = std::chrono::high_resolution_clock::now();
+    for (int step{ 0 }; step < loader.n_steps(); step++)
     {
-        actor_sum += actor_losses.at(i);
-        critic_sum += critic_losses.at(i);
-        total_sum += total_losses.at(i);
+        const MinibatchLoader::Batch& batch = loader.next();
+        torch::Tensor observations_batch = batch.observations.to(dev_);
+        torch::Tensor target_probs_batch = batch.probabilities.to(dev_);
+        torch::Tensor target_wdl_batch = batch.wdls.to(dev_);
+
+        std::tuple predicted = network_ptr->forward(observations_batch);
+        torch::Tensor predicted_probs = std::get<0>(predicted);
+        torch::Tensor predicted_wdls = std::get<1>(predicted);
+
+        // Targets were checked for NaN when they entered the replay buffer. Rows the
+        // network predicts NaN for are masked out of the loss
+        torch::Tensor nan_probs_rows = torch::any(torch::isnan(predicted_probs), -1);
+        torch::Tensor nan_wdls_rows = torch::any(torch::isnan(predicted_wdls), -1);
+        nan_pred_probs += nan_probs_rows.sum();
+        nan_pred_wdls += nan_wdls_rows.sum();
+        torch::Tensor valid_rows = torch::logical_not(torch::logical_or(nan_probs_rows, nan_wdls_rows));
+
+        torch::Tensor actor_loss = cross_entropy_loss_(target_probs_batch, predicted_probs, valid_rows);
+        torch::Tensor critic_loss = cross_entropy_loss_(target_wdl_batch, predicted_wdls, valid_rows);
+
+        torch::Tensor total_loss = actor_loss + critic_loss * critic_ceof_;
+        optimizer_ref.zero_grad();
+        total_loss.backward();
+
+        torch::nn::utils::clip_grad_value_(network_ptr->parameters(), 10000);
+        torch::nn::utils::clip_grad_norm_(network_ptr->parameters(), 10, 2.0, true);
+
+        optimizer_ref.step();
+        actor_sum += actor_loss.detach();
+        critic_sum += critic_loss.detach();
+        total_sum += total_loss.detach();
     }
-    std::cout << "Actor Loss = " << actor_sum / actor_losses.size() << "\n";
-    std::cout << "Critic Loss = " << critic_sum / critic_losses.size() << "\n";
-    std::cout << "Total Loss = " << total_sum / total_losses.size() << "\n";
+    float n_steps = static_cast<float>(loader.n_steps());
+    float total_mean = total_sum.item<float>() / n_steps;
+    auto training_duration = std::chrono::high_resolution_clock::now() - training_start;
+    double training_seconds = std::chrono::duration<double>(training_duration).count();
+    std::cout << loader.n_steps() << " steps of " << batch_size << " samples at " << n_steps / std::max(training_seconds, 1e-9) << " steps/s\n";
+    std::cout << "Actor Loss = " << actor_sum.item<float>() / n_steps << "\n";
+    std::cout << "Critic Loss = " << critic_sum.item<float>() / n_steps << "\n";
+    std::cout << "Total Loss = " << total_mean << "\n";
+    bool nan_found_in_pred_probs = nan_pred_probs.item<int64_t>() > 0;
+    bool nan_found_in_pred_wdls = nan_pred_wdls.item<int64_t>() > 0;
+    bool nan_found_in_loss = std::isnan(total_mean);
     if (!nan_found_in_pred_probs && !nan_found_in_pred_wdls && !nan_found_in_loss) {
         std::cout << "Clean Run: No NaNs detected." << std::endl;
     }
@@ -343,76 +331,130 @@ void AlphaZero::train_network(std::unique_ptr<IAlphazeroNetwork>& network_ptr, t
     }
 }
 
-torch::Tensor AlphaZero::cross_entropy_loss_(torch::Tensor& target, torch::Tensor& prediction)
+torch::Tensor AlphaZero::cross_entropy_loss_(torch::Tensor& target, torch::Tensor& prediction, torch::Tensor& valid_rows)
 {
+    // masked rows read a prediction of 1 instead, where() passes them no gradient
+    auto kept_pred = torch::where(valid_rows.unsqueeze(-1), prediction, torch::ones_like(prediction));
     // testing safe prediction
-    auto safe_pred = prediction + EPS;
+    auto safe_pred = kept_pred + EPS;
     auto log_probs = safe_pred.log();
-    auto loss = -(target * log_probs).sum(-1).mean();
+    auto row_losses = -(target * log_probs).sum(-1);
+    auto loss = torch::where(valid_rows, row_losses, torch::zeros_like(row_losses)).sum() / valid_rows.sum().clamp_min(1);
     return loss;
 }
 void AlphaZero::collect_data()
 {
     int max_n_trees = states_ptrs_.size();
-    std::cout << "running " << max_n_trees << " asynchronous trees" << std::endl;
-    int completed_episodes = 0;
-    int trees_n_simulations = 0;
-    auto ev_ptr = std::make_unique<NetworkEvaluator>(base_network_ptr_->copy(), n_game_actions_, initial_state_ptr_->get_observation_shape());
+    int n_workers = std::max(1, std::min(N_COLLECTION_THREADS, max_n_trees));
+    std::cout << "running " << max_n_trees << " asynchronous trees on " << n_workers << " threads" << std::endl;
+    auto collection_start = std::chrono::high_resolution_clock::now();
+    std::unique_ptr<players::IEvaluator> ev_ptr = std::make_unique<NetworkEvaluator>(base_network_ptr_->copy(), n_game_actions_, initial_state_ptr_->get_observation_shape());
+    if (n_workers > 1)
+    {
+        // every worker evaluates one half of its trees at a time, the server waits
+        // for about that many leaves from all of them before running the network
+        int max_batch_size = std::max(1, N_TREES * N_SUB_TREE_ASYNC / 2);
+        ev_ptr = std::make_unique<players::BatchingEvaluator>(std::move(ev_ptr), max_batch_size, COLLECTION_BATCH_DELAY);
+    }
 
-    auto concurrent_tree_ptr = get_new_concurrent_tree_ptr();
-    while (completed_episodes < n_episodes_)
+    // subtree i goes to worker i % n_workers, so the complete to end subtrees are spread
+    std::vector<std::vector<int>> shards(n_workers);
+    for (int tree_id = 0; tree_id < max_n_trees; tree_id++)
+    {
+        shards.at(tree_id % n_workers).push_back(tree_id);
+    }
+    std::atomic<int> completed_episodes{ 0 };
+    std::atomic<bool> stop{ false };
+    replay_buffer_->begin_iteration();
+    if (n_workers == 1)
+    {
+        collect_shard(shards.at(0), std::move(ev_ptr), completed_episodes, stop);
+    }
+    else
+    {
+        // an exception must not escape a std::thread, so the first one is carried
+        // back and rethrown here once every worker has stopped
+        std::exception_ptr error{ nullptr };
+        std::mutex error_mutex{};
+        std::vector<std::thread> threads{};
+        for (int worker = 0; worker < n_workers; worker++)
+        {
+            threads.emplace_back([&, worker, worker_ev_ptr = ev_ptr->copy()]() mutable
+                {
+                    try
+                    {
+                        collect_shard(shards.at(worker), std::move(worker_ev_ptr), completed_episodes, stop);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!error)
+                        {
+                            error = std::current_exception();
+                        }
+                        stop.store(true, std::memory_order_relaxed);
+                    }
+                });
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+    std::chrono::duration<double> collection_duration = std::chrono::high_resolution_clock::now() - collection_start;
+    std::cout << "Collected " << completed_episodes.load() << " games , " << completed_episodes.load() * 3600.0 / collection_duration.count() << " games per hour" << std::endl;
+}
+
+void AlphaZero::collect_shard(const std::vector<int>& tree_ids, std::unique_ptr<players::IEvaluator> ev_ptr, std::atomic<int>& completed_episodes, std::atomic<bool>& stop)
+{
+    // a worker only ever touches the per subtree buffers of its own tree ids
+    auto concurrent_tree_ptr = get_new_concurrent_tree_ptr(std::move(ev_ptr));
+    auto observation_shape = initial_state_ptr_->get_observation_shape();
+    const size_t observation_size = static_cast<size_t>(observation_shape[0]) * observation_shape[1] * observation_shape[2];
+    const int current_n_trees = static_cast<int>(tree_ids.size());
+    std::vector<const rl::common::IState*> states_ptrs_vec(current_n_trees, nullptr);
+    while (completed_episodes.load(std::memory_order_relaxed) < n_episodes_ && !stop.load(std::memory_order_relaxed))
     {
-        int current_n_trees = static_cast<int>(states_ptrs_.size());
-        std::vector<const rl::common::IState*> states_ptrs_vec(current_n_trees, nullptr);
         for (int i = 0;i < current_n_trees;i++)
         {
-            states_ptrs_vec.at(i) = states_ptrs_.at(i).get();
+            states_ptrs_vec.at(i) = states_ptrs_.at(tree_ids.at(i)).get();
         }
         auto [trees_probs, trees_values] = concurrent_tree_ptr->search_multiple(states_ptrs_vec, n_sims_, std::chrono::milliseconds(0));
 
-        for (int tree_id = 0;tree_id < current_n_trees;tree_id++)
+        for (int i = 0;i < current_n_trees;i++)
         {
+            int tree_id = tree_ids.at(i);
             auto& state_ptr = states_ptrs_.at(tree_id);
             int current_player = state_ptr->player_turn();
             episode_players_.at(tree_id).push_back(current_player);
-            std::vector<float>& state_probs = trees_probs.at(tree_id);
-            float ev = trees_values.at(tree_id);
-            auto current_obs = state_ptr->get_observation();
-            for (float cell : current_obs)
+            std::vector<float>& state_probs = trees_probs.at(i);
+            float ev = trees_values.at(i);
+            // the observation, its probs and their symmetries are written straight into the
+            // episode buffers, symmetry k right after symmetry k - 1
+            std::vector<float>& episode_obs = episode_obsevations_.at(tree_id);
+            std::vector<float>& episode_probs = episode_probs_.at(tree_id);
+            const int n_syms = state_ptr->n_symmetries();
+            const size_t n_probs = state_probs.size();
+            const size_t obs_start = episode_obs.size();
+            const size_t probs_start = episode_probs.size();
+            episode_obs.resize(obs_start + (1 + n_syms) * observation_size);
+            episode_probs.resize(probs_start + (1 + n_syms) * n_probs);
+            float* obs = episode_obs.data() + obs_start;
+            float* probs = episode_probs.data() + probs_start;
+            state_ptr->write_observation(obs);
+            std::copy(state_probs.begin(), state_probs.end(), probs);
+            for (int sym = 0; sym < n_syms; sym++)
             {
-                episode_obsevations_.at(tree_id).push_back(cell);
-            }
-            for (float p : state_probs)
-            {
-                episode_probs_.at(tree_id).push_back(p);
-            }
-            std::vector<std::vector<float>> obs_syms_vector;
-            std::vector<std::vector<float>> probs_sym_vector;
-            state_ptr->get_symmetrical_obs_and_actions(current_obs, state_probs, obs_syms_vector, probs_sym_vector);
-            if (obs_syms_vector.size() != probs_sym_vector.size())
-            {
-                throw std::runtime_error("alphazero number of symmetrical observations and symmetrical actions are not equal");
-            }
-
-            for (auto& obs_sym : obs_syms_vector)
-            {
-                for (float cell : obs_sym)
-                {
-                    episode_obsevations_.at(tree_id).push_back(cell);
-                }
+                state_ptr->write_symmetrical_obs_and_actions(obs, probs, sym, obs + (sym + 1) * observation_size, probs + (sym + 1) * n_probs);
                 // push current player equal to the number of symmertical observations
                 // wdl is counting on it
                 episode_players_.at(tree_id).push_back(current_player);
             }
 
-            for (auto& probs_sym : probs_sym_vector)
-            {
-                for (float p : probs_sym)
-                {
-                    episode_probs_.at(tree_id).push_back(p);
-                }
-            }
-
             bool is_complete_to_end = tree_id < N_COMPLETE_TO_END;
             /*
             should resign if all these condition is met:
@@ -425,7 +467,7 @@ void AlphaZero::collect_data()
                 int last_player = state_ptr->player_turn();
                 float result = -1.0f;
                 end_subtree(tree_id, last_player, result);
-                completed_episodes++;
+                completed_episodes.fetch_add(1, std::memory_order_relaxed);
             }
             else
             {
@@ -441,7 +483,7 @@ void AlphaZero::collect_data()
                     int last_player = state_ptr->player_turn();
                     float result = state_ptr->get_reward();
                     end_subtree(tree_id, last_player, result);
-                    completed_episodes++;
+                    completed_episodes.fetch_add(1, std::memory_order_relaxed);
                 }
             }
         }
@@ -470,17 +512,10 @@ void AlphaZero::end_subtree(int i, int last_player, float result)
         }
     }
 
-    for (float cell : episode_obsevations_.at(i))
-    {
-        all_observations_.push_back(cell);
-    }
-    for (float p : episode_probs_.at(i))
-    {
-        all_probabilities_.push_back(p);
-    }
-    for (float v : episode_wdls_.at(i))
     {
-        all_wdls_.push_back(v);
+        // every entry of episode_players_ is one sample, symmetries included
+        std::lock_guard<std::mutex> lock(replay_mutex_);
+        replay_buffer_->add(episode_obsevations_.at(i).data(), episode_probs_.at(i).data(), episode_wdls_.at(i).data(), static_cast<int64_t>(episode_players_.at(i).size()));
     }
 
     // reset everything belongs to this state
@@ -497,10 +532,9 @@ void AlphaZero::end_subtree(int i, int last_player, float result)
     states_ptrs_.at(i) = initial_state_ptr_->reset();
 }
 
-std::unique_ptr<players::ConcurrentAmcts> AlphaZero::get_new_concurrent_tree_ptr()
+std::unique_ptr<players::ConcurrentAmcts> AlphaZero::get_new_concurrent_tree_ptr(std::unique_ptr<players::IEvaluator> ev_ptr)
 {
-    auto ev_ptr = std::make_unique<NetworkEvaluator>(base_network_ptr_->copy(), n_game_actions_, initial_state_ptr_->get_observation_shape());
-    return std::make_unique<players::ConcurrentAmcts>(n_game_actions_, std::move(ev_ptr), CPUCT, 1.0f, N_SUB_TREE_ASYNC, DIRICHLET_EPSILON, DIRICHLET_ALPHA, N_VISITS, N_WINS);
+    return std::make_unique<players::ConcurrentAmcts>(n_game_actions_, std::move(ev_ptr), CPUCT, 1.0f, N_SUB_TREE_ASYNC, DIRICHLET_EPSILON, DIRICHLET_ALPHA, N_VISITS, N_WINS, true);
 }
 
 void AlphaZero::initialize_subtrees()
@@ -0,0 +1,129 @@
+#include <stdexcept>
+#include <deeplearning/alphazero/minibatch_loader.hpp>
+
+namespace rl::deeplearning::alphazero
+{
+MinibatchLoader::MinibatchLoader(const ReplayBuffer& replay_buffer, int batch_size, int n_batches, int n_epochs, float eps)
+    : replay_buffer_{ replay_buffer },
+    batch_size_{ batch_size },
+    n_batches_{ n_batches },
+    n_epochs_{ n_epochs },
+    eps_{ eps },
+    observations_{ replay_buffer.observations() },
+    probabilities_{ replay_buffer.probabilities() },
+    wdls_{ replay_buffer.wdls() }
+{
+    if (static_cast<int64_t>(batch_size_) * n_batches_ > replay_buffer_.size())
+    {
+        throw std::invalid_argument("an epoch needs more samples than the replay buffer holds");
+    }
+    std::vector<int64_t> observation_sizes = observations_.sizes().vec();
+    observation_sizes.at(0) = batch_size_;
+    for (Batch& slot : slots_)
+    {
+        slot.observations = torch::empty(observation_sizes, torch::kFloat32);
+        slot.probabilities = torch::empty({ static_cast<int64_t>(batch_size_), probabilities_.size(1) }, torch::kFloat32);
+        slot.wdls = torch::empty({ static_cast<int64_t>(batch_size_), wdls_.size(1) }, torch::kFloat32);
+    }
+    worker_ = std::thread(&MinibatchLoader::run, this);
+}
+
+MinibatchLoader::~MinibatchLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+}
+
+const MinibatchLoader::Batch& MinibatchLoader::next()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (n_taken_ == n_steps())
+    {
+        throw std::out_of_range("the loader already handed out every batch");
+    }
+    if (held_slot_ >= 0)
+    {
+        is_filled_.at(held_slot_) = false;
+        held_slot_ = -1;
+        cv_.notify_all();
+    }
+    cv_.wait(lock, [this] { return is_filled_.at(next_slot_) || error_ != nullptr; });
+    if (error_ != nullptr)
+    {
+        std::rethrow_exception(error_);
+    }
+    held_slot_ = next_slot_;
+    next_slot_ = (next_slot_ + 1) % N_SLOTS;
+    n_taken_++;
+    return slots_.at(held_slot_);
+}
+
+int MinibatchLoader::n_steps() const
+{
+    return n_batches_ * n_epochs_;
+}
+
+void MinibatchLoader::run()
+{
+    try
+    {
+        int slot = 0;
+        for (int epoch{ 0 }; epoch < n_epochs_; epoch++)
+        {
+            torch::Tensor indices = replay_buffer_.shuffled_slots();
+            for (int batch{ 0 }; batch < n_batches_; batch++)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [this, slot] { return stop_ || !is_filled_.at(slot); });
+                    if (stop_)
+                    {
+                        return;
+                    }
+                }
+                int64_t batch_start = static_cast<int64_t>(batch) * batch_size_;
+                fill(slots_.at(slot), indices.slice(0, batch_start, batch_start + batch_size_));
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    is_filled_.at(slot) = true;
+                }
+                cv_.notify_all();
+                slot = (slot + 1) % N_SLOTS;
+            }
+        }
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = std::current_exception();
+        }
+        cv_.notify_all();
+    }
+}
+
+void MinibatchLoader::fill(Batch& batch, const torch::Tensor& sample_ids)
+{
+    if (observations_.scalar_type() == batch.observations.scalar_type())
+    {
+        torch::index_select_out(batch.observations, observations_, 0, sample_ids);
+    }
+    else
+    {
+        // float16 observations widen on the way into the slot
+        batch.observations.copy_(observations_.index_select(0, sample_ids));
+    }
+    torch::index_select_out(batch.probabilities, probabilities_, 0, sample_ids);
+    torch::index_select_out(batch.wdls, wdls_, 0, sample_ids);
+
+    // Avoid extreme prob values like 1 or 0
+    batch.probabilities.add_(eps_);
+    batch.probabilities.div_(batch.probabilities.sum(-1, true));
+    batch.wdls.add_(eps_);
+    batch.wdls.div_(batch.wdls.sum(-1, true));
+}
+} // namespace rl::deeplearning::alphazero
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <deeplearning/alphazero/replay_buffer.hpp>
+
+namespace rl::deeplearning::alphazero
+{
+ReplayBuffer::ReplayBuffer(const std::array<int, 3>& observation_shape, int n_actions, int64_t capacity, int window_iterations, bool half_observations)
+    : observation_shape_{ observation_shape },
+    observation_size_{ static_cast<int64_t>(observation_shape[0]) * observation_shape[1] * observation_shape[2] },
+    n_actions_{ n_actions },
+    capacity_{ capacity },
+    window_iterations_{ std::max(1, window_iterations) },
+    half_observations_{ half_observations }
+{
+    if (capacity_ <= 0)
+    {
+        throw std::invalid_argument("replay buffer capacity must be positive");
+    }
+    if (half_observations_)
+    {
+        half_observations_slab_.resize(capacity_ * observation_size_);
+    }
+    else
+    {
+        observations_.resize(capacity_ * observation_size_);
+    }
+    probabilities_.resize(capacity_ * n_actions_);
+    wdls_.resize(capacity_ * 3);
+}
+
+void ReplayBuffer::begin_iteration()
+{
+    iteration_sizes_.push_back(0);
+    while (static_cast<int>(iteration_sizes_.size()) > window_iterations_)
+    {
+        iteration_sizes_.pop_front();
+    }
+    // the oldest samples sit right after the newest, dropping them moves nothing.
+    // Some of the window's own may already be overwritten when it outgrew the capacity
+    int64_t window_size = 0;
+    for (int64_t iteration_size : iteration_sizes_)
+    {
+        window_size += iteration_size;
+    }
+    size_ = std::min(size_, window_size);
+}
+
+void ReplayBuffer::add(const float* observations, const float* probabilities, const float* wdls, int64_t n)
+{
+    if (iteration_sizes_.empty())
+    {
+        iteration_sizes_.push_back(0);
+    }
+    auto is_finite = [](const float* begin, int64_t count) { return std::all_of(begin, begin + count, [](float value) { return std::isfinite(value); }); };
+    int64_t n_accepted = 0;
+    for (int64_t i = 0; i < n; i++)
+    {
+        const float* observation = observations + i * observation_size_;
+        // a sample is checked once here instead of every batch it lands in
+        if (!is_finite(observation, observation_size_) || !is_finite(probabilities + i * n_actions_, n_actions_) || !is_finite(wdls + i * 3, 3))
+        {
+            n_rejected_++;
+            continue;
+        }
+        if (half_observations_)
+        {
+            std::transform(observation, observation + observation_size_, half_observations_slab_.begin() + head_ * observation_size_, [](float cell) { return c10::Half(cell); });
+        }
+        else
+        {
+            std::copy(observation, observation + observation_size_, observations_.begin() + head_ * observation_size_);
+        }
+        std::copy(probabilities + i * n_actions_, probabilities + (i + 1) * n_actions_, probabilities_.begin() + head_ * n_actions_);
+        std::copy(wdls + i * 3, wdls + (i + 1) * 3, wdls_.begin() + head_ * 3);
+        head_ = (head_ + 1) % capacity_;
+        n_accepted++;
+    }
+    size_ = std::min(capacity_, size_ + n_accepted);
+    iteration_sizes_.back() += n_accepted;
+}
+
+int64_t ReplayBuffer::size() const
+{
+    return size_;
+}
+
+int64_t ReplayBuffer::n_rejected() const
+{
+    return n_rejected_;
+}
+
+int64_t ReplayBuffer::capacity() const
+{
+    return capacity_;
+}
+
+size_t ReplayBuffer::bytes() const
+{
+    return observations_.size() * sizeof(float) + half_observations_slab_.size() * sizeof(c10::Half) + probabilities_.size() * sizeof(float) + wdls_.size() * sizeof(float);
+}
+
+torch::Tensor ReplayBuffer::observations() const
+{
+    std::vector<int64_t> sizes{ capacity_, observation_shape_[0], observation_shape_[1], observation_shape_[2] };
+    if (half_observations_)
+    {
+        return torch::from_blob(const_cast<c10::Half*>(half_observations_slab_.data()), sizes, torch::kFloat16);
+    }
+    return torch::from_blob(const_cast<float*>(observations_.data()), sizes, torch::kFloat32);
+}
+
+torch::Tensor ReplayBuffer::probabilities() const
+{
+    return torch::from_blob(const_cast<float*>(probabilities_.data()), { capacity_, static_cast<int64_t>(n_actions_) }, torch::kFloat32);
+}
+
+torch::Tensor ReplayBuffer::wdls() const
+{
+    return torch::from_blob(const_cast<float*>(wdls_.data()), { capacity_, int64_t{ 3 } }, torch::kFloat32);
+}
+
+torch::Tensor ReplayBuffer::shuffled_slots() const
+{
+    // the held samples are the size_ slots before head_, wrapping around
+    int64_t oldest = (head_ - size_ + capacity_) % capacity_;
+    return (torch::randperm(size_, torch::kInt64) + oldest).remainder(capacity_);
+}
+} // namespace rl::deeplearning::alphazero
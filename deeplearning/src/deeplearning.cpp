@@ -76,6 +76,11 @@ void train_alphazero(AzTrainParameters train_parameters)
     config.complete_to_end_ratio = train_parameters.complete_to_end_ratio;
     config.no_resign_threshold = train_parameters.no_resign_threshold;
     config.no_resign_steps = train_parameters.no_resign_steps;
+    config.n_collection_threads = train_parameters.n_collection_threads;
+    config.replay_capacity = train_parameters.replay_capacity;
+    config.replay_window_iterations = train_parameters.replay_window_iterations;
+    config.replay_half_observations = train_parameters.replay_half_observations;
+    config.gating_interval = train_parameters.gating_interval;
     rl::deeplearning::alphazero::AlphaZero az(
         fn, fn, std::move(network_ptr->deepcopy()), network_ptr->deepcopy(), config);
     std::cout << "To train alphazero type Y or y" << std::endl;
@@ -1,4 +1,5 @@
 #include <deeplearning/network_evaluator.hpp>
+#include <common/bits.hpp>
 
 namespace rl::deeplearning
 {
@@ -49,35 +50,33 @@ void NetworkEvaluator::evaluate(const std::vector<const rl::common::IState*>& st
         return;
     }
     int observation_size = observation_shape_.at(0) * observation_shape_.at(1) * observation_shape_.at(2);
-    std::vector<float> observations;
-    std::vector<float> actions_mask;
-    observations.reserve(n_states * observation_size);
-    actions_mask.reserve(n_states * n_actions_);
-    probs_out.reserve(n_states * n_actions_);
-    values_out.reserve(n_states);
+    observations_.resize(static_cast<size_t>(n_states) * observation_size);
+    actions_mask_.assign(static_cast<size_t>(n_states) * n_actions_, 0.0f);
+    legal_words_.resize(rl::common::bits::n_words(n_actions_));
 
-    for (auto& state_ptr : state_ptrs_vec)
+    for (int i = 0; i < n_states; i++)
     {
-        for (auto& cell_value : state_ptr->get_observation())
+        const rl::common::IState* state_ptr = state_ptrs_vec[i];
+        if (state_ptr->get_observation_shape() != observation_shape_)
         {
-            observations.emplace_back(cell_value);
+            throw std::runtime_error("while evaluating a state , got an error on its observation size");
         }
-        for (auto cell_value : state_ptr->actions_mask())
-        {
-            actions_mask.emplace_back(float(cell_value));
-        }
-    }
+        state_ptr->write_observation(observations_.data() + static_cast<size_t>(i) * observation_size);
 
-    if (observations.size() != n_states * observation_size)
-    {
-        throw std::runtime_error("while evaluating a state , got an error on its observation size");
+        float* mask = actions_mask_.data() + static_cast<size_t>(i) * n_actions_;
+        state_ptr->legal_actions_bitset(legal_words_.data());
+        rl::common::bits::for_each_bit(legal_words_.data(), static_cast<int>(legal_words_.size()), [mask](int action)
+            { mask[action] = 1.0f; });
     }
 
     torch::NoGradGuard nograd;
-    torch::Tensor observations_tensor = torch::tensor(observations, torch::kFloat32)
-        .to(network_ptr_->device())
-        .reshape({ n_states, observation_shape_.at(0), observation_shape_.at(1), observation_shape_.at(2) });
-    torch::Tensor actions_mask_tensor = torch::tensor(actions_mask, torch::kFloat32).to(network_ptr_->device()).reshape({ n_states, n_actions_ });
+    // from_blob wraps the scratch buffers without copying; on cpu .to() is then a no-op,
+    // on cuda it is the single host to device copy
+    torch::Tensor observations_tensor = torch::from_blob(observations_.data(),
+        { n_states, observation_shape_.at(0), observation_shape_.at(1), observation_shape_.at(2) },
+        torch::kFloat32)
+        .to(network_ptr_->device());
+    torch::Tensor actions_mask_tensor = torch::from_blob(actions_mask_.data(), { n_states, n_actions_ }, torch::kFloat32).to(network_ptr_->device());
     auto rs = network_ptr_->forward(observations_tensor);
     auto probs_tensor = std::get<0>(rs);
     auto legal_probs_tensor = probs_tensor * actions_mask_tensor; // assign illegal probs as zeroes
@@ -84,6 +84,7 @@ public:
     std::unique_ptr<rl::common::IState> reset() const override;
 
     std::unique_ptr<DammaState> step_state(int action) const;
+    void apply(int action) override;
     std::unique_ptr<rl::common::IState> step(int action) const override;
 
     void render() const override;
@@ -91,9 +92,14 @@ public:
     float get_reward() const override;
 
     std::vector<float> get_observation() const override;
+    void write_observation(float* out) const override;
 
     std::string to_short() const override;
 
+    uint64_t hash() const override;
+    size_t memory_bytes() const override;
+    std::string game_name() const override;
+
     std::array<int, 3> get_observation_shape() const override;
 
     int get_n_actions() const override;
@@ -113,6 +119,7 @@ private:
     std::optional<std::pair<int, int>> last_jump_;
     std::vector<bool> last_jump_action_mask_;
     int current_player_;
+    uint64_t hash_;
 
     // cache
     mutable std::vector<bool> cached_actions_masks_;
@@ -120,12 +127,18 @@ private:
     mutable std::optional<float> cached_result_;
     mutable std::vector<float> cached_observation_;
 
+    // copies the position without the caches and without rehashing the board
+    DammaState(Board board, int n_no_capture_rounds, std::optional<std::pair<int, int>> last_jump, std::vector<bool> last_jump_action_mask, int current_player, uint64_t hash);
+    static uint64_t compute_hash(const Board& board, int n_no_capture_rounds, const std::optional<std::pair<int, int>>& last_jump, int current_player);
+    // the move itself, shared by step and apply once they checked legality
+    void apply_unchecked(int action);
+    void clear_cache();
     static bool assign_legal_action(Board& board, int row, int col, bool capture_only, std::vector<bool>& action_legality_no_capture_out, std::vector<bool>& action_legality_capture_out);
     bool is_opponent_win() const;
     bool is_draw() const;
-    void add_no_capture_rounds_observation_(std::vector<float>& observation_out) const;
-    void add_last_jump_observation_(std::vector<float>& observation_out) const;
-    void add_current_player_turn_observation_(std::vector<float>& observation_out) const;
+    void add_no_capture_rounds_observation_(float* observation_out) const;
+    void add_last_jump_observation_(float* observation_out) const;
+    void add_current_player_turn_observation_(float* observation_out) const;
 };
 
 } // namespace rl::games
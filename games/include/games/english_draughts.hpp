@@ -40,6 +40,7 @@ private:
     std::vector<int> last_jump_{};
     std::vector<bool> last_jump_actions_mask_{};
     int current_player_{};
+    uint64_t hash_{};
 
     // cache
     mutable std::vector<bool> cached_actions_masks_;
@@ -47,6 +48,13 @@ private:
     mutable std::optional<float> cached_result_;
     mutable std::vector<float> cached_observation_;
 
+    // copies the position without the caches and without rehashing the board
+    EnglishDraughtState(std::array<std::array<int8_t, COLS>, ROWS> board, int n_no_capture_rounds, std::vector<bool> last_jump_actions_mask, std::vector<int> last_jump, int current_player, uint64_t hash);
+    static uint64_t compute_hash(const Board& board, int n_no_capture_rounds, const std::vector<int>& last_jump, int current_player);
+    // the move itself, shared by step and apply once they checked legality
+    void apply_unchecked(int action);
+    void clear_cache();
+
     // private static methods
     static RowColDirectionAction get_row_col_direction_from_action_(int action);
     static bool is_king_(const Board& board, int row, int col);
@@ -59,9 +67,9 @@ private:
     // private methods
     bool is_opponent_win_() const;
     bool is_draw_() const;
-    void add_no_capture_rounds_observation_(std::vector<float>& observation_out) const;
-    void add_last_jump_observation_(std::vector<float>& observation_out) const;
-    void add_current_player_turn_observation_(std::vector<float>& observation_out) const;
+    void add_no_capture_rounds_observation_(float* observation_out) const;
+    void add_last_jump_observation_(float* observation_out) const;
+    void add_current_player_turn_observation_(float* observation_out) const;
 
 public:
     EnglishDraughtState(std::array<std::array<int8_t, COLS>, ROWS> board, int n_no_capture_rounds, std::vector<bool> last_jump_actions_mask, std::vector<int> last_jump, int current_player);
@@ -74,6 +82,7 @@ public:
 
     std::unique_ptr<EnglishDraughtState> step_state(int action)const;
     std::unique_ptr<rl::common::IState> step(int action)const override;
+    void apply(int action) override;
 
     void render()const override;
     bool is_terminal()const override;
@@ -81,8 +90,12 @@ public:
     float get_reward()const override;
 
     std::vector<float> get_observation()const override;
+    void write_observation(float* out) const override;
 
     std::string to_short()const override;
+    uint64_t hash() const override;
+    size_t memory_bytes() const override;
+    std::string game_name() const override;
 
     std::array<int, 3> get_observation_shape()const override;
 
@@ -30,15 +30,21 @@ public:
     static std::unique_ptr<GobbletGoblersState> initialize_state();
     std::unique_ptr<rl::common::IState> step(int action) const override;
     std::unique_ptr<GobbletGoblersState> step_state(int action) const;
+    void apply(int action) override;
     std::unique_ptr<rl::common::IState> reset() const override;
     std::unique_ptr<GobbletGoblersState> reset_state() const;
     void render() const override;
     bool is_terminal() const override;
     float get_reward() const override;
     std::vector<float> get_observation() const override;
+    void write_observation(float* out) const override;
 
     std::string to_short() const override;
 
+    uint64_t hash() const override;
+    size_t memory_bytes() const override;
+    std::string game_name() const override;
+
     std::array<int, 3> get_observation_shape() const override;
 
     int get_n_actions() const override;
@@ -49,6 +55,8 @@ public:
     std::unique_ptr<rl::common::IState> clone() const override;
     std::unique_ptr<GobbletGoblersState> clone_state() const;
     void get_symmetrical_obs_and_actions(std::vector<float> const& obs, std::vector<float> const& actions_distribution, std::vector<std::vector<float>>& out_syms, std::vector<std::vector<float>>& out_actions_distribution) const override;
+    int n_symmetries() const override;
+    void write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const override;
     std::array<std::array<int, COLS>, ROWS> get_board()const;
 
 
@@ -56,6 +64,7 @@ private:
     std::array<std::array<std::array<int8_t, COLS>, ROWS>, CHANNELS> board_;
     int8_t player_;
     int turn_;
+    uint64_t hash_;
 
     // cached
     mutable std::vector<bool> legal_actions_;
@@ -63,6 +72,12 @@ private:
     mutable std::optional<float> cached_result_;
     mutable std::vector<float> cached_observation_;
 
+    // copies the position without the caches and without rehashing the board
+    GobbletGoblersState(std::array<std::array<std::array<int8_t, COLS>, ROWS>, CHANNELS> board, int8_t player, int turn, uint64_t hash);
+    static uint64_t compute_hash(std::array<std::array<std::array<int8_t, COLS>, ROWS>, CHANNELS> const& board, int player, int turn);
+    // the move itself, shared by step and apply once they checked legality
+    void apply_unchecked(int action);
+    void clear_cache();
     static void get_top_board(std::array<std::array<std::array<int8_t, COLS>, ROWS>, CHANNELS> const& board, std::array<std::array<int, COLS>, ROWS>& top_board);
 
     static bool is_winning(std::array<std::array<int, COLS>, ROWS>const& top_board, int player);
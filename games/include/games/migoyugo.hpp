@@ -30,6 +30,7 @@ private:
   int current_player_;
   int step_;
   int last_action_;
+  uint64_t hash_;
   mutable std::vector<bool> cached_actions_masks_{};
   mutable std::optional<bool> cached_is_terminal_;
   mutable std::optional<float> cached_result_;
@@ -37,6 +38,8 @@ private:
   mutable std::optional<std::string>cached_short_{};
 
   int get_streak_count(int row, int col, int row_dir, int col_dir, int player) const;
+  // placing on an empty cell is illegal when it would make a line of 5 or more
+  bool is_legal_placement(int row, int col) const;
   bool is_in_board(int row, int col) const;
 
   bool is_opponent_won()const;
@@ -46,6 +49,13 @@ private:
   bool check_backward_diagonal_winning(std::array<std::array<int8_t, COLS>, ROWS> const& opponent_yugos_board, int row, int col)const;
   bool has_legal_action()const;
 
+  // copies the position without the caches and without rehashing the board
+  MigoyugoState(std::array<std::array<int8_t, COLS>, ROWS> board, int player, int step, int last_action, uint64_t hash);
+  static uint64_t compute_hash(std::array<std::array<int8_t, COLS>, ROWS> const& board, int player);
+  // the move itself, shared by step and apply once they checked legality
+  void apply_unchecked(int action);
+  void clear_cache();
+
 
 
 public:
@@ -57,19 +67,27 @@ public:
   std::unique_ptr<MigoyugoState> reset_state() const;
   std::unique_ptr<rl::common::IState> step(int action) const override;
   std::unique_ptr<MigoyugoState> step_state(int action) const;
+  void apply(int action) override;
   void render() const override;
   bool is_terminal() const override;
   float get_reward() const override;
   std::vector<float> get_observation() const override;
+  void write_observation(float* out) const override;
   std::string to_short() const override;
+  uint64_t hash() const override;
+  size_t memory_bytes() const override;
+  std::string game_name() const override;
   std::array<int, 3> get_observation_shape() const override;
   int get_n_actions() const override;
   int player_turn() const override;
   std::vector<bool> actions_mask() const override;
+  void legal_actions_bitset(uint64_t* out_words) const override;
 
   std::unique_ptr<MigoyugoState> clone_state() const;
   std::unique_ptr<rl::common::IState> clone() const override;
   void get_symmetrical_obs_and_actions(std::vector<float> const& obs, std::vector<float> const& actions_distribution, std::vector<std::vector<float>>& out_syms, std::vector<std::vector<float>>& out_actions_distribution) const override;
+  int n_symmetries() const override;
+  void write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const override;
   static int encode_action(int row, int col);
   int get_last_action()const;
 
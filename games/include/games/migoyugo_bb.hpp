@@ -555,6 +555,53 @@ private:
     }
 };
 
+// --------------------------------------------------------------------------
+// Value-type game for the compile-time searches in players/bandits/static
+// --------------------------------------------------------------------------
+
+// MigoyugoBB plays moves without ever looking back, so the Igo win do_move
+// reports is kept here to answer is_terminal and get_reward afterwards.
+struct MigoyugoGame
+{
+    static constexpr int N_ACTIONS = 64;
+
+    MigoyugoBB board{};
+    // the player who just moved made four Yugos in a row
+    bool igo{ false };
+
+    static MigoyugoGame initial() { return MigoyugoGame(); }
+
+    static MigoyugoGame from_short(const std::string& s)
+    {
+        MigoyugoGame g;
+        g.board = MigoyugoBB::from_short(s);
+        g.igo = has_line_of_4(g.board.yugo[1 - g.board.stm]) != 0;
+        return g;
+    }
+
+    int player_turn() const { return board.stm; }
+
+    bool is_terminal() const { return igo || board.legal_moves() == 0; }
+
+    float get_reward() const { return igo ? -1.0f : board.wego_reward(); }
+
+    int legal_actions(int* out) const
+    {
+        int n = 0;
+        for (uint64_t b = board.legal_moves(); b; b &= b - 1)
+        {
+            out[n++] = ctz64(b);
+        }
+        return n;
+    }
+
+    void apply(int action)
+    {
+        Undo u;
+        igo = board.do_move(action, u);
+    }
+};
+
 } // namespace rl::games::mgbb
 
 #endif
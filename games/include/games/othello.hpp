@@ -23,9 +23,16 @@ private:
     mutable bool is_terminal_;
     mutable bool is_result_cached_;
     mutable float cached_result_;
+    uint64_t hash_;
 
+    // copies the position without the caches and without rehashing the board
+    OthelloState(std::array<std::array<std::array<int8_t, COLS>, ROWS>, N_PLAYERS> observation, int player, int consecutive_skips, uint64_t hash);
+    static uint64_t compute_hash(const std::array<std::array<std::array<int8_t, COLS>, ROWS>, N_PLAYERS>& observation, int player, int consecutive_skips);
     std::vector<std::pair<int, int>> get_board_changes_on_action(int row, int col) const;
     bool is_board_action(int row, int col) const;
+    // the move itself, shared by step and apply once they checked legality
+    void apply_unchecked(int action);
+    void clear_cache();
 
 public:
     OthelloState(std::array<std::array<std::array<int8_t, COLS>, ROWS>, N_PLAYERS> observation, int player, int consecutive_skips);
@@ -36,11 +43,16 @@ public:
     std::unique_ptr<OthelloState> reset_state() const;
     std::unique_ptr<rl::common::IState> step(int action) const override;
     std::unique_ptr<OthelloState> step_state(int action) const;
+    void apply(int action) override;
     void render() const override;
     bool is_terminal() const override;
     float get_reward() const override;
     std::vector<float> get_observation() const override;
+    void write_observation(float* out) const override;
     std::string to_short() const override;
+    uint64_t hash() const override;
+    size_t memory_bytes() const override;
+    std::string game_name() const override;
     std::array<int, 3> get_observation_shape() const override;
     int get_n_actions() const override;
     int player_turn() const override;
@@ -48,6 +60,8 @@ public:
     std::unique_ptr<OthelloState> clone_state() const;
     std::unique_ptr<rl::common::IState> clone() const override;
     void get_symmetrical_obs_and_actions(std::vector<float> const& obs, std::vector<float> const& actions_distribution, std::vector<std::vector<float>>& out_syms, std::vector<std::vector<float>>& out_actions_distribution) const override;
+    int n_symmetries() const override;
+    void write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const override;
 };
 
 } // namespace rl::games
@@ -0,0 +1,171 @@
+#ifndef RL_GAMES_OTHELLO_BB_HPP_
+#define RL_GAMES_OTHELLO_BB_HPP_
+
+// Value-type bitboard Othello for the compile-time searches in
+// players/bandits/static. OthelloState stays the source of truth for the
+// rules; this must agree with it move for move, skips and end of game
+// included (run/bench_static_mcts.cpp diff checks that).
+
+#include <cstdint>
+#include <cctype>
+#include <string>
+#include <common/bits.hpp>
+
+namespace rl::games
+{
+struct OthelloBB
+{
+    static constexpr int N_ACTIONS = 65;
+    static constexpr int SKIP_ACTION = 64;
+
+    // bit row * 8 + col, the same as the action encoding
+    uint64_t discs[2]{ (1ULL << 28) | (1ULL << 35), (1ULL << 27) | (1ULL << 36) };
+    int player{ 0 };
+    int n_consecutive_skips{ 0 };
+
+    static OthelloBB initial() { return OthelloBB(); }
+
+    // Parses OthelloState::to_short(). The skip counter is not part of it and
+    // starts at 0: a skip leaves the board as it was, so a position reached by
+    // one has the same moves and the same outcome, only one forced ply longer.
+    static OthelloBB from_short(const std::string& s)
+    {
+        OthelloBB b;
+        b.discs[0] = b.discs[1] = 0;
+        const size_t hash_pos = s.find_last_of('#');
+        int cell = 0;
+        for (size_t i = 0; i < hash_pos; i++)
+        {
+            const char ch = s[i];
+            if (std::isdigit(static_cast<unsigned char>(ch)))
+            {
+                int run = 0;
+                while (i < hash_pos && std::isdigit(static_cast<unsigned char>(s[i])))
+                {
+                    run = run * 10 + (s[i] - '0');
+                    i++;
+                }
+                i--;
+                cell += run;
+                continue;
+            }
+            if (ch == 'x') b.discs[0] |= 1ULL << cell;
+            if (ch == 'o') b.discs[1] |= 1ULL << cell;
+            cell++;
+        }
+        b.player = std::stoi(s.substr(hash_pos + 1));
+        return b;
+    }
+
+    int player_turn() const { return player; }
+
+    bool is_terminal() const
+    {
+        return n_consecutive_skips == 2 || (discs[0] | discs[1]) == ~0ULL;
+    }
+
+    // relative to the player to move, by disc count
+    float get_reward() const
+    {
+        const int own = rl::common::bits::popcount64(discs[player]);
+        const int other = rl::common::bits::popcount64(discs[1 - player]);
+        return own > other ? 1.0f : own == other ? 0.0f : -1.0f;
+    }
+
+    uint64_t board_moves() const
+    {
+        const uint64_t own = discs[player];
+        const uint64_t other = discs[1 - player];
+        const uint64_t empty = ~(own | other);
+        return moves_along<1>(own, other, empty) | moves_along<-1>(own, other, empty)
+            | moves_along<8>(own, other, empty) | moves_along<-8>(own, other, empty)
+            | moves_along<9>(own, other, empty) | moves_along<-9>(own, other, empty)
+            | moves_along<7>(own, other, empty) | moves_along<-7>(own, other, empty);
+    }
+
+    // the skip is legal exactly when no disc can be placed
+    int legal_actions(int* out) const
+    {
+        const uint64_t moves = board_moves();
+        if (moves == 0)
+        {
+            out[0] = SKIP_ACTION;
+            return 1;
+        }
+        int n = 0;
+        for (uint64_t b = moves; b; b &= b - 1)
+        {
+            out[n++] = rl::common::bits::ctz64(b);
+        }
+        return n;
+    }
+
+    void apply(int action)
+    {
+        if (action == SKIP_ACTION)
+        {
+            n_consecutive_skips++;
+            player = 1 - player;
+            return;
+        }
+        n_consecutive_skips = 0;
+        const uint64_t sqbb = 1ULL << action;
+        const uint64_t own = discs[player];
+        const uint64_t other = discs[1 - player];
+        const uint64_t flips = flips_along<1>(sqbb, own, other) | flips_along<-1>(sqbb, own, other)
+            | flips_along<8>(sqbb, own, other) | flips_along<-8>(sqbb, own, other)
+            | flips_along<9>(sqbb, own, other) | flips_along<-9>(sqbb, own, other)
+            | flips_along<7>(sqbb, own, other) | flips_along<-7>(sqbb, own, other);
+        discs[player] = own | flips | sqbb;
+        discs[1 - player] = other & ~flips;
+        player = 1 - player;
+    }
+
+private:
+    static constexpr uint64_t NOT_FILE_A = 0xfefefefefefefefeULL; // col >= 1
+    static constexpr uint64_t NOT_FILE_H = 0x7f7f7f7f7f7f7f7fULL; // col <= 6
+
+    // one step towards +S (S = row step * 8 + col step), masking the result so
+    // nothing wraps around a file edge
+    template <int S>
+    static uint64_t shift(uint64_t x)
+    {
+        constexpr int COL_STEP = ((S % 8) + 8 + 1) % 8 - 1; // -1, 0 or 1
+        constexpr uint64_t MASK = COL_STEP == 1 ? NOT_FILE_A : COL_STEP == -1 ? NOT_FILE_H : ~0ULL;
+        if constexpr (S > 0)
+        {
+            return (x << S) & MASK;
+        }
+        else
+        {
+            return (x >> -S) & MASK;
+        }
+    }
+
+    template <int S>
+    static uint64_t moves_along(uint64_t own, uint64_t other, uint64_t empty)
+    {
+        uint64_t x = shift<S>(own) & other;
+        for (int i = 0; i < 5; i++)
+        {
+            x |= shift<S>(x) & other;
+        }
+        return shift<S>(x) & empty;
+    }
+
+    template <int S>
+    static uint64_t flips_along(uint64_t sqbb, uint64_t own, uint64_t other)
+    {
+        uint64_t flips = 0;
+        uint64_t x = shift<S>(sqbb);
+        while (x & other)
+        {
+            flips |= x;
+            x = shift<S>(x);
+        }
+        return (x & own) ? flips : 0;
+    }
+};
+} // namespace rl::games
+
+#endif
@@ -39,11 +39,16 @@ public:
     std::unique_ptr<SantoriniState> reset_state() const;
     std::unique_ptr<rl::common::IState> step(int action) const override;
     std::unique_ptr<SantoriniState> step_state(int action) const;
+    void apply(int action) override;
     void render() const override;
     bool is_terminal() const override;
     float get_reward() const override;
     std::vector<float> get_observation() const override;
+    void write_observation(float* out) const override;
     std::string to_short() const override;
+    uint64_t hash() const override;
+    size_t memory_bytes() const override;
+    std::string game_name() const override;
     std::array<int, 3> get_observation_shape() const override;
     int get_n_actions() const override;
     int player_turn() const override;
@@ -51,6 +56,8 @@ public:
     std::unique_ptr<SantoriniState> clone_state() const;
     std::unique_ptr<rl::common::IState> clone() const override;
     void get_symmetrical_obs_and_actions(std::vector<float> const& obs, std::vector<float> const& actions_distribution, std::vector<std::vector<float>>& out_syms, std::vector<std::vector<float>>& out_actions_distribution)const override;
+    int n_symmetries() const override;
+    void write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const override;
     SantoriniPhase get_current_phase() const;
 
     static std::pair<int, int> decode_action(int action);
@@ -63,7 +70,22 @@ private:
     int current_player_;
     int turn_;
     std::optional<std::pair<int, int>> selection_;
+    uint64_t hash_;
 
+    // copies the position without the caches and without rehashing the boards
+    SantoriniState(const Board& players,
+        const Board& buildings,
+        SantoriniPhase current_phase,
+        bool is_winning_move,
+        int turn,
+        int current_player,
+        std::optional<std::pair<int, int>> selection,
+        uint64_t hash);
+    static uint64_t compute_hash(const Board& players, const Board& buildings, SantoriniPhase current_phase, bool is_winning_move, int current_player, const std::optional<std::pair<int, int>>& selection);
+
+    // the move itself, shared by step and apply once they checked legality
+    void apply_unchecked(int action);
+    void clear_cache();
     bool has_legal_action() const;
     void get_current_state_status(std::stringstream& ss)const;
 
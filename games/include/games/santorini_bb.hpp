@@ -0,0 +1,185 @@
+#ifndef RL_GAMES_SANTORINI_BB_HPP_
+#define RL_GAMES_SANTORINI_BB_HPP_
+
+// Value-type Santorini for the compile-time searches in
+// players/bandits/static, the workers as 25 bit masks. SantoriniState stays
+// the source of truth for the rules, quirks included; this must agree with it
+// move for move (run/bench_static_mcts.cpp diff checks that).
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <common/bits.hpp>
+
+namespace rl::games
+{
+namespace santorini_bb
+{
+// [cell][direction] the neighbouring cell, -1 off the board. The directions
+// go row by row, so the cells come out in increasing order.
+constexpr std::array<std::array<int, 8>, 25> make_neighbours()
+{
+    constexpr int DIRECTIONS[8][2] = { {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} };
+    std::array<std::array<int, 8>, 25> neighbours{};
+    for (int cell = 0; cell < 25; cell++)
+    {
+        for (int a = 0; a < 8; a++)
+        {
+            const int row = cell / 5 + DIRECTIONS[a][0];
+            const int col = cell % 5 + DIRECTIONS[a][1];
+            neighbours[cell][a] = row >= 0 && row < 5 && col >= 0 && col < 5 ? row * 5 + col : -1;
+        }
+    }
+    return neighbours;
+}
+inline constexpr std::array<std::array<int, 8>, 25> NEIGHBOURS = make_neighbours();
+} // namespace santorini_bb
+
+struct SantoriniBB
+{
+    enum class Phase : int8_t
+    {
+        placement,
+        selection,
+        moving,
+        building,
+    };
+
+    // row * 5 + col; the last one is never legal, SantoriniState keeps it too
+    static constexpr int N_ACTIONS = 26;
+    static constexpr int DOME = 4;
+
+    uint32_t workers[2]{};
+    std::array<int8_t, 25> heights{};
+    Phase phase{ Phase::placement };
+    bool is_winning_move{ false };
+    int player{ 0 };
+    int turn{ 1 };
+    // the worker picked in selection, then the cell it moved to; -1 otherwise
+    int selection{ -1 };
+
+    static SantoriniBB initial() { return SantoriniBB(); }
+
+    // Parses SantoriniState::to_short(): 5 rows of workers (' ', 'x', 'o', upper
+    // case for the selected one), 5 rows of heights, then "#x" or "#o", the
+    // phase letter and the turn. The winning move flag is not in it, but a
+    // state with it set is terminal and never searched.
+    static SantoriniBB from_short(const std::string& s)
+    {
+        SantoriniBB b;
+        for (int cell = 0; cell < 25; cell++)
+        {
+            const char ch = s[(cell / 5) * 6 + cell % 5];
+            if (ch == 'x' || ch == 'X') b.workers[0] |= 1u << cell;
+            if (ch == 'o' || ch == 'O') b.workers[1] |= 1u << cell;
+            if (ch == 'X' || ch == 'O') b.selection = cell;
+            b.heights[cell] = static_cast<int8_t>(s[30 + (cell / 5) * 6 + cell % 5] - '0');
+        }
+        const size_t status = s.find('#', 60);
+        b.player = s[status + 1] == 'x' ? 0 : 1;
+        const char phase = s[status + 3];
+        b.phase = phase == 'P' ? Phase::placement : phase == 'S' ? Phase::selection : phase == 'M' ? Phase::moving : Phase::building;
+        b.turn = std::stoi(s.substr(status + 5));
+        return b;
+    }
+
+    int player_turn() const { return player; }
+
+    bool is_terminal() const
+    {
+        if (is_winning_move)
+        {
+            return true;
+        }
+        int actions[N_ACTIONS];
+        return legal_actions(actions) == 0;
+    }
+
+    // the mover climbed to the third level, or the player to move is stuck
+    float get_reward() const { return is_winning_move ? 1.0f : -1.0f; }
+
+    int legal_actions(int* out) const
+    {
+        const uint32_t occupied = workers[0] | workers[1];
+        int n = 0;
+        switch (phase)
+        {
+        case Phase::placement:
+            for (uint64_t b = ~occupied & 0x1ffffffu; b; b &= b - 1)
+            {
+                out[n++] = rl::common::bits::ctz64(b);
+            }
+            break;
+        case Phase::selection:
+            for (uint64_t b = workers[player]; b; b &= b - 1)
+            {
+                out[n++] = rl::common::bits::ctz64(b);
+            }
+            break;
+        case Phase::moving:
+            // up at most one level, down any number, domes included
+            for (int cell : santorini_bb::NEIGHBOURS[selection])
+            {
+                if (cell >= 0 && !(occupied >> cell & 1u) && heights[cell] - heights[selection] <= 1)
+                {
+                    out[n++] = cell;
+                }
+            }
+            break;
+        case Phase::building:
+            for (int cell : santorini_bb::NEIGHBOURS[selection])
+            {
+                if (cell >= 0 && !(occupied >> cell & 1u) && heights[cell] != DOME)
+                {
+                    out[n++] = cell;
+                }
+            }
+            break;
+        }
+        return n;
+    }
+
+    void apply(int action)
+    {
+        switch (phase)
+        {
+        case Phase::placement:
+            workers[player] |= 1u << action;
+            turn++;
+            // each player places both workers in a row
+            if (turn != 2 && turn != 4)
+            {
+                player = 1 - player;
+            }
+            if (turn > 4)
+            {
+                phase = Phase::selection;
+            }
+            is_winning_move = false;
+            selection = -1;
+            break;
+        case Phase::selection:
+            selection = action;
+            phase = Phase::moving;
+            is_winning_move = false;
+            break;
+        case Phase::moving:
+            workers[player] ^= (1u << selection) | (1u << action);
+            is_winning_move = heights[action] == 3 && heights[selection] < 3;
+            phase = Phase::building;
+            selection = action;
+            break;
+        case Phase::building:
+            heights[action]++;
+            turn++;
+            player = 1 - player;
+            phase = Phase::selection;
+            is_winning_move = false;
+            selection = -1;
+            break;
+        }
+    }
+};
+} // namespace rl::games
+
+#endif
@@ -19,6 +19,7 @@ public:
     static std::unique_ptr<TicTacToeState> initialize_state();
     std::unique_ptr<rl::common::IState> step(int action) const override;
     std::unique_ptr<TicTacToeState> step_state(int action) const;
+    void apply(int action) override;
 
     std::unique_ptr<rl::common::IState> reset() const override;
     std::unique_ptr<TicTacToeState> reset_state() const;
@@ -30,23 +31,39 @@ public:
     float get_reward() const override;
 
     std::vector<float> get_observation() const override;
+    void write_observation(float* out) const override;
 
     std::string to_short() const override;
 
+    uint64_t hash() const override;
+    size_t memory_bytes() const override;
+    std::string game_name() const override;
+
     std::array<int, 3> get_observation_shape() const override;
 
     int get_n_actions() const override;
 
     int player_turn() const override;
     std::vector<bool> actions_mask() const override;
+    void legal_actions_bitset(uint64_t* out_words) const override;
     ~TicTacToeState() override;
     std::unique_ptr<rl::common::IState> clone() const override;
     std::unique_ptr<TicTacToeState> clone_state() const;
     void get_symmetrical_obs_and_actions(std::vector<float> const& obs, std::vector<float> const& actions_distribution, std::vector<std::vector<float>>& out_syms, std::vector<std::vector<float>>& out_actions_distribution) const override;
+    int n_symmetries() const override;
+    void write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const override;
 
 private:
     std::array<std::array<int8_t, ROWS>, COLS> board_;
     int8_t player_;
+    uint64_t hash_;
+
+    // copies the position without the caches and without rehashing the board
+    TicTacToeState(std::array<std::array<int8_t, COLS>, ROWS> board, int8_t player, uint64_t hash);
+    static uint64_t compute_hash(const std::array<std::array<int8_t, COLS>, ROWS>& board, int player);
+    // the move itself, shared by step and apply once they checked legality
+    void apply_unchecked(int action);
+    void clear_cache();
 
     // used for caching , should not change the state
     mutable std::vector<bool> legal_actions_;
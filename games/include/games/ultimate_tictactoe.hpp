@@ -24,6 +24,7 @@ public:
     std::unique_ptr<UltimateTicTacToeState> reset_state() const;
     std::unique_ptr<rl::common::IState> step(int action) const override;
     std::unique_ptr<UltimateTicTacToeState> step_state(int action) const;
+    void apply(int action) override;
 
     void render() const override;
 
@@ -32,19 +33,27 @@ public:
     float get_reward() const override;
 
     std::vector<float> get_observation() const override;
+    void write_observation(float* out) const override;
 
     std::string to_short() const override;
 
+    uint64_t hash() const override;
+    size_t memory_bytes() const override;
+    std::string game_name() const override;
+
     std::array<int, 3> get_observation_shape() const override;
 
     int get_n_actions() const override;
 
     int player_turn() const override;
     std::vector<bool> actions_mask() const override;
+    void legal_actions_bitset(uint64_t* out_words) const override;
     ~UltimateTicTacToeState() override;
     std::unique_ptr<rl::common::IState> clone() const override;
     std::unique_ptr<UltimateTicTacToeState> clone_state() const;
     void get_symmetrical_obs_and_actions(std::vector<float> const& obs, std::vector<float> const& actions_distribution, std::vector<std::vector<float>>& out_syms, std::vector<std::vector<float>>& out_actions_distribution) const override;
+    int n_symmetries() const override;
+    void write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const override;
     int get_last_action() const;
 
 private:
@@ -53,6 +62,14 @@ private:
     std::array<std::array<int, COLS>, ROWS> ultimate_board_terminals_;
     int player_;
     int last_action_;
+    uint64_t hash_;
+
+    // copies the position without the caches and without rehashing the boards
+    UltimateTicTacToeState(std::array<std::array<std::array<int, COLS>, ROWS>, BOARDS> board, std::array<std::array<int, COLS>, ROWS> ultimate_board, std::array<std::array<int, COLS>, ROWS> ultimate_board_terminals, int player, int last_action, uint64_t hash);
+    static uint64_t compute_hash(const std::array<std::array<std::array<int, COLS>, ROWS>, BOARDS>& board, int player, int last_action);
+    // the move itself, shared by step and apply once they checked legality
+    void apply_unchecked(int action);
+    void clear_cache();
 
     // used for caching , should not change the state
     mutable std::vector<bool> legal_actions_;
@@ -0,0 +1,142 @@
+#ifndef RL_GAMES_ULTIMATE_TICTACTOE_BB_HPP_
+#define RL_GAMES_ULTIMATE_TICTACTOE_BB_HPP_
+
+// Value-type Ultimate TicTacToe for the compile-time searches in
+// players/bandits/static, every small board a 9 bit mask per player.
+// UltimateTicTacToeState stays the source of truth for the rules; this must
+// agree with it move for move (run/bench_static_mcts.cpp diff checks that).
+
+#include <cstdint>
+#include <string>
+#include <common/bits.hpp>
+
+namespace rl::games
+{
+struct UltimateTicTacToeBB
+{
+    static constexpr int N_ACTIONS = 81;
+    static constexpr uint32_t ALL_CELLS = 0x1ff;
+
+    // Bit row * 3 + col of a small board, and of the ultimate board for board
+    // numbers, so an action is board * 9 + cell and the board it sends the
+    // opponent to is action % 9.
+    uint32_t marks[2][9]{};
+    uint32_t won[2]{};
+    // won or full, no move can be played there any more
+    uint32_t closed{ 0 };
+    int player{ 0 };
+    int last_action{ -1 };
+
+    static UltimateTicTacToeBB initial() { return UltimateTicTacToeBB(); }
+
+    // Parses UltimateTicTacToeState::to_short(), 81 cells board by board then
+    // '#' and the last action. The side to move and the won and closed boards
+    // all follow from the marks.
+    static UltimateTicTacToeBB from_short(const std::string& s)
+    {
+        UltimateTicTacToeBB b;
+        int n_marks[2]{};
+        for (int i = 0; i < N_ACTIONS; i++)
+        {
+            const int p = s[i] == 'X' ? 0 : s[i] == 'O' ? 1 : -1;
+            if (p >= 0)
+            {
+                b.marks[p][i / 9] |= 1u << (i % 9);
+                n_marks[p]++;
+            }
+        }
+        for (int board = 0; board < 9; board++)
+        {
+            for (int p = 0; p < 2; p++)
+            {
+                if (has_line(b.marks[p][board]))
+                {
+                    b.won[p] |= 1u << board;
+                }
+            }
+            if (((b.won[0] | b.won[1]) >> board & 1u) || (b.marks[0][board] | b.marks[1][board]) == ALL_CELLS)
+            {
+                b.closed |= 1u << board;
+            }
+        }
+        b.player = n_marks[0] == n_marks[1] ? 0 : 1;
+        b.last_action = std::stoi(s.substr(s.find_last_of('#') + 1));
+        return b;
+    }
+
+    static constexpr bool has_line(uint32_t mask)
+    {
+        constexpr uint32_t LINES[8] = { 0007, 0070, 0700, 0111, 0222, 0444, 0421, 0124 };
+        for (uint32_t line : LINES)
+        {
+            if ((mask & line) == line)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int player_turn() const { return player; }
+
+    bool is_terminal() const
+    {
+        return has_line(won[1 - player]) || closed == ALL_CELLS;
+    }
+
+    // only the player who just moved can have won, anything else is a draw
+    float get_reward() const
+    {
+        return has_line(won[1 - player]) ? -1.0f : 0.0f;
+    }
+
+    int legal_actions(int* out) const
+    {
+        int n = 0;
+        // sent to the board matching the last move's cell, unless that one is closed
+        if (last_action >= 0 && !(closed >> (last_action % 9) & 1u))
+        {
+            add_board_actions(last_action % 9, out, n);
+            return n;
+        }
+        for (int board = 0; board < 9; board++)
+        {
+            if (!(closed >> board & 1u))
+            {
+                add_board_actions(board, out, n);
+            }
+        }
+        return n;
+    }
+
+    void apply(int action)
+    {
+        const int board = action / 9;
+        uint32_t& own = marks[player][board];
+        own |= 1u << (action % 9);
+        if (has_line(own))
+        {
+            won[player] |= 1u << board;
+            closed |= 1u << board;
+        }
+        else if ((own | marks[1 - player][board]) == ALL_CELLS)
+        {
+            closed |= 1u << board;
+        }
+        last_action = action;
+        player = 1 - player;
+    }
+
+private:
+    void add_board_actions(int board, int* out, int& n) const
+    {
+        const uint64_t empty = ~(marks[0][board] | marks[1][board]) & ALL_CELLS;
+        for (uint64_t b = empty; b; b &= b - 1)
+        {
+            out[n++] = board * 9 + rl::common::bits::ctz64(b);
+        }
+    }
+};
+} // namespace rl::games
+
+#endif
@@ -34,6 +34,14 @@ private:
     int current_player_;
     Walls walls_;
     Positions positions_;
+    uint64_t hash_;
+
+    // copies the position without the caches and without rehashing the board
+    WallsState(Walls walls, Positions positions, int current_player, uint64_t hash);
+    static uint64_t compute_hash(const Walls& walls, const Positions& positions, int current_player);
+    // the move itself, shared by step and apply once they checked legality
+    void apply_unchecked(int action);
+    void clear_cache();
 
     // chache
     mutable std::vector<bool> cached_actions_masks_{};
@@ -56,6 +64,7 @@ public:
     std::unique_ptr<rl::common::IState> reset() const override;
 
     std::unique_ptr<WallsState> step_state(int action) const;
+    void apply(int action) override;
     std::unique_ptr<rl::common::IState> step(int action) const override;
 
     void render() const override;
@@ -64,15 +73,21 @@ public:
     float get_reward() const override;
 
     std::vector<float> get_observation() const override;
+    void write_observation(float* out) const override;
 
     std::string to_short() const override;
 
+    uint64_t hash() const override;
+    size_t memory_bytes() const override;
+    std::string game_name() const override;
+
     std::array<int, 3> get_observation_shape() const override;
 
     int get_n_actions() const override;
 
     int player_turn() const override;
     std::vector<bool> actions_mask() const override;
+    void legal_actions_bitset(uint64_t* out_words) const override;
     std::unique_ptr<WallsState> clone_state() const;
     std::unique_ptr<rl::common::IState> clone() const override;
     void get_symmetrical_obs_and_actions(std::vector<float> const& obs, std::vector<float> const& actions_distribution, std::vector<std::vector<float>>& out_syms, std::vector<std::vector<float>>& out_actions_distribution)const override;
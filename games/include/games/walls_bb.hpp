@@ -0,0 +1,129 @@
+#ifndef RL_GAMES_WALLS_BB_HPP_
+#define RL_GAMES_WALLS_BB_HPP_
+
+// Value-type Walls for the compile-time searches in players/bandits/static,
+// the 7x7 walls as one 49 bit mask. WallsState stays the source of truth for
+// the rules; this must agree with it move for move (run/bench_static_mcts.cpp
+// diff checks that).
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace rl::games
+{
+namespace walls_bb
+{
+// [cell][direction] the neighbouring cell in WallsState::DIRECTIONS order, -1 off the board
+constexpr std::array<std::array<int, 8>, 49> make_neighbours()
+{
+    constexpr int DIRECTIONS[8][2] = { {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} };
+    std::array<std::array<int, 8>, 49> neighbours{};
+    for (int cell = 0; cell < 49; cell++)
+    {
+        for (int a = 0; a < 8; a++)
+        {
+            const int row = cell / 7 + DIRECTIONS[a][0];
+            const int col = cell % 7 + DIRECTIONS[a][1];
+            neighbours[cell][a] = row >= 0 && row < 7 && col >= 0 && col < 7 ? row * 7 + col : -1;
+        }
+    }
+    return neighbours;
+}
+inline constexpr std::array<std::array<int, 8>, 49> NEIGHBOURS = make_neighbours();
+} // namespace walls_bb
+
+struct WallsBB
+{
+    static constexpr int ROWS = 7;
+    static constexpr int COLS = 7;
+    static constexpr int N_DIRECTIONS = 8;
+    // jump cell * 8 + build direction, as WallsState encodes them
+    static constexpr int N_ACTIONS = ROWS * COLS * N_DIRECTIONS;
+
+    // bit row * 7 + col
+    uint64_t walls{ 0 };
+    // [0] is always the player to move, like WallsState::positions_
+    int positions[2]{ 6 * COLS + 3, 0 * COLS + 3 };
+    int player{ 0 };
+
+    static WallsBB initial() { return WallsBB(); }
+
+    // Parses WallsState::to_short(): 7 rows of '.', '=' (wall), 'X' (player 0)
+    // and 'O' (player 1), each ending in a newline, then '#' and the player.
+    static WallsBB from_short(const std::string& s)
+    {
+        WallsBB b;
+        int pawns[2]{};
+        for (int row = 0; row < ROWS; row++)
+        {
+            for (int col = 0; col < COLS; col++)
+            {
+                const char ch = s[row * (COLS + 1) + col];
+                const int cell = row * COLS + col;
+                if (ch == '=') b.walls |= 1ULL << cell;
+                if (ch == 'X') pawns[0] = cell;
+                if (ch == 'O') pawns[1] = cell;
+            }
+        }
+        b.player = std::stoi(s.substr(s.find_last_of('#') + 1));
+        b.positions[0] = pawns[b.player];
+        b.positions[1] = pawns[1 - b.player];
+        return b;
+    }
+
+    int player_turn() const { return player; }
+
+    // A jump always has the cell it left to build on, so the player to move is
+    // stuck exactly when every neighbouring cell is a wall or the opponent.
+    bool is_terminal() const
+    {
+        const uint64_t blocked = walls | (1ULL << positions[1]);
+        for (int jump : walls_bb::NEIGHBOURS[positions[0]])
+        {
+            if (jump >= 0 && !(blocked >> jump & 1ULL))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the player to move lost
+    float get_reward() const { return -1.0f; }
+
+    int legal_actions(int* out) const
+    {
+        const uint64_t blocked = walls | (1ULL << positions[1]);
+        int n = 0;
+        // neighbours come in increasing cell order, so the actions do too
+        for (int jump : walls_bb::NEIGHBOURS[positions[0]])
+        {
+            if (jump < 0 || (blocked >> jump & 1ULL))
+            {
+                continue;
+            }
+            const std::array<int, N_DIRECTIONS>& builds = walls_bb::NEIGHBOURS[jump];
+            for (int a = 0; a < N_DIRECTIONS; a++)
+            {
+                if (builds[a] >= 0 && !(blocked >> builds[a] & 1ULL))
+                {
+                    out[n++] = jump * N_DIRECTIONS + a;
+                }
+            }
+        }
+        return n;
+    }
+
+    void apply(int action)
+    {
+        const int jump = action / N_DIRECTIONS;
+        walls |= 1ULL << walls_bb::NEIGHBOURS[jump][action % N_DIRECTIONS];
+        positions[0] = positions[1];
+        positions[1] = jump;
+        player = 1 - player;
+    }
+};
+} // namespace rl::games
+
+#endif
@@ -1,17 +1,31 @@
 #include <games/damma.hpp>
 #include <common/exceptions.hpp>
+#include <common/zobrist.hpp>
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 
 namespace rl::games
 {
+// [piece][cell] for the four piece values as seen by the player to move, the
+// side to move, the cell a multi-jump continues from, and the no-capture count
+constexpr int ZOBRIST_SIDE = 4 * DammaState::ROWS * DammaState::COLS;
+constexpr int ZOBRIST_LAST_JUMP = ZOBRIST_SIDE + 1;
+constexpr int ZOBRIST_NO_CAPTURE = ZOBRIST_LAST_JUMP + DammaState::ROWS * DammaState::COLS;
+constexpr auto ZOBRIST = rl::common::zobrist::make_keys<ZOBRIST_NO_CAPTURE + DammaState::MAX_NO_CAPTURE_ROUNDS + 1>(0xda33a0c0ffee0001ULL);
 
 DammaState::DammaState(Board board, int n_no_capture_rounds, std::optional<std::pair<int, int>> last_jump, std::vector<bool> last_jump_action_mask, int current_player)
+    : DammaState(board, n_no_capture_rounds, last_jump, last_jump_action_mask, current_player, compute_hash(board, n_no_capture_rounds, last_jump, current_player))
+{
+}
+
+DammaState::DammaState(Board board, int n_no_capture_rounds, std::optional<std::pair<int, int>> last_jump, std::vector<bool> last_jump_action_mask, int current_player, uint64_t hash)
     : board_(board),
     n_no_capture_rounds_{ n_no_capture_rounds },
     last_jump_{ last_jump },
     last_jump_action_mask_(last_jump_action_mask),
     current_player_{ current_player },
+    hash_{ hash },
     cached_actions_masks_{},
     cached_is_terminal_{},
     cached_result_{},
@@ -21,6 +35,31 @@ DammaState::DammaState(Board board, int n_no_capture_rounds, std::optional<std::
 
 DammaState::~DammaState() = default;
 
+uint64_t DammaState::compute_hash(const Board& board, int n_no_capture_rounds, const std::optional<std::pair<int, int>>& last_jump, int current_player)
+{
+    uint64_t hash = current_player == 1 ? ZOBRIST[ZOBRIST_SIDE] : 0;
+    for (int row = 0; row < ROWS; row++)
+    {
+        for (int col = 0; col < COLS; col++)
+        {
+            int cell = board[row][col];
+            if (cell != EMPTY_CELL)
+            {
+                // -2, -1, 1, 2 -> 0, 1, 2, 3
+                int piece = cell < 0 ? cell + 2 : cell + 1;
+                hash ^= ZOBRIST[piece * ROWS * COLS + row * COLS + col];
+            }
+        }
+    }
+    if (last_jump.has_value())
+    {
+        auto [row, col] = last_jump.value();
+        hash ^= ZOBRIST[ZOBRIST_LAST_JUMP + row * COLS + col];
+    }
+    hash ^= ZOBRIST[ZOBRIST_NO_CAPTURE + std::min(n_no_capture_rounds, MAX_NO_CAPTURE_ROUNDS)];
+    return hash;
+}
+
 std::unique_ptr<DammaState> DammaState::initialize_state()
 {
     Board board{
@@ -92,6 +131,54 @@ std::unique_ptr<DammaState> DammaState::step_state(int action) const
         throw rl::common::IllegalActionException(ss.str());
     }
 
+    auto next_state_ptr = std::unique_ptr<DammaState>(new DammaState(board_, n_no_capture_rounds_, last_jump_, last_jump_action_mask_, current_player_, hash_));
+    next_state_ptr->apply_unchecked(action);
+    return next_state_ptr;
+}
+
+void DammaState::apply(int action)
+{
+    if (is_terminal())
+    {
+        std::stringstream ss;
+        ss << "Stepping a terminal Damma state";
+        throw rl::common::SteppingTerminalStateException(ss.str());
+    }
+    if (actions_mask().at(action) == false)
+    {
+        std::stringstream ss;
+        ss << "Stepping a Damma state with an illegal action " << action;
+        auto [row, col, target_row, target_col] = decode_action(action);
+        ss << "\nDecoded action row: " << row << " col " << col << "target row " << target_row << "target col " << target_col << "\n";
+        ss << to_short();
+        std::vector<int> legal_actions{};
+        auto am = actions_mask();
+        if (last_jump_.has_value())
+        {
+            auto [jumprow, jumpcol] = last_jump_.value();
+            ss << "\nlast jump is (" << jumprow << "," << jumpcol << ")";
+        }
+        else
+        {
+            ss << "\nno last jump , " << last_jump_action_mask_.size();
+        }
+        ss << "\nlegal actions are: ";
+        for (int a = 0; a < am.size(); a++)
+        {
+            if (am.at(action))
+            {
+                ss << a << ",";
+            }
+        }
+
+        throw rl::common::IllegalActionException(ss.str());
+    }
+
+    apply_unchecked(action);
+}
+
+void DammaState::apply_unchecked(int action)
+{
     auto [row, col, target_row, target_col] = decode_action(action);
     Board new_board = board_;
     if (new_board.at(row).at(col) <= 0)
@@ -174,7 +261,24 @@ std::unique_ptr<DammaState> DammaState::step_state(int action) const
         swap_board_view(new_board);
     }
 
-    return std::make_unique<DammaState>(new_board, new_no_capture_rounds, new_last_jump, new_last_jump_action_mask, next_player);
+    board_ = new_board;
+    n_no_capture_rounds_ = new_no_capture_rounds;
+    last_jump_ = new_last_jump;
+    last_jump_action_mask_ = std::move(new_last_jump_action_mask);
+    current_player_ = next_player;
+    // step flips the board to the mover's view, which moves every piece, so the
+    // key is rebuilt from the board rather than updated incrementally
+    hash_ = compute_hash(board_, n_no_capture_rounds_, last_jump_, current_player_);
+    clear_cache();
+}
+
+void DammaState::clear_cache()
+{
+    // clear keeps the buffers' capacity for the next ply
+    cached_actions_masks_.clear();
+    cached_is_terminal_.reset();
+    cached_result_.reset();
+    cached_observation_.clear();
 }
 
 std::unique_ptr<rl::common::IState> DammaState::step(int action) const
@@ -284,12 +388,14 @@ float DammaState::get_reward() const
 
 std::vector<float> DammaState::get_observation() const
 {
-    if (cached_observation_.size())
-    {
-        return cached_observation_;
-    }
+    std::vector<float> observation(CHANNELS * ROWS * COLS);
+    write_observation(observation.data());
+    return observation;
+}
 
-    std::vector<float> cached_observation_ = std::vector<float>(CHANNELS * ROWS * COLS, 0);
+void DammaState::write_observation(float* out) const
+{
+    std::fill_n(out, CHANNELS * ROWS * COLS, 0.0f);
     constexpr int player_0_pawn = 1;
     constexpr int player_0_king = 2;
     constexpr int player_1_pawn = -1;
@@ -304,7 +410,7 @@ std::vector<float> DammaState::get_observation() const
     {
         for (int col{ 0 }; col < COLS; col++)
         {
-            int cell_value = board_.at(row).at(col);
+            int cell_value = board_[row][col];
             int current_channel{ -1 };
             if (cell_value == player_0_pawn)
             {
@@ -331,14 +437,27 @@ std::vector<float> DammaState::get_observation() const
                 continue;
             }
             int observation_cell_id = channel_size * current_channel + row * COLS + col;
-            cached_observation_.at(observation_cell_id) = 1.0f;
+            out[observation_cell_id] = 1.0f;
         }
     }
-    add_no_capture_rounds_observation_(cached_observation_);
-    add_last_jump_observation_(cached_observation_);
-    // add_current_player_turn_observation_(cached_observation_);
+    add_no_capture_rounds_observation_(out);
+    add_last_jump_observation_(out);
+    // add_current_player_turn_observation_(out);
+}
+
+uint64_t DammaState::hash() const
+{
+    return hash_;
+}
 
-    return cached_observation_;
+size_t DammaState::memory_bytes() const
+{
+    return sizeof(*this) + last_jump_action_mask_.capacity() / 8 + cached_actions_masks_.capacity() / 8 + cached_observation_.capacity() * sizeof(float);
+}
+
+std::string DammaState::game_name() const
+{
+    return "damma";
 }
 
 std::string DammaState::to_short() const
@@ -967,7 +1086,7 @@ bool DammaState::is_draw() const
     return n_no_capture_rounds_ == MAX_NO_CAPTURE_ROUNDS;
 }
 
-void DammaState::add_no_capture_rounds_observation_(std::vector<float>& observation_out) const
+void DammaState::add_no_capture_rounds_observation_(float* observation_out) const
 {
     constexpr int no_capture_rounds_obs_channel_id = 4;
     constexpr int channel_size = ROWS * COLS;
@@ -975,11 +1094,11 @@ void DammaState::add_no_capture_rounds_observation_(std::vector<float>& observat
     constexpr int channel_end = channel_start + channel_size;
     for (int i = { channel_start }; i < channel_end; i++)
     {
-        observation_out.at(i) = static_cast<float>(n_no_capture_rounds_) / MAX_NO_CAPTURE_ROUNDS;
+        observation_out[i] = static_cast<float>(n_no_capture_rounds_) / MAX_NO_CAPTURE_ROUNDS;
     }
 }
 
-void DammaState::add_current_player_turn_observation_(std::vector<float>& observation_out) const
+void DammaState::add_current_player_turn_observation_(float* observation_out) const
 {
     constexpr int current_player_turn_channel_id{ 6 };
     constexpr int channel_size = ROWS * COLS;
@@ -989,11 +1108,11 @@ void DammaState::add_current_player_turn_observation_(std::vector<float>& observ
     int player = current_player_;
     for (int i{ channel_start }; i < channel_end; i++)
     {
-        observation_out.at(i) = player;
+        observation_out[i] = player;
     }
 }
 
-void DammaState::add_last_jump_observation_(std::vector<float>& observation_out) const
+void DammaState::add_last_jump_observation_(float* observation_out) const
 {
     if (!last_jump_.has_value())
     {
@@ -1007,7 +1126,7 @@ void DammaState::add_last_jump_observation_(std::vector<float>& observation_out)
     auto [row, col] = last_jump_.value();
 
     int cell_to_be_modified = channel_start + row * COLS + col;
-    observation_out.at(cell_to_be_modified) = 1.0f;
+    observation_out[cell_to_be_modified] = 1.0f;
 }
 
 } // namespace rl::games
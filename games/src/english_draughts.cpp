@@ -1,25 +1,81 @@
+#include <algorithm>
 #include <sstream>
 #include <cassert>
 #include <iostream>
 
 #include <games/english_draughts.hpp>
 #include <common/exceptions.hpp>
+#include <common/zobrist.hpp>
 
 namespace rl::games
 {
+// [piece][cell] for the pieces -2, -1, 1, 2, then the side to move, the cell a
+// multi-jump continues from, and the no-capture count
+constexpr int ZOBRIST_CELLS = 8 * 8;
+constexpr int ZOBRIST_SIDE = 4 * ZOBRIST_CELLS;
+constexpr int ZOBRIST_LAST_JUMP = ZOBRIST_SIDE + 1;
+constexpr int ZOBRIST_NO_CAPTURE = ZOBRIST_LAST_JUMP + ZOBRIST_CELLS;
+constexpr int ZOBRIST_MAX_NO_CAPTURE = 40;
+constexpr auto ZOBRIST = rl::common::zobrist::make_keys<ZOBRIST_NO_CAPTURE + ZOBRIST_MAX_NO_CAPTURE + 1>(0xe9d2a0575c0ffee1ULL);
+
+static uint64_t piece_key(int piece, int row, int col)
+{
+    if (piece == 0)
+    {
+        return 0;
+    }
+    // -2, -1, 1, 2 -> 0, 1, 2, 3
+    int piece_id = piece < 0 ? piece + 2 : piece + 1;
+    return ZOBRIST[piece_id * ZOBRIST_CELLS + row * 8 + col];
+}
+
+static uint64_t last_jump_key(const std::vector<int>& last_jump)
+{
+    return last_jump.size() ? ZOBRIST[ZOBRIST_LAST_JUMP + last_jump.at(0) * 8 + last_jump.at(1)] : 0;
+}
+
+static uint64_t no_capture_key(int n_no_capture_rounds)
+{
+    return ZOBRIST[ZOBRIST_NO_CAPTURE + std::min(n_no_capture_rounds, ZOBRIST_MAX_NO_CAPTURE)];
+}
+
 EnglishDraughtState::EnglishDraughtState(Board board,
     int n_no_capture_rounds,
     std::vector<bool> last_jump_actions_mask,
     std::vector<int> last_jump,
     int current_player)
+    : EnglishDraughtState(board, n_no_capture_rounds, last_jump_actions_mask, last_jump, current_player, compute_hash(board, n_no_capture_rounds, last_jump, current_player))
+{
+}
+
+EnglishDraughtState::EnglishDraughtState(Board board,
+    int n_no_capture_rounds,
+    std::vector<bool> last_jump_actions_mask,
+    std::vector<int> last_jump,
+    int current_player,
+    uint64_t hash)
     : board_(board),
     n_no_capture_rounds_{ n_no_capture_rounds },
     last_jump_actions_mask_{ last_jump_actions_mask },
     last_jump_{ last_jump },
-    current_player_{ current_player }
+    current_player_{ current_player },
+    hash_{ hash }
 {
 }
 
+uint64_t EnglishDraughtState::compute_hash(const Board& board, int n_no_capture_rounds, const std::vector<int>& last_jump, int current_player)
+{
+    uint64_t hash = current_player == 1 ? ZOBRIST[ZOBRIST_SIDE] : 0;
+    for (int row = 0; row < ROWS; row++)
+    {
+        for (int col = 0; col < COLS; col++)
+        {
+            hash ^= piece_key(board[row][col], row, col);
+        }
+    }
+    return hash ^ last_jump_key(last_jump) ^ no_capture_key(n_no_capture_rounds);
+}
+
 EnglishDraughtState::~EnglishDraughtState()
 {
 }
@@ -67,6 +123,31 @@ std::unique_ptr<EnglishDraughtState> EnglishDraughtState::step_state(int action)
         throw rl::common::IllegalActionException(ss.str());
     }
 
+    auto next_state_ptr = std::unique_ptr<EnglishDraughtState>(new EnglishDraughtState(board_, n_no_capture_rounds_, last_jump_actions_mask_, last_jump_, current_player_, hash_));
+    next_state_ptr->apply_unchecked(action);
+    return next_state_ptr;
+}
+
+void EnglishDraughtState::apply(int action)
+{
+    if (is_terminal())
+    {
+        std::stringstream ss;
+        ss << "Stepping a terminal EnglishDraught state";
+        throw rl::common::SteppingTerminalStateException(ss.str());
+    }
+    if (actions_mask().at(action) == false)
+    {
+        std::stringstream ss;
+        ss << "Stepping an EnglishDraught state with an illegal action " << action;
+        throw rl::common::IllegalActionException(ss.str());
+    }
+
+    apply_unchecked(action);
+}
+
+void EnglishDraughtState::apply_unchecked(int action)
+{
     RowColDirectionAction rcd_action = get_row_col_direction_from_action_(action);
     int target_row = rcd_action.row + rcd_action.row_direction;
     int target_col = rcd_action.col + rcd_action.col_direction;
@@ -159,7 +240,41 @@ std::unique_ptr<EnglishDraughtState> EnglishDraughtState::step_state(int action)
             new_last_jump = {};
         }
     }
-    return std::make_unique<EnglishDraughtState>(new_board, new_n_no_capture_round, new_last_jump_actions_mask, new_last_jump, next_player);
+
+    uint64_t new_hash = hash_ ^ last_jump_key(last_jump_) ^ last_jump_key(new_last_jump)
+        ^ no_capture_key(n_no_capture_rounds_) ^ no_capture_key(new_n_no_capture_round);
+    if (next_player != current_player_)
+    {
+        new_hash ^= ZOBRIST[ZOBRIST_SIDE];
+    }
+    // a move touches the source, the target and, for a capture, the landing cell
+    std::array<std::array<int, 2>, 3> touched_cells{ {
+        {rcd_action.row, rcd_action.col},
+        {target_row, target_col},
+        {target_row + rcd_action.row_direction, target_col + rcd_action.col_direction}} };
+    for (auto [row, col] : touched_cells)
+    {
+        if (row >= 0 && row < ROWS && col >= 0 && col < COLS)
+        {
+            new_hash ^= piece_key(board_[row][col], row, col) ^ piece_key(new_board[row][col], row, col);
+        }
+    }
+    board_ = new_board;
+    n_no_capture_rounds_ = new_n_no_capture_round;
+    last_jump_actions_mask_ = std::move(new_last_jump_actions_mask);
+    last_jump_ = std::move(new_last_jump);
+    current_player_ = next_player;
+    hash_ = new_hash;
+    clear_cache();
+}
+
+void EnglishDraughtState::clear_cache()
+{
+    // clear keeps the buffers' capacity for the next ply
+    cached_actions_masks_.clear();
+    cached_is_terminal_.reset();
+    cached_result_.reset();
+    cached_observation_.clear();
 }
 
 std::unique_ptr<rl::common::IState> EnglishDraughtState::step(int action) const
@@ -263,6 +378,21 @@ float EnglishDraughtState::get_reward() const
     return cached_result_.value();
 }
 
+uint64_t EnglishDraughtState::hash() const
+{
+    return hash_;
+}
+
+size_t EnglishDraughtState::memory_bytes() const
+{
+    return sizeof(*this) + last_jump_.capacity() * sizeof(int) + last_jump_actions_mask_.capacity() / 8 + cached_actions_masks_.capacity() / 8 + cached_observation_.capacity() * sizeof(float);
+}
+
+std::string EnglishDraughtState::game_name() const
+{
+    return "english_draughts";
+}
+
 std::string EnglishDraughtState::to_short() const
 {
     std::stringstream ss;
@@ -323,13 +453,14 @@ std::string EnglishDraughtState::to_short() const
 
 std::vector<float> EnglishDraughtState::get_observation() const
 {
-    if (cached_observation_.size())
-    {
-        return cached_observation_;
-    }
-    // NOTE : obviously not thread safe
+    std::vector<float> observation(CHANNELS * ROWS * COLS);
+    write_observation(observation.data());
+    return observation;
+}
 
-    std::vector<float> cached_observation_ = std::vector<float>(CHANNELS * ROWS * COLS);
+void EnglishDraughtState::write_observation(float* out) const
+{
+    std::fill_n(out, CHANNELS * ROWS * COLS, 0.0f);
     constexpr int player_0_pawn = std::get<0>(PLAYERS_P_FLAGS);
     constexpr int player_0_king = std::get<0>(PLAYERS_K_FLAGS);
     constexpr int player_1_pawn = std::get<1>(PLAYERS_P_FLAGS);
@@ -340,7 +471,7 @@ std::vector<float> EnglishDraughtState::get_observation() const
     {
         for (int col{ 0 }; col < COLS; col++)
         {
-            int cell_value = board_.at(row).at(col);
+            int cell_value = board_[row][col];
             int current_channel{ -1 };
             if (cell_value == player_0_pawn)
             {
@@ -367,15 +498,13 @@ std::vector<float> EnglishDraughtState::get_observation() const
                 continue;
             }
             int observation_cell_id = channel_size * current_channel + row * COLS + col;
-            cached_observation_.at(observation_cell_id) = 1.0f;
+            out[observation_cell_id] = 1.0f;
         }
     }
 
-    add_no_capture_rounds_observation_(cached_observation_);
-    add_last_jump_observation_(cached_observation_);
-    add_current_player_turn_observation_(cached_observation_);
-
-    return cached_observation_;
+    add_no_capture_rounds_observation_(out);
+    add_last_jump_observation_(out);
+    add_current_player_turn_observation_(out);
 }
 
 std::array<int, 3> EnglishDraughtState::get_observation_shape() const
@@ -608,7 +737,7 @@ bool EnglishDraughtState::is_draw_() const
     return n_no_capture_rounds_ == MAX_NO_CAPTURE_ROUNDS;
 }
 
-void EnglishDraughtState::add_no_capture_rounds_observation_(std::vector<float>& observation_out) const
+void EnglishDraughtState::add_no_capture_rounds_observation_(float* observation_out) const
 {
     constexpr int no_capture_rounds_obs_channel_id = 4;
     constexpr int channel_size = ROWS * COLS;
@@ -616,11 +745,11 @@ void EnglishDraughtState::add_no_capture_rounds_observation_(std::vector<float>&
     constexpr int channel_end = channel_start + channel_size;
     for (int i = { channel_start }; i < channel_end; i++)
     {
-        observation_out.at(i) = static_cast<float>(n_no_capture_rounds_) / MAX_NO_CAPTURE_ROUNDS;
+        observation_out[i] = static_cast<float>(n_no_capture_rounds_) / MAX_NO_CAPTURE_ROUNDS;
     }
 }
 
-void EnglishDraughtState::add_last_jump_observation_(std::vector<float>& observation_out) const
+void EnglishDraughtState::add_last_jump_observation_(float* observation_out) const
 {
     if (last_jump_.size() == 0)
     {
@@ -634,10 +763,10 @@ void EnglishDraughtState::add_last_jump_observation_(std::vector<float>& observa
     int row = last_jump_.at(0);
     int col = last_jump_.at(1);
     int cell_to_be_modified = channel_start + row * COLS + col;
-    observation_out.at(cell_to_be_modified) = 1.0f;
+    observation_out[cell_to_be_modified] = 1.0f;
 }
 
-void EnglishDraughtState::add_current_player_turn_observation_(std::vector<float>& observation_out) const
+void EnglishDraughtState::add_current_player_turn_observation_(float* observation_out) const
 {
     constexpr int current_player_turn_channel_id{ 6 };
     constexpr int channel_size = ROWS * COLS;
@@ -647,7 +776,7 @@ void EnglishDraughtState::add_current_player_turn_observation_(std::vector<float
     int player = current_player_;
     for (int i{ channel_start }; i < channel_end; i++)
     {
-        observation_out.at(i) = player;
+        observation_out[i] = player;
     }
 }
 
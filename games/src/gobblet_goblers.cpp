@@ -1,15 +1,31 @@
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 
 #include <games/gobblet_goblers.hpp>
 #include <common/exceptions.hpp>
+#include <common/zobrist.hpp>
 
 namespace rl::games
 {
+// [channel][cell] for the piece channels and the selected piece on the board,
+// one key per whole-board flag channel, then the side to move and the turn
+constexpr int ZOBRIST_CELL_CHANNELS = GobbletGoblersState::SELECTED_PIECE_ONBOARD_CHANNEL + 1;
+constexpr int ZOBRIST_FLAGS = ZOBRIST_CELL_CHANNELS * 9;
+constexpr int ZOBRIST_SIDE = ZOBRIST_FLAGS + GobbletGoblersState::SELECTION_PHASE_CHANNEL + 1 - ZOBRIST_CELL_CHANNELS;
+constexpr int ZOBRIST_TURN = ZOBRIST_SIDE + 1;
+constexpr auto ZOBRIST = rl::common::zobrist::make_keys<ZOBRIST_TURN + GobbletGoblersState::MAX_TURNS + 1>(0x90bb1e7c0ffee001ULL);
+
 GobbletGoblersState::GobbletGoblersState(std::array<std::array<std::array<int8_t, COLS>, ROWS>, CHANNELS> board, int8_t player, int turn)
+    : GobbletGoblersState(board, player, turn, compute_hash(board, player, turn))
+{
+}
+
+GobbletGoblersState::GobbletGoblersState(std::array<std::array<std::array<int8_t, COLS>, ROWS>, CHANNELS> board, int8_t player, int turn, uint64_t hash)
     :board_(board),
     player_{ player },
     turn_{ turn },
+    hash_{ hash },
     legal_actions_{},
     cached_observation_{},
     cached_is_terminal_{},
@@ -17,6 +33,32 @@ GobbletGoblersState::GobbletGoblersState(std::array<std::array<std::array<int8_t
 {
 }
 
+uint64_t GobbletGoblersState::compute_hash(std::array<std::array<std::array<int8_t, COLS>, ROWS>, CHANNELS> const& board, int player, int turn)
+{
+    uint64_t hash = player == 1 ? ZOBRIST[ZOBRIST_SIDE] : 0;
+    for (int channel = 0; channel < ZOBRIST_CELL_CHANNELS; channel++)
+    {
+        for (int row = 0; row < ROWS; row++)
+        {
+            for (int col = 0; col < COLS; col++)
+            {
+                if (board[channel][row][col])
+                {
+                    hash ^= ZOBRIST[channel * ROWS * COLS + row * COLS + col];
+                }
+            }
+        }
+    }
+    for (int channel = ZOBRIST_CELL_CHANNELS; channel <= SELECTION_PHASE_CHANNEL; channel++)
+    {
+        if (board[channel][0][0])
+        {
+            hash ^= ZOBRIST[ZOBRIST_FLAGS + channel - ZOBRIST_CELL_CHANNELS];
+        }
+    }
+    return hash ^ ZOBRIST[ZOBRIST_TURN + std::min(turn, MAX_TURNS)];
+}
+
 std::unique_ptr<GobbletGoblersState> GobbletGoblersState::initialize_state()
 {
     std::array<std::array<std::array<int8_t, COLS>, ROWS>, CHANNELS> array{};
@@ -52,6 +94,23 @@ std::unique_ptr<GobbletGoblersState> GobbletGoblersState::step_state(int action)
         throw rl::common::SteppingTerminalStateException("");
     }
 
+    auto next_state_ptr = std::unique_ptr<GobbletGoblersState>(new GobbletGoblersState(board_, player_, turn_, hash_));
+    next_state_ptr->apply_unchecked(action);
+    return next_state_ptr;
+}
+
+void GobbletGoblersState::apply(int action)
+{
+    if (!actions_mask().at(action))
+    {
+        throw rl::common::SteppingTerminalStateException("");
+    }
+
+    apply_unchecked(action);
+}
+
+void GobbletGoblersState::apply_unchecked(int action)
+{
     int current_player = player_;
     int opponent = 1 - current_player;
     int is_selection_phase = board_.at(SELECTION_PHASE_CHANNEL).at(0).at(0);
@@ -175,7 +234,22 @@ std::unique_ptr<GobbletGoblersState> GobbletGoblersState::step_state(int action)
     {
         fill_channel(new_board, SELECTION_PHASE_CHANNEL, static_cast<int>(static_cast<bool>(new_is_selection_phase)));
     }
-    return std::make_unique<GobbletGoblersState>(new_board, new_player, new_turn);
+    board_ = new_board;
+    player_ = new_player;
+    turn_ = new_turn;
+    // step swaps the two players' channels every turn, so the key is rebuilt
+    // from the board rather than updated incrementally
+    hash_ = compute_hash(board_, player_, turn_);
+    clear_cache();
+}
+
+void GobbletGoblersState::clear_cache()
+{
+    // clear keeps the buffers' capacity for the next ply
+    legal_actions_.clear();
+    cached_is_terminal_.reset();
+    cached_result_.reset();
+    cached_observation_.clear();
 }
 
 std::unique_ptr<rl::common::IState> GobbletGoblersState::step(int action) const
@@ -633,8 +707,19 @@ std::vector<float> GobbletGoblersState::get_observation() const
         return cached_observation_;
     }
 
+    std::vector<float> observation(OBSERVATION_SIZE);
+    write_observation(observation.data());
+    cached_observation_ = observation;
+    return cached_observation_;
+}
 
-    cached_observation_.resize(CHANNELS * ROWS * COLS);
+void GobbletGoblersState::write_observation(float* out) const
+{
+    if (cached_observation_.size())
+    {
+        std::copy(cached_observation_.begin(), cached_observation_.end(), out);
+        return;
+    }
 
     // copy the all channels except turn
     for (int channel = 0;channel < CHANNELS;channel++)
@@ -648,7 +733,7 @@ std::vector<float> GobbletGoblersState::get_observation() const
             for (int col = 0;col < COLS;col++)
             {
                 int cell = channel * ROWS * COLS + row * COLS + col;
-                cached_observation_.at(cell) = board_.at(channel).at(row).at(col);
+                out[cell] = board_[channel][row][col];
             }
         }
     }
@@ -658,11 +743,24 @@ std::vector<float> GobbletGoblersState::get_observation() const
         for (int col = 0;col < COLS;col++)
         {
             int cell = TURN_CHANNEL * ROWS * COLS + row * COLS + col;
-            cached_observation_.at(cell) = turn_ / static_cast<float>(MAX_TURNS);
+            out[cell] = turn_ / static_cast<float>(MAX_TURNS);
         }
     }
+}
 
-    return cached_observation_;
+uint64_t GobbletGoblersState::hash() const
+{
+    return hash_;
+}
+
+size_t GobbletGoblersState::memory_bytes() const
+{
+    return sizeof(*this) + legal_actions_.capacity() / 8 + cached_observation_.capacity() * sizeof(float);
+}
+
+std::string GobbletGoblersState::game_name() const
+{
+    return "gobblet";
 }
 
 std::string GobbletGoblersState::to_short() const
@@ -955,6 +1053,30 @@ void GobbletGoblersState::get_symmetrical_obs_and_actions(std::vector<float> con
     }
 }
 
+int GobbletGoblersState::n_symmetries() const
+{
+    return 3;
+}
+
+void GobbletGoblersState::write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const
+{
+    using namespace gobblet_syms;
+    // same order as get_symmetrical_obs_and_actions
+    static const std::array<decltype(&FIRST_OBS_SYM), 3> OBS_SYMS{ { &FIRST_OBS_SYM, &SECOND_OBS_SYM, &THIRD_OBS_SYM } };
+    static const std::array<decltype(&FIRST_ACTIONS), 3> ACTIONS_SYMS{ { &FIRST_ACTIONS, &SECOND_ACTIONS, &THIRD_ACTIONS } };
+
+    const auto& obs_sym = *OBS_SYMS.at(symmetry);
+    for (size_t i = 0; i < obs_sym.size(); i++)
+    {
+        out_obs[i] = obs[obs_sym[i]];
+    }
+    const auto& actions_sym = *ACTIONS_SYMS.at(symmetry);
+    for (size_t i = 0; i < actions_sym.size(); i++)
+    {
+        out_actions_distribution[i] = actions_distribution[actions_sym[i]];
+    }
+}
+
 std::array<std::array<int, 3>, 3> GobbletGoblersState::get_board() const
 {
     std::array<std::array<int, COLS>, ROWS> top_board{};
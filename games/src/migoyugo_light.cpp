@@ -1,6 +1,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <iomanip>
+#include <algorithm>
 #include <iostream>
 #include <array>
 #include <string>
@@ -12,6 +13,8 @@
 #include <games/migoyugo_light.hpp>
 #include <games/migoyugo.hpp>
 #include <common/exceptions.hpp>
+#include <common/zobrist.hpp>
+#include <common/bits.hpp>
 
 
 namespace rl::games
@@ -27,12 +30,46 @@ inline int ctz64(uint64_t x) {
     return __builtin_ctzll(x);
 #endif
 }
+// [piece][cell] for the pieces -2, -1, 1, 2, then the side to move
+constexpr int ZOBRIST_SIDE = 4 * 64;
+constexpr auto ZOBRIST = rl::common::zobrist::make_keys<ZOBRIST_SIDE + 1>(0x3190a0911900c0f1ULL);
+
+static uint64_t piece_key(int piece, int row, int col)
+{
+    if (piece == 0)
+    {
+        return 0;
+    }
+    // -2, -1, 1, 2 -> 0, 1, 2, 3
+    int piece_id = piece < 0 ? piece + 2 : piece + 1;
+    return ZOBRIST[piece_id * 64 + row * 8 + col];
+}
+
 MigoyugoLightState::MigoyugoLightState(std::array<std::array<int8_t, COLS>, ROWS> board, int player, int step, int last_action)
+    : MigoyugoLightState(board, player, step, last_action, compute_hash(board, player))
+{
+}
+
+MigoyugoLightState::MigoyugoLightState(std::array<std::array<int8_t, COLS>, ROWS> board, int player, int step, int last_action, uint64_t hash)
     : board_(board),
     current_player_(player),
     step_(step),
-    last_action_(last_action)
+    last_action_(last_action),
+    hash_(hash)
+{
+}
+
+uint64_t MigoyugoLightState::compute_hash(std::array<std::array<int8_t, COLS>, ROWS> const& board, int player)
 {
+    uint64_t hash = player == 1 ? ZOBRIST[ZOBRIST_SIDE] : 0;
+    for (int row = 0; row < ROWS; row++)
+    {
+        for (int col = 0; col < COLS; col++)
+        {
+            hash ^= piece_key(board[row][col], row, col);
+        }
+    }
+    return hash;
 }
 
 MigoyugoLightState::~MigoyugoLightState() = default;
@@ -128,6 +165,31 @@ std::unique_ptr<MigoyugoLightState> MigoyugoLightState::step_state(int action) c
         throw rl::common::IllegalActionException(ss.str());
     }
 
+    auto next_state_ptr = std::unique_ptr<MigoyugoLightState>(new MigoyugoLightState(board_, current_player_, step_, last_action_, hash_));
+    next_state_ptr->apply_unchecked(action);
+    return next_state_ptr;
+}
+
+void MigoyugoLightState::apply(int action)
+{
+    if (is_terminal())
+    {
+        throw rl::common::SteppingTerminalStateException("Trying to step a terminal state");
+    }
+    auto am = actions_mask_2();
+    bool action_legality = am.at(action);
+    if (action_legality == false)
+    {
+        std::stringstream ss;
+        ss << "Trying to perform an illegal action of " << action;
+        throw rl::common::IllegalActionException(ss.str());
+    }
+
+    apply_unchecked(action);
+}
+
+void MigoyugoLightState::apply_unchecked(int action)
+{
     int player = current_player_;
     int other = 1 - player;
 
@@ -190,7 +252,31 @@ std::unique_ptr<MigoyugoLightState> MigoyugoLightState::step_state(int action) c
         new_board[row_id][col_id] = (current_player_ == 0) ? 1 : -1;
     }
 
-    return std::make_unique<MigoyugoLightState>(new_board, other, step_ + 1, action);
+    // the placed piece, and any of the mover's migos a new yugo cleared
+    uint64_t new_hash = hash_ ^ ZOBRIST[ZOBRIST_SIDE] ^ piece_key(new_board[row_id][col_id], row_id, col_id);
+    for (int i = 0; i < change_count; ++i) {
+        auto& cell = change_buffer[i];
+        if (new_board[cell.first][cell.second] != board_[cell.first][cell.second]) {
+            new_hash ^= piece_key(board_[cell.first][cell.second], cell.first, cell.second);
+        }
+    }
+    board_ = new_board;
+    current_player_ = other;
+    step_++;
+    last_action_ = action;
+    hash_ = new_hash;
+    clear_cache();
+}
+
+void MigoyugoLightState::clear_cache()
+{
+    // clear keeps the buffers' capacity for the next ply
+    cached_actions_masks_.clear();
+    cached_actions_masks_2_.clear();
+    cached_is_terminal_.reset();
+    cached_result_.reset();
+    cached_observation_.clear();
+    cached_short_.reset();
 }
 
 
@@ -309,7 +395,15 @@ std::unique_ptr<MigoyugoLightState> MigoyugoLightState::step_state_light(int act
         update_out.black_added.push_back(get_feature_id(row_id, col_id, migo_piece, 1));
     }
 
-    return std::make_unique<MigoyugoLightState>(new_board, other, step_ + 1, action);
+    // the placed piece, and any of the mover's migos a new yugo cleared
+    uint64_t new_hash = hash_ ^ ZOBRIST[ZOBRIST_SIDE] ^ piece_key(new_board[row_id][col_id], row_id, col_id);
+    for (int i = 0; i < change_count; ++i) {
+        auto& cell = change_buffer[i];
+        if (new_board[cell.first][cell.second] != board_[cell.first][cell.second]) {
+            new_hash ^= piece_key(board_[cell.first][cell.second], cell.first, cell.second);
+        }
+    }
+    return std::unique_ptr<MigoyugoLightState>(new MigoyugoLightState(new_board, other, step_ + 1, action, new_hash));
 }
 void MigoyugoLightState::render() const
 {
@@ -580,37 +674,10 @@ std::vector<bool> MigoyugoLightState::actions_mask() const
 {
     if (!cached_actions_masks_.empty()) return cached_actions_masks_;
 
-    std::vector<bool> result(get_n_actions(), true);
-
-    constexpr std::array<std::array<std::pair<int, int>, 2>, 4> directions = { {
-   {{ {0, 1}, {0, -1} }},
-   {{ {1, 0}, {-1, 0} }},
-   {{ {1, 1}, {-1, -1} }},
-   {{ {1, -1}, {-1, 1} }}
-        } };
-
+    std::vector<bool> result(get_n_actions(), false);
     for (int row = 0; row < ROWS; row++) {
         for (int col = 0; col < COLS; col++) {
-            int action = row * COLS + col;
-
-            if (board_[row][col] != 0) {
-                result[action] = false;
-                continue;
-            }
-
-            // Check all 4 axes using the unified helper
-            for (const auto& axis : directions) {
-                int total_streak = 0;
-                for (const auto& dir : axis) {
-                    total_streak += get_streak_count(row, col, dir.first, dir.second, current_player_);
-                }
-
-                // Rule: Line of 5 or more (3 existing + 1 placed + 1 more) is illegal
-                if (total_streak >= 4) {
-                    result[action] = false;
-                    break;
-                }
-            }
+            result[row * COLS + col] = is_legal_placement(row, col);
         }
     }
     cached_actions_masks_ = result;
@@ -659,6 +726,37 @@ std::vector<int> MigoyugoLightState::actions_mask_2() const
 }
 
 // This is the only streak helper you need in the class
+bool MigoyugoLightState::is_legal_placement(int row, int col) const
+{
+    constexpr std::array<std::array<std::pair<int, int>, 2>, 4> directions = { {
+   {{ {0, 1}, {0, -1} }},
+   {{ {1, 0}, {-1, 0} }},
+   {{ {1, 1}, {-1, -1} }},
+   {{ {1, -1}, {-1, 1} }}
+        } };
+
+    if (board_[row][col] != 0) return false;
+    for (const auto& axis : directions) {
+        int total_streak = 0;
+        for (const auto& dir : axis) {
+            total_streak += get_streak_count(row, col, dir.first, dir.second, current_player_);
+        }
+        // Rule: Line of 5 or more (3 existing + 1 placed + 1 more) is illegal
+        if (total_streak >= 4) return false;
+    }
+    return true;
+}
+
+void MigoyugoLightState::legal_actions_bitset(uint64_t* out_words) const
+{
+    std::fill_n(out_words, rl::common::bits::n_words(N_ACTIONS), 0ULL);
+    for (int row = 0; row < ROWS; row++) {
+        for (int col = 0; col < COLS; col++) {
+            if (is_legal_placement(row, col)) rl::common::bits::set_bit(out_words, row * COLS + col);
+        }
+    }
+}
+
 int MigoyugoLightState::get_streak_count(int row, int col, int row_dir, int col_dir, int player) const
 {
     int count = 0;
@@ -791,6 +889,21 @@ std::unique_ptr<rl::common::IState> MigoyugoLightState::clone() const
     return clone_state();
 }
 
+uint64_t MigoyugoLightState::hash() const
+{
+    return hash_;
+}
+
+size_t MigoyugoLightState::memory_bytes() const
+{
+    return sizeof(*this) + cached_actions_masks_.capacity() / 8 + cached_actions_masks_2_.capacity() * sizeof(int) + cached_observation_.capacity() * sizeof(float);
+}
+
+std::string MigoyugoLightState::game_name() const
+{
+    return "migoyugo_light";
+}
+
 std::string MigoyugoLightState::to_short() const
 {
     if (cached_short_.has_value())
@@ -897,6 +1010,30 @@ void MigoyugoLightState::get_symmetrical_obs_and_actions(
     add_symmetry(ANTI_TRANSPOSE_OBS_SYM, ANTI_TRANSPOSE_ACTIONS_SYM);
 }
 
+int MigoyugoLightState::n_symmetries() const
+{
+    return 7;
+}
+
+void MigoyugoLightState::write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const
+{
+    using namespace miguyugo_syms;
+    // same order as get_symmetrical_obs_and_actions
+    static const std::array<decltype(&ROT90_OBS_SYM), 7> OBS_SYMS{ { &ROT90_OBS_SYM, &ROT180_OBS_SYM, &ROT270_OBS_SYM, &FLIP_LR_OBS_SYM, &FLIP_UD_OBS_SYM, &TRANSPOSE_OBS_SYM, &ANTI_TRANSPOSE_OBS_SYM } };
+    static const std::array<decltype(&ROT90_ACTIONS_SYM), 7> ACTIONS_SYMS{ { &ROT90_ACTIONS_SYM, &ROT180_ACTIONS_SYM, &ROT270_ACTIONS_SYM, &FLIP_LR_ACTIONS_SYM, &FLIP_UD_ACTIONS_SYM, &TRANSPOSE_ACTIONS_SYM, &ANTI_TRANSPOSE_ACTIONS_SYM } };
+
+    const auto& obs_sym = *OBS_SYMS.at(symmetry);
+    for (size_t i = 0; i < obs_sym.size(); i++)
+    {
+        out_obs[i] = obs[obs_sym[i]];
+    }
+    const auto& actions_sym = *ACTIONS_SYMS.at(symmetry);
+    for (size_t i = 0; i < actions_sym.size(); i++)
+    {
+        out_actions_distribution[i] = actions_distribution[actions_sym[i]];
+    }
+}
+
 std::vector<float> MigoyugoLightState::get_observation() const
 {
     if (cached_observation_.size())
@@ -904,10 +1041,21 @@ std::vector<float> MigoyugoLightState::get_observation() const
         return cached_observation_;
     }
 
-    int player = current_player_;
-    std::vector<float> true_obs;
+    std::vector<float> true_obs(CHANNELS * ROWS * COLS);
+    write_observation(true_obs.data());
+    cached_observation_ = true_obs;
+    return true_obs;
+}
+
+void MigoyugoLightState::write_observation(float* out) const
+{
+    if (cached_observation_.size())
+    {
+        std::copy(cached_observation_.begin(), cached_observation_.end(), out);
+        return;
+    }
 
-    true_obs.resize(CHANNELS * ROWS * COLS, 0);
+    int player = current_player_;
     int index = 0;
 
     for (size_t channel = 0; channel < CHANNELS; channel++)
@@ -957,17 +1105,11 @@ std::vector<float> MigoyugoLightState::get_observation() const
                 }
 
 
-                if (board_.at(row).at(col) == channel_flag)
-                {
-                    true_obs.at(index) = 1.0;
-                }
+                out[index] = board_[row][col] == channel_flag ? 1.0f : 0.0f;
                 index++;
             }
         }
     }
-
-    cached_observation_ = true_obs;
-    return true_obs;
 }
 
 
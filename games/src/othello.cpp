@@ -4,10 +4,21 @@
 #include <iostream>
 #include <games/othello.hpp>
 #include <common/exceptions.hpp>
+#include <common/zobrist.hpp>
 
 namespace rl::games
 {
+// [player][cell] discs, then the side to move and the consecutive skip count
+constexpr int ZOBRIST_SIDE = 2 * 64;
+constexpr int ZOBRIST_SKIPS = ZOBRIST_SIDE + 1;
+constexpr auto ZOBRIST = rl::common::zobrist::make_keys<ZOBRIST_SKIPS + 3>(0x0a7e110c0ffee001ULL);
+
 OthelloState::OthelloState(std::array<std::array<std::array<int8_t, COLS>, ROWS>, N_PLAYERS> observation, int player, int consecutive_skips)
+    : OthelloState(observation, player, consecutive_skips, compute_hash(observation, player, consecutive_skips))
+{
+}
+
+OthelloState::OthelloState(std::array<std::array<std::array<int8_t, COLS>, ROWS>, N_PLAYERS> observation, int player, int consecutive_skips, uint64_t hash)
     : observation_(observation),
     current_player_(player),
     n_consecutive_skips_(consecutive_skips),
@@ -15,8 +26,32 @@ OthelloState::OthelloState(std::array<std::array<std::array<int8_t, COLS>, ROWS>
     is_terminal_cached_(false),
     is_terminal_(false),
     is_result_cached_(false),
-    cached_result_(false)
+    cached_result_(false),
+    hash_(hash)
+{
+}
+
+uint64_t OthelloState::compute_hash(const std::array<std::array<std::array<int8_t, COLS>, ROWS>, N_PLAYERS>& observation, int player, int consecutive_skips)
 {
+    uint64_t hash = ZOBRIST[ZOBRIST_SKIPS + consecutive_skips];
+    if (player == 1)
+    {
+        hash ^= ZOBRIST[ZOBRIST_SIDE];
+    }
+    for (int p = 0; p < N_PLAYERS; p++)
+    {
+        for (int row = 0; row < ROWS; row++)
+        {
+            for (int col = 0; col < COLS; col++)
+            {
+                if (observation[p][row][col])
+                {
+                    hash ^= ZOBRIST[p * ROWS * COLS + row * COLS + col];
+                }
+            }
+        }
+    }
+    return hash;
 }
 
 OthelloState::~OthelloState() = default;
@@ -63,8 +98,7 @@ std::unique_ptr<OthelloState> OthelloState::step_state(int action) const
     {
         throw rl::common::SteppingTerminalStateException("Trying to step a terminal state");
     }
-    actions_legality_ = actions_mask();
-    bool action_legality = actions_legality_[action];
+    bool action_legality = actions_mask()[action];
     if (action_legality == false)
     {
         std::stringstream ss;
@@ -72,20 +106,48 @@ std::unique_ptr<OthelloState> OthelloState::step_state(int action) const
         throw rl::common::IllegalActionException(ss.str());
     }
 
+    auto next_state_ptr = std::unique_ptr<OthelloState>(new OthelloState(observation_, current_player_, n_consecutive_skips_, hash_));
+    next_state_ptr->apply_unchecked(action);
+    return next_state_ptr;
+}
+
+void OthelloState::apply(int action)
+{
+    if (is_terminal())
+    {
+        throw rl::common::SteppingTerminalStateException("Trying to step a terminal state");
+    }
+    bool action_legality = actions_mask()[action];
+    if (action_legality == false)
+    {
+        std::stringstream ss;
+        ss << "Trying to perform an illegal action of " << action;
+        throw rl::common::IllegalActionException(ss.str());
+    }
+    apply_unchecked(action);
+}
+
+void OthelloState::apply_unchecked(int action)
+{
     int player = current_player_;
     int other = 1 - player;
 
-    std::array<std::array<std::array<int8_t, COLS>, ROWS>, 2> new_obs(observation_);
+    hash_ ^= ZOBRIST[ZOBRIST_SIDE] ^ ZOBRIST[ZOBRIST_SKIPS + n_consecutive_skips_];
 
     // check if action is a skip action which is 64
     constexpr int skip_action_number = ROWS * COLS;
     if (action == skip_action_number)
     {
-        // return new state with an increased number to consecutive skips by 1
-        return std::make_unique<OthelloState>(new_obs, other, n_consecutive_skips_ + 1);
+        // increase the number of consecutive skips by 1
+        n_consecutive_skips_++;
+        hash_ ^= ZOBRIST[ZOBRIST_SKIPS + n_consecutive_skips_];
+        current_player_ = other;
+        clear_cache();
+        return;
     }
 
-    int skips = 0;
+    n_consecutive_skips_ = 0;
+    hash_ ^= ZOBRIST[ZOBRIST_SKIPS + n_consecutive_skips_];
 
     // turn action into (row,col) action
     int row_id = action / COLS;
@@ -104,14 +166,27 @@ std::unique_ptr<OthelloState> OthelloState::step_state(int action) const
         const int& cell_col = cell.second;
 
         // let our player update his cell value
-        new_obs[player][cell_row][cell_col] = 1;
+        observation_[player][cell_row][cell_col] = 1;
 
         // let the other player remove the cell value
-        new_obs[other][cell_row][cell_col] = 0;
+        observation_[other][cell_row][cell_col] = 0;
+
+        int cell_id = cell_row * COLS + cell_col;
+        hash_ ^= ZOBRIST[player * ROWS * COLS + cell_id] ^ ZOBRIST[other * ROWS * COLS + cell_id];
     }
 
-    new_obs[player][row_id][col_id] = 1;
-    return std::make_unique<OthelloState>(new_obs, other, skips);
+    observation_[player][row_id][col_id] = 1;
+    hash_ ^= ZOBRIST[player * ROWS * COLS + action];
+    current_player_ = other;
+    clear_cache();
+}
+
+void OthelloState::clear_cache()
+{
+    // clear keeps the mask's capacity for the next ply
+    actions_legality_.clear();
+    is_terminal_cached_ = false;
+    is_result_cached_ = false;
 }
 
 std::unique_ptr<rl::common::IState> OthelloState::step(int action) const
@@ -217,36 +292,40 @@ std::vector<bool> OthelloState::actions_mask() const
 }
 std::vector<float> OthelloState::get_observation() const
 {
-    int player = current_player_;
-    std::vector<float> true_obs;
-    true_obs.reserve(N_PLAYERS * ROWS * COLS);
-    if (player == 0)
+    std::vector<float> true_obs(N_PLAYERS * ROWS * COLS);
+    write_observation(true_obs.data());
+    return true_obs;
+}
+
+void OthelloState::write_observation(float* out) const
+{
+    // the current player's channel comes first
+    for (int i{ 0 }; i < N_PLAYERS; i++)
     {
-        for (int channel{ 0 }; channel < N_PLAYERS; channel++)
+        int channel = current_player_ == 0 ? i : N_PLAYERS - 1 - i;
+        for (int row{ 0 }; row < ROWS; row++)
         {
-            for (int row{ 0 }; row < ROWS; row++)
+            for (int col{ 0 }; col < COLS; col++)
             {
-                for (int col{ 0 }; col < COLS; col++)
-                {
-                    true_obs.emplace_back(float(observation_[channel][row][col]));
-                }
+                *out++ = float(observation_[channel][row][col]);
             }
         }
     }
-    else
-    { // reverse , start from player 2 then move to player 1
-        for (int channel{ N_PLAYERS - 1 }; channel >= 0; channel--)
-        {
-            for (int row{ 0 }; row < ROWS; row++)
-            {
-                for (int col{ 0 }; col < COLS; col++)
-                {
-                    true_obs.emplace_back(float(observation_[channel][row][col]));
-                }
-            }
-        }
-    }
-    return true_obs;
+}
+
+uint64_t OthelloState::hash() const
+{
+    return hash_;
+}
+
+size_t OthelloState::memory_bytes() const
+{
+    return sizeof(*this) + actions_legality_.capacity() / 8;
+}
+
+std::string OthelloState::game_name() const
+{
+    return "othello";
 }
 
 std::string OthelloState::to_short() const
@@ -547,4 +626,28 @@ void OthelloState::get_symmetrical_obs_and_actions(std::vector<float> const& obs
         third_actions.emplace_back(value);
     }
 }
+
+int OthelloState::n_symmetries() const
+{
+    return 3;
+}
+
+void OthelloState::write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const
+{
+    using namespace othello_syms;
+    // same order as get_symmetrical_obs_and_actions
+    static const std::array<decltype(&FIRST_OBS_SYM), 3> OBS_SYMS{ { &FIRST_OBS_SYM, &SECOND_OBS_SYM, &THIRD_OBS_SYM } };
+    static const std::array<decltype(&FIRST_ACTIONS_SYM), 3> ACTIONS_SYMS{ { &FIRST_ACTIONS_SYM, &SECOND_ACTIONS_SYM, &THIRD_ACTIONS_SYM } };
+
+    const auto& obs_sym = *OBS_SYMS.at(symmetry);
+    for (size_t i = 0; i < obs_sym.size(); i++)
+    {
+        out_obs[i] = obs[obs_sym[i]];
+    }
+    const auto& actions_sym = *ACTIONS_SYMS.at(symmetry);
+    for (size_t i = 0; i < actions_sym.size(); i++)
+    {
+        out_actions_distribution[i] = actions_distribution[actions_sym[i]];
+    }
+}
 } // namespace rl::games
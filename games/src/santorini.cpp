@@ -1,23 +1,87 @@
 #include <games/santorini.hpp>
 #include <common/exceptions.hpp>
+#include <common/zobrist.hpp>
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <array>
 
 namespace rl::games
 {
+// [player][cell] workers, [level - 1][cell] buildings, then the side to move,
+// the phase, the winning move flag and the selected cell. The turn counter is
+// left out: past placement it changes nothing, and during placement it follows
+// from the number of workers on the board.
+constexpr int ZOBRIST_BUILDINGS = 2 * 25;
+constexpr int ZOBRIST_SIDE = ZOBRIST_BUILDINGS + 4 * 25;
+constexpr int ZOBRIST_PHASE = ZOBRIST_SIDE + 1;
+constexpr int ZOBRIST_WINNING = ZOBRIST_PHASE + 4;
+constexpr int ZOBRIST_SELECTION = ZOBRIST_WINNING + 1;
+constexpr auto ZOBRIST = rl::common::zobrist::make_keys<ZOBRIST_SELECTION + 25>(0x5a9702190000e001ULL);
+
+static uint64_t worker_key(int player, int row, int col)
+{
+    return ZOBRIST[player * 25 + row * 5 + col];
+}
+
+static uint64_t building_key(int level, int row, int col)
+{
+    return level == 0 ? 0 : ZOBRIST[ZOBRIST_BUILDINGS + (level - 1) * 25 + row * 5 + col];
+}
+
+// everything but the two boards
+static uint64_t status_key(SantoriniPhase phase, bool is_winning_move, int player, const std::optional<std::pair<int, int>>& selection)
+{
+    uint64_t key = ZOBRIST[ZOBRIST_PHASE + static_cast<int>(phase)];
+    if (is_winning_move)
+    {
+        key ^= ZOBRIST[ZOBRIST_WINNING];
+    }
+    if (player == 1)
+    {
+        key ^= ZOBRIST[ZOBRIST_SIDE];
+    }
+    if (selection.has_value())
+    {
+        key ^= ZOBRIST[ZOBRIST_SELECTION + selection->first * 5 + selection->second];
+    }
+    return key;
+}
 
 SantoriniState::SantoriniState(const Board& players, const Board& buildings, SantoriniPhase current_phase, bool is_winning_move, int turn, int current_player, std::optional<std::pair<int, int>> selection)
+    : SantoriniState(players, buildings, current_phase, is_winning_move, turn, current_player, selection, compute_hash(players, buildings, current_phase, is_winning_move, current_player, selection))
+{
+}
+
+SantoriniState::SantoriniState(const Board& players, const Board& buildings, SantoriniPhase current_phase, bool is_winning_move, int turn, int current_player, std::optional<std::pair<int, int>> selection, uint64_t hash)
     : players_(players),
     buildings_(buildings),
     current_phase_{ current_phase },
     is_winning_move_{ is_winning_move },
     turn_{ turn },
     current_player_{ current_player },
-    selection_(selection)
+    selection_(selection),
+    hash_{ hash }
 {
 }
 
+uint64_t SantoriniState::compute_hash(const Board& players, const Board& buildings, SantoriniPhase current_phase, bool is_winning_move, int current_player, const std::optional<std::pair<int, int>>& selection)
+{
+    uint64_t hash = status_key(current_phase, is_winning_move, current_player, selection);
+    for (int row = 0; row < ROWS; row++)
+    {
+        for (int col = 0; col < COLS; col++)
+        {
+            if (players[row][col] != 0)
+            {
+                hash ^= worker_key(players[row][col] == 1 ? 0 : 1, row, col);
+            }
+            hash ^= building_key(buildings[row][col], row, col);
+        }
+    }
+    return hash;
+}
+
 SantoriniState::~SantoriniState() = default;
 
 std::unique_ptr<SantoriniState> SantoriniState::initialize_state()
@@ -70,37 +134,64 @@ std::unique_ptr<SantoriniState> SantoriniState::step_state(int action) const
         throw rl::common::IllegalActionException(ss.str());
     }
 
+    auto next_state_ptr = std::unique_ptr<SantoriniState>(new SantoriniState(players_, buildings_, current_phase_, is_winning_move_, turn_, current_player_, selection_, hash_));
+    next_state_ptr->apply_unchecked(action);
+    return next_state_ptr;
+}
+
+void SantoriniState::apply(int action)
+{
+    if (is_terminal())
+    {
+        std::stringstream ss;
+        ss << "Stepping a terminal Santorini state";
+        throw rl::common::SteppingTerminalStateException(ss.str());
+    }
+
+    if (actions_mask().at(action) == false)
+    {
+        std::stringstream ss;
+        ss << "Stepping a santorini state with an illegal action " << action << "\n";
+        get_current_state_status(ss);
+        throw rl::common::IllegalActionException(ss.str());
+    }
+    apply_unchecked(action);
+}
+
+void SantoriniState::apply_unchecked(int action)
+{
     auto [row, col] = decode_action(action);
+    hash_ ^= status_key(current_phase_, is_winning_move_, current_player_, selection_);
     if (current_phase_ == SantoriniPhase::placement)
     {
-        Board new_players(players_);
         if (current_player_ == 0)
         {
-            new_players.at(row).at(col) = 1;
+            players_.at(row).at(col) = 1;
         }
         else
         {
-            new_players.at(row).at(col) = -1;
+            players_.at(row).at(col) = -1;
         }
+        hash_ ^= worker_key(current_player_, row, col);
         int next_player = 1 - current_player_;
-        int next_turn = turn_ + 1;
-        if (next_turn == 2 || next_turn == 4)
+        turn_++;
+        if (turn_ == 2 || turn_ == 4)
         {
             next_player = current_player_;
         }
-        SantoriniPhase next_phase = SantoriniPhase::placement;
-        if (next_turn > 4)
+        current_player_ = next_player;
+        if (turn_ > 4)
         {
-            next_phase = SantoriniPhase::selection;
+            current_phase_ = SantoriniPhase::selection;
         }
-        std::optional<std::pair<int, int>> no_selection;
-        return std::make_unique<SantoriniState>(new_players, buildings_, next_phase, false, next_turn, next_player, no_selection);
+        is_winning_move_ = false;
+        selection_.reset();
     }
     else if (current_phase_ == SantoriniPhase::selection)
     {
-        std::optional<std::pair<int, int>> new_selection(std::make_pair(row, col));
-        SantoriniPhase next_phase = SantoriniPhase::moving;
-        return std::make_unique<SantoriniState>(players_, buildings_, next_phase, false, turn_, current_player_, new_selection);
+        selection_.emplace(std::make_pair(row, col));
+        current_phase_ = SantoriniPhase::moving;
+        is_winning_move_ = false;
     }
     else if (current_phase_ == SantoriniPhase::moving)
     {
@@ -108,18 +199,13 @@ std::unique_ptr<SantoriniState> SantoriniState::step_state(int action) const
         {
             throw rl::common::UnreachableCodeException("Santorini state assertion failed , moving with no selection");
         }
-        Board new_players(players_);
         auto [prev_row, prev_col] = selection_.value();
-        new_players.at(prev_row).at(prev_col) = 0;
-        new_players.at(row).at(col) = current_player_ == 0 ? 1 : -1;
-        bool is_winning_move = false;
-        if (buildings_.at(row).at(col) == 3 && buildings_.at(prev_row).at(prev_col) < 3)
-        {
-            is_winning_move = true;
-        }
-        SantoriniPhase next_phase(SantoriniPhase::building);
-        std::optional<std::pair<int, int>> new_selection(std::make_pair(row, col));
-        return std::make_unique<SantoriniState>(new_players, buildings_, next_phase, is_winning_move, turn_, current_player_, new_selection);
+        players_.at(prev_row).at(prev_col) = 0;
+        players_.at(row).at(col) = current_player_ == 0 ? 1 : -1;
+        is_winning_move_ = buildings_.at(row).at(col) == 3 && buildings_.at(prev_row).at(prev_col) < 3;
+        hash_ ^= worker_key(current_player_, prev_row, prev_col) ^ worker_key(current_player_, row, col);
+        current_phase_ = SantoriniPhase::building;
+        selection_.emplace(std::make_pair(row, col));
     }
     else if (current_phase_ == SantoriniPhase::building)
     {
@@ -127,18 +213,30 @@ std::unique_ptr<SantoriniState> SantoriniState::step_state(int action) const
         {
             throw rl::common::UnreachableCodeException("Santorini state assertion failed , building with no selection");
         }
-        Board new_buildings(buildings_);
-        new_buildings.at(row).at(col)++;
-        int next_turn = turn_ + 1;
-        int next_player = 1 - current_player_;
-        SantoriniPhase next_phase(SantoriniPhase::selection);
-        std::optional<std::pair<int, int>> no_selection;
-        return std::make_unique<SantoriniState>(players_, new_buildings, next_phase, false, next_turn, next_player, no_selection);
+        hash_ ^= building_key(buildings_[row][col], row, col);
+        buildings_.at(row).at(col)++;
+        hash_ ^= building_key(buildings_[row][col], row, col);
+        turn_++;
+        current_player_ = 1 - current_player_;
+        current_phase_ = SantoriniPhase::selection;
+        is_winning_move_ = false;
+        selection_.reset();
     }
     else
     {
         throw rl::common::UnreachableCodeException("Santorini state assertion failed");
     }
+    hash_ ^= status_key(current_phase_, is_winning_move_, current_player_, selection_);
+    clear_cache();
+}
+
+void SantoriniState::clear_cache()
+{
+    // clear keeps the buffers' capacity for the next ply
+    cached_actions_masks_.clear();
+    cached_is_terminal_.reset();
+    cached_result_.reset();
+    cached_observation_.clear();
 }
 
 void SantoriniState::render() const
@@ -290,6 +388,20 @@ std::vector<float> SantoriniState::get_observation() const
         return cached_observation_;
     }
 
+    std::vector<float> observation(CHANNELS * ROWS * COLS);
+    write_observation(observation.data());
+    cached_observation_ = observation;
+    return cached_observation_;
+}
+
+void SantoriniState::write_observation(float* out) const
+{
+    if (cached_observation_.size())
+    {
+        std::copy(cached_observation_.begin(), cached_observation_.end(), out);
+        return;
+    }
+
     constexpr int CURRENT_PLAYER_CHANNEL = 0;
     constexpr int OPPONENT_PLAYER_CHANNEL = 1;
     constexpr int SELECTION_CHANNEL = 2;
@@ -297,13 +409,13 @@ std::vector<float> SantoriniState::get_observation() const
     constexpr int PLACEMENT_PHASE_CHANNEL = 8;
     constexpr int CHANNEL_SIZE = ROWS * COLS;
 
-    cached_observation_.resize(CHANNELS * ROWS * COLS);
+    std::fill_n(out, CHANNELS * ROWS * COLS, 0.0f);
 
     if (selection_.has_value())
     {
         auto [row, col] = selection_.value();
         int observation_cell_id = CHANNEL_SIZE * SELECTION_CHANNEL + row * COLS + col;
-        cached_observation_.at(observation_cell_id) = 1.0f;
+        out[observation_cell_id] = 1.0f;
     }
     for (int row = 0; row < ROWS; row++)
     {
@@ -318,13 +430,13 @@ std::vector<float> SantoriniState::get_observation() const
             {
                 int channel = CURRENT_PLAYER_CHANNEL;
                 int observation_cell_id = CHANNEL_SIZE * channel + row * COLS + col;
-                cached_observation_.at(observation_cell_id) = 1.0f;
+                out[observation_cell_id] = 1.0f;
             }
             else if (player_flag == -1)
             {
                 int channel = OPPONENT_PLAYER_CHANNEL;
                 int observation_cell_id = CHANNEL_SIZE * channel + row * COLS + col;
-                cached_observation_.at(observation_cell_id) = 1.0f;
+                out[observation_cell_id] = 1.0f;
             }
         }
     }
@@ -337,7 +449,7 @@ std::vector<float> SantoriniState::get_observation() const
             int height = buildings_.at(row).at(col);
             int channel = ZERO_HEIGHT_CHANNEL + height;
             int observation_cell_id = CHANNEL_SIZE * channel + row * COLS + col;
-            cached_observation_.at(observation_cell_id) = 1.0f;
+            out[observation_cell_id] = 1.0f;
         }
     }
 
@@ -364,10 +476,23 @@ std::vector<float> SantoriniState::get_observation() const
     int channel_end = channel_start + CHANNEL_SIZE;
     for (int cell = channel_start; cell < channel_end; cell++)
     {
-        cached_observation_.at(cell) = 1.0f;
+        out[cell] = 1.0f;
     }
+}
 
-    return cached_observation_;
+uint64_t SantoriniState::hash() const
+{
+    return hash_;
+}
+
+size_t SantoriniState::memory_bytes() const
+{
+    return sizeof(*this) + cached_actions_masks_.capacity() / 8 + cached_observation_.capacity() * sizeof(float);
+}
+
+std::string SantoriniState::game_name() const
+{
+    return "santorini";
 }
 
 std::string SantoriniState::to_short() const
@@ -655,6 +780,30 @@ void SantoriniState::get_symmetrical_obs_and_actions(std::vector<float> const& o
     }
 }
 
+int SantoriniState::n_symmetries() const
+{
+    return 3;
+}
+
+void SantoriniState::write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const
+{
+    using namespace santorini_syms;
+    // same order as get_symmetrical_obs_and_actions
+    static const std::array<decltype(&FIRST_OBS_SYM), 3> OBS_SYMS{ { &FIRST_OBS_SYM, &SECOND_OBS_SYM, &THIRD_OBS_SYM } };
+    static const std::array<decltype(&FIRST_ACTIONS_SYM), 3> ACTIONS_SYMS{ { &FIRST_ACTIONS_SYM, &SECOND_ACTIONS_SYM, &THIRD_ACTIONS_SYM } };
+
+    const auto& obs_sym = *OBS_SYMS.at(symmetry);
+    for (size_t i = 0; i < obs_sym.size(); i++)
+    {
+        out_obs[i] = obs[obs_sym[i]];
+    }
+    const auto& actions_sym = *ACTIONS_SYMS.at(symmetry);
+    for (size_t i = 0; i < actions_sym.size(); i++)
+    {
+        out_actions_distribution[i] = actions_distribution[actions_sym[i]];
+    }
+}
+
 SantoriniPhase SantoriniState::get_current_phase() const
 {
     return current_phase_;
@@ -3,11 +3,23 @@
 
 #include <games/tictactoe.hpp>
 #include <common/exceptions.hpp>
+#include <common/zobrist.hpp>
+#include <common/bits.hpp>
 namespace rl::games
 {
+// [player][cell] marks, then the side to move
+constexpr int ZOBRIST_SIDE = 2 * 9;
+constexpr auto ZOBRIST = rl::common::zobrist::make_keys<ZOBRIST_SIDE + 1>(0x7ac7ac70e0000001ULL);
+
 TicTacToeState::TicTacToeState(std::array<std::array<int8_t, ROWS>, COLS> board, int8_t player)
+    : TicTacToeState(board, player, compute_hash(board, player))
+{
+}
+
+TicTacToeState::TicTacToeState(std::array<std::array<int8_t, ROWS>, COLS> board, int8_t player, uint64_t hash)
     : board_(board),
     player_{ player },
+    hash_{ hash },
     legal_actions_{},
     is_game_over_cached_{ false },
     is_game_over_{ false },
@@ -15,6 +27,25 @@ TicTacToeState::TicTacToeState(std::array<std::array<int8_t, ROWS>, COLS> board,
     game_result_cache_{ 0.0f }
 {
 }
+
+uint64_t TicTacToeState::compute_hash(const std::array<std::array<int8_t, COLS>, ROWS>& board, int player)
+{
+    uint64_t hash = player == 1 ? ZOBRIST[ZOBRIST_SIDE] : 0;
+    for (int row = 0; row < ROWS; row++)
+    {
+        for (int col = 0; col < COLS; col++)
+        {
+            for (int p = 0; p < 2; p++)
+            {
+                if (board[row][col] == FLAGS[p])
+                {
+                    hash ^= ZOBRIST[p * N_ACTIONS + row * COLS + col];
+                }
+            }
+        }
+    }
+    return hash;
+}
 std::unique_ptr<TicTacToeState> TicTacToeState::initialize_state()
 {
     std::array<std::array<int8_t, 3>, 3> array{};
@@ -43,14 +74,38 @@ std::unique_ptr<TicTacToeState> TicTacToeState::step_state(int action) const
     {
         throw rl::common::SteppingTerminalStateException("");
     }
+    auto next_state_ptr = std::unique_ptr<TicTacToeState>(new TicTacToeState(board_, player_, hash_));
+    next_state_ptr->apply_unchecked(action);
+    return next_state_ptr;
+}
+
+void TicTacToeState::apply(int action)
+{
+    if (!actions_mask().at(action))
+    {
+        throw rl::common::SteppingTerminalStateException("");
+    }
+    apply_unchecked(action);
+}
+
+void TicTacToeState::apply_unchecked(int action)
+{
     int current_player = player_;
     int current_player_flag = FLAGS.at(current_player);
-    int next_player = 1 - current_player;
-    std::array<std::array<int8_t, ROWS>, COLS> next_board(board_);
     int action_row = action / COLS;
     int action_col = action % COLS;
-    next_board.at(action_row).at(action_col) = current_player_flag;
-    return std::make_unique<TicTacToeState>(next_board, next_player);
+    board_.at(action_row).at(action_col) = current_player_flag;
+    hash_ ^= ZOBRIST[ZOBRIST_SIDE] ^ ZOBRIST[current_player * N_ACTIONS + action];
+    player_ = 1 - current_player;
+    clear_cache();
+}
+
+void TicTacToeState::clear_cache()
+{
+    // clear keeps the mask's capacity for the next ply
+    legal_actions_.clear();
+    is_game_over_cached_ = false;
+    is_game_result_cached_ = false;
 }
 
 std::unique_ptr<rl::common::IState> TicTacToeState::step(int action) const
@@ -65,30 +120,42 @@ std::vector<float> TicTacToeState::get_observation() const
         the 1-index indicates the opponent player
         each channel consists of 9 flat cells , 3 rows 3 cols
     */
+    std::vector<float> observation(OBSERVATION_SIZE);
+    write_observation(observation.data());
+    return observation;
+}
+
+void TicTacToeState::write_observation(float* out) const
+{
     int current_player{ player_ };
     int opponent{ 1 - current_player };
     int player_flag{ FLAGS.at(current_player) };
     int opponent_flag{ FLAGS.at(opponent) };
 
-    std::vector<float> observation;
-    observation.reserve(CHANNELS * ROWS * COLS);
-    for (int row{ 0 }; row < ROWS; row++)
-    {
-        for (int col{ 0 }; col < COLS; col++)
-        {
-            int cell_index = row * COLS + col;
-            observation.emplace_back(board_.at(row).at(col) == player_flag ? 1.0f : 0.0f);
-        }
-    }
     for (int row{ 0 }; row < ROWS; row++)
     {
         for (int col{ 0 }; col < COLS; col++)
         {
             int cell_index = row * COLS + col;
-            observation.emplace_back(board_.at(row).at(col) == opponent_flag ? 1.0f : 0.0f);
+            out[cell_index] = board_[row][col] == player_flag ? 1.0f : 0.0f;
+            out[ROWS * COLS + cell_index] = board_[row][col] == opponent_flag ? 1.0f : 0.0f;
         }
     }
-    return observation;
+}
+
+uint64_t TicTacToeState::hash() const
+{
+    return hash_;
+}
+
+size_t TicTacToeState::memory_bytes() const
+{
+    return sizeof(*this) + legal_actions_.capacity() / 8;
+}
+
+std::string TicTacToeState::game_name() const
+{
+    return "tictactoe";
 }
 
 std::string TicTacToeState::to_short() const
@@ -132,6 +199,21 @@ std::vector<bool> TicTacToeState::actions_mask() const
     return legal_actions_;
 }
 
+void TicTacToeState::legal_actions_bitset(uint64_t* out_words) const
+{
+    out_words[0] = 0;
+    for (int row{ 0 }; row < ROWS; row++)
+    {
+        for (int col{ 0 }; col < COLS; col++)
+        {
+            if (board_[row][col] == 0)
+            {
+                rl::common::bits::set_bit(out_words, row * COLS + col);
+            }
+        }
+    }
+}
+
 bool TicTacToeState::is_terminal() const
 {
     if (is_game_over_cached_)
@@ -362,4 +444,28 @@ void TicTacToeState::get_symmetrical_obs_and_actions(std::vector<float> const& o
     }
 }
 
+int TicTacToeState::n_symmetries() const
+{
+    return 3;
+}
+
+void TicTacToeState::write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const
+{
+    using namespace tictactoe_syms;
+    // same order as get_symmetrical_obs_and_actions
+    static const std::array<decltype(&FIRST_SYM), 3> OBS_SYMS{ { &FIRST_SYM, &SECOND_SYM, &THIRD_SYM } };
+    static const std::array<decltype(&FIRST_ACTIONS), 3> ACTIONS_SYMS{ { &FIRST_ACTIONS, &SECOND_ACTIONS, &THIRD_ACTIONS } };
+
+    const auto& obs_sym = *OBS_SYMS.at(symmetry);
+    for (size_t i = 0; i < obs_sym.size(); i++)
+    {
+        out_obs[i] = obs[obs_sym[i]];
+    }
+    const auto& actions_sym = *ACTIONS_SYMS.at(symmetry);
+    for (size_t i = 0; i < actions_sym.size(); i++)
+    {
+        out_actions_distribution[i] = actions_distribution[actions_sym[i]];
+    }
+}
+
 } // namespace rl::games
\ No newline at end of file
@@ -3,13 +3,27 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 #include <games/ultimate_tictactoe.hpp>
 #include <common/exceptions.hpp>
+#include <common/zobrist.hpp>
+#include <common/bits.hpp>
 
 
 namespace rl::games
 {
+// [player][action] marks, the side to move, then the board the next move is sent
+// to (the last move's cell), with the last slot for a free choice. The ultimate
+// boards are functions of the small ones and need no keys of their own.
+constexpr int ZOBRIST_SIDE = 2 * 81;
+constexpr int ZOBRIST_TARGET = ZOBRIST_SIDE + 1;
+constexpr auto ZOBRIST = rl::common::zobrist::make_keys<ZOBRIST_TARGET + 10>(0x0171e7ac7ac70e01ULL);
+
+static uint64_t target_key(int last_action)
+{
+    return ZOBRIST[ZOBRIST_TARGET + (last_action < 0 ? 9 : last_action % 9)];
+}
 
 
 
@@ -18,17 +32,49 @@ UltimateTicTacToeState::~UltimateTicTacToeState() = default;
 
 
 UltimateTicTacToeState::UltimateTicTacToeState(std::array<std::array<std::array<int, COLS>, ROWS>, BOARDS> board, std::array<std::array<int, COLS>, ROWS> ultimate_board, std::array<std::array<int, COLS>, ROWS> ultimate_board_terminals, int player, int last_action)
+    : UltimateTicTacToeState(board, ultimate_board, ultimate_board_terminals, player, last_action, compute_hash(board, player, last_action))
+{
+}
+
+UltimateTicTacToeState::UltimateTicTacToeState(std::array<std::array<std::array<int, COLS>, ROWS>, BOARDS> board, std::array<std::array<int, COLS>, ROWS> ultimate_board, std::array<std::array<int, COLS>, ROWS> ultimate_board_terminals, int player, int last_action, uint64_t hash)
     : board_(board),
     ultimate_board_(ultimate_board),
     ultimate_board_terminals_(ultimate_board_terminals),
     player_{ player },
     last_action_{ last_action },
+    hash_{ hash },
     legal_actions_{},
     is_game_over_cached_{},
     game_result_cached_{}
 {
 }
 
+uint64_t UltimateTicTacToeState::compute_hash(const std::array<std::array<std::array<int, COLS>, ROWS>, BOARDS>& board, int player, int last_action)
+{
+    uint64_t hash = target_key(last_action);
+    if (player == 1)
+    {
+        hash ^= ZOBRIST[ZOBRIST_SIDE];
+    }
+    for (int board_no = 0; board_no < BOARDS; board_no++)
+    {
+        for (int row = 0; row < ROWS; row++)
+        {
+            for (int col = 0; col < COLS; col++)
+            {
+                for (int p = 0; p < 2; p++)
+                {
+                    if (board[board_no][row][col] == FLAGS[p])
+                    {
+                        hash ^= ZOBRIST[p * N_ACTIONS + board_no * ROWS * COLS + row * COLS + col];
+                    }
+                }
+            }
+        }
+    }
+    return hash;
+}
+
 
 std::unique_ptr<rl::common::IState> UltimateTicTacToeState::initialize()
 {
@@ -71,34 +117,59 @@ std::unique_ptr<UltimateTicTacToeState> UltimateTicTacToeState::step_state(int a
         throw rl::common::SteppingTerminalStateException("Stepping a terminal state");
     }
 
-    int last_action = action;
+    auto next_state_ptr = std::unique_ptr<UltimateTicTacToeState>(new UltimateTicTacToeState(board_, ultimate_board_, ultimate_board_terminals_, player_, last_action_, hash_));
+    next_state_ptr->apply_unchecked(action);
+    return next_state_ptr;
+}
+
+void UltimateTicTacToeState::apply(int action)
+{
+    if (!actions_mask().at(action))
+    {
+        throw rl::common::IllegalActionException("Stepping a state with invalid action");
+    }
+    if (is_terminal())
+    {
+        throw rl::common::SteppingTerminalStateException("Stepping a terminal state");
+    }
+    apply_unchecked(action);
+}
+
+void UltimateTicTacToeState::apply_unchecked(int action)
+{
     int current_player = player_;
     int current_player_flag = FLAGS.at(current_player);
-    int next_player = 1 - current_player;
-
-    std::array<std::array<std::array<int, ROWS>, COLS>, BOARDS> next_board(board_);
 
     int action_board_no = action / (ROWS * COLS);
     int action_row = action % (ROWS * COLS) / COLS;
     int action_col = action % (ROWS * COLS) % COLS;
 
-    next_board.at(action_board_no).at(action_row).at(action_col) = current_player_flag;
+    board_.at(action_board_no).at(action_row).at(action_col) = current_player_flag;
 
-    std::array<std::array<int, ROWS>, COLS> next_ultimate_board = ultimate_board_;
-    std::array<std::array<int, ROWS>, COLS> next_ultimate_board_terminals = ultimate_board_terminals_;
     int ultimate_board_row = action_board_no / COLS;
     int ultimate_board_col = action_board_no % COLS;
-    if (is_winning(current_player, next_board.at(action_board_no)))
+    if (is_winning(current_player, board_.at(action_board_no)))
     {
-        next_ultimate_board.at(ultimate_board_row).at(ultimate_board_col) = current_player_flag;
-        next_ultimate_board_terminals.at(ultimate_board_row).at(ultimate_board_col) = 1;
+        ultimate_board_.at(ultimate_board_row).at(ultimate_board_col) = current_player_flag;
+        ultimate_board_terminals_.at(ultimate_board_row).at(ultimate_board_col) = 1;
     }
-    else if (is_full(next_board.at(action_board_no))) {
-        next_ultimate_board_terminals.at(ultimate_board_row).at(ultimate_board_col) = 1;
+    else if (is_full(board_.at(action_board_no))) {
+        ultimate_board_terminals_.at(ultimate_board_row).at(ultimate_board_col) = 1;
     }
 
+    hash_ ^= ZOBRIST[ZOBRIST_SIDE] ^ ZOBRIST[current_player * N_ACTIONS + action] ^ target_key(last_action_) ^ target_key(action);
+    last_action_ = action;
+    player_ = 1 - current_player;
+    clear_cache();
+}
 
-    return std::make_unique<UltimateTicTacToeState>(next_board, next_ultimate_board, next_ultimate_board_terminals, next_player, last_action);
+void UltimateTicTacToeState::clear_cache()
+{
+    // clear keeps the buffers' capacity for the next ply
+    legal_actions_.clear();
+    is_game_over_cached_.reset();
+    game_result_cached_.reset();
+    observation_cached_.clear();
 }
 
 void UltimateTicTacToeState::render() const
@@ -212,6 +283,20 @@ std::vector<float> UltimateTicTacToeState::get_observation() const
     {
         return observation_cached_;
     }
+
+    std::vector<float> observation(CHANNELS * ROWS * COLS);
+    write_observation(observation.data());
+    observation_cached_ = observation;
+    return observation;
+}
+
+void UltimateTicTacToeState::write_observation(float* out) const
+{
+    if (observation_cached_.size())
+    {
+        std::copy(observation_cached_.begin(), observation_cached_.end(), out);
+        return;
+    }
     /*
     observation consists of 30 channels , YES 30 channels
     [0,9] channels are for the current player (9 for each board and 1 for the ultimate board)
@@ -225,9 +310,8 @@ std::vector<float> UltimateTicTacToeState::get_observation() const
     int player_flag{ FLAGS.at(current_player) };
     int opponent_flag{ FLAGS.at(opponent) };
 
-    std::vector<float> observation;
     constexpr int CELLS = CHANNELS * ROWS * COLS;
-    observation.resize(CELLS);
+    std::fill_n(out, CELLS, 0.0f);
 
     for (size_t board_no = 0; board_no < BOARDS; board_no++)
     {
@@ -246,7 +330,7 @@ std::vector<float> UltimateTicTacToeState::get_observation() const
                     }
 
                     int cell_index = relative_board * (ROWS * COLS) + row * COLS + col;
-                    observation.at(cell_index) = 1.0;
+                    out[cell_index] = 1.0f;
                 }
             }
         }
@@ -271,20 +355,18 @@ std::vector<float> UltimateTicTacToeState::get_observation() const
                     }
 
                     int cell_index = relative_board * (ROWS * COLS) + row * COLS + col;
-                    observation.at(cell_index) = 1.0;
+                    out[cell_index] = 1.0f;
                 }
             }
         }
     }
 
-    auto masks = actions_mask();
-
     constexpr int ACTIONS_INITIAL_CELL = ((BOARDS + 1) * 2) * ROWS * COLS;
 
-    for (size_t i = 0; i < masks.size(); i++)
-    {
-        observation.at(ACTIONS_INITIAL_CELL + i) = static_cast<float>(masks.at(i));
-    }
+    std::array<uint64_t, rl::common::bits::n_words(N_ACTIONS)> legal_words;
+    legal_actions_bitset(legal_words.data());
+    rl::common::bits::for_each_bit(legal_words.data(), static_cast<int>(legal_words.size()), [out](int action)
+        { out[ACTIONS_INITIAL_CELL + action] = 1.0f; });
 
     // ALL ONES CHANNEL
 
@@ -294,13 +376,25 @@ std::vector<float> UltimateTicTacToeState::get_observation() const
 
     for (size_t i = 0; i < ROWS * COLS; i++)
     {
-        observation.at(ALL_ONES_INITIAL_CELL_INDEX + i) = 1.0f;
+        out[ALL_ONES_INITIAL_CELL_INDEX + i] = 1.0f;
     }
+}
 
-    observation_cached_ = observation;
-    return observation;
+
+uint64_t UltimateTicTacToeState::hash() const
+{
+    return hash_;
 }
 
+size_t UltimateTicTacToeState::memory_bytes() const
+{
+    return sizeof(*this) + legal_actions_.capacity() / 8 + observation_cached_.capacity() * sizeof(float);
+}
+
+std::string UltimateTicTacToeState::game_name() const
+{
+    return "uttt";
+}
 
 std::string UltimateTicTacToeState::to_short() const
 {
@@ -401,6 +495,18 @@ std::vector<bool> UltimateTicTacToeState::actions_mask() const
     return legal_actions_;
 }
 
+void UltimateTicTacToeState::legal_actions_bitset(uint64_t* out_words) const
+{
+    std::fill_n(out_words, rl::common::bits::n_words(N_ACTIONS), 0ULL);
+    for (int action = 0; action < N_ACTIONS; action++)
+    {
+        if (is_legal_action(action))
+        {
+            rl::common::bits::set_bit(out_words, action);
+        }
+    }
+}
+
 
 
 
@@ -544,6 +650,30 @@ void UltimateTicTacToeState::get_symmetrical_obs_and_actions(std::vector<float>
     add_symmetry(ANTI_TRANSPOSE_OBS_SYM, ANTI_TRANSPOSE_ACTIONS_SYM);
 }
 
+int UltimateTicTacToeState::n_symmetries() const
+{
+    return 7;
+}
+
+void UltimateTicTacToeState::write_symmetrical_obs_and_actions(const float* obs, const float* actions_distribution, int symmetry, float* out_obs, float* out_actions_distribution) const
+{
+    using namespace ultimate_tictactoe_syms;
+    // same order as get_symmetrical_obs_and_actions
+    static const std::array<decltype(&ROT90_OBS_SYM), 7> OBS_SYMS{ { &ROT90_OBS_SYM, &ROT180_OBS_SYM, &ROT270_OBS_SYM, &FLIP_LR_OBS_SYM, &FLIP_UD_OBS_SYM, &TRANSPOSE_OBS_SYM, &ANTI_TRANSPOSE_OBS_SYM } };
+    static const std::array<decltype(&ROT90_ACTIONS_SYM), 7> ACTIONS_SYMS{ { &ROT90_ACTIONS_SYM, &ROT180_ACTIONS_SYM, &ROT270_ACTIONS_SYM, &FLIP_LR_ACTIONS_SYM, &FLIP_UD_ACTIONS_SYM, &TRANSPOSE_ACTIONS_SYM, &ANTI_TRANSPOSE_ACTIONS_SYM } };
+
+    const auto& obs_sym = *OBS_SYMS.at(symmetry);
+    for (size_t i = 0; i < obs_sym.size(); i++)
+    {
+        out_obs[i] = obs[obs_sym[i]];
+    }
+    const auto& actions_sym = *ACTIONS_SYMS.at(symmetry);
+    for (size_t i = 0; i < actions_sym.size(); i++)
+    {
+        out_actions_distribution[i] = actions_distribution[actions_sym[i]];
+    }
+}
+
 
 bool UltimateTicTacToeState::is_horizontal_win(int player, const std::array<std::array<int, COLS>, ROWS>& board) const
 {
@@ -1,20 +1,58 @@
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 
 #include <games/walls.hpp>
 #include <common/exceptions.hpp>
+#include <common/zobrist.hpp>
+#include <common/bits.hpp>
 
 namespace rl::games
 {
+// [cell] walls, then [player][cell] pawns, then the side to move
+constexpr int ZOBRIST_CELLS = 7 * 7;
+constexpr int ZOBRIST_PAWNS = ZOBRIST_CELLS;
+constexpr int ZOBRIST_SIDE = ZOBRIST_PAWNS + 2 * ZOBRIST_CELLS;
+constexpr auto ZOBRIST = rl::common::zobrist::make_keys<ZOBRIST_SIDE + 1>(0x3a115a11c0ffee01ULL);
+
+static uint64_t pawn_key(int player, int row, int col)
+{
+    return ZOBRIST[ZOBRIST_PAWNS + player * ZOBRIST_CELLS + row * 7 + col];
+}
 
 WallsState::WallsState(Walls walls, Positions positions, int current_player)
-    : walls_(walls),
+    : WallsState(walls, positions, current_player, compute_hash(walls, positions, current_player))
+{
+}
+
+WallsState::WallsState(Walls walls, Positions positions, int current_player, uint64_t hash)
+    : current_player_{ current_player },
+    walls_(walls),
     positions_(positions),
-    current_player_{ current_player },
+    hash_{ hash },
     cached_actions_masks_{}
 {
 }
 
+uint64_t WallsState::compute_hash(const Walls& walls, const Positions& positions, int current_player)
+{
+    uint64_t hash = current_player == 1 ? ZOBRIST[ZOBRIST_SIDE] : 0;
+    for (int row = 0; row < ROWS; row++)
+    {
+        for (int col = 0; col < COLS; col++)
+        {
+            if (walls[row][col])
+            {
+                hash ^= ZOBRIST[row * COLS + col];
+            }
+        }
+    }
+    // positions[0] is always the player to move
+    hash ^= pawn_key(current_player, positions[0][0], positions[0][1]);
+    hash ^= pawn_key(1 - current_player, positions[1][0], positions[1][1]);
+    return hash;
+}
+
 WallsState::~WallsState() = default;
 
 std::unique_ptr<WallsState> WallsState::initialize_state()
@@ -54,16 +92,51 @@ std::unique_ptr<WallsState> WallsState::step_state(int action) const
         ss << "Stepping an Walls state with an illegal action " << action;
         throw rl::common::IllegalActionException(ss.str());
     }
+    auto next_state_ptr = std::unique_ptr<WallsState>(new WallsState(walls_, positions_, current_player_, hash_));
+    next_state_ptr->apply_unchecked(action);
+    return next_state_ptr;
+}
+
+void WallsState::apply(int action)
+{
+    if (is_terminal())
+    {
+        std::stringstream ss;
+        ss << "Stepping a terminal Walls state";
+        throw rl::common::SteppingTerminalStateException(ss.str());
+    }
+    if (actions_mask().at(action) == false)
+    {
+        std::stringstream ss;
+        ss << "Stepping an Walls state with an illegal action " << action;
+        throw rl::common::IllegalActionException(ss.str());
+    }
+    apply_unchecked(action);
+}
+
+void WallsState::apply_unchecked(int action)
+{
     int player = current_player_;
-    int opponent = 1 - player;
     auto [jump_row, jump_col, build_row, build_col] = get_jump_row_col_and_build_row_col_from_action(action);
 
-    Walls new_walls{ walls_ };
-    new_walls.at(build_row).at(build_col) = 1;
-    auto opponent_position{ std::get<1>(positions_) };
-    Positions new_position{ {opponent_position, {jump_row, jump_col}} };
-    return std::make_unique<WallsState>(new_walls, new_position, opponent);
+    walls_.at(build_row).at(build_col) = 1;
+    hash_ ^= ZOBRIST[ZOBRIST_SIDE] ^ ZOBRIST[build_row * COLS + build_col]
+        ^ pawn_key(player, positions_[0][0], positions_[0][1]) ^ pawn_key(player, jump_row, jump_col);
+    // positions_[0] is always the player to move
+    positions_ = Positions{ {positions_[1], {jump_row, jump_col}} };
+    current_player_ = 1 - player;
+    clear_cache();
 }
+
+void WallsState::clear_cache()
+{
+    // clear keeps the buffers' capacity for the next ply
+    cached_actions_masks_.clear();
+    cached_is_terminal_.reset();
+    cached_result_.reset();
+    cached_observation_.clear();
+}
+
 std::unique_ptr<rl::common::IState> WallsState::step(int action) const
 {
     return step_state(action);
@@ -186,6 +259,21 @@ float WallsState::get_reward() const
 
 } // namespace rl::games
 
+uint64_t WallsState::hash() const
+{
+    return hash_;
+}
+
+size_t WallsState::memory_bytes() const
+{
+    return sizeof(*this) + cached_actions_masks_.capacity() / 8 + cached_observation_.capacity() * sizeof(float);
+}
+
+std::string WallsState::game_name() const
+{
+    return "walls";
+}
+
 std::string WallsState::to_short() const
 {
     std::stringstream ss;
@@ -243,38 +331,43 @@ std::vector<float> WallsState::get_observation() const
 
     // Note : not threadsafe
 
-    cached_observation_ = std::vector<float>(CHANNELS * ROWS * COLS);
+    std::vector<float> observation(CHANNELS * ROWS * COLS);
+    write_observation(observation.data());
+    cached_observation_ = observation;
+    return cached_observation_;
+}
+
+void WallsState::write_observation(float* out) const
+{
+    if (cached_observation_.size())
+    {
+        std::copy(cached_observation_.begin(), cached_observation_.end(), out);
+        return;
+    }
+    std::fill_n(out, CHANNELS * ROWS * COLS, 0.0f);
 
     int player_row, player_col, opponent_row, opponent_col;
 
     // Note: positions has current player at position 0 index inside the array
-    player_row = positions_.at(0).at(0);
-    player_col = positions_.at(0).at(1);
-    opponent_row = positions_.at(1).at(0);
-    opponent_col = positions_.at(1).at(1);
+    player_row = positions_[0][0];
+    player_col = positions_[0][1];
+    opponent_row = positions_[1][0];
+    opponent_col = positions_[1][1];
 
     int player_index = PLAYER_CHANNEL * ROWS * COLS + player_row * COLS + player_col;
-    cached_observation_[player_index] = 1;
+    out[player_index] = 1;
     int opponent_index = OPPONENT_CHANNEL * ROWS * COLS + opponent_row * COLS + opponent_col;
-    cached_observation_[opponent_index] = 1;
+    out[opponent_index] = 1;
 
     int wall_index = WALLS_CHANNEL * ROWS * COLS;
     for (int row = 0; row < ROWS; row++)
     {
         for (int col = 0; col < COLS; col++)
         {
-            cached_observation_.at(wall_index) = walls_[row][col];
+            out[wall_index] = walls_[row][col];
             wall_index++;
         }
     }
-
-    if (wall_index != ROWS * COLS * CHANNELS)
-    {
-        std::stringstream ss;
-        ss << "something went wrong " << wall_index << "!= " << ROWS * COLS * CHANNELS;
-        throw rl::common::UnreachableCodeException(ss.str());
-    }
-    return cached_observation_;
 }
 
 std::array<int, 3> WallsState::get_observation_shape() const
@@ -334,6 +427,34 @@ std::vector<bool> WallsState::actions_mask() const
     return cached_actions_masks_;
 }
 
+void WallsState::legal_actions_bitset(uint64_t* out_words) const
+{
+    std::fill_n(out_words, rl::common::bits::n_words(N_ACTIONS), 0ULL);
+
+    int player_row = positions_[0][0];
+    int player_col = positions_[0][1];
+    int opponent_row = positions_[1][0];
+    int opponent_col = positions_[1][1];
+
+    for (auto [row_dir, col_dir] : DIRECTIONS)
+    {
+        int jump_row = player_row + row_dir;
+        int jump_col = player_col + col_dir;
+        if (!is_valid_jump(jump_row, jump_col, opponent_row, opponent_col, walls_))
+        {
+            continue;
+        }
+        for (int a = 0; a < DIRECTIONS.size(); a++)
+        {
+            auto [build_row_dir, build_col_dir] = DIRECTIONS[a];
+            if (is_valid_build(jump_row + build_row_dir, jump_col + build_col_dir, opponent_row, opponent_col, walls_))
+            {
+                rl::common::bits::set_bit(out_words, jump_row * COLS * N_DIRECTIONS + jump_col * N_DIRECTIONS + a);
+            }
+        }
+    }
+}
+
 std::unique_ptr<WallsState> WallsState::clone_state() const
 {
     return std::unique_ptr<WallsState>(new WallsState(*this));
@@ -46,6 +46,7 @@
 
 #include "nnue_layerstacks_eval_v2.hpp"
 #include "nnue_layerstacks_model_v2.hpp"
+#include "nnue_refresh_cache_v2.hpp"
 
 #include <algorithm>
 #include <chrono>
@@ -218,7 +219,7 @@ public:
         {
             // Once per search, not once per simulation: the root never moves,
             // and rebuilding it costs more than an entire rollout.
-            rl::nnue::build_accumulator(*model_, root_board_, accumulator_stack_[0]);
+            refresh_cache_.refresh(*model_, root_board_, accumulator_stack_[0]);
         }
 
         // Both budgets are floors, and both must be satisfied before the search
@@ -840,6 +841,7 @@ private:
     // Written at depth + 1 while depth is read, so index MAX_TREE_DEPTH + 1
     // must exist. 133 KB, and untouched unless the network is in use.
     alignas(64) int16_t accumulator_stack_[MAX_TREE_DEPTH + 2][2][256];
+    rl::nnue::AccumulatorRefreshCache refresh_cache_;
 
     std::shared_ptr<const NNUELayerStacksModelV2> model_;
     std::chrono::duration<int, std::milli> minimum_duration_;
@@ -0,0 +1,126 @@
+#ifndef RL_NNUE_NNUE_EVAL_V2_KERNELS_HPP_
+#define RL_NNUE_NNUE_EVAL_V2_KERNELS_HPP_
+
+// The hot loops of the v2 network, the accumulator update and the three
+// layers of the head, in one variant per instruction set, picked once at
+// startup by cpuid.
+//
+// The build baseline stays -mavx -msse4.2 (see the top-level CMakeLists.txt),
+// so the SSE variants in nnue_layerstacks_eval_v2.hpp are what every host can
+// run. The AVX2 and AVX-512 variants live in their own translation units,
+// compiled with their own -m flags, and are only ever reached through the
+// table below after the CPU said it has them. Those files include nothing but
+// this header and <immintrin.h>: an inline function instantiated there with
+// -mavx2 could be the copy the linker keeps for the whole program.
+//
+// The kernels take raw pointers rather than the model for the same reason.
+// All variants do the same integer arithmetic, so results are bit-identical;
+// `bench_migoyugo_bb determinism` runs each available level against SSE.
+
+#include <cstdint>
+
+namespace rl::nnue
+{
+
+enum class SimdLevel
+{
+    SSE = 0,
+    AVX2 = 1,
+    AVX512 = 2,
+};
+
+// dst <- src + sum of l1 rows `add` - sum of l1 rows `sub`, 256 int16.
+// l1_weights is the [feature][256] table.
+using AccumulatorTransformKernel = void (*)(int16_t* dst, const int16_t* src,
+    const int16_t* l1_weights, const uint16_t* add, int n_add, const uint16_t* sub, int n_sub);
+
+// One move of an accumulator chain: dst <- previous + rows `add` - rows `sub`,
+// where previous is the chain's source for the first step and the step
+// before's dst after that.
+struct AccumulatorStep
+{
+    int16_t* dst;
+    const uint16_t* add;
+    int n_add;
+    const uint16_t* sub;
+    int n_sub;
+};
+
+// Several moves in one pass: each slice of the accumulator is loaded from
+// `src` once, carried through every step in registers and stored into each
+// step's dst on the way. No dst may be `src`.
+using AccumulatorChainKernel = void (*)(const int16_t* src, const int16_t* l1_weights,
+    const AccumulatorStep* steps, int n_steps);
+
+// Clipped ReLU of the 256-wide accumulator, then the bucket's 256 -> 16 layer:
+// l2_out[i] = clamp((l2_bias[i] + sum_j w[i][j] * crelu(acc[j])) >> 7, 0, 127).
+// l2_weights is the bucket's [16][256] block.
+using L2Kernel = void (*)(const int16_t* accumulator, const int16_t* l2_weights,
+    const int32_t* l2_bias, int32_t* l2_out);
+
+// The bucket's 16 -> 32 layer:
+// l3_out[i] = clamp((l3_bias[i] + sum_j w[i][j] * l2_out[j]) >> 7, 0, 127).
+// l3_weights is the bucket's block of NNUELayerStacksModelV2::l3_weights_interleaved,
+// 64-byte aligned. l3_out is int16 because the output layer madds it.
+using L3Kernel = void (*)(const int32_t* l2_out, const int16_t* l3_weights,
+    const int32_t* l3_bias, int16_t* l3_out);
+
+// The bucket's 32 -> 1 layer, out_bias + sum_i out_weights[i] * l3_out[i],
+// unshifted: the raw value evaluate_accumulator returns.
+using OutputKernel = int32_t (*)(const int16_t* l3_out, const int16_t* out_weights, int32_t out_bias);
+
+struct EvalV2Kernels
+{
+    SimdLevel level;
+    AccumulatorTransformKernel accumulator_transform;
+    AccumulatorChainKernel accumulator_chain;
+    L2Kernel l2;
+    L3Kernel l3;
+    OutputKernel output;
+};
+
+// The widest level this CPU and OS support, capped by the environment variable
+// RL_NNUE_SIMD=sse|avx2|avx512 when it is set. Detected once.
+SimdLevel detected_simd_level();
+const char* simd_level_name(SimdLevel level);
+
+// Switches every later evaluation to `level`. For benchmarks and checks only:
+// no search may be running. Returns false, changing nothing, when the CPU
+// lacks the level.
+bool set_simd_level(SimdLevel level);
+
+namespace detail
+{
+extern const EvalV2Kernels* active_eval_v2_kernels;
+} // namespace detail
+
+inline const EvalV2Kernels& eval_v2_kernels()
+{
+    return *detail::active_eval_v2_kernels;
+}
+
+#if !defined(__EMSCRIPTEN__)
+void accumulator_transform_avx2(int16_t* dst, const int16_t* src,
+    const int16_t* l1_weights, const uint16_t* add, int n_add, const uint16_t* sub, int n_sub);
+void accumulator_chain_avx2(const int16_t* src, const int16_t* l1_weights,
+    const AccumulatorStep* steps, int n_steps);
+void l2_avx2(const int16_t* accumulator, const int16_t* l2_weights,
+    const int32_t* l2_bias, int32_t* l2_out);
+void l3_avx2(const int32_t* l2_out, const int16_t* l3_weights,
+    const int32_t* l3_bias, int16_t* l3_out);
+int32_t output_avx2(const int16_t* l3_out, const int16_t* out_weights, int32_t out_bias);
+
+void accumulator_transform_avx512(int16_t* dst, const int16_t* src,
+    const int16_t* l1_weights, const uint16_t* add, int n_add, const uint16_t* sub, int n_sub);
+void accumulator_chain_avx512(const int16_t* src, const int16_t* l1_weights,
+    const AccumulatorStep* steps, int n_steps);
+void l2_avx512(const int16_t* accumulator, const int16_t* l2_weights,
+    const int32_t* l2_bias, int32_t* l2_out);
+void l3_avx512(const int32_t* l2_out, const int16_t* l3_weights,
+    const int32_t* l3_bias, int16_t* l3_out);
+int32_t output_avx512(const int16_t* l3_out, const int16_t* out_weights, int32_t out_bias);
+#endif
+
+} // namespace rl::nnue
+
+#endif
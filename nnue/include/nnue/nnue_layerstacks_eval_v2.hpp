@@ -11,11 +11,12 @@
 // results must stay bit-identical - `bench_migoyugo_bb determinism` and
 // `bench_migoyugo_bb match` are the check.
 //
-// Two conventions worth stating once:
+// Conventions worth stating once:
 //
 //   * Accumulators are int16_t[256] and MUST be at least 16-byte aligned;
-//     every load here is _mm_load_si128, not the unaligned form. Declare them
-//     `alignas(64)`.
+//     every SSE load here is _mm_load_si128, not the unaligned form. Declare
+//     them `alignas(64)`. The wider kernels in nnue_eval_v2_kernels.hpp load
+//     accumulators unaligned and so ask for no more than that.
 //
 //   * Feature ids from MigoyugoBB::active_features() and FeatureDelta are
 //     from White's point of view. The network wants the side to move's point
@@ -28,6 +29,7 @@
 
 #include <games/migoyugo_bb.hpp>
 
+#include "nnue_eval_v2_kernels.hpp"
 #include "nnue_layerstacks_model_v2.hpp"
 
 #include <immintrin.h>
@@ -66,30 +68,14 @@ inline void accumulator_add_feature(const NNUELayerStacksModelV2& model,
     for (int i = 0; i < 32; ++i) a[i] = _mm_add_epi16(a[i], w[i]);
 }
 
-// Both perspectives of a position, from scratch. Used for a root, or for any
-// position reached other than by a move from one we already have.
-inline void build_accumulator(const NNUELayerStacksModelV2& model,
-    const mgbb::MigoyugoBB& board, int16_t (*perspective)[256])
-{
-    uint16_t features[192];
-    const int n = board.active_features(features);
-
-    for (int p = 0; p < 2; ++p)
-        std::memcpy(perspective[p], model.l1_bias.data(), sizeof(model.l1_bias));
-
-    for (int i = 0; i < n; ++i)
-    {
-        accumulator_add_feature(model, perspective[0], features[i]);
-        accumulator_add_feature(model, perspective[1], mgbb::flip_perspective(features[i]));
-    }
-}
-
-// Writes `dst` while reading `src`, so the copy is free: no separate memcpy
-// pass, and undoing costs nothing because `src` is never touched.
-inline void accumulator_transform(const NNUELayerStacksModelV2& model,
-    int16_t* __restrict dst, const int16_t* __restrict src,
-    const uint16_t* add, int n_add, const uint16_t* sub, int n_sub)
+// SSE baseline of AccumulatorChainKernel, see nnue_eval_v2_kernels.hpp.
+// Writes each step's dst while reading the step before, so the copy is free:
+// no separate memcpy pass, and undoing costs nothing because nothing earlier
+// in the chain is touched.
+inline void accumulator_chain_sse(const int16_t* src, const int16_t* l1_weights,
+    const AccumulatorStep* steps, int n_steps)
 {
+    constexpr int L1 = NNUELayerStacksModelV2::L1_SIZE;
     // 64 int16 at a time: 8 live vectors, comfortably inside the 16 XMM
     // registers Ivy Bridge gives us, with the weight rows streamed through.
     for (int c = 0; c < 256; c += 64)
@@ -104,43 +90,175 @@ inline void accumulator_transform(const NNUELayerStacksModelV2& model,
         __m128i v6 = _mm_load_si128(s + 6);
         __m128i v7 = _mm_load_si128(s + 7);
 
-        for (int k = 0; k < n_add; ++k)
+        for (int i = 0; i < n_steps; ++i)
         {
-            const __m128i* w = reinterpret_cast<const __m128i*>(model.l1_weights[add[k]].data() + c);
-            v0 = _mm_add_epi16(v0, _mm_load_si128(w + 0));
-            v1 = _mm_add_epi16(v1, _mm_load_si128(w + 1));
-            v2 = _mm_add_epi16(v2, _mm_load_si128(w + 2));
-            v3 = _mm_add_epi16(v3, _mm_load_si128(w + 3));
-            v4 = _mm_add_epi16(v4, _mm_load_si128(w + 4));
-            v5 = _mm_add_epi16(v5, _mm_load_si128(w + 5));
-            v6 = _mm_add_epi16(v6, _mm_load_si128(w + 6));
-            v7 = _mm_add_epi16(v7, _mm_load_si128(w + 7));
-        }
-        for (int k = 0; k < n_sub; ++k)
-        {
-            const __m128i* w = reinterpret_cast<const __m128i*>(model.l1_weights[sub[k]].data() + c);
-            v0 = _mm_sub_epi16(v0, _mm_load_si128(w + 0));
-            v1 = _mm_sub_epi16(v1, _mm_load_si128(w + 1));
-            v2 = _mm_sub_epi16(v2, _mm_load_si128(w + 2));
-            v3 = _mm_sub_epi16(v3, _mm_load_si128(w + 3));
-            v4 = _mm_sub_epi16(v4, _mm_load_si128(w + 4));
-            v5 = _mm_sub_epi16(v5, _mm_load_si128(w + 5));
-            v6 = _mm_sub_epi16(v6, _mm_load_si128(w + 6));
-            v7 = _mm_sub_epi16(v7, _mm_load_si128(w + 7));
+            const AccumulatorStep& step = steps[i];
+            for (int k = 0; k < step.n_add; ++k)
+            {
+                const __m128i* w = reinterpret_cast<const __m128i*>(l1_weights + step.add[k] * L1 + c);
+                v0 = _mm_add_epi16(v0, _mm_load_si128(w + 0));
+                v1 = _mm_add_epi16(v1, _mm_load_si128(w + 1));
+                v2 = _mm_add_epi16(v2, _mm_load_si128(w + 2));
+                v3 = _mm_add_epi16(v3, _mm_load_si128(w + 3));
+                v4 = _mm_add_epi16(v4, _mm_load_si128(w + 4));
+                v5 = _mm_add_epi16(v5, _mm_load_si128(w + 5));
+                v6 = _mm_add_epi16(v6, _mm_load_si128(w + 6));
+                v7 = _mm_add_epi16(v7, _mm_load_si128(w + 7));
+            }
+            for (int k = 0; k < step.n_sub; ++k)
+            {
+                const __m128i* w = reinterpret_cast<const __m128i*>(l1_weights + step.sub[k] * L1 + c);
+                v0 = _mm_sub_epi16(v0, _mm_load_si128(w + 0));
+                v1 = _mm_sub_epi16(v1, _mm_load_si128(w + 1));
+                v2 = _mm_sub_epi16(v2, _mm_load_si128(w + 2));
+                v3 = _mm_sub_epi16(v3, _mm_load_si128(w + 3));
+                v4 = _mm_sub_epi16(v4, _mm_load_si128(w + 4));
+                v5 = _mm_sub_epi16(v5, _mm_load_si128(w + 5));
+                v6 = _mm_sub_epi16(v6, _mm_load_si128(w + 6));
+                v7 = _mm_sub_epi16(v7, _mm_load_si128(w + 7));
+            }
+
+            __m128i* d = reinterpret_cast<__m128i*>(step.dst + c);
+            _mm_store_si128(d + 0, v0);
+            _mm_store_si128(d + 1, v1);
+            _mm_store_si128(d + 2, v2);
+            _mm_store_si128(d + 3, v3);
+            _mm_store_si128(d + 4, v4);
+            _mm_store_si128(d + 5, v5);
+            _mm_store_si128(d + 6, v6);
+            _mm_store_si128(d + 7, v7);
         }
+    }
+}
+
+// SSE baseline of AccumulatorTransformKernel: a chain of one.
+inline void accumulator_transform_sse(int16_t* dst, const int16_t* src,
+    const int16_t* l1_weights, const uint16_t* add, int n_add, const uint16_t* sub, int n_sub)
+{
+    const AccumulatorStep step{ dst, add, n_add, sub, n_sub };
+    accumulator_chain_sse(src, l1_weights, &step, 1);
+}
 
-        __m128i* d = reinterpret_cast<__m128i*>(dst + c);
-        _mm_store_si128(d + 0, v0);
-        _mm_store_si128(d + 1, v1);
-        _mm_store_si128(d + 2, v2);
-        _mm_store_si128(d + 3, v3);
-        _mm_store_si128(d + 4, v4);
-        _mm_store_si128(d + 5, v5);
-        _mm_store_si128(d + 6, v6);
-        _mm_store_si128(d + 7, v7);
+// SSE baseline of L2Kernel.
+inline void l2_sse(const int16_t* accumulator, const int16_t* l2_weights,
+    const int32_t* l2_bias, int32_t* l2_out)
+{
+    alignas(64) int16_t activated[256];
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i c127 = _mm_set1_epi16(127);
+        const __m128i* a = reinterpret_cast<const __m128i*>(accumulator);
+        __m128i* o = reinterpret_cast<__m128i*>(activated);
+        for (int i = 0; i < 32; ++i)
+            o[i] = _mm_min_epi16(_mm_max_epi16(_mm_load_si128(a + i), zero), c127);
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        __m128i sum = _mm_setzero_si128();
+        const __m128i* w = reinterpret_cast<const __m128i*>(l2_weights + i * 256);
+        const __m128i* in = reinterpret_cast<const __m128i*>(activated);
+        for (int j = 0; j < 32; ++j)
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_load_si128(w + j), _mm_load_si128(in + j)));
+
+        alignas(16) int32_t parts[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(parts), sum);
+        const int32_t total = l2_bias[i] + parts[0] + parts[1] + parts[2] + parts[3];
+        l2_out[i] = std::clamp(total >> 7, 0, 127);
     }
 }
 
+// SSE baseline of L3Kernel. SSE2 only, like everything the WebAssembly build
+// compiles: no _mm_min/max_epi32, so the clamp happens after the saturating
+// pack to int16, which cannot change a value that ends up in [0, 127].
+inline void l3_sse(const int32_t* l2_out, const int16_t* l3_weights,
+    const int32_t* l3_bias, int16_t* l3_out)
+{
+    // the 16 inputs as int16 pairs, pair p being inputs 2p and 2p+1
+    alignas(16) int32_t pairs[8];
+    {
+        const __m128i* in = reinterpret_cast<const __m128i*>(l2_out);
+        __m128i* o = reinterpret_cast<__m128i*>(pairs);
+        _mm_store_si128(o + 0, _mm_packs_epi32(_mm_loadu_si128(in + 0), _mm_loadu_si128(in + 1)));
+        _mm_store_si128(o + 1, _mm_packs_epi32(_mm_loadu_si128(in + 2), _mm_loadu_si128(in + 3)));
+    }
+
+    // all 32 outputs in 8 registers, spelled out like accumulator_transform_sse
+    // so they stay in registers at -O2 too
+    const __m128i* b = reinterpret_cast<const __m128i*>(l3_bias);
+    __m128i s0 = _mm_loadu_si128(b + 0);
+    __m128i s1 = _mm_loadu_si128(b + 1);
+    __m128i s2 = _mm_loadu_si128(b + 2);
+    __m128i s3 = _mm_loadu_si128(b + 3);
+    __m128i s4 = _mm_loadu_si128(b + 4);
+    __m128i s5 = _mm_loadu_si128(b + 5);
+    __m128i s6 = _mm_loadu_si128(b + 6);
+    __m128i s7 = _mm_loadu_si128(b + 7);
+
+    for (int p = 0; p < 8; ++p)
+    {
+        const __m128i pair = _mm_set1_epi32(pairs[p]);
+        const __m128i* w = reinterpret_cast<const __m128i*>(l3_weights) + p * 8;
+        s0 = _mm_add_epi32(s0, _mm_madd_epi16(pair, _mm_load_si128(w + 0)));
+        s1 = _mm_add_epi32(s1, _mm_madd_epi16(pair, _mm_load_si128(w + 1)));
+        s2 = _mm_add_epi32(s2, _mm_madd_epi16(pair, _mm_load_si128(w + 2)));
+        s3 = _mm_add_epi32(s3, _mm_madd_epi16(pair, _mm_load_si128(w + 3)));
+        s4 = _mm_add_epi32(s4, _mm_madd_epi16(pair, _mm_load_si128(w + 4)));
+        s5 = _mm_add_epi32(s5, _mm_madd_epi16(pair, _mm_load_si128(w + 5)));
+        s6 = _mm_add_epi32(s6, _mm_madd_epi16(pair, _mm_load_si128(w + 6)));
+        s7 = _mm_add_epi32(s7, _mm_madd_epi16(pair, _mm_load_si128(w + 7)));
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c127 = _mm_set1_epi16(127);
+    __m128i* o = reinterpret_cast<__m128i*>(l3_out);
+    const auto shift_pack_clamp = [&](__m128i lo, __m128i hi) {
+        const __m128i packed = _mm_packs_epi32(_mm_srai_epi32(lo, 7), _mm_srai_epi32(hi, 7));
+        return _mm_min_epi16(_mm_max_epi16(packed, zero), c127);
+    };
+    _mm_storeu_si128(o + 0, shift_pack_clamp(s0, s1));
+    _mm_storeu_si128(o + 1, shift_pack_clamp(s2, s3));
+    _mm_storeu_si128(o + 2, shift_pack_clamp(s4, s5));
+    _mm_storeu_si128(o + 3, shift_pack_clamp(s6, s7));
+}
+
+// SSE baseline of OutputKernel.
+inline int32_t output_sse(const int16_t* l3_out, const int16_t* out_weights, int32_t out_bias)
+{
+    const __m128i* in = reinterpret_cast<const __m128i*>(l3_out);
+    const __m128i* w = reinterpret_cast<const __m128i*>(out_weights);
+    __m128i sum = _mm_setzero_si128();
+    for (int k = 0; k < 4; ++k)
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128(in + k), _mm_loadu_si128(w + k)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return out_bias + _mm_cvtsi128_si32(sum);
+}
+
+// Through the kernel cpuid picked at startup.
+inline void accumulator_transform(const NNUELayerStacksModelV2& model,
+    int16_t* __restrict dst, const int16_t* __restrict src,
+    const uint16_t* add, int n_add, const uint16_t* sub, int n_sub)
+{
+    eval_v2_kernels().accumulator_transform(dst, src, model.l1_weights[0].data(), add, n_add, sub, n_sub);
+}
+
+// Both perspectives of a position, from scratch. Used for a root, or for any
+// position reached other than by a move from one we already have. One pass of
+// the transform kernel per perspective, from the bias, adding every feature.
+inline void build_accumulator(const NNUELayerStacksModelV2& model,
+    const mgbb::MigoyugoBB& board, int16_t (*perspective)[256])
+{
+    uint16_t features[192];
+    uint16_t flipped[192];
+    const int n = board.active_features(features);
+    for (int i = 0; i < n; ++i)
+        flipped[i] = static_cast<uint16_t>(mgbb::flip_perspective(features[i]));
+
+    accumulator_transform(model, perspective[0], model.l1_bias.data(), features, n, nullptr, 0);
+    accumulator_transform(model, perspective[1], model.l1_bias.data(), flipped, n, nullptr, 0);
+}
+
 // One move's worth of feature changes, both perspectives, dst <- src + delta.
 inline void accumulator_apply_delta(const NNUELayerStacksModelV2& model,
     int16_t (*dst)[256], const int16_t (*src)[256], const mgbb::FeatureDelta& delta)
@@ -167,53 +285,65 @@ inline void accumulator_apply_delta(const NNUELayerStacksModelV2& model,
     }
 }
 
+// Several moves' worth of feature changes in one pass, both perspectives:
+// dst[0] <- src + deltas[0], then dst[k] <- dst[k-1] + deltas[k]. Every
+// intermediate accumulator is stored, but each is loaded only once, as the
+// chain kernel carries it from one move to the next in registers.
+inline void accumulator_apply_deltas(const NNUELayerStacksModelV2& model,
+    int16_t (*dst)[2][256], const int16_t (*src)[256], const mgbb::FeatureDelta* deltas, int n)
+{
+    // steps per kernel call, bounding the flipped feature lists on the stack
+    constexpr int MAX_STEPS = 8;
+
+    while (n > 0)
+    {
+        const int n_steps = std::min(n, MAX_STEPS);
+        AccumulatorStep steps[MAX_STEPS];
+        uint16_t add[MAX_STEPS][mgbb::FeatureDelta::CAPACITY];
+        uint16_t sub[MAX_STEPS][mgbb::FeatureDelta::CAPACITY];
+
+        for (int i = 0; i < n_steps; ++i)
+            steps[i] = { dst[i][0], deltas[i].added, deltas[i].n_added, deltas[i].removed, deltas[i].n_removed };
+        eval_v2_kernels().accumulator_chain(src[0], model.l1_weights[0].data(), steps, n_steps);
+
+        for (int i = 0; i < n_steps; ++i)
+        {
+            const mgbb::FeatureDelta& delta = deltas[i];
+            for (int k = 0; k < delta.n_added; ++k)
+                add[i][k] = static_cast<uint16_t>(mgbb::flip_perspective(delta.added[k]));
+            for (int k = 0; k < delta.n_removed; ++k)
+                sub[i][k] = static_cast<uint16_t>(mgbb::flip_perspective(delta.removed[k]));
+            steps[i] = { dst[i][1], add[i], delta.n_added, sub[i], delta.n_removed };
+        }
+        eval_v2_kernels().accumulator_chain(src[1], model.l1_weights[0].data(), steps, n_steps);
+
+        src = dst[n_steps - 1];
+        dst += n_steps;
+        deltas += n_steps;
+        n -= n_steps;
+    }
+}
+
 // ----------------------------------------------------------------- eval ---
 
 // Returns the raw quantized sum; see the header comment on scaling.
 //
 // Identical arithmetic to NNUELayerStacksPlayer::evaluate_nnue_simd, so a v1
 // and a v2 export of the same checkpoint produce bit-identical values; only the
-// clipped ReLU is vectorised and the L1 index order differs.
+// L1 index order differs. All three layers run in the dispatched kernels, L3
+// against the interleaved weights prepare_nnue_layerstacks_v2() built.
 inline int32_t evaluate_accumulator(const NNUELayerStacksModelV2& model,
     const int16_t* accumulator, int bucket)
 {
-    alignas(64) int16_t activated[256];
-    {
-        const __m128i zero = _mm_setzero_si128();
-        const __m128i c127 = _mm_set1_epi16(127);
-        const __m128i* a = reinterpret_cast<const __m128i*>(accumulator);
-        __m128i* o = reinterpret_cast<__m128i*>(activated);
-        for (int i = 0; i < 32; ++i)
-            o[i] = _mm_min_epi16(_mm_max_epi16(_mm_load_si128(a + i), zero), c127);
-    }
+    const EvalV2Kernels& kernels = eval_v2_kernels();
 
     alignas(32) int32_t l2_out[16];
-    for (int i = 0; i < 16; ++i)
-    {
-        __m128i sum = _mm_setzero_si128();
-        const __m128i* w = reinterpret_cast<const __m128i*>(model.l2_weights[bucket][i].data());
-        const __m128i* in = reinterpret_cast<const __m128i*>(activated);
-        for (int j = 0; j < 32; ++j)
-            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_load_si128(w + j), _mm_load_si128(in + j)));
-
-        alignas(16) int32_t parts[4];
-        _mm_store_si128(reinterpret_cast<__m128i*>(parts), sum);
-        const int32_t total = model.l2_bias[bucket][i] + parts[0] + parts[1] + parts[2] + parts[3];
-        l2_out[i] = std::clamp(total >> 7, 0, 127);
-    }
-
-    alignas(32) int32_t l3_out[32];
-    for (int i = 0; i < 32; ++i)
-    {
-        int32_t total = model.l3_bias[bucket][i];
-        for (int j = 0; j < 16; ++j) total += model.l3_weights[bucket][i][j] * l2_out[j];
-        l3_out[i] = std::clamp(total >> 7, 0, 127);
-    }
+    kernels.l2(accumulator, model.l2_weights[bucket][0].data(), model.l2_bias[bucket].data(), l2_out);
 
-    int32_t final_sum = model.out_bias[bucket];
-    for (int i = 0; i < 32; ++i) final_sum += model.out_weights[bucket][i] * l3_out[i];
+    alignas(32) int16_t l3_out[32];
+    kernels.l3(l2_out, model.l3_weights_interleaved[bucket].data(), model.l3_bias[bucket].data(), l3_out);
 
-    return final_sum;
+    return kernels.output(l3_out, model.out_weights[bucket].data(), model.out_bias[bucket]);
 }
 
 // Convenience for callers that hold both perspectives and want the value in
@@ -21,6 +21,7 @@
 // mismatched weights file is rejected instead of being read as noise. Field
 // order must match scripts/export_nnue_layerstacks_v2.py exactly.
 
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
 #include <cstring>
@@ -54,11 +55,25 @@ struct alignas(64) NNUELayerStacksModelV2
 
     std::array<std::array<int16_t, L3_SIZE>, NUM_BUCKETS> out_weights;
     std::array<int32_t, NUM_BUCKETS> out_bias;
+
+    // Not in the file. l3_weights rearranged by prepare_nnue_layerstacks_v2()
+    // for the L3 kernels: for each pair of inputs (2p, 2p+1), the 32 outputs'
+    // weight pairs side by side, [bucket][p][output][2]. One madd against the
+    // broadcast input pair then yields a partial sum for consecutive outputs,
+    // with no horizontal adds.
+    alignas(64) std::array<std::array<int16_t, L2_SIZE * L3_SIZE>, NUM_BUCKETS> l3_weights_interleaved;
+
+    // Not in the file. A process-wide serial number handed out by every
+    // prepare_nnue_layerstacks_v2() call, so anything that caches results
+    // derived from the weights can tell a new model - or new weights written
+    // into the old one - from the one it cached, even at the same address.
+    // 0, as make_nnue_layerstacks_v2() zeroes it, until first prepared.
+    uint64_t generation;
 };
 
-// alignas(64) rounds sizeof() up past the last field, so the number of bytes
-// actually on disk is the extent of the fields, not sizeof(). Reading sizeof()
-// bytes would demand 32 bytes of padding the exporter never writes.
+// The number of bytes actually on disk is the extent of the exported fields,
+// not sizeof(): alignas(64) pads the struct, and the derived layouts after
+// out_bias are built at load time rather than read.
 inline constexpr size_t kNNUEModelV2PayloadBytes =
 offsetof(NNUELayerStacksModelV2, out_bias) + sizeof(NNUELayerStacksModelV2::out_bias);
 
@@ -113,6 +128,25 @@ inline bool check_nnue_layerstacks_v2_header(const NNUEModelV2Header& header, co
 // The exact number of bytes a valid weights file has.
 inline constexpr size_t kNNUEModelV2FileBytes = sizeof(NNUEModelV2Header) + kNNUEModelV2PayloadBytes;
 
+// Fills the derived fields from the exported ones. Every loader calls this
+// once the payload is in; anything that writes weights into a model by hand
+// must call it again afterwards.
+inline void prepare_nnue_layerstacks_v2(NNUELayerStacksModelV2& model)
+{
+    static std::atomic<uint64_t> next_generation{ 1 };
+
+    constexpr int L2 = NNUELayerStacksModelV2::L2_SIZE;
+    constexpr int L3 = NNUELayerStacksModelV2::L3_SIZE;
+    for (int b = 0; b < NNUELayerStacksModelV2::NUM_BUCKETS; ++b)
+        for (int p = 0; p < L2 / 2; ++p)
+            for (int i = 0; i < L3; ++i)
+            {
+                model.l3_weights_interleaved[b][(p * L3 + i) * 2 + 0] = model.l3_weights[b][i][2 * p];
+                model.l3_weights_interleaved[b][(p * L3 + i) * 2 + 1] = model.l3_weights[b][i][2 * p + 1];
+            }
+    model.generation = next_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
 // Allocates a model. Deliberately NOT std::make_shared: the type is
 // alignas(64) and the whole aligned-load argument in this header rests on
 // that, but make_shared fuses the control block and the object into one
@@ -150,6 +184,7 @@ inline std::shared_ptr<const NNUELayerStacksModelV2> load_nnue_layerstacks_v2_fr
     auto model = make_nnue_layerstacks_v2();
     std::memcpy(model.get(), static_cast<const uint8_t*>(data) + sizeof(header),
         kNNUEModelV2PayloadBytes);
+    prepare_nnue_layerstacks_v2(*model);
     return model;
 }
 
@@ -199,5 +234,6 @@ inline std::shared_ptr<const NNUELayerStacksModelV2> load_nnue_layerstacks_v2(co
         return nullptr;
     }
 
+    prepare_nnue_layerstacks_v2(*model);
     return model;
 }
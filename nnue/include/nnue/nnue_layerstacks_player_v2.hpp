@@ -27,20 +27,33 @@
 //
 // Everything the search touches lives on the stack or in members; the only
 // shared table is the TT, which stores scores and moves - never accumulators.
-
+//
+// That is also what makes Lazy SMP cheap to bolt on. With set_threads(n) the
+// search starts n - 1 helpers, each a private instance of this class with its
+// own accumulator stack, killers and history, all probing and storing into the
+// one table. Helpers never report a move; they exist to fill the TT with
+// results the main thread then finds already searched. Entries are two atomic
+// words, the second holding key ^ data, so a torn write from another thread
+// fails verification and reads as a miss instead of as a corrupt move.
+
+#include <common/large_pages.hpp>
 #include <common/player.hpp>
 #include <games/migoyugo_bb.hpp>
 
 #include "nnue_layerstacks_eval_v2.hpp"
 #include "nnue_layerstacks_model_v2.hpp"
+#include "nnue_refresh_cache_v2.hpp"
 
 #include <immintrin.h>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace rl::players
@@ -52,6 +65,7 @@ class NNUELayerStacksPlayerV2 : public rl::common::IPlayer
 {
 public:
     static constexpr int MAX_PLY = 96;
+    static constexpr int MAX_THREADS = 64;
     static constexpr int MATE = 30000;
     static constexpr int MATE_IN_MAX = MATE - 2 * MAX_PLY;
 
@@ -88,6 +102,7 @@ public:
         start_time_ = std::chrono::high_resolution_clock::now();
         time_up_ = false;
         nodes_ = 0;
+        helper_nodes_ = 0;
         ++generation_;
 
         // Reset the reported stats up front so the early returns below cannot
@@ -115,56 +130,31 @@ public:
         if ((legal & (legal - 1)) == 0) { last_move_ = mgbb::ctz64(legal); return last_move_; }
 
         state_ = root_;
-        int best_move = mgbb::ctz64(legal);
-        int best_score = 0;
-        int completed_depth = 0;
-
-        int alpha = -MATE;
-        int beta = MATE;
-        int window = 64;
 
-        for (int depth = 1; depth <= MAX_PLY - 8; ++depth)
+        // Helpers start only now: the early returns above need no search, and
+        // a helper started for them would have nothing to do but get joined.
+        std::vector<std::thread> pool;
+        stop_.store(false, std::memory_order_relaxed);
+        for (size_t i = 0; i < helpers_.size(); ++i)
         {
-            while (true)
-            {
-                root_best_move_ = -1;
-                const int score = search_root(depth, alpha, beta);
-                if (time_up_) break;
-
-                if (score <= alpha)
-                {
-                    // Fail low: re-search with a lower floor, keeping beta so
-                    // the window does not explode in both directions at once.
-                    beta = (alpha + beta) / 2;
-                    alpha = std::max(-MATE, score - window);
-                    window *= 4;
-                    continue;
-                }
-                if (score >= beta)
-                {
-                    beta = std::min(MATE, score + window);
-                    window *= 4;
-                    continue;
-                }
-
-                best_score = score;
-                if (root_best_move_ >= 0) best_move = root_best_move_;
-                completed_depth = depth;
-                break;
-            }
-
-            if (time_up_) break;
-
-            // A proven result cannot improve with more depth.
-            if (std::abs(best_score) >= MATE_IN_MAX) break;
+            NNUELayerStacksPlayerV2& h = *helpers_[i];
+            prepare_helper(h);
+            // Every other helper runs one ply ahead of the main thread, so the
+            // table holds a deeper result by the time the main thread gets there.
+            const int first_depth = 1 + static_cast<int>((i + 1) & 1);
+            pool.emplace_back([&h, first_depth] {
+                int move = -1, score = 0;
+                h.iterate(first_depth, false, move, score);
+            });
+        }
 
-            window = 64;
-            alpha = std::max(-MATE, best_score - window);
-            beta = std::min(MATE, best_score + window);
+        int best_move = mgbb::ctz64(legal);
+        int best_score = 0;
+        const int completed_depth = iterate(1, true, best_move, best_score);
 
-            const auto now = std::chrono::high_resolution_clock::now();
-            if ((now - start_time_) * 2 > max_duration_) break;
-        }
+        stop_.store(true, std::memory_order_relaxed);
+        for (auto& t : pool) t.join();
+        for (const auto& h : helpers_) helper_nodes_ += h->nodes_;
 
         last_depth_ = completed_depth;
         last_score_ = best_score;
@@ -176,8 +166,8 @@ public:
         {
             std::cout << "NNUE-LS-v2  depth " << last_depth_
                 << "\tscore " << last_score_ / 1024.0
-                << "\tnodes " << nodes_
-                << "\tnps " << static_cast<uint64_t>(last_elapsed_ > 0 ? nodes_ / last_elapsed_ : 0)
+                << "\tnodes " << nodes()
+                << "\tnps " << static_cast<uint64_t>(last_elapsed_ > 0 ? nodes() / last_elapsed_ : 0)
                 << "\tmove " << last_move_ << std::endl;
         }
 
@@ -185,12 +175,16 @@ public:
     }
 
     // Fixed-depth entry point for benchmarking and for the forced-move
-    // soundness test, which needs to compare scores at equal depth.
+    // soundness test, which needs to compare scores at equal depth. Always
+    // single-threaded, whatever set_threads says: helpers would make both the
+    // node count and the score depend on scheduling.
     int search_fixed_depth(const mgbb::MigoyugoBB& position, int depth, int* out_move = nullptr)
     {
         start_time_ = std::chrono::high_resolution_clock::now();
         time_up_ = false;
         nodes_ = 0;
+        helper_nodes_ = 0;
+        stop_.store(false, std::memory_order_relaxed);
         ++generation_;
         root_ = position;
         std::memset(killers_, 0xff, sizeof(killers_));
@@ -214,7 +208,24 @@ public:
     void set_max_duration(std::chrono::duration<int, std::milli> d) { max_duration_ = d; }
     void set_verbose(bool on) { verbose_ = on; }
 
-    uint64_t nodes() const { return nodes_; }
+    // Search threads, main thread included. 1 is the plain single-threaded
+    // search and stays the default; the helpers for n > 1 are allocated here,
+    // not per move. Clamped to 1 in a WebAssembly build without pthreads,
+    // where std::thread cannot start and the module must not throw.
+    void set_threads(int n)
+    {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+        n = 1;
+#endif
+        n = std::clamp(n, 1, MAX_THREADS);
+        while (static_cast<int>(helpers_.size()) > n - 1) helpers_.pop_back();
+        while (static_cast<int>(helpers_.size()) < n - 1)
+            helpers_.push_back(std::unique_ptr<NNUELayerStacksPlayerV2>(new NNUELayerStacksPlayerV2(*this, HelperTag{})));
+    }
+    int threads() const { return static_cast<int>(helpers_.size()) + 1; }
+
+    // Every thread's nodes for the last search, helpers included.
+    uint64_t nodes() const { return nodes_ + helper_nodes_; }
 
     // Stats from the last search, for a UI readout that does not have to
     // scrape stdout.
@@ -223,20 +234,38 @@ public:
     int last_move() const { return last_move_; }
     double last_elapsed_s() const { return last_elapsed_; }
 
-    void resize_tt(size_t mb)
+    // The table is a LargePageBuffer: on Linux it sits on transparent huge
+    // pages when the kernel has them, so a probe into a 1 GB table is one
+    // cache miss instead of a cache miss and a page walk. huge_pages = false
+    // asks for ordinary pages, for measuring exactly that.
+    void resize_tt(size_t mb, bool huge_pages = true)
     {
         size_t clusters = (mb * 1024 * 1024) / sizeof(TTCluster);
         size_t pow2 = 1;
         while (pow2 * 2 <= clusters) pow2 *= 2;
         if (pow2 < 1024) pow2 = 1024;
-        tt_.assign(pow2, TTCluster{});
+        tt_storage_ = rl::common::LargePageBuffer(); // free the old table before the new one exists
+        tt_storage_ = rl::common::LargePageBuffer(pow2 * sizeof(TTCluster), huge_pages);
+        // Zeroed memory is an empty table: the clusters are trivially
+        // constructible, and a slot of zeros has BOUND_NONE.
+        tt_ = static_cast<TTCluster*>(tt_storage_.data());
         tt_mask_ = pow2 - 1;
     }
 
+    bool tt_huge_pages() const { return tt_storage_.huge_pages(); }
+
     void clear_tt()
     {
-        std::fill(tt_.begin(), tt_.end(), TTCluster{});
+        for (size_t i = 0; i <= tt_mask_; ++i)
+        {
+            for (TTSlot& e : tt_[i].e)
+            {
+                e.check.store(0, std::memory_order_relaxed);
+                e.data.store(0, std::memory_order_relaxed);
+            }
+        }
         std::memset(history_, 0, sizeof(history_));
+        for (auto& h : helpers_) std::memset(h->history_, 0, sizeof(h->history_));
         generation_ = 0;
     }
 
@@ -257,63 +286,123 @@ private:
     static constexpr uint8_t BOUND_EXACT = 3;
     static constexpr int16_t NO_EVAL = INT16_MIN;
 
+    // What the search reads and writes: one entry, decoded.
     struct TTEntry
     {
-        uint32_t key32;
         int16_t value;
         int16_t eval;
         uint8_t depth;
         uint8_t gen_bound; // generation << 2 | bound
         uint8_t move;      // 0..63, 0xff for none
-        uint8_t pad[5];    // pads the entry to 16 bytes: 4 per cache line
     };
-    struct TTCluster { TTEntry e[4]; };
-    static_assert(sizeof(TTEntry) == 16, "TT entry should be 16 bytes");
+
+    // What the table holds: the entry packed into one word, next to the full
+    // key XORed with that word. Both are relaxed atomics, so a reader racing a
+    // writer sees each word whole but may pair one write's data with another's
+    // check - which then matches no key and reads as a miss.
+    struct TTSlot
+    {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+    struct alignas(64) TTCluster { TTSlot e[4]; };
+    static_assert(sizeof(TTSlot) == 16, "TT slot should be 16 bytes");
     static_assert(sizeof(TTCluster) == 64, "TT cluster should be one cache line");
+    static_assert(std::is_trivially_default_constructible_v<TTCluster>,
+        "resize_tt hands out zeroed memory as clusters");
+
+    static uint64_t tt_pack(const TTEntry& e)
+    {
+        return static_cast<uint64_t>(static_cast<uint16_t>(e.value))
+            | (static_cast<uint64_t>(static_cast<uint16_t>(e.eval)) << 16)
+            | (static_cast<uint64_t>(e.depth) << 32)
+            | (static_cast<uint64_t>(e.gen_bound) << 40)
+            | (static_cast<uint64_t>(e.move) << 48);
+    }
+
+    static TTEntry tt_unpack(uint64_t d)
+    {
+        TTEntry e;
+        e.value = static_cast<int16_t>(static_cast<uint16_t>(d));
+        e.eval = static_cast<int16_t>(static_cast<uint16_t>(d >> 16));
+        e.depth = static_cast<uint8_t>(d >> 32);
+        e.gen_bound = static_cast<uint8_t>(d >> 40);
+        e.move = static_cast<uint8_t>(d >> 48);
+        return e;
+    }
+
+    static void tt_write(TTSlot& slot, uint64_t key, const TTEntry& e)
+    {
+        const uint64_t d = tt_pack(e);
+        slot.data.store(d, std::memory_order_relaxed);
+        slot.check.store(key ^ d, std::memory_order_relaxed);
+    }
 
-    TTEntry* tt_probe(uint64_t key, bool& hit)
+    // Issued as soon as a move has produced the child's key, so the line is on
+    // its way while the child checks the clock, its legal moves and the
+    // forced-move rule, all before its own tt_probe.
+    void tt_prefetch(uint64_t key) const
+    {
+        _mm_prefetch(reinterpret_cast<const char*>(&tt_[(key >> 32) & tt_mask_]), _MM_HINT_T0);
+    }
+
+    // Returns the slot holding `key` (hit, with the entry decoded into `out`)
+    // or the slot to replace (miss, `out` untouched).
+    TTSlot* tt_probe(uint64_t key, bool& hit, TTEntry& out)
     {
         TTCluster& c = tt_[(key >> 32) & tt_mask_];
-        const uint32_t k32 = static_cast<uint32_t>(key);
+        const uint8_t gen = static_cast<uint8_t>(generation_ << 2);
 
         for (int i = 0; i < 4; ++i)
         {
-            if (c.e[i].key32 == k32 && (c.e[i].gen_bound & 3) != BOUND_NONE)
+            const uint64_t d = c.e[i].data.load(std::memory_order_relaxed);
+            if ((c.e[i].check.load(std::memory_order_relaxed) ^ d) != key) continue;
+
+            TTEntry e = tt_unpack(d);
+            if ((e.gen_bound & 3) == BOUND_NONE) continue;
+
+            // Only rewrite when the generation actually changes, so threads
+            // sharing a hot entry do not keep stealing its line from each other.
+            if ((e.gen_bound & ~3) != gen)
             {
-                c.e[i].gen_bound = static_cast<uint8_t>((generation_ << 2) | (c.e[i].gen_bound & 3));
-                hit = true;
-                return &c.e[i];
+                e.gen_bound = static_cast<uint8_t>(gen | (e.gen_bound & 3));
+                tt_write(c.e[i], key, e);
             }
+            hit = true;
+            out = e;
+            return &c.e[i];
         }
 
         // Depth-preferred, with entries from older searches heavily discounted.
         hit = false;
-        TTEntry* victim = &c.e[0];
+        TTSlot* victim = &c.e[0];
         int worst = INT32_MAX;
         for (int i = 0; i < 4; ++i)
         {
-            if ((c.e[i].gen_bound & 3) == BOUND_NONE) return &c.e[i];
-            const int age = ((c.e[i].gen_bound >> 2) == (generation_ & 63)) ? 0 : 1;
-            const int value = c.e[i].depth - 8 * age;
+            const TTEntry e = tt_unpack(c.e[i].data.load(std::memory_order_relaxed));
+            if ((e.gen_bound & 3) == BOUND_NONE) return &c.e[i];
+            const int age = ((e.gen_bound >> 2) == (generation_ & 63)) ? 0 : 1;
+            const int value = e.depth - 8 * age;
             if (value < worst) { worst = value; victim = &c.e[i]; }
         }
         return victim;
     }
 
-    void tt_store(TTEntry* e, uint64_t key, int value, int eval, int depth, uint8_t bound, int move, int ply)
+    void tt_store(TTSlot* slot, uint64_t key, int value, int eval, int depth, uint8_t bound, int move, int ply)
     {
-        const uint32_t k32 = static_cast<uint32_t>(key);
-
         // Never throw away a deeper result for the same position from this
         // same search, unless the new one is exact.
-        if (e->key32 == k32 && depth < e->depth - 2 && bound != BOUND_EXACT) return;
-
-        e->key32 = k32;
-        e->value = static_cast<int16_t>(to_tt_score(value, ply));
-        e->eval = static_cast<int16_t>(eval);
-        e->depth = static_cast<uint8_t>(std::clamp(depth, 0, 255));
-        e->gen_bound = static_cast<uint8_t>((generation_ << 2) | bound);
-        e->move = static_cast<uint8_t>(move < 0 ? 0xff : move);
+        const uint64_t d = slot->data.load(std::memory_order_relaxed);
+        if ((slot->check.load(std::memory_order_relaxed) ^ d) == key
+            && depth < tt_unpack(d).depth - 2 && bound != BOUND_EXACT) return;
+
+        TTEntry e;
+        e.value = static_cast<int16_t>(to_tt_score(value, ply));
+        e.eval = static_cast<int16_t>(eval);
+        e.depth = static_cast<uint8_t>(std::clamp(depth, 0, 255));
+        e.gen_bound = static_cast<uint8_t>((generation_ << 2) | bound);
+        e.move = static_cast<uint8_t>(move < 0 ? 0xff : move);
+        tt_write(*slot, key, e);
     }
 
     // Mate scores are stored as distance-to-mate from the entry's own position
@@ -340,15 +429,31 @@ private:
 
     void init_root_accumulator()
     {
-        rl::nnue::build_accumulator(*model_, root_, acc_[0]);
+        refresh_cache_.refresh(*model_, root_, acc_[0]);
+        acc_ready_[0] = true;
     }
 
-    // Writes the child accumulator while reading the parent's, so the copy is
-    // free: no separate memcpy pass, and undo costs nothing because the parent
-    // slot is never touched.
-    void apply_delta(int parent_ply, int child_ply, const mgbb::FeatureDelta& d)
+    // Accumulators are brought up to date lazily. A move only leaves its
+    // FeatureDelta in deltas_[child_ply], written there by do_move, and marks
+    // the child stale; nodes cut by the table, the forced-move verdict or
+    // mate-distance pruning never pay for one. Undo costs nothing because no
+    // ancestor's slot is ever touched.
+    void defer_delta(int child_ply)
     {
-        rl::nnue::accumulator_apply_delta(*model_, acc_[child_ply], acc_[parent_ply], d);
+        acc_ready_[child_ply] = false;
+    }
+
+    // Walks back to the nearest ancestor whose accumulator is current and
+    // replays every pending move from there in one fused pass, storing each
+    // ply on the way so that their other children start from them.
+    void materialize_accumulator(int ply)
+    {
+        if (acc_ready_[ply]) return;
+        int ready = ply - 1;
+        while (!acc_ready_[ready]) --ready;
+        rl::nnue::accumulator_apply_deltas(*model_, acc_ + ready + 1, acc_[ready],
+            deltas_ + ready + 1, ply - ready);
+        for (int p = ready + 1; p <= ply; ++p) acc_ready_[p] = true;
     }
 
     // ------------------------------------------------------------- eval ---
@@ -356,19 +461,105 @@ private:
     // Engine units: the raw quantized sum shifted down by EVAL_SHIFT.
     int evaluate(int ply)
     {
+        materialize_accumulator(ply);
         return rl::nnue::evaluate_accumulator(*model_, acc_[ply][state_.stm],
             rl::nnue::compute_bucket_index(state_)) >> EVAL_SHIFT;
     }
 
     // ----------------------------------------------------------- search ---
 
+    // Helpers also stop when the main thread does, which is the only way they
+    // ever stop short of the budget: they have no soft limit of their own.
     bool out_of_time()
     {
         if ((++nodes_ & 2047) != 0) return time_up_;
-        if (std::chrono::high_resolution_clock::now() - start_time_ > max_duration_) time_up_ = true;
+        if (stop_flag_->load(std::memory_order_relaxed)
+            || std::chrono::high_resolution_clock::now() - start_time_ > max_duration_) time_up_ = true;
         return time_up_;
     }
 
+    // Iterative deepening with aspiration windows from `first_depth` up,
+    // starting from state_ == root_. Returns the last completed depth and
+    // leaves that iteration's move and score in the out parameters.
+    //
+    // The main thread also stops on a proven result and on the soft limit -
+    // not starting an iteration it could not finish; helpers only on stop_.
+    int iterate(int first_depth, bool is_main, int& best_move, int& best_score)
+    {
+        int completed_depth = 0;
+
+        int alpha = -MATE;
+        int beta = MATE;
+        int window = 64;
+
+        for (int depth = first_depth; depth <= MAX_PLY - 8; ++depth)
+        {
+            while (true)
+            {
+                root_best_move_ = -1;
+                const int score = search_root(depth, alpha, beta);
+                if (time_up_) break;
+
+                if (score <= alpha)
+                {
+                    // Fail low: re-search with a lower floor, keeping beta so
+                    // the window does not explode in both directions at once.
+                    beta = (alpha + beta) / 2;
+                    alpha = std::max(-MATE, score - window);
+                    window *= 4;
+                    continue;
+                }
+                if (score >= beta)
+                {
+                    beta = std::min(MATE, score + window);
+                    window *= 4;
+                    continue;
+                }
+
+                best_score = score;
+                if (root_best_move_ >= 0) best_move = root_best_move_;
+                completed_depth = depth;
+                break;
+            }
+
+            if (time_up_) break;
+
+            // A proven result cannot improve with more depth.
+            if (is_main && std::abs(best_score) >= MATE_IN_MAX) break;
+
+            window = 64;
+            alpha = std::max(-MATE, best_score - window);
+            beta = std::min(MATE, best_score + window);
+
+            const auto now = std::chrono::high_resolution_clock::now();
+            if (is_main && (now - start_time_) * 2 > max_duration_) break;
+        }
+
+        return completed_depth;
+    }
+
+    // Everything a helper needs from the main thread for one search. The table
+    // pointer is refreshed every time because resize_tt may have moved it.
+    void prepare_helper(NNUELayerStacksPlayerV2& h) const
+    {
+        h.tt_ = tt_;
+        h.tt_mask_ = tt_mask_;
+        h.generation_ = generation_;
+        h.start_time_ = start_time_;
+        h.max_duration_ = max_duration_;
+        h.use_forced_moves_ = use_forced_moves_;
+        h.use_lmr_ = use_lmr_;
+        h.time_up_ = false;
+        h.nodes_ = 0;
+
+        h.root_ = root_;
+        std::memset(h.killers_, 0xff, sizeof(h.killers_));
+        h.age_history();
+        std::memcpy(h.acc_[0], acc_[0], sizeof(acc_[0]));
+        h.acc_ready_[0] = true;
+        h.state_ = h.root_;
+    }
+
     // Score for a Wego: the side to move has no legal move, so the game ends
     // now and the Yugo count decides it.
     int wego_score(int ply) const
@@ -507,8 +698,9 @@ private:
         }
 
         bool hit = false;
-        TTEntry* tte = tt_probe(state_.key, hit);
-        const int tt_move = (hit && tte->move != 0xff) ? tte->move : -1;
+        TTEntry tte;
+        TTSlot* slot = tt_probe(state_.key, hit, tte);
+        const int tt_move = (hit && tte.move != 0xff) ? tte.move : -1;
 
         MoveList ml;
         order_moves(legal, 0, tt_move, ml);
@@ -522,8 +714,7 @@ private:
             const int move = pick_next(ml, i);
 
             mgbb::Undo u;
-            mgbb::FeatureDelta delta;
-            const bool igo = state_.do_move(move, u, delta);
+            const bool igo = state_.do_move(move, u, deltas_[1]);
 
             int score;
             if (igo)
@@ -532,7 +723,8 @@ private:
             }
             else
             {
-                apply_delta(0, 1, delta);
+                tt_prefetch(state_.key);
+                defer_delta(1);
                 if (i == 0)
                 {
                     score = -search(depth - 1, -beta, -alpha, 1);
@@ -563,7 +755,7 @@ private:
             root_best_move_ = best_move;
             const uint8_t bound = best >= beta ? BOUND_LOWER
                 : (best > alpha_orig ? BOUND_EXACT : BOUND_UPPER);
-            tt_store(tte, state_.key, best, NO_EVAL, depth, bound, best_move, 0);
+            tt_store(slot, state_.key, best, NO_EVAL, depth, bound, best_move, 0);
         }
 
         return best;
@@ -591,19 +783,20 @@ private:
         if (apply_forced_moves(legal, ply, decided) == Verdict::Decided) return decided;
 
         bool hit = false;
-        TTEntry* tte = tt_probe(state_.key, hit);
+        TTEntry tte;
+        TTSlot* slot = tt_probe(state_.key, hit, tte);
         int tt_move = -1;
         int static_eval = NO_EVAL;
 
         if (hit)
         {
-            if (tte->move != 0xff) tt_move = tte->move;
-            static_eval = tte->eval;
+            if (tte.move != 0xff) tt_move = tte.move;
+            static_eval = tte.eval;
 
-            if (tte->depth >= depth)
+            if (tte.depth >= depth)
             {
-                const int v = from_tt_score(tte->value, ply);
-                const uint8_t bound = tte->gen_bound & 3;
+                const int v = from_tt_score(tte.value, ply);
+                const uint8_t bound = tte.gen_bound & 3;
                 if (bound == BOUND_EXACT) return v;
                 if (bound == BOUND_LOWER && v >= beta) return v;
                 if (bound == BOUND_UPPER && v <= alpha) return v;
@@ -617,7 +810,7 @@ private:
             // above already catches the tactic that matters at the horizon.
             const int e = (static_eval != NO_EVAL) ? static_eval : evaluate(ply);
             if (static_eval == NO_EVAL)
-                tt_store(tte, state_.key, e, e, 0, BOUND_EXACT, -1, ply);
+                tt_store(slot, state_.key, e, e, 0, BOUND_EXACT, -1, ply);
             return e;
         }
 
@@ -638,8 +831,7 @@ private:
                 || move == killers_[ply][1];
 
             mgbb::Undo u;
-            mgbb::FeatureDelta delta;
-            const bool igo = state_.do_move(move, u, delta);
+            const bool igo = state_.do_move(move, u, deltas_[ply + 1]);
 
             int score;
             if (igo)
@@ -648,7 +840,8 @@ private:
             }
             else
             {
-                apply_delta(ply, ply + 1, delta);
+                tt_prefetch(state_.key);
+                defer_delta(ply + 1);
 
                 // Late move reductions: after the first few moves, and only for
                 // moves nothing has flagged as interesting, search shallower
@@ -690,14 +883,28 @@ private:
 
         const uint8_t bound = best >= beta ? BOUND_LOWER
             : (best > alpha_orig ? BOUND_EXACT : BOUND_UPPER);
-        tt_store(tte, state_.key, best, static_eval, depth, bound, best_move, ply);
+        tt_store(slot, state_.key, best, static_eval, depth, bound, best_move, ply);
 
         return best;
     }
 
+    // A Lazy SMP helper: shares the model, and the main thread's table and
+    // stop flag through prepare_helper; owns no table of its own.
+    struct HelperTag {};
+    NNUELayerStacksPlayerV2(const NNUELayerStacksPlayerV2& main, HelperTag)
+        : model_(main.model_), max_duration_(main.max_duration_), stop_flag_(&main.stop_),
+        verbose_(false)
+    {
+    }
+
     // ----------------------------------------------------------- members ---
 
     alignas(64) int16_t acc_[MAX_PLY + 1][2][256];
+    // deltas_[ply] is the move into ply; acc_ready_[ply] says acc_[ply] has it
+    mgbb::FeatureDelta deltas_[MAX_PLY + 1];
+    bool acc_ready_[MAX_PLY + 1]{};
+    // successive roots share most of their features, see nnue_refresh_cache_v2.hpp
+    rl::nnue::AccumulatorRefreshCache refresh_cache_;
 
     std::shared_ptr<const NNUELayerStacksModelV2> model_;
     std::chrono::duration<int, std::milli> max_duration_;
@@ -706,9 +913,16 @@ private:
     mgbb::MigoyugoBB root_;
     mgbb::MigoyugoBB state_;
 
-    std::vector<TTCluster> tt_;
+    // Owned by the main thread; helpers point tt_ at the main thread's table.
+    rl::common::LargePageBuffer tt_storage_;
+    TTCluster* tt_{ nullptr };
     size_t tt_mask_{ 0 };
 
+    std::vector<std::unique_ptr<NNUELayerStacksPlayerV2>> helpers_;
+    std::atomic<bool> stop_{ false };
+    const std::atomic<bool>* stop_flag_{ &stop_ };
+    uint64_t helper_nodes_{ 0 };
+
     int killers_[MAX_PLY][2]{};
     int history_[2][64]{};
 
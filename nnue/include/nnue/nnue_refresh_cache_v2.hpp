@@ -0,0 +1,141 @@
+#ifndef RL_NNUE_NNUE_REFRESH_CACHE_V2_HPP_
+#define RL_NNUE_NNUE_REFRESH_CACHE_V2_HPP_
+
+// A refresh cache, the "Finny table" of chess engines, in front of
+// build_accumulator.
+//
+// Building an accumulator from the bias costs one weight row per active
+// feature, per perspective, and a midgame board has dozens of them. The
+// positions a player has to build from scratch are mostly its successive
+// search roots, two plies apart, so they share almost every feature. The cache
+// keeps the last accumulator built under each signature together with its
+// feature set, and a new position with the same signature costs only the rows
+// in the symmetric difference. When that difference is no smaller than the
+// position's own feature list, or the entry is empty, it calls build_accumulator
+// itself; a miss then costs that plus the bookkeeping - a dozen popcounts and a
+// 1 KB copy into the entry - which is measurable when nothing is ever shared,
+// e.g. positions in random order, but small next to the rows.
+//
+// The signature is the layer-stack bucket, which only moves forward as pieces
+// accumulate, so consecutive roots of a game land on one entry and the entry
+// is replaced only when the game moves into its next phase.
+//
+// Results are bit-identical to build_accumulator, since the int16 additions
+// wrap and so do not depend on order. One cache per thread; it is not shared.
+// Entries are tagged with the model's generation rather than its address, so a
+// model freed and replaced by another at the same address, or reloaded in
+// place, empties the cache instead of feeding it stale accumulators.
+
+#include <games/migoyugo_bb.hpp>
+
+#include "nnue_layerstacks_eval_v2.hpp"
+#include "nnue_layerstacks_model_v2.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace rl::nnue
+{
+
+class AccumulatorRefreshCache
+{
+public:
+    // 384 features, one bit each: migo/yugo of White, migo/yugo of Black,
+    // then each side's piline set, in feature id order.
+    static constexpr int FEATURE_WORDS = NNUELayerStacksModelV2::NUM_FEATURES / 64;
+
+    // Both perspectives of `board`, as build_accumulator would write them.
+    void refresh(const NNUELayerStacksModelV2& model, const mgbb::MigoyugoBB& board,
+        int16_t (*perspective)[256])
+    {
+        // an unprepared model has no generation to tell it apart, never trust the entries
+        if (model.generation != generation_ || model.generation == 0)
+        {
+            clear();
+            generation_ = model.generation;
+        }
+
+        const uint64_t features[FEATURE_WORDS] = {
+            board.migo[0], board.yugo[0], board.migo[1], board.yugo[1], board.piline[0], board.piline[1] };
+        int n_features = 0;
+        for (int w = 0; w < FEATURE_WORDS; ++w) n_features += mgbb::popcount64(features[w]);
+
+        Entry& entry = entries_[compute_bucket_index(board)];
+
+        uint16_t add[2][NNUELayerStacksModelV2::NUM_FEATURES];
+        uint16_t sub[2][NNUELayerStacksModelV2::NUM_FEATURES];
+        int n_add = 0;
+        int n_sub = 0;
+        if (entry.valid)
+        {
+            for (int w = 0; w < FEATURE_WORDS; ++w)
+            {
+                n_add += mgbb::popcount64(features[w] & ~entry.features[w]);
+                n_sub += mgbb::popcount64(entry.features[w] & ~features[w]);
+            }
+        }
+
+        if (entry.valid && n_add + n_sub < n_features)
+        {
+            n_add = collect(features, entry.features, add[0]);
+            n_sub = collect(entry.features, features, sub[0]);
+            for (int i = 0; i < n_add; ++i) add[1][i] = static_cast<uint16_t>(mgbb::flip_perspective(add[0][i]));
+            for (int i = 0; i < n_sub; ++i) sub[1][i] = static_cast<uint16_t>(mgbb::flip_perspective(sub[0][i]));
+
+            for (int p = 0; p < 2; ++p)
+                accumulator_transform(model, perspective[p], entry.perspective[p], add[p], n_add, sub[p], n_sub);
+            n_rows_ += n_add + n_sub;
+            ++n_updates_;
+        }
+        else
+        {
+            build_accumulator(model, board, perspective);
+            n_rows_ += n_features;
+            ++n_rebuilds_;
+        }
+
+        std::memcpy(entry.perspective, perspective, sizeof(entry.perspective));
+        std::memcpy(entry.features, features, sizeof(entry.features));
+        entry.valid = true;
+    }
+
+    void clear()
+    {
+        for (Entry& entry : entries_) entry.valid = false;
+        generation_ = 0;
+    }
+
+    // Positions served from an entry, positions built from the bias, and
+    // the weight rows applied for them, per perspective.
+    long long updates() const { return n_updates_; }
+    long long rebuilds() const { return n_rebuilds_; }
+    long long rows() const { return n_rows_; }
+
+private:
+    struct Entry
+    {
+        alignas(64) int16_t perspective[2][256];
+        uint64_t features[FEATURE_WORDS];
+        bool valid{ false };
+    };
+
+    // The feature ids in `from` but not in `except`, White's point of view.
+    static int collect(const uint64_t* from, const uint64_t* except, uint16_t* out)
+    {
+        int n = 0;
+        for (int w = 0; w < FEATURE_WORDS; ++w)
+            for (uint64_t b = from[w] & ~except[w]; b; b &= b - 1)
+                out[n++] = static_cast<uint16_t>(w * 64 + mgbb::ctz64(b));
+        return n;
+    }
+
+    Entry entries_[NNUELayerStacksModelV2::NUM_BUCKETS];
+    uint64_t generation_{ 0 };
+    long long n_updates_{ 0 };
+    long long n_rebuilds_{ 0 };
+    long long n_rows_{ 0 };
+};
+
+} // namespace rl::nnue
+
+#endif
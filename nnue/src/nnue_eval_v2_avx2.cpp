@@ -0,0 +1,165 @@
+// AVX2 kernels of the v2 network, compiled with -mavx2 and only reached
+// through eval_v2_kernels() on a CPU that has it. Includes nothing that
+// defines an inline function, see nnue_eval_v2_kernels.hpp.
+
+#include <nnue/nnue_eval_v2_kernels.hpp>
+
+#include <immintrin.h>
+
+namespace rl::nnue
+{
+
+void accumulator_chain_avx2(const int16_t* src, const int16_t* l1_weights,
+    const AccumulatorStep* steps, int n_steps)
+{
+    // 128 int16 at a time in 8 named registers: an array of 16 covering the
+    // whole accumulator ends up on the stack instead, at -O2 and -O3 alike
+    for (int c = 0; c < 256; c += 128)
+    {
+        const __m256i* s = reinterpret_cast<const __m256i*>(src + c);
+        __m256i v0 = _mm256_loadu_si256(s + 0);
+        __m256i v1 = _mm256_loadu_si256(s + 1);
+        __m256i v2 = _mm256_loadu_si256(s + 2);
+        __m256i v3 = _mm256_loadu_si256(s + 3);
+        __m256i v4 = _mm256_loadu_si256(s + 4);
+        __m256i v5 = _mm256_loadu_si256(s + 5);
+        __m256i v6 = _mm256_loadu_si256(s + 6);
+        __m256i v7 = _mm256_loadu_si256(s + 7);
+
+        for (int i = 0; i < n_steps; ++i)
+        {
+            const AccumulatorStep& step = steps[i];
+            for (int k = 0; k < step.n_add; ++k)
+            {
+                const __m256i* w = reinterpret_cast<const __m256i*>(l1_weights + step.add[k] * 256 + c);
+                v0 = _mm256_add_epi16(v0, _mm256_load_si256(w + 0));
+                v1 = _mm256_add_epi16(v1, _mm256_load_si256(w + 1));
+                v2 = _mm256_add_epi16(v2, _mm256_load_si256(w + 2));
+                v3 = _mm256_add_epi16(v3, _mm256_load_si256(w + 3));
+                v4 = _mm256_add_epi16(v4, _mm256_load_si256(w + 4));
+                v5 = _mm256_add_epi16(v5, _mm256_load_si256(w + 5));
+                v6 = _mm256_add_epi16(v6, _mm256_load_si256(w + 6));
+                v7 = _mm256_add_epi16(v7, _mm256_load_si256(w + 7));
+            }
+            for (int k = 0; k < step.n_sub; ++k)
+            {
+                const __m256i* w = reinterpret_cast<const __m256i*>(l1_weights + step.sub[k] * 256 + c);
+                v0 = _mm256_sub_epi16(v0, _mm256_load_si256(w + 0));
+                v1 = _mm256_sub_epi16(v1, _mm256_load_si256(w + 1));
+                v2 = _mm256_sub_epi16(v2, _mm256_load_si256(w + 2));
+                v3 = _mm256_sub_epi16(v3, _mm256_load_si256(w + 3));
+                v4 = _mm256_sub_epi16(v4, _mm256_load_si256(w + 4));
+                v5 = _mm256_sub_epi16(v5, _mm256_load_si256(w + 5));
+                v6 = _mm256_sub_epi16(v6, _mm256_load_si256(w + 6));
+                v7 = _mm256_sub_epi16(v7, _mm256_load_si256(w + 7));
+            }
+
+            __m256i* d = reinterpret_cast<__m256i*>(step.dst + c);
+            _mm256_storeu_si256(d + 0, v0);
+            _mm256_storeu_si256(d + 1, v1);
+            _mm256_storeu_si256(d + 2, v2);
+            _mm256_storeu_si256(d + 3, v3);
+            _mm256_storeu_si256(d + 4, v4);
+            _mm256_storeu_si256(d + 5, v5);
+            _mm256_storeu_si256(d + 6, v6);
+            _mm256_storeu_si256(d + 7, v7);
+        }
+    }
+}
+
+void accumulator_transform_avx2(int16_t* dst, const int16_t* src,
+    const int16_t* l1_weights, const uint16_t* add, int n_add, const uint16_t* sub, int n_sub)
+{
+    const AccumulatorStep step{ dst, add, n_add, sub, n_sub };
+    accumulator_chain_avx2(src, l1_weights, &step, 1);
+}
+
+void l2_avx2(const int16_t* accumulator, const int16_t* l2_weights,
+    const int32_t* l2_bias, int32_t* l2_out)
+{
+    __m256i activated[16];
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c127 = _mm256_set1_epi16(127);
+    const __m256i* a = reinterpret_cast<const __m256i*>(accumulator);
+    for (int j = 0; j < 16; ++j)
+        activated[j] = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256(a + j), zero), c127);
+
+    // four outputs at a time, their lane sums reduced together by two hadds
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m256i sums[4];
+        for (int r = 0; r < 4; ++r)
+        {
+            const __m256i* w = reinterpret_cast<const __m256i*>(l2_weights + (i + r) * 256);
+            __m256i sum = _mm256_setzero_si256();
+            for (int j = 0; j < 16; ++j)
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_load_si256(w + j), activated[j]));
+            sums[r] = sum;
+        }
+        const __m256i s01 = _mm256_hadd_epi32(sums[0], sums[1]);
+        const __m256i s23 = _mm256_hadd_epi32(sums[2], sums[3]);
+        const __m256i s0123 = _mm256_hadd_epi32(s01, s23);
+        // lanes 0-3 hold the low halves of outputs i..i+3, lanes 4-7 the high halves
+        __m128i total = _mm_add_epi32(_mm256_castsi256_si128(s0123), _mm256_extracti128_si256(s0123, 1));
+        total = _mm_add_epi32(total, _mm_loadu_si128(reinterpret_cast<const __m128i*>(l2_bias + i)));
+        total = _mm_srai_epi32(total, 7);
+        total = _mm_min_epi32(_mm_max_epi32(total, _mm_setzero_si128()), _mm_set1_epi32(127));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(l2_out + i), total);
+    }
+}
+
+void l3_avx2(const int32_t* l2_out, const int16_t* l3_weights,
+    const int32_t* l3_bias, int16_t* l3_out)
+{
+    alignas(16) int32_t pairs[8];
+    {
+        const __m128i* in = reinterpret_cast<const __m128i*>(l2_out);
+        __m128i* o = reinterpret_cast<__m128i*>(pairs);
+        _mm_store_si128(o + 0, _mm_packs_epi32(_mm_loadu_si128(in + 0), _mm_loadu_si128(in + 1)));
+        _mm_store_si128(o + 1, _mm_packs_epi32(_mm_loadu_si128(in + 2), _mm_loadu_si128(in + 3)));
+    }
+
+    // eight outputs per register, all 32 in four
+    const __m256i* b = reinterpret_cast<const __m256i*>(l3_bias);
+    __m256i s0 = _mm256_loadu_si256(b + 0);
+    __m256i s1 = _mm256_loadu_si256(b + 1);
+    __m256i s2 = _mm256_loadu_si256(b + 2);
+    __m256i s3 = _mm256_loadu_si256(b + 3);
+
+    for (int p = 0; p < 8; ++p)
+    {
+        const __m256i pair = _mm256_set1_epi32(pairs[p]);
+        const __m256i* w = reinterpret_cast<const __m256i*>(l3_weights) + p * 4;
+        s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(pair, _mm256_load_si256(w + 0)));
+        s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(pair, _mm256_load_si256(w + 1)));
+        s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(pair, _mm256_load_si256(w + 2)));
+        s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(pair, _mm256_load_si256(w + 3)));
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c127 = _mm256_set1_epi16(127);
+    const auto shift_pack_clamp = [&](__m256i lo, __m256i hi) {
+        // packs works within 128-bit lanes; the permute puts the quadwords back in order
+        __m256i packed = _mm256_packs_epi32(_mm256_srai_epi32(lo, 7), _mm256_srai_epi32(hi, 7));
+        packed = _mm256_permute4x64_epi64(packed, 0xd8);
+        return _mm256_min_epi16(_mm256_max_epi16(packed, zero), c127);
+    };
+    __m256i* o = reinterpret_cast<__m256i*>(l3_out);
+    _mm256_storeu_si256(o + 0, shift_pack_clamp(s0, s1));
+    _mm256_storeu_si256(o + 1, shift_pack_clamp(s2, s3));
+}
+
+int32_t output_avx2(const int16_t* l3_out, const int16_t* out_weights, int32_t out_bias)
+{
+    const __m256i* in = reinterpret_cast<const __m256i*>(l3_out);
+    const __m256i* w = reinterpret_cast<const __m256i*>(out_weights);
+    const __m256i sum256 = _mm256_add_epi32(
+        _mm256_madd_epi16(_mm256_loadu_si256(in + 0), _mm256_loadu_si256(w + 0)),
+        _mm256_madd_epi16(_mm256_loadu_si256(in + 1), _mm256_loadu_si256(w + 1)));
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(sum256), _mm256_extracti128_si256(sum256, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return out_bias + _mm_cvtsi128_si32(sum);
+}
+
+} // namespace rl::nnue
@@ -0,0 +1,147 @@
+// AVX-512 (F + BW) kernels of the v2 network, compiled with -mavx512f
+// -mavx512bw and only reached through eval_v2_kernels() on a CPU that has
+// both. Includes nothing that defines an inline function, see
+// nnue_eval_v2_kernels.hpp.
+
+#include <nnue/nnue_eval_v2_kernels.hpp>
+
+#include <immintrin.h>
+
+// GCC 12's avx512fintrin.h seeds masked builtins with a self-initialised
+// _mm512_undefined_epi32(), which -Wall reports as uninitialized at every
+// use of srai, min, max and extract. Fixed in later GCC releases.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+
+namespace rl::nnue
+{
+
+void accumulator_chain_avx512(const int16_t* src, const int16_t* l1_weights,
+    const AccumulatorStep* steps, int n_steps)
+{
+    // the whole accumulator in 8 named registers; a weight row is 8 ZMM
+    // loads, one per cache line
+    const __m512i* s = reinterpret_cast<const __m512i*>(src);
+    __m512i v0 = _mm512_loadu_si512(s + 0);
+    __m512i v1 = _mm512_loadu_si512(s + 1);
+    __m512i v2 = _mm512_loadu_si512(s + 2);
+    __m512i v3 = _mm512_loadu_si512(s + 3);
+    __m512i v4 = _mm512_loadu_si512(s + 4);
+    __m512i v5 = _mm512_loadu_si512(s + 5);
+    __m512i v6 = _mm512_loadu_si512(s + 6);
+    __m512i v7 = _mm512_loadu_si512(s + 7);
+
+    for (int i = 0; i < n_steps; ++i)
+    {
+        const AccumulatorStep& step = steps[i];
+        for (int k = 0; k < step.n_add; ++k)
+        {
+            const __m512i* w = reinterpret_cast<const __m512i*>(l1_weights + step.add[k] * 256);
+            v0 = _mm512_add_epi16(v0, _mm512_load_si512(w + 0));
+            v1 = _mm512_add_epi16(v1, _mm512_load_si512(w + 1));
+            v2 = _mm512_add_epi16(v2, _mm512_load_si512(w + 2));
+            v3 = _mm512_add_epi16(v3, _mm512_load_si512(w + 3));
+            v4 = _mm512_add_epi16(v4, _mm512_load_si512(w + 4));
+            v5 = _mm512_add_epi16(v5, _mm512_load_si512(w + 5));
+            v6 = _mm512_add_epi16(v6, _mm512_load_si512(w + 6));
+            v7 = _mm512_add_epi16(v7, _mm512_load_si512(w + 7));
+        }
+        for (int k = 0; k < step.n_sub; ++k)
+        {
+            const __m512i* w = reinterpret_cast<const __m512i*>(l1_weights + step.sub[k] * 256);
+            v0 = _mm512_sub_epi16(v0, _mm512_load_si512(w + 0));
+            v1 = _mm512_sub_epi16(v1, _mm512_load_si512(w + 1));
+            v2 = _mm512_sub_epi16(v2, _mm512_load_si512(w + 2));
+            v3 = _mm512_sub_epi16(v3, _mm512_load_si512(w + 3));
+            v4 = _mm512_sub_epi16(v4, _mm512_load_si512(w + 4));
+            v5 = _mm512_sub_epi16(v5, _mm512_load_si512(w + 5));
+            v6 = _mm512_sub_epi16(v6, _mm512_load_si512(w + 6));
+            v7 = _mm512_sub_epi16(v7, _mm512_load_si512(w + 7));
+        }
+
+        __m512i* d = reinterpret_cast<__m512i*>(step.dst);
+        _mm512_storeu_si512(d + 0, v0);
+        _mm512_storeu_si512(d + 1, v1);
+        _mm512_storeu_si512(d + 2, v2);
+        _mm512_storeu_si512(d + 3, v3);
+        _mm512_storeu_si512(d + 4, v4);
+        _mm512_storeu_si512(d + 5, v5);
+        _mm512_storeu_si512(d + 6, v6);
+        _mm512_storeu_si512(d + 7, v7);
+    }
+}
+
+void accumulator_transform_avx512(int16_t* dst, const int16_t* src,
+    const int16_t* l1_weights, const uint16_t* add, int n_add, const uint16_t* sub, int n_sub)
+{
+    const AccumulatorStep step{ dst, add, n_add, sub, n_sub };
+    accumulator_chain_avx512(src, l1_weights, &step, 1);
+}
+
+void l2_avx512(const int16_t* accumulator, const int16_t* l2_weights,
+    const int32_t* l2_bias, int32_t* l2_out)
+{
+    __m512i activated[8];
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i c127 = _mm512_set1_epi16(127);
+    const __m512i* a = reinterpret_cast<const __m512i*>(accumulator);
+    for (int j = 0; j < 8; ++j)
+        activated[j] = _mm512_min_epi16(_mm512_max_epi16(_mm512_loadu_si512(a + j), zero), c127);
+
+    alignas(64) int32_t totals[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        const __m512i* w = reinterpret_cast<const __m512i*>(l2_weights + i * 256);
+        __m512i sum = _mm512_setzero_si512();
+        for (int j = 0; j < 8; ++j)
+            sum = _mm512_add_epi32(sum, _mm512_madd_epi16(_mm512_load_si512(w + j), activated[j]));
+        totals[i] = _mm512_reduce_add_epi32(sum);
+    }
+
+    // bias, shift and clamp for all 16 outputs in one vector
+    __m512i out = _mm512_add_epi32(_mm512_load_si512(totals), _mm512_loadu_si512(l2_bias));
+    out = _mm512_srai_epi32(out, 7);
+    out = _mm512_min_epi32(_mm512_max_epi32(out, _mm512_setzero_si512()), _mm512_set1_epi32(127));
+    _mm512_storeu_si512(l2_out, out);
+}
+
+void l3_avx512(const int32_t* l2_out, const int16_t* l3_weights,
+    const int32_t* l3_bias, int16_t* l3_out)
+{
+    alignas(16) int32_t pairs[8];
+    {
+        const __m128i* in = reinterpret_cast<const __m128i*>(l2_out);
+        __m128i* o = reinterpret_cast<__m128i*>(pairs);
+        _mm_store_si128(o + 0, _mm_packs_epi32(_mm_loadu_si128(in + 0), _mm_loadu_si128(in + 1)));
+        _mm_store_si128(o + 1, _mm_packs_epi32(_mm_loadu_si128(in + 2), _mm_loadu_si128(in + 3)));
+    }
+
+    // sixteen outputs per register: a weight pair block is exactly two ZMM loads
+    __m512i sum0 = _mm512_loadu_si512(l3_bias);
+    __m512i sum1 = _mm512_loadu_si512(l3_bias + 16);
+    const __m512i* w = reinterpret_cast<const __m512i*>(l3_weights);
+    for (int p = 0; p < 8; ++p)
+    {
+        const __m512i pair = _mm512_set1_epi32(pairs[p]);
+        sum0 = _mm512_add_epi32(sum0, _mm512_madd_epi16(pair, _mm512_load_si512(w + p * 2 + 0)));
+        sum1 = _mm512_add_epi32(sum1, _mm512_madd_epi16(pair, _mm512_load_si512(w + p * 2 + 1)));
+    }
+
+    // clamped first, so the truncating narrow to int16 is exact and in order
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i c127 = _mm512_set1_epi32(127);
+    sum0 = _mm512_min_epi32(_mm512_max_epi32(_mm512_srai_epi32(sum0, 7), zero), c127);
+    sum1 = _mm512_min_epi32(_mm512_max_epi32(_mm512_srai_epi32(sum1, 7), zero), c127);
+    __m256i* o = reinterpret_cast<__m256i*>(l3_out);
+    _mm256_storeu_si256(o + 0, _mm512_cvtepi32_epi16(sum0));
+    _mm256_storeu_si256(o + 1, _mm512_cvtepi32_epi16(sum1));
+}
+
+int32_t output_avx512(const int16_t* l3_out, const int16_t* out_weights, int32_t out_bias)
+{
+    const __m512i sum = _mm512_madd_epi16(_mm512_loadu_si512(l3_out), _mm512_loadu_si512(out_weights));
+    return out_bias + _mm512_reduce_add_epi32(sum);
+}
+
+} // namespace rl::nnue
@@ -0,0 +1,107 @@
+#include <nnue/nnue_eval_v2_kernels.hpp>
+#include <nnue/nnue_layerstacks_eval_v2.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && !defined(__EMSCRIPTEN__)
+#include <intrin.h>
+#endif
+
+namespace rl::nnue
+{
+namespace
+{
+
+constexpr EvalV2Kernels SSE_KERNELS{ SimdLevel::SSE, &accumulator_transform_sse, &accumulator_chain_sse,
+    &l2_sse, &l3_sse, &output_sse };
+#if !defined(__EMSCRIPTEN__)
+constexpr EvalV2Kernels AVX2_KERNELS{ SimdLevel::AVX2, &accumulator_transform_avx2, &accumulator_chain_avx2,
+    &l2_avx2, &l3_avx2, &output_avx2 };
+constexpr EvalV2Kernels AVX512_KERNELS{ SimdLevel::AVX512,
+    &accumulator_transform_avx512, &accumulator_chain_avx512, &l2_avx512, &l3_avx512, &output_avx512 };
+#endif
+
+const EvalV2Kernels& kernels_for(SimdLevel level)
+{
+#if !defined(__EMSCRIPTEN__)
+    if (level == SimdLevel::AVX512) return AVX512_KERNELS;
+    if (level == SimdLevel::AVX2) return AVX2_KERNELS;
+#endif
+    (void)level;
+    return SSE_KERNELS;
+}
+
+// What the CPU and the OS can run, before any cap from the environment.
+SimdLevel cpu_simd_level()
+{
+#if defined(__EMSCRIPTEN__)
+    return SimdLevel::SSE;
+#elif defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return SimdLevel::SSE;
+    __cpuid(regs, 1);
+    // OSXSAVE, then the OS must save the YMM state (XCR0 bits 1 and 2)
+    if (!(regs[2] & (1 << 27))) return SimdLevel::SSE;
+    const unsigned long long xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) != 0x6) return SimdLevel::SSE;
+    __cpuidex(regs, 7, 0);
+    const bool avx2 = regs[1] & (1 << 5);
+    const bool avx512 = (regs[1] & (1 << 16)) && (regs[1] & (1 << 30)) && (xcr0 & 0xe0) == 0xe0;
+    if (avx512) return SimdLevel::AVX512;
+    return avx2 ? SimdLevel::AVX2 : SimdLevel::SSE;
+#else
+    // __builtin_cpu_supports checks the OS saves the wider registers too
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    return SimdLevel::SSE;
+#endif
+}
+
+SimdLevel detect()
+{
+    SimdLevel level = cpu_simd_level();
+    if (const char* cap = std::getenv("RL_NNUE_SIMD"))
+    {
+        SimdLevel wanted = level;
+        if (std::strcmp(cap, "sse") == 0) wanted = SimdLevel::SSE;
+        else if (std::strcmp(cap, "avx2") == 0) wanted = SimdLevel::AVX2;
+        else if (std::strcmp(cap, "avx512") == 0) wanted = SimdLevel::AVX512;
+        if (wanted < level) level = wanted;
+    }
+    return level;
+}
+
+} // namespace
+
+SimdLevel detected_simd_level()
+{
+    static const SimdLevel level = detect();
+    return level;
+}
+
+const char* simd_level_name(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX512: return "avx512";
+    case SimdLevel::AVX2: return "avx2";
+    default: return "sse";
+    }
+}
+
+bool set_simd_level(SimdLevel level)
+{
+    if (level > cpu_simd_level()) return false;
+    detail::active_eval_v2_kernels = &kernels_for(level);
+    return true;
+}
+
+namespace detail
+{
+const EvalV2Kernels* active_eval_v2_kernels = &kernels_for(detected_simd_level());
+} // namespace detail
+
+} // namespace rl::nnue
@@ -2,6 +2,7 @@
 #define RL_ONNXEVAL_ONNX_EVALUATOR_HPP_
 
 #include <array>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <players/evaluator.hpp>
@@ -12,10 +13,14 @@ namespace rl::onnxeval
 /// @brief NetworkEvaluator's post-processing, without libtorch.
 ///
 /// Everything after the forward pass is a deliberate line-for-line port of
-/// rl::deeplearning::NetworkEvaluator: mask the policy with actions_mask(),
+/// rl::deeplearning::NetworkEvaluator: mask the policy with the legal actions,
 /// renormalize by the row sum, and reduce wdl to a scalar as w - l. Keeping the
 /// arithmetic identical is what lets run/onnx_parity diff the two evaluators and
 /// attribute any difference to the network backend rather than to the wrapper.
+///
+/// Not reentrant: evaluate() works in the instance's scratch buffers, so one
+/// instance must never be called from two threads at once, even though the
+/// session could be. Every thread takes its own with copy().
 class OnnxEvaluator : public rl::players::IEvaluator
 {
 private:
@@ -28,6 +33,7 @@ private:
     // vectors reach their high-water mark once and stop allocating.
     std::vector<float> observations_;
     std::vector<float> actions_mask_;
+    std::vector<uint64_t> legal_words_;
     std::vector<float> raw_probs_;
     std::vector<float> wdls_;
 
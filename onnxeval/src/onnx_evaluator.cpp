@@ -1,4 +1,5 @@
 #include <stdexcept>
+#include <common/bits.hpp>
 #include <onnxeval/onnx_evaluator.hpp>
 
 namespace rl::onnxeval
@@ -56,26 +57,23 @@ void OnnxEvaluator::evaluate(const std::vector<const rl::common::IState*>& state
     }
     const int observation_size = observation_shape_.at(0) * observation_shape_.at(1) * observation_shape_.at(2);
 
-    observations_.clear();
-    actions_mask_.clear();
-    observations_.reserve(static_cast<size_t>(n_states) * observation_size);
-    actions_mask_.reserve(static_cast<size_t>(n_states) * n_actions_);
+    observations_.resize(static_cast<size_t>(n_states) * observation_size);
+    actions_mask_.assign(static_cast<size_t>(n_states) * n_actions_, 0.0f);
+    legal_words_.resize(rl::common::bits::n_words(n_actions_));
 
-    for (auto& state_ptr : state_ptrs_vec)
+    for (int i = 0; i < n_states; i++)
     {
-        for (auto& cell_value : state_ptr->get_observation())
-        {
-            observations_.emplace_back(cell_value);
-        }
-        for (auto cell_value : state_ptr->actions_mask())
+        const rl::common::IState* state_ptr = state_ptrs_vec[i];
+        if (state_ptr->get_observation_shape() != observation_shape_)
         {
-            actions_mask_.emplace_back(float(cell_value));
+            throw std::runtime_error("while evaluating a state , got an error on its observation size");
         }
-    }
+        state_ptr->write_observation(observations_.data() + static_cast<size_t>(i) * observation_size);
 
-    if (observations_.size() != static_cast<size_t>(n_states) * observation_size)
-    {
-        throw std::runtime_error("while evaluating a state , got an error on its observation size");
+        float* mask = actions_mask_.data() + static_cast<size_t>(i) * n_actions_;
+        state_ptr->legal_actions_bitset(legal_words_.data());
+        rl::common::bits::for_each_bit(legal_words_.data(), static_cast<int>(legal_words_.size()), [mask](int action)
+            { mask[action] = 1.0f; });
     }
 
     raw_probs_.resize(static_cast<size_t>(n_states) * n_actions_);
@@ -5,7 +5,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <set>
-#include <string>
+#include <cstdint>
 #include "evaluator.hpp"
 #include "search_tree.hpp"
 
@@ -13,10 +13,11 @@ namespace rl::players
 {
 struct AmctsInfo
 {
-    std::string state_short;
+    uint64_t state_hash;
     int action;
     int player;
 };
+// Statistics are keyed by IState::hash(), so transpositions share one entry.
 class Amcts : public ISearchTree
 {
 private:
@@ -25,13 +26,13 @@ private:
     std::unique_ptr<IEvaluator> evaluator_ptr_;
     float cpuct_;
     float temperature_;
-    std::unordered_set<std::string> states_;
-    std::unordered_map<std::string, std::vector<std::unique_ptr<rl::common::IState>>> edges_;
-    std::unordered_map<std::string, float> ns_;
-    std::unordered_map<std::string, std::vector<float>> nsa_;
-    std::unordered_map<std::string, std::vector<float>> wsa_;
-    std::unordered_map<std::string, std::vector<float>> psa_;
-    std::unordered_map<std::string, std::vector<bool>> masks_;
+    std::unordered_set<uint64_t> states_;
+    std::unordered_map<uint64_t, std::vector<std::unique_ptr<rl::common::IState>>> edges_;
+    std::unordered_map<uint64_t, float> ns_;
+    std::unordered_map<uint64_t, std::vector<float>> nsa_;
+    std::unordered_map<uint64_t, std::vector<float>> wsa_;
+    std::unordered_map<uint64_t, std::vector<float>> psa_;
+    std::unordered_map<uint64_t, std::vector<bool>> masks_;
     rl::common::IState* root_ptr;
     int root_player_;
     std::vector<std::tuple<const rl::common::IState*, std::vector<AmctsInfo>>> rollouts_;
@@ -39,11 +40,11 @@ private:
     void evaluate_collected_states();
     void simulate_once(const rl::common::IState* state_ptr, std::vector<AmctsInfo>& visited_path);
     void backpropogate(std::vector<AmctsInfo>& visited_path, float final_result, int final_player);
-    void expand_state(const rl::common::IState* state_ptr, std::string& short_state);
+    void expand_state(const rl::common::IState* state_ptr, uint64_t state_hash);
 
     // TODO check if we can just simply add the visited_path reference
     void add_to_rollouts(const rl::common::IState* state_ptr, std::vector<AmctsInfo> visited_path);
-    int find_best_action(std::string& short_state);
+    int find_best_action(uint64_t state_hash);
     std::vector<float> get_probs(const rl::common::IState* state_ptr);
 
 public:
@@ -12,6 +12,8 @@
 
 namespace rl::players
 {
+class Amcts2;
+class ConcurrentAmcts;
 using IPlayer = rl::common::IPlayer;
 using IConcurrentPlayer = rl::common::IConcurrentPlayer;
 class Amcts2Player : public IPlayer
@@ -28,6 +30,9 @@ private:
     float dirichlet_alpha_;
     float default_visits_;
     float default_wins_;
+    int n_threads_;
+    // kept between moves so the subtree of the position we reach is reused
+    std::unique_ptr<Amcts2> tree_ptr_;
 
 public:
     Amcts2Player(int n_game_actions,
@@ -40,7 +45,8 @@ public:
         float dirichlet_epsilon,
         float dirichlet_alpha,
         float default_visits = 1.0f,
-        float default_wins = -1.0f);
+        float default_wins = -1.0f,
+        int n_threads = 1);
     ~Amcts2Player()override;
     int choose_action(const std::unique_ptr<rl::common::IState>& state_ptr) override;
 };
@@ -59,6 +65,8 @@ private:
     float dirichlet_alpha_;
     float default_visits_;
     float default_wins_;
+    // kept between calls so every game's subtree can be reused
+    std::unique_ptr<ConcurrentAmcts> tree_ptr_;
 public:
     ConcurrentPlayer(
         int n_game_actions,
@@ -13,11 +13,19 @@ class Amcts2 : public ISearchTree
 {
 
 public:
-    Amcts2(int n_game_actions, std::unique_ptr<IEvaluator> evaluator_ptr, float cpuct, float temperature, int max_async_simulations, float dirichlet_epsilon,float dirichlet_alpha,float default_visits, float default_wins);
+    /// @param n_threads worker threads descending the one tree concurrently, each
+    ///     batching max_async_simulations leaves through its own copy of the evaluator
+    Amcts2(int n_game_actions, std::unique_ptr<IEvaluator> evaluator_ptr, float cpuct, float temperature, int max_async_simulations, float dirichlet_epsilon,float dirichlet_alpha,float default_visits, float default_wins, int n_threads = 1);
     ~Amcts2()override;
     std::vector<float> search(const rl::common::IState* state_ptr, int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration) override;
 
+    /// @brief starts the tree at state_ptr. When the previous root or a node up to two
+    ///     plies below it is the same position, that subtree becomes the root with its
+    ///     visits kept. The rest of the old tree is freed during the next searches
     void set_root(const rl::common::IState* state_ptr);
+    /// @brief caps the tree's nodes and edges; a search stops early rather than grow past
+    ///     it. Each node also keeps its state, which comes on top. Drops the tree
+    void set_memory_budget_mb(int megabytes);
     void roll(float dirichlet_epsilon,float dirichlet_alpha);
     std::vector<const rl::common::IState*> get_rollouts();
     void evaluate_collected_states(std::tuple<std::vector<float>, std::vector<float>>& evaluations_tuple);
@@ -26,7 +34,9 @@ public:
     void clear_rollout();
 
 private:
-    std::unique_ptr<Amcts2Node> root_node_;
+    std::unique_ptr<Amcts2Tree> tree_;
+    // trees of earlier searches, oldest first, freed a batch at a time while searching
+    std::vector<std::unique_ptr<Amcts2Tree>> retired_trees_{};
     std::unique_ptr<IEvaluator> evaluator_ptr_;
     int n_game_actions_;
     float cpuct_;
@@ -34,8 +44,13 @@ private:
     int max_async_simulations_;
     float dirichlet_epsilon_,dirichlet_alpha_;
     float default_n_, default_w_;
+    int n_threads_;
+    size_t memory_budget_bytes_;
     std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>> rollouts_{};
     void backpropogate(std::vector<Amcts2Info>& visited_path, float final_result, int final_player, std::vector<float>& probs);
+    void search_parallel(int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration);
+    /// @brief frees up to max_nodes nodes of the oldest retired tree
+    void release_retired(int32_t max_nodes);
 };
 
 } // namespace rl::players
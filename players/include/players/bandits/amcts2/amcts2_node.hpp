@@ -1,50 +1,114 @@
 #ifndef RL_SEARCH_TREES_AMCTS2_NODE_HPP_
 #define RL_SEARCH_TREES_AMCTS2_NODE_HPP_
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <common/state.hpp>
+#include <players/node_arena.hpp>
 namespace rl::players
 {
 struct Amcts2Info
 {
-    int action;
-    int player;
+    int32_t node;
+    // index into the tree's edges, -1 for the node the descent stopped at
+    int32_t edge;
 };
 
-class Amcts2Node
+// A node header. Everything but the statistics and the two flags is written once,
+// before the node's index is published to the parent's edge, and only read after.
+struct Amcts2Node
+{
+    std::unique_ptr<rl::common::IState> state_ptr{};
+    // edges are [first_edge, first_edge + n_edges), one per legal action, sorted
+    int32_t first_edge{ -1 };
+    int32_t n_edges{ 0 };
+    int player_turn{ 0 };
+    float terminal_reward{ 0.0f };
+    bool is_terminal{ false };
+    // set by the descent that sends the node to the evaluator
+    std::atomic<bool> is_expanded{ false };
+    std::atomic<float> n_visits{ 0.0f };
+    std::atomic<float> delta_wins{ 0.0f };
+    // guards creating children
+    std::mutex mutex;
+};
+
+struct Amcts2Edge
+{
+    int32_t action{ -1 };
+    // -1 until the action is first selected, then set exactly once under the parent's mutex
+    std::atomic<int32_t> child{ -1 };
+    std::atomic<float> prob{ 0.0f };
+    std::atomic<float> visits{ 0.0f };
+    std::atomic<float> wins{ 0.0f };
+};
+
+// Safe to search from several threads at once. Statistics are atomics, and
+// the default_n / default_w added on the way down is the virtual loss that
+// steers concurrent descents apart until the real result is backpropagated.
+// Creating a child is the only write that needs exclusion, and it takes the
+// parent's own mutex; everything else is lock-free. States cache lazily in
+// their const methods, so a node reads everything it needs from its state,
+// legal actions included, before the node is published.
+//
+// Nodes and edges live in arenas and refer to each other by index, the root is
+// node 0. Leaf states handed out for evaluation stay valid until the tree is
+// destroyed or extract() moves them.
+class Amcts2Tree
 {
 public:
-    Amcts2Node(std::unique_ptr<rl::common::IState> state_ptr,int n_game_actions,float cpuct);
-    ~Amcts2Node();
-    void simulate_once(std::pair<rl::common::IState* ,std::vector<Amcts2Info>>& rollout_info_ref,float dirichlet_epsilon,float dirichlet_alpha,float default_n,float default_w,Amcts2Node* const root_node_ptr);
-    void backpropogate(std::vector<Amcts2Info>& visited_path,int depth, float final_result, int final_player, std::vector<float>& probs,float default_n,float default_w);
-    void expand_node();
+    Amcts2Tree(std::unique_ptr<rl::common::IState> root_state_ptr, int n_game_actions, float cpuct, size_t memory_budget_bytes);
+    ~Amcts2Tree();
+    void simulate_once(std::pair<rl::common::IState*, std::vector<Amcts2Info>>& rollout_info_ref, float dirichlet_epsilon, float dirichlet_alpha, float default_n, float default_w);
+    void backpropogate(const std::vector<Amcts2Info>& visited_path, float final_result, int final_player, const std::vector<float>& probs, float default_n, float default_w);
     std::vector<float> get_probs(float temperature);
     float get_evaluation();
+    /// @brief true when in_flight more simulations might not fit in the memory budget
+    bool is_full(int in_flight) const;
+    /// @brief the arenas and the states held by their nodes
+    size_t bytes_used() const;
+
+    // Tree reuse between searches; none of these may run while a search is.
+    const rl::common::IState* state(int32_t node = 0) const;
+    /// @return the node 1 to max_depth plies below the root holding the same position
+    ///     as state, shallowest first, or -1 if the search never reached it
+    int32_t find_descendant(const rl::common::IState& state, int max_depth) const;
+    /// @brief appends the root and every node up to max_depth plies below it, depth first
+    void nodes_within(int max_depth, std::vector<int32_t>& out_nodes) const;
+    /// @brief moves the subtree under node, with its statistics, into a tree of its own
+    ///     that only takes the memory the subtree needs. Leaves this tree unusable
+    std::unique_ptr<Amcts2Tree> extract(int32_t node, size_t memory_budget_bytes);
+    /// @brief frees up to max_nodes nodes, and their worth of edges, of a tree no search
+    ///     uses anymore, so a big one can be let go of a little at a time
+    /// @return true once nothing is left
+    bool release(int32_t max_nodes);
+
 private:
-    std::unique_ptr<rl::common::IState> state_ptr_;
+    using Arenas = TreeArenas<Amcts2Node, Amcts2Edge>;
+
     int n_game_actions_;
     float cpuct_;
-    std::vector<bool> actions_mask_{};
-    std::vector<std::unique_ptr<Amcts2Node>> children_;
-    std::vector<float> probs_{};
+    size_t memory_budget_bytes_;
+    Arenas arenas_;
+    // what the nodes' states take, the arenas only count the headers
+    std::atomic<size_t> state_bytes_{ 0 };
+    // the noise only ever mixes into the root's priors
     std::vector<float> dirichlet_noise_{};
-    float n_visits_{ 0 };
-    float delta_wins{ 0 };
-    std::vector<float> actions_visits_{ 0 };
-    std::vector<float> delta_actions_wins{ 0 };
-    int find_best_action(float dirichlet_epsilon , float dirichlet_alpha);
+    std::atomic<bool> has_dirichlet_noise_{ false };
+    std::mutex dirichlet_mutex_;
 
+    Amcts2Tree(int n_game_actions, float cpuct, size_t memory_budget_bytes);
+    /// @return the new node's index
+    int32_t add_node(std::unique_ptr<rl::common::IState> state_ptr);
+    /// @return an edge index
+    int32_t find_best_action(Amcts2Node& node, float dirichlet_epsilon, float dirichlet_alpha);
+    int32_t find_descendant(int32_t node, const rl::common::IState& state, uint64_t key, int max_depth) const;
+    void nodes_within(int32_t node, int max_depth, std::vector<int32_t>& out_nodes) const;
 };
 
-
-
 } // namespace rl::players
 
-
-
-
-
-#endif
\ No newline at end of file
+#endif
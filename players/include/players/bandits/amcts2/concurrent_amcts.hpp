@@ -2,6 +2,8 @@
 #define RL_SEARCH_TREES_CONCURRENT_AMCTS2_HPP_
 
 
+#include <array>
+#include <unordered_map>
 #include <players/concurrent_search_tree.hpp>
 #include <players/bandits/amcts2/amcts2_node.hpp>
 #include <players/evaluator.hpp>
@@ -14,15 +16,26 @@ class ConcurrentAmcts : public IConcurrentSearchTree
 {
 
 public:
-    ConcurrentAmcts(int n_game_actions, std::unique_ptr<IEvaluator> evaluator_ptr, float cpuct, float temperature, int max_async_simulations_per_tree,float dirichlet_epsilon,float dirichlet_alpha, float default_visits, float default_wins);
+    /// @param pipelined when set, search_multiple splits the trees into two halves
+    ///     and selects on one half while the other half's batch is being evaluated
+    ///     on a helper thread, so search and inference overlap. Needs at least two
+    ///     trees; with fewer it searches sequentially.
+    ConcurrentAmcts(int n_game_actions, std::unique_ptr<IEvaluator> evaluator_ptr, float cpuct, float temperature, int max_async_simulations_per_tree,float dirichlet_epsilon,float dirichlet_alpha, float default_visits, float default_wins, bool pipelined = false);
     ~ConcurrentAmcts()override;
     std::vector<float> search(const rl::common::IState* state_ptr, int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration) override;
     std::pair<std::vector<std::vector<float>>,std::vector<float>> search_multiple(const std::vector<const rl::common::IState*>& state_ptrs, int minimum_sims,std::chrono::duration<int, std::milli> minimum_duration) override;
-    void evaluate_collected_states(std::unique_ptr<Amcts2Node>& root_node_ptr,std::tuple<std::vector<float>, std::vector<float>>& evaluations_tuple,std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>>& tree_rollouts);
+    /// @brief when on, the trees of a search_multiple call are kept for the next one,
+    ///     and every state that is one of the kept roots or up to two plies below one
+    ///     resumes from that subtree instead of an empty tree
+    void set_tree_reuse(bool reuse_trees);
+    /// @brief caps the trees of a search_multiple call together, each gets an equal
+    ///     share; a tree stops growing rather than go past its share. Drops kept trees
+    void set_memory_budget_mb(int megabytes);
+    void evaluate_collected_states(std::unique_ptr<Amcts2Tree>& tree_ptr,std::tuple<std::vector<float>, std::vector<float>>& evaluations_tuple,std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>>& tree_rollouts);
 
 
 private:
-    std::vector<std::unique_ptr<Amcts2Node>> root_nodes_;
+    std::vector<std::unique_ptr<Amcts2Tree>> trees_;
     std::unique_ptr<IEvaluator> evaluator_ptr_;
     int n_game_actions_;
     float cpuct_;
@@ -30,7 +43,14 @@ private:
     int max_async_simulations_;
     float dirichlet_epsilon_,dirichlet_alpha_;
     float default_n_, default_w_;
-    void backpropogate(std::unique_ptr<Amcts2Node>& root_node_ptr,std::vector<Amcts2Info>& visited_path, float final_result, int final_player, std::vector<float>& probs);
+    bool pipelined_;
+    bool reuse_trees_{ false };
+    size_t memory_budget_bytes_;
+    std::unique_ptr<Amcts2Tree> take_reusable_tree(const rl::common::IState* state_ptr, const std::unordered_map<uint64_t, std::pair<int, int32_t>>& reusable, size_t tree_budget_bytes);
+    bool are_full(std::vector<std::unique_ptr<Amcts2Tree>>& trees, const std::vector<int>& tree_ids);
+    void collect_rollouts(std::vector<std::unique_ptr<Amcts2Tree>>& trees, std::vector<std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>>>& all_rollouts, const std::vector<int>& tree_ids, std::vector<const rl::common::IState*>& rollout_states, std::vector<int>& trees_idx);
+    void backpropogate_evaluations(std::vector<std::unique_ptr<Amcts2Tree>>& trees, std::vector<std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>>>& all_rollouts, const std::vector<int>& tree_ids, const std::vector<int>& trees_idx, std::tuple<std::vector<float>, std::vector<float>>& evaluations);
+    void backpropogate(std::unique_ptr<Amcts2Tree>& tree_ptr,std::vector<Amcts2Info>& visited_path, float final_result, int final_player, std::vector<float>& probs);
 };
 
 } // namespace rl::players
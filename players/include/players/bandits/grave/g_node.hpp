@@ -5,6 +5,7 @@
 #include <vector>
 #include <utility>
 #include <optional>
+#include <cstdint>
 #include <common/state.hpp>
 namespace rl::players
 {
@@ -21,8 +22,11 @@ private:
     const int n_game_actions_;
     std::optional<bool> is_terminal_;
     std::optional<float> result_;
-    std::vector<bool> actions_mask_{};
+    std::vector<uint64_t> legal_actions_bits_{};
+    std::vector<int> legal_actions_{};
     bool is_leaf_node_{};
+    // children_, wsa_ and nsa_ are indexed like legal_actions_, the amaf
+    // statistics by game action since playouts report game actions
     std::vector<std::unique_ptr<GNode>> children_;
 
     int n_;
@@ -33,6 +37,9 @@ private:
     std::vector<float> amaf_wsa_player_1_;
     std::vector<int> amaf_nsa_player_1_;
     void heuristic();
+    /// @return an index into legal_actions_
+    int choose_best_idx(const GNode* amaf_ptr) const;
+    float action_value(const GNode* amaf_ptr, int idx) const;
     std::pair<float, int> playout(std::vector<int>& player_0_actions, std::vector<int>& player_1_actions);
     void update_amf(const std::pair<const float, const int>& playout_res, const std::vector<int>& player_0_actions_ref, const std::vector<int>& player_1_actions_ref);
 
@@ -18,14 +18,18 @@ private:
     std::optional<bool> terminal_;
     bool is_leaf_node_;
     std::optional<bool> game_result_;
+    // indexed like legal_actions_
     std::vector<std::unique_ptr<GraveNode>> children_;
     int n_;
-    // total score for action "a"
+    // total score for legal action "a"
     std::vector<float> wsa_;
 
-    // total visits for action "a"
+    // total visits for legal action "a"
     std::vector<int> nsa_;
 
+    // the amaf statistics below stay indexed by game action, playouts report game actions
+    // and save_illegal_amaf_actions keeps scores for actions illegal at this node
+
     // player 0 amaf total score for action "a"
     std::vector<float> amaf_wsa_player_0;
 
@@ -38,7 +42,11 @@ private:
     // player 1 amaf total score for action "a"
     std::vector<int> amaf_nsa_player_1;
 
-    std::vector<bool> actions_legality_;
+    std::vector<uint64_t> legal_actions_bits_;
+    std::vector<int> legal_actions_;
+    void load_legal_actions();
+    /// @return an index into legal_actions_
+    int selectMoveIdx(GraveNode* amaf_node_ptr, int depth, const float& b_square_ref);
     void heuristic();
     void update_amaf(float our_score, const std::vector<int>& our_actions_ref, const std::vector<int>& opponents_actions_ref, int depth, bool save_illegal_amaf_actions);
 
@@ -18,18 +18,23 @@ private:
     std::optional<bool> terminal_;
     bool is_leaf_node;
     std::optional<float> game_result_;
+    // children_, nsa_ and qsa_ are indexed like legal_actions_
     std::vector<std::unique_ptr<McraveNode>> children_;
     std::vector<int> nsa_;
     std::vector<float> qsa_;
 
+    // rave statistics, indexed by game action since playouts report game actions
     std::vector<int> n_sa_;
     std::vector<float> q_sa_;
 
-    std::vector<bool> actions_legality_;
+    std::vector<uint64_t> legal_actions_bits_;
+    std::vector<int> legal_actions_;
 
     std::pair<float, int> simulateOne(float b, std::vector<int>& out_our_actions, std::vector<int>& out_their_actions);
     void getFinalProbabilities(std::vector<float>& out_actions_probs);
+    /// @return an index into legal_actions_
     int selectMove(float b);
+    void load_legal_actions();
     virtual void heuristic();
     std::pair<float, int> simDefault(std::vector<int>& out_our_actions, std::vector<int>& out_their_actions);
     int player();
@@ -0,0 +1,42 @@
+#ifndef RL_PLAYERS_BANDITS_STATIC_MCTS_STATIC_GAME_HPP_
+#define RL_PLAYERS_BANDITS_STATIC_MCTS_STATIC_GAME_HPP_
+
+// The searches in this directory take the game as a template parameter
+// instead of an IState, so every rules call in the selection and rollout
+// loops is a direct call the compiler can inline, and a position is copied by
+// value instead of cloned onto the heap. A game type provides:
+//
+//   static constexpr int N_ACTIONS;        same encoding as the IState game
+//   bool is_terminal() const;
+//   float get_reward() const;              terminal only, relative to player_turn()
+//   int player_turn() const;
+//   int legal_actions(int* out) const;     increasing order, returns the count,
+//                                          out holds at least N_ACTIONS ints
+//   void apply(int action);                in place, action must be legal
+//   static Game from_short(const std::string&);
+//                                          parses the IState game's to_short(),
+//                                          StaticSearchTree needs it
+//
+// games/*_bb.hpp hold the ones that exist.
+
+#include <utility>
+#include <common/random.hpp>
+
+namespace rl::players
+{
+/// @brief plays uniformly random moves until the game ends
+/// @return the reward and the player it is relative to, like UctNode::rollout
+template <class Game>
+std::pair<float, int> static_rollout(Game game)
+{
+    int actions[Game::N_ACTIONS];
+    while (!game.is_terminal())
+    {
+        const int n_actions = game.legal_actions(actions);
+        game.apply(actions[rl::common::get(n_actions)]);
+    }
+    return std::make_pair(game.get_reward(), game.player_turn());
+}
+} // namespace rl::players
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef RL_PLAYERS_BANDITS_STATIC_MCTS_STATIC_PUCT_HPP_
+#define RL_PLAYERS_BANDITS_STATIC_MCTS_STATIC_PUCT_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <common/exceptions.hpp>
+#include <common/random.hpp>
+#include "static_game.hpp"
+
+namespace rl::players
+{
+/// @brief uniform priors over the legal actions and a random rollout for the value,
+///     RandomRolloutEvaluator for value-type games.
+///
+///     An evaluator for StaticPuct provides
+///     float evaluate(const Game& game, float* priors), writing Game::N_ACTIONS priors
+///     and returning the value relative to game.player_turn()
+template <class Game>
+class StaticRolloutEvaluator
+{
+public:
+    float evaluate(const Game& game, float* priors) const
+    {
+        int actions[Game::N_ACTIONS];
+        const int n_actions = game.legal_actions(actions);
+        std::fill(priors, priors + Game::N_ACTIONS, 0.0f);
+        for (int i = 0; i < n_actions; i++)
+        {
+            priors[actions[i]] = 1.0f / float(n_actions);
+        }
+        auto [result, last_player] = static_rollout(game);
+        return last_player == game.player_turn() ? result : -result;
+    }
+};
+
+/// @brief MCTSNode's search over a value-type game (see static_game.hpp), laid out
+///     like StaticUct. The evaluator is a template parameter too, so it is called
+///     directly and sees the concrete game
+template <class Game, class Evaluator = StaticRolloutEvaluator<Game>>
+class StaticPuct
+{
+public:
+    using game_type = Game;
+
+    StaticPuct(float cpuct, float temperature, Evaluator evaluator = Evaluator())
+        : cpuct_{ cpuct },
+        temperature_{ temperature },
+        evaluator_{ std::move(evaluator) }
+    {
+    }
+
+    /// @return Game::N_ACTIONS probabilities
+    std::vector<float> search(const Game& root, int minimum_simulations, std::chrono::duration<int, std::milli> minimum_duration)
+    {
+        if (root.is_terminal())
+        {
+            throw rl::common::SteppingTerminalStateException("MCTS Node is searching a terminal state which cannot be stepped.");
+        }
+        nodes_.clear();
+        nodes_.emplace_back();
+
+        auto t_end = std::chrono::high_resolution_clock::now() + minimum_duration;
+        for (int i = 0; i <= minimum_simulations; i++)
+        {
+            simulate_one(root);
+        }
+
+        while (t_end > std::chrono::high_resolution_clock::now())
+        {
+            simulate_one(root);
+        }
+
+        return get_probs();
+    }
+
+private:
+    enum class NodeKind : int8_t
+    {
+        unvisited,
+        expanded,
+        terminal,
+    };
+
+    struct Node
+    {
+        // children are [first_child, first_child + n_children)
+        int first_child{ -1 };
+        int n_children{ 0 };
+        int action{ -1 };
+        // visits through this node, MCTSNode::n_visits
+        int n_visits{ 0 };
+        // the parent's statistics for the action leading here
+        float prior{ 0.0f };
+        float visits{ 0.0f };
+        float delta_wins{ 0.0f };
+        // cached reward of a terminal node
+        float result{ 0.0f };
+        NodeKind kind{ NodeKind::unvisited };
+    };
+
+    float cpuct_;
+    float temperature_;
+    Evaluator evaluator_;
+    std::vector<Node> nodes_{};
+    std::vector<int> path_{};
+    std::vector<int> path_players_{};
+
+    void simulate_one(const Game& root)
+    {
+        Game game = root;
+        int node_idx = 0;
+        path_.clear();
+        path_players_.clear();
+        float z;
+        int p;
+        while (true)
+        {
+            path_.push_back(node_idx);
+            path_players_.push_back(game.player_turn());
+            if (nodes_[node_idx].kind == NodeKind::unvisited)
+            {
+                if (game.is_terminal())
+                {
+                    nodes_[node_idx].kind = NodeKind::terminal;
+                    nodes_[node_idx].result = game.get_reward();
+                }
+                else
+                {
+                    z = expand(game, node_idx);
+                    p = game.player_turn();
+                    break;
+                }
+            }
+            if (nodes_[node_idx].kind == NodeKind::terminal)
+            {
+                z = nodes_[node_idx].result;
+                p = game.player_turn();
+                break;
+            }
+            node_idx = get_best_child(nodes_[node_idx]);
+            game.apply(nodes_[node_idx].action);
+        }
+
+        for (int i = static_cast<int>(path_.size()) - 2; i >= 0; i--)
+        {
+            if (p != path_players_[i])
+            {
+                z = -z;
+            }
+            p = path_players_[i];
+            Node& child = nodes_[path_[i + 1]];
+            child.delta_wins += z;
+            child.visits += 1;
+            nodes_[path_[i]].n_visits += 1;
+        }
+    }
+
+    /// @return the evaluator's value for the node
+    float expand(const Game& game, int node_idx)
+    {
+        float priors[Game::N_ACTIONS];
+        const float value = evaluator_.evaluate(game, priors);
+        int actions[Game::N_ACTIONS];
+        const int n_actions = game.legal_actions(actions);
+        const int first_child = static_cast<int>(nodes_.size());
+        nodes_.resize(nodes_.size() + n_actions);
+        for (int i = 0; i < n_actions; i++)
+        {
+            nodes_[first_child + i].action = actions[i];
+            nodes_[first_child + i].prior = priors[actions[i]];
+        }
+        nodes_[node_idx].first_child = first_child;
+        nodes_[node_idx].n_children = n_actions;
+        nodes_[node_idx].kind = NodeKind::expanded;
+        return value;
+    }
+
+    int get_best_child(const Node& node) const
+    {
+        float max_u = -std::numeric_limits<float>::infinity();
+        int best_idx = -1;
+        const float sqrt_n = sqrtf(node.n_visits + 1e-8f);
+        for (int idx = node.first_child; idx < node.first_child + node.n_children; idx++)
+        {
+            const Node& child = nodes_[idx];
+            float qsa = 0;
+            if (child.visits > 0)
+            {
+                qsa = child.delta_wins / child.visits;
+            }
+            const float u = qsa + cpuct_ * child.prior * sqrt_n / (1 + child.visits);
+            if (u > max_u)
+            {
+                max_u = u;
+                best_idx = idx;
+            }
+        }
+
+        if (best_idx == -1)
+        {
+            best_idx = node.first_child + rl::common::get(node.n_children);
+        }
+        return best_idx;
+    }
+
+    std::vector<float> get_probs() const
+    {
+        std::vector<float> probs(Game::N_ACTIONS, 0.0f);
+        const Node& root = nodes_[0];
+        const int begin = root.first_child;
+        const int end = root.first_child + root.n_children;
+
+        if (temperature_ == 0.0f)
+        {
+            // ties share the probability
+            float max_action_visits = -1.0f;
+            for (int idx = begin; idx < end; idx++)
+            {
+                max_action_visits = std::max(max_action_visits, nodes_[idx].visits);
+            }
+            float n_best = 0.0f;
+            for (int idx = begin; idx < end; idx++)
+            {
+                n_best += nodes_[idx].visits == max_action_visits;
+            }
+            for (int idx = begin; idx < end; idx++)
+            {
+                if (nodes_[idx].visits == max_action_visits)
+                {
+                    probs[nodes_[idx].action] = 1.0f / n_best;
+                }
+            }
+            return probs;
+        }
+
+        float sum_action_visits = 0.0f;
+        for (int idx = begin; idx < end; idx++)
+        {
+            sum_action_visits += nodes_[idx].visits;
+        }
+        float sum_probs = 0.0f;
+        for (int idx = begin; idx < end; idx++)
+        {
+            const float p = powf(nodes_[idx].visits / sum_action_visits, 1.0f / temperature_);
+            sum_probs += p;
+            probs[nodes_[idx].action] = p;
+        }
+        for (int idx = begin; idx < end; idx++)
+        {
+            probs[nodes_[idx].action] /= sum_probs;
+        }
+        return probs;
+    }
+};
+} // namespace rl::players
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef RL_PLAYERS_BANDITS_STATIC_MCTS_STATIC_SEARCH_TREE_HPP_
+#define RL_PLAYERS_BANDITS_STATIC_MCTS_STATIC_SEARCH_TREE_HPP_
+
+#include <utility>
+#include <players/search_tree.hpp>
+
+namespace rl::players
+{
+/// @brief runs StaticUct or StaticPuct behind ISearchTree, so players and matches
+///     use them like any other search. The IState is converted once per search
+///     through to_short(); the state must be of the game Search was built for
+template <class Search>
+class StaticSearchTree : public ISearchTree
+{
+private:
+    Search search_;
+
+public:
+    template <class... Args>
+    explicit StaticSearchTree(Args&&... args)
+        : search_(std::forward<Args>(args)...)
+    {
+    }
+
+    std::vector<float> search(const rl::common::IState* state_ptr, int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration) override
+    {
+        using Game = typename Search::game_type;
+        const Game root = Game::from_short(state_ptr->to_short());
+        return search_.search(root, minimum_no_simulations, minimum_duration);
+    }
+};
+} // namespace rl::players
+
+#endif
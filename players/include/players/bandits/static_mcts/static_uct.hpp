@@ -0,0 +1,227 @@
+#ifndef RL_PLAYERS_BANDITS_STATIC_MCTS_STATIC_UCT_HPP_
+#define RL_PLAYERS_BANDITS_STATIC_MCTS_STATIC_UCT_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <vector>
+#include <common/exceptions.hpp>
+#include <common/random.hpp>
+#include "static_game.hpp"
+
+namespace rl::players
+{
+/// @brief UctNode's search over a value-type game (see static_game.hpp). Same
+///     selection, backup and final probabilities; the tree is one flat vector with
+///     the children of a node next to each other, and positions are recomputed on
+///     the way down from a copy of the root instead of being stored per node
+template <class Game>
+class StaticUct
+{
+public:
+    using game_type = Game;
+
+    StaticUct(float cuct, float temperature)
+        : cuct_{ cuct },
+        temperature_{ temperature }
+    {
+    }
+
+    /// @return Game::N_ACTIONS probabilities
+    std::vector<float> search(const Game& root, int minimum_simulations, std::chrono::duration<int, std::milli> minimum_duration)
+    {
+        if (root.is_terminal())
+        {
+            throw rl::common::SteppingTerminalStateException("");
+        }
+        nodes_.clear();
+        nodes_.emplace_back();
+
+        auto t_end = std::chrono::high_resolution_clock::now() + minimum_duration;
+        for (int i = 0; i < minimum_simulations; i++)
+        {
+            simulate_one(root);
+        }
+
+        while (t_end > std::chrono::high_resolution_clock::now())
+        {
+            simulate_one(root);
+        }
+
+        return final_probabilities();
+    }
+
+private:
+    enum class NodeKind : int8_t
+    {
+        unvisited,
+        expanded,
+        terminal,
+    };
+
+    struct Node
+    {
+        // children are [first_child, first_child + n_children)
+        int first_child{ -1 };
+        int n_children{ 0 };
+        int action{ -1 };
+        // visits through this node, UctNode::n_
+        int n{ 0 };
+        // visits from the parent and Q(s,a) for the action leading here
+        int nsa{ 0 };
+        float qsa{ 0.0f };
+        // cached reward of a terminal node
+        float result{ 0.0f };
+        NodeKind kind{ NodeKind::unvisited };
+    };
+
+    float cuct_;
+    float temperature_;
+    std::vector<Node> nodes_{};
+    // node indices from the root down, and the player to move at each
+    std::vector<int> path_{};
+    std::vector<int> path_players_{};
+
+    void simulate_one(const Game& root)
+    {
+        Game game = root;
+        int node_idx = 0;
+        path_.clear();
+        path_players_.clear();
+        float z;
+        int p;
+        while (true)
+        {
+            path_.push_back(node_idx);
+            path_players_.push_back(game.player_turn());
+            if (nodes_[node_idx].kind == NodeKind::unvisited)
+            {
+                if (game.is_terminal())
+                {
+                    nodes_[node_idx].kind = NodeKind::terminal;
+                    nodes_[node_idx].result = game.get_reward();
+                }
+                else
+                {
+                    // first none terminal visit, expand then rollout
+                    expand(game, node_idx);
+                    std::tie(z, p) = static_rollout(game);
+                    break;
+                }
+            }
+            if (nodes_[node_idx].kind == NodeKind::terminal)
+            {
+                z = nodes_[node_idx].result;
+                p = game.player_turn();
+                break;
+            }
+            node_idx = find_best_child(nodes_[node_idx]);
+            game.apply(nodes_[node_idx].action);
+        }
+
+        for (int i = static_cast<int>(path_.size()) - 2; i >= 0; i--)
+        {
+            if (p != path_players_[i])
+            {
+                z = -z;
+            }
+            p = path_players_[i];
+            Node& child = nodes_[path_[i + 1]];
+            nodes_[path_[i]].n++;
+            child.nsa++;
+            child.qsa += (z - child.qsa) / float(child.nsa);
+        }
+    }
+
+    void expand(const Game& game, int node_idx)
+    {
+        int actions[Game::N_ACTIONS];
+        const int n_actions = game.legal_actions(actions);
+        const int first_child = static_cast<int>(nodes_.size());
+        // may reallocate, the node is only touched through its index afterwards
+        nodes_.resize(nodes_.size() + n_actions);
+        for (int i = 0; i < n_actions; i++)
+        {
+            nodes_[first_child + i].action = actions[i];
+        }
+        nodes_[node_idx].first_child = first_child;
+        nodes_[node_idx].n_children = n_actions;
+        nodes_[node_idx].kind = NodeKind::expanded;
+    }
+
+    int find_best_child(const Node& node) const
+    {
+        float max_u = -std::numeric_limits<float>::infinity();
+        int best_idx = -1;
+        const float log_n = logf(float(node.n));
+        for (int idx = node.first_child; idx < node.first_child + node.n_children; idx++)
+        {
+            const Node& child = nodes_[idx];
+            float u;
+            if (child.nsa == 0)
+            {
+                u = std::numeric_limits<float>::infinity();
+            }
+            else
+            {
+                u = child.qsa + cuct_ * sqrtf(log_n / float(child.nsa));
+            }
+            if (u > max_u)
+            {
+                max_u = u;
+                best_idx = idx;
+            }
+        }
+
+        if (best_idx != -1)
+        {
+            return best_idx;
+        }
+        return node.first_child + rl::common::get(node.n_children);
+    }
+
+    std::vector<float> final_probabilities() const
+    {
+        std::vector<float> probs(Game::N_ACTIONS, 0.0f);
+        const Node& root = nodes_[0];
+        const int begin = root.first_child;
+        const int end = root.first_child + root.n_children;
+
+        if (temperature_ == 0.0f)
+        {
+            int max_visits_count = 0;
+            for (int idx = begin; idx < end; idx++)
+            {
+                max_visits_count = std::max(max_visits_count, nodes_[idx].nsa);
+            }
+            std::vector<int> best_actions{};
+            for (int idx = begin; idx < end; idx++)
+            {
+                if (nodes_[idx].nsa == max_visits_count)
+                {
+                    best_actions.push_back(nodes_[idx].action);
+                }
+            }
+            probs[best_actions[rl::common::get(static_cast<int>(best_actions.size()))]] = 1.0f;
+            return probs;
+        }
+
+        float sum_probs = 0;
+        for (int idx = begin; idx < end; idx++)
+        {
+            const float new_prob = powf(float(nodes_[idx].nsa) / root.n, 1.0f / temperature_);
+            sum_probs += new_prob;
+            probs[nodes_[idx].action] = new_prob;
+        }
+        for (int idx = begin; idx < end; idx++)
+        {
+            probs[nodes_[idx].action] /= sum_probs;
+        }
+        return probs;
+    }
+};
+} // namespace rl::players
+
+#endif
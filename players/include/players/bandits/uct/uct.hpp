@@ -1,20 +1,27 @@
 #ifndef RL_PLAYERS_BANDITS_UCT_UCT_HPP_
 #define RL_PLAYERS_BANDITS_UCT_UCT_HPP_
 
+#include <memory>
 #include <players/search_tree.hpp>
 
 namespace rl::players
 {
+class UctTree;
 class UctSearchTree : public rl::players::ISearchTree
 {
 private:
     int n_game_actions_;
     float cuct_;
     float temperature_;
+    // kept between searches so its arenas are too
+    std::unique_ptr<UctTree> tree_;
 
 public:
     UctSearchTree(int n_game_actions, float cuct, float temperature);
+    ~UctSearchTree() override;
     std::vector<float> search(const rl::common::IState* state_ptr, int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration) override;
+    /// @brief caps the tree; a search stops early rather than grow past it
+    void set_memory_budget_mb(int megabytes);
 };
 } // namespace rl::players
 #endif
@@ -1,41 +1,73 @@
 #ifndef RL_PLAYERS_BANDITS_UCT_UCT_NODE_HPP_
 #define RL_PLAYERS_BANDITS_UCT_UCT_NODE_HPP_
 #include <common/state.hpp>
+#include <players/node_arena.hpp>
 #include <players/search_tree.hpp>
-#include <optional>
 #include <memory>
 #include <utility>
+#include <vector>
 namespace rl::players
 {
-class UctNode
+// 20 bytes. Nodes hold no state: every simulation clones the root once and
+// applies the actions on its way down.
+struct UctNode
 {
-private:
-    const std::unique_ptr<const rl::common::IState> state_ptr_;
-    int n_game_actions_;
-    float cuct_;
-    std::optional<bool> terminal_;
-    bool is_game_result_cached_;
-    std::optional<float> game_result_;
-    std::vector<bool> actions_legality_;
-    std::vector<std::unique_ptr<UctNode>> children_;
+    // edges are [first_edge, first_edge + n_edges), filled on the first none terminal visit
+    int32_t first_edge{ -1 };
+    int32_t n_edges{ 0 };
+    int32_t n{ 0 };
+    float game_result{ 0.0f };
+    bool is_terminal{ false };
+    bool is_visited{ false };
+};
 
-    int n_;
+// 16 bytes, one per legal action of an expanded node
+struct UctEdge
+{
+    int32_t action{ -1 };
+    // -1 until the action is first selected
+    int32_t child{ -1 };
+    // N(s,a)
+    int32_t nsa{ 0 };
     // Q(s,a)
-    std::vector<float> qsa_;
+    float qsa{ 0.0f };
+};
 
-    // N(n,a)
-    std::vector<int> nsa_;
+class UctTree
+{
+private:
+    int n_game_actions_;
+    float cuct_;
+    size_t memory_budget_bytes_;
+    TreeArenas<UctNode, UctEdge> arenas_;
+    std::vector<int> legal_actions_{};
+    // an allocation failed, the search stops at the end of that simulation
+    bool out_of_budget_{ false };
+    struct PathEntry
+    {
+        int32_t node;
+        int32_t edge;
+        int player;
+    };
+    // from the root down
+    std::vector<PathEntry> path_{};
 
-    std::pair<float, int> simulateOne();
-    int findBestAction();
+    std::pair<float, int> simulateOne(const rl::common::IState* root_state_ptr);
+    /// @return an edge index
+    int32_t findBestAction(const UctNode& node);
+    /// @return false when the edges do not fit in the memory budget
+    bool expand(int32_t node_idx, const rl::common::IState* state_ptr);
     void getFinalProbabilities(float temperature, std::vector<float>& out_actions_probs);
     std::pair<float, int> rollout(std::unique_ptr<rl::common::IState> state_ptr);
 
 public:
-    UctNode(const std::unique_ptr<const rl::common::IState> state_ptr, int n_game_actions, float cuct);
-    void search(int minimum_simulations, std::chrono::duration<int, std::milli> minimum_duration, float uct, float temperature, std::vector<float>& out_actions_probs);
-    ~UctNode();
+    UctTree(int n_game_actions, float cuct, size_t memory_budget_bytes);
+    /// @brief searches from scratch, the previous tree is dropped. Stops early when the
+    ///     next simulation might not fit in the memory budget
+    void search(const rl::common::IState* state_ptr, int minimum_simulations, std::chrono::duration<int, std::milli> minimum_duration, float temperature, std::vector<float>& out_actions_probs);
+    bool is_full() const;
+    size_t bytes_used() const;
 };
 } // namespace players
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,93 @@
+#ifndef RL_PLAYERS_BATCHING_EVALUATOR_HPP_
+#define RL_PLAYERS_BATCHING_EVALUATOR_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "evaluator.hpp"
+
+namespace rl::players
+{
+
+struct BatchedEvaluation
+{
+    std::vector<float> probs;
+    float value;
+};
+
+/// @brief Owns an evaluator and the single thread that runs it. Any number of
+///     threads submit states and get futures back; the inference thread drains
+///     the queue into batches of up to max_batch_size states, and never holds
+///     the oldest queued state for longer than max_delay.
+///     A submitted state must stay alive until its future is ready.
+class BatchingEvaluatorServer
+{
+public:
+    BatchingEvaluatorServer(std::unique_ptr<IEvaluator> evaluator_ptr, int max_batch_size, std::chrono::microseconds max_delay);
+    ~BatchingEvaluatorServer();
+    BatchingEvaluatorServer(const BatchingEvaluatorServer&) = delete;
+    BatchingEvaluatorServer& operator=(const BatchingEvaluatorServer&) = delete;
+
+    std::future<BatchedEvaluation> submit(const rl::common::IState* state_ptr);
+    std::vector<std::future<BatchedEvaluation>> submit(const std::vector<const rl::common::IState*>& state_ptrs);
+
+    const IEvaluator& evaluator() const;
+    int max_batch_size() const;
+    std::chrono::microseconds max_delay() const;
+    long long n_batches() const;
+    long long n_evaluated_states() const;
+
+private:
+    struct Request
+    {
+        const rl::common::IState* state_ptr;
+        std::promise<BatchedEvaluation> promise;
+        std::chrono::steady_clock::time_point submitted_at;
+    };
+
+    std::unique_ptr<IEvaluator> evaluator_ptr_;
+    int max_batch_size_;
+    std::chrono::microseconds max_delay_;
+    mutable std::mutex mutex_{};
+    std::condition_variable cv_{};
+    std::deque<Request> queue_{};
+    bool stop_{ false };
+    long long n_batches_{ 0 };
+    long long n_evaluated_states_{ 0 };
+    std::thread worker_{};
+
+    void run();
+    void evaluate_batch(std::vector<Request>& batch);
+};
+
+/// @brief IEvaluator front-end of a BatchingEvaluatorServer, so searches that
+///     take an IEvaluator run on the shared server unchanged. copy() shares the
+///     server, which is what lets the per-thread copies of a tree-parallel search
+///     (or several searches at once) fill the same batches; clone() starts a new
+///     server on a clone of the wrapped evaluator.
+class BatchingEvaluator : public IEvaluator
+{
+public:
+    BatchingEvaluator(std::unique_ptr<IEvaluator> evaluator_ptr, int max_batch_size, std::chrono::microseconds max_delay);
+    explicit BatchingEvaluator(std::shared_ptr<BatchingEvaluatorServer> server_ptr);
+    ~BatchingEvaluator() override;
+
+    std::tuple<std::vector<float>, std::vector<float>> evaluate(const std::vector<const rl::common::IState*>& state_ptrs) override;
+    std::tuple<std::vector<float>, std::vector<float>> evaluate(const rl::common::IState* state_ptrs) override;
+    std::tuple<std::vector<float>, std::vector<float>> evaluate(const std::unique_ptr<rl::common::IState>& state_ptrs) override;
+    std::unique_ptr<IEvaluator> clone() const override;
+    std::unique_ptr<IEvaluator> copy() const override;
+
+    const std::shared_ptr<BatchingEvaluatorServer>& server() const;
+
+private:
+    std::shared_ptr<BatchingEvaluatorServer> server_ptr_;
+};
+
+} // namespace rl::players
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef RL_PLAYERS_CACHING_EVALUATOR_HPP_
+#define RL_PLAYERS_CACHING_EVALUATOR_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "evaluator.hpp"
+
+namespace rl::players
+{
+
+struct EvaluationCacheStats
+{
+    long long n_lookups = 0;
+    long long n_hits = 0;
+    long long n_inserts = 0;
+    long long n_evictions = 0;
+    double hit_rate() const;
+};
+
+/// @brief Policies and values by position key in a table allocated once. The table
+///     is N_WAYS-way set associative: a key can only sit in the ways of its set, and
+///     a new key replaces the least recently used of them. Sets are guarded by
+///     N_STRIPES mutexes, so threads on different sets do not wait on each other.
+class EvaluationCache
+{
+public:
+    static constexpr int N_WAYS = 4;
+    static constexpr int N_STRIPES = 64;
+
+    /// @param n_entries rounded up to a power of two sets of N_WAYS entries
+    EvaluationCache(size_t n_entries, int n_actions);
+    EvaluationCache(const EvaluationCache&) = delete;
+    EvaluationCache& operator=(const EvaluationCache&) = delete;
+
+    /// @brief copies the n_actions probabilities and the value out on a hit
+    bool lookup(uint64_t key, float* out_probs, float& out_value);
+    void insert(uint64_t key, const float* probs, float value);
+    void clear();
+
+    EvaluationCacheStats stats() const;
+    size_t capacity() const;
+    int n_actions() const;
+    /// @brief what the table takes, allocated in the constructor
+    size_t bytes() const;
+
+private:
+    int n_actions_;
+    size_t n_sets_;
+    std::vector<uint64_t> keys_{};
+    // 0 for an empty entry, otherwise the tick of its last use
+    std::vector<uint64_t> last_used_{};
+    std::vector<float> probs_{};
+    std::vector<float> values_{};
+    std::vector<uint64_t> stripe_ticks_;
+    std::unique_ptr<std::mutex[]> stripes_;
+    std::atomic<long long> n_lookups_{ 0 };
+    std::atomic<long long> n_hits_{ 0 };
+    std::atomic<long long> n_inserts_{ 0 };
+    std::atomic<long long> n_evictions_{ 0 };
+
+    size_t set_of(uint64_t key) const;
+};
+
+/// @brief IEvaluator that answers the positions its EvaluationCache holds and passes
+///     only the others on to the wrapped evaluator, in one batch per call. copy()
+///     shares the cache and copies the wrapped evaluator, so the per-thread copies
+///     of a search, or every player of a concurrent match, reuse each other's
+///     evaluations; clone() starts an empty cache of the same size.
+///
+///     Positions are keyed by IState::hash(). With use_symmetries, a position and
+///     its symmetric images share one key instead: the smallest hash of their
+///     observations, legal actions and player to move. The policy is stored for that
+///     canonical image and mapped back through the action permutation on a hit, so
+///     use_symmetries assumes the wrapped evaluator is equivariant under the game's
+///     symmetries, as a network trained on symmetric samples is meant to be.
+///
+///     A cached random rollout is one sample, answered again for every later visit.
+///
+///     Not reentrant: evaluate() works in the instance's scratch buffers, so one
+///     instance must never be called from two threads at once. Every thread takes its
+///     own with copy(), which still shares the cache.
+class CachingEvaluator : public IEvaluator
+{
+public:
+    CachingEvaluator(std::unique_ptr<IEvaluator> evaluator_ptr, size_t n_entries, int n_actions, bool use_symmetries);
+    CachingEvaluator(std::unique_ptr<IEvaluator> evaluator_ptr, std::shared_ptr<EvaluationCache> cache_ptr, bool use_symmetries);
+    ~CachingEvaluator() override;
+
+    std::tuple<std::vector<float>, std::vector<float>> evaluate(const std::vector<const rl::common::IState*>& state_ptrs) override;
+    std::tuple<std::vector<float>, std::vector<float>> evaluate(const rl::common::IState* state_ptrs) override;
+    std::tuple<std::vector<float>, std::vector<float>> evaluate(const std::unique_ptr<rl::common::IState>& state_ptrs) override;
+    std::unique_ptr<IEvaluator> clone() const override;
+    std::unique_ptr<IEvaluator> copy() const override;
+
+    const std::shared_ptr<EvaluationCache>& cache() const;
+
+private:
+    std::unique_ptr<IEvaluator> evaluator_ptr_;
+    std::shared_ptr<EvaluationCache> cache_ptr_;
+    bool use_symmetries_;
+    // scratch reused across calls, one evaluate() runs at a time per evaluator
+    std::vector<float> observation_{};
+    std::vector<float> symmetric_observation_{};
+    std::vector<float> identity_actions_{};
+    std::vector<float> symmetric_actions_{};
+    std::vector<int> legal_actions_{};
+    std::vector<uint8_t> is_legal_{};
+    std::vector<float> canonical_probs_{};
+    std::vector<int> candidate_permutation_{};
+    std::vector<uint8_t> is_taken_{};
+    // IState::n_symmetries() can be as slow as building every image, it is asked once
+    int n_symmetries_{ -1 };
+
+    /// @brief the state's key, and the action permutation into its canonical image,
+    ///     canonical action i being the state's action permutation[i]. Empty when the
+    ///     image is the state itself
+    uint64_t key_of(const rl::common::IState* state_ptr, std::vector<int>& permutation);
+};
+
+} // namespace rl::players
+
+#endif
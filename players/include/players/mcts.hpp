@@ -4,48 +4,92 @@
 #include <optional>
 #include <memory>
 #include "evaluator.hpp"
+#include "node_arena.hpp"
 #include "search_tree.hpp"
 #include <common/state.hpp>
 
 namespace rl::players
 {
-class MCTSNode
+// 40 bytes plus the state. Every node keeps its state, so a simulation only
+// steps the state of the node it adds instead of replaying its whole path.
+struct MCTSNode
 {
-private:
-    std::unique_ptr<rl::common::IState> state_ptr_;
-    int n_game_actions_;
-    float cpuct_;
-    std::vector<bool> actions_mask_;
-    std::vector<std::unique_ptr<MCTSNode>> children_;
-    std::vector<float> probs_;
-    int n_visits{ 0 };
-    std::vector<float> actions_visits_;
-    std::vector<float> delta_wins_;
-    std::optional<bool> is_terminal_;
-    std::optional<float> game_result_;
-    std::pair<float, int> search(std::unique_ptr<IEvaluator>& evaluator_ptr);
-    std::vector<float> get_probs(float temperature);
-    int get_best_action();
+    std::unique_ptr<rl::common::IState> state_ptr{};
+    // the state's hash, how a search finds the node again when the tree is reused
+    uint64_t key{ 0 };
+    // edges are [first_edge, first_edge + n_edges), filled on the first visit
+    int32_t first_edge{ -1 };
+    int32_t n_edges{ 0 };
+    int32_t n_visits{ 0 };
+    float game_result{ 0.0f };
+    bool is_terminal{ false };
+    bool is_visited{ false };
+};
 
-public:
-    MCTSNode(std::unique_ptr<rl::common::IState> state_ptr, int n_game_actions, float cpuct);
-    ~MCTSNode();
-    std::vector<float> search_and_get_probs(std::unique_ptr<IEvaluator>& evaluator_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration, float temperature);
+// 20 bytes, one per legal action of an expanded node
+struct MCTSEdge
+{
+    int32_t action{ -1 };
+    // -1 until the action is first selected
+    int32_t child{ -1 };
+    float prob{ 0.0f };
+    float visits{ 0.0f };
+    float delta_wins{ 0.0f };
 };
+
 class MCTS : public ISearchTree
 {
 
 private:
+    using Arenas = TreeArenas<MCTSNode, MCTSEdge>;
+
     std::unique_ptr<IEvaluator> evaluator_ptr_;
     float cpuct_;
     float temperature_;
-    std::unique_ptr<MCTSNode> root_node;
     int n_game_actions_;
+    size_t memory_budget_bytes_;
+    // the tree, its root at index 0, and empty arenas a reused subtree is moved into
+    std::unique_ptr<Arenas> tree_;
+    std::unique_ptr<Arenas> spare_;
+    // trees of earlier searches, oldest first, freed a few nodes per simulation so
+    // dropping a big tree never stalls a move
+    std::vector<std::unique_ptr<Arenas>> retired_trees_{};
+    // what the states of the expanded nodes take, the arenas only count the headers
+    size_t state_bytes_{ 0 };
+    // set when an arena refused an allocation, the search stops
+    bool out_of_budget_{ false };
+    std::vector<int> legal_actions_{};
+    struct PathEntry
+    {
+        int32_t node;
+        int32_t edge;
+        int player;
+    };
+    std::vector<PathEntry> path_{};
+
+    void simulate_once();
+    /// @brief empties the tree down to a root holding state_ptr
+    void reset_root(const rl::common::IState* state_ptr);
+    /// @return an edge index
+    int32_t get_best_action(const MCTSNode& node);
+    std::vector<float> get_probs(float temperature);
+    /// @return the node 0 to max_depth plies below node holding the same position as
+    ///     state, shallowest first, or -1 if the search never reached it
+    int32_t find_descendant(int32_t node, const rl::common::IState& state, uint64_t key, int max_depth) const;
+    /// @brief hands tree_ over to retired_trees_ and takes empty arenas in its place
+    void retire_tree();
+    /// @brief frees up to max_items nodes, and their worth of edges, of the oldest retired tree
+    void release_retired(int32_t max_items);
+    bool is_full() const;
 
 public:
     MCTS(std::unique_ptr<IEvaluator> evaluator_ptr, int n_game_actions, float cpuct, float temperature);
     ~MCTS()override;
+    /// @brief searching the previous root again, or a position up to two plies below it
+    ///     that the last search reached, resumes from that subtree
     std::vector<float> search(const rl::common::IState* state_ptr, int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration)override;
+    /// @brief caps the tree; a search stops early rather than grow past it. Drops the tree
+    void set_memory_budget_mb(int megabytes);
 };
 
 } // namespace rl::searchTrees
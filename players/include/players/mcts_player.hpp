@@ -7,6 +7,7 @@
 
 namespace rl::players
 {
+class MCTS;
 class MctsPlayer : public rl::common::IPlayer
 {
 private:
@@ -16,6 +17,8 @@ private:
     std::chrono::duration<int, std::milli> duration_in_millis_;
     float temperature_;
     float cpuct_;
+    // kept between moves so the subtree of the position we reach is reused
+    std::unique_ptr<MCTS> mcts_ptr_;
 
 public:
     MctsPlayer(int n_game_actions,
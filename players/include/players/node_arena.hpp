@@ -0,0 +1,233 @@
+#ifndef RL_PLAYERS_NODE_ARENA_HPP_
+#define RL_PLAYERS_NODE_ARENA_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+namespace rl::players
+{
+// What a search tree may grow to unless set_memory_budget_mb says otherwise.
+// Arenas take memory a chunk at a time as the tree grows, so this is a
+// ceiling, not an up front reservation.
+constexpr int DEFAULT_MEMORY_BUDGET_MB = 1024;
+
+inline size_t memory_budget_bytes(int megabytes)
+{
+    return static_cast<size_t>(std::max(1, megabytes)) * 1024u * 1024u;
+}
+
+/// @brief Storage for search tree nodes and their per action statistics, addressed
+///     by int32_t index instead of pointer, in the spirit of MigoyugoGravePlayer's
+///     arenas. Items live in chunks of about CHUNK_BYTES that are never moved, so a
+///     reference stays valid while the arena grows, and a tree of a million nodes is
+///     a few hundred allocations instead of millions.
+///
+///     allocate() is thread safe; reading an index another thread allocated is safe
+///     once that index was published with release/acquire ordering. The arena never
+///     holds more than max_bytes worth of items: allocate() returns -1 instead.
+template <class T>
+class NodeArena
+{
+public:
+    static constexpr size_t CHUNK_BYTES = 256 * 1024;
+
+    explicit NodeArena(size_t max_bytes)
+        : max_items_{ static_cast<int32_t>(std::min<size_t>(max_bytes / sizeof(T), INT32_MAX - CHUNK_SIZE)) },
+        n_chunks_{ (max_items_ + CHUNK_SIZE - 1) / CHUNK_SIZE },
+        chunks_{ new std::atomic<T*>[n_chunks_] }
+    {
+        for (int32_t c = 0; c < n_chunks_; c++)
+        {
+            chunks_[c].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    ~NodeArena()
+    {
+        for (int32_t c = 0; c < n_chunks_; c++)
+        {
+            delete[] chunks_[c].load(std::memory_order_relaxed);
+        }
+    }
+
+    /// @return the index of the first of n contiguous, value initialized items,
+    ///     or -1 when they would not fit in the budget
+    int32_t allocate(int32_t n)
+    {
+        if (n > CHUNK_SIZE)
+        {
+            throw std::length_error("node arena allocation larger than a chunk");
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        int32_t first = size_.load(std::memory_order_relaxed);
+        // a run never straddles two chunks, the rest of this one is left unused
+        if ((first % CHUNK_SIZE) + n > CHUNK_SIZE)
+        {
+            first = (first / CHUNK_SIZE + 1) * CHUNK_SIZE;
+        }
+        if (first + n > max_items_)
+        {
+            return -1;
+        }
+        std::atomic<T*>& chunk = chunks_[first / CHUNK_SIZE];
+        if (chunk.load(std::memory_order_relaxed) == nullptr)
+        {
+            chunk.store(new T[CHUNK_SIZE](), std::memory_order_release);
+        }
+        size_.store(first + n, std::memory_order_release);
+        return first;
+    }
+
+    T& operator[](int32_t index)
+    {
+        return chunks_[index / CHUNK_SIZE].load(std::memory_order_acquire)[index % CHUNK_SIZE];
+    }
+
+    const T& operator[](int32_t index) const
+    {
+        return chunks_[index / CHUNK_SIZE].load(std::memory_order_acquire)[index % CHUNK_SIZE];
+    }
+
+    /// @brief one past the last allocated index
+    int32_t size() const
+    {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    size_t bytes_used() const
+    {
+        return static_cast<size_t>(size()) * sizeof(T);
+    }
+
+    /// @brief drops every item but keeps the chunks for the next tree. Not thread safe
+    void clear()
+    {
+        clear_back(size_.load(std::memory_order_relaxed));
+    }
+
+    /// @brief drops up to max_items items from the end, so a large tree can be let go of
+    ///     a little at a time. Not thread safe
+    /// @return true once the arena is empty
+    bool clear_back(int32_t max_items)
+    {
+        const int32_t size = size_.load(std::memory_order_relaxed);
+        const int32_t new_size = std::max(0, size - max_items);
+        // items may own resources (states), give them back now rather than on reuse
+        for (int32_t i = size - 1; i >= new_size; i--)
+        {
+            T& item = (*this)[i];
+            item.~T();
+            new (&item) T();
+        }
+        size_.store(new_size, std::memory_order_relaxed);
+        return new_size == 0;
+    }
+
+private:
+    static constexpr int32_t CHUNK_SIZE = static_cast<int32_t>(CHUNK_BYTES / sizeof(T) > 0 ? CHUNK_BYTES / sizeof(T) : 1);
+
+    int32_t max_items_;
+    int32_t n_chunks_;
+    std::unique_ptr<std::atomic<T*>[]> chunks_;
+    std::atomic<int32_t> size_{ 0 };
+    std::mutex mutex_;
+};
+
+/// @brief the two arenas of a tree: fixed size node headers, and the per action
+///     statistics of every expanded node as one contiguous run
+template <class Node, class Edge>
+struct TreeArenas
+{
+    NodeArena<Node> nodes;
+    NodeArena<Edge> edges;
+
+    explicit TreeArenas(size_t max_bytes)
+        : nodes(max_bytes),
+        edges(max_bytes)
+    {
+    }
+
+    void clear()
+    {
+        nodes.clear();
+        edges.clear();
+    }
+
+    /// @return true once both arenas are empty
+    bool clear_back(int32_t max_nodes, int32_t max_edges)
+    {
+        const bool are_nodes_empty = nodes.clear_back(max_nodes);
+        const bool are_edges_empty = edges.clear_back(max_edges);
+        return are_nodes_empty && are_edges_empty;
+    }
+
+    size_t bytes_used() const
+    {
+        return nodes.bytes_used() + edges.bytes_used();
+    }
+};
+
+/// @brief copies the subtree under root into empty arenas, so a reused subtree stops
+///     dragging the rest of the old tree along. Node needs first_edge and n_edges,
+///     Edge needs child (-1 when there is none). move_node(from, to) and
+///     move_edge(from, to) carry over whole items; the indices they copy are
+///     rewritten here
+/// @return the root's index in to, -1 if it ran out of budget
+template <class Node, class Edge, class MoveNode, class MoveEdge>
+int32_t move_subtree(TreeArenas<Node, Edge>& from, int32_t root, TreeArenas<Node, Edge>& to, MoveNode move_node, MoveEdge move_edge)
+{
+    const int32_t new_root = to.nodes.allocate(1);
+    if (new_root < 0)
+    {
+        return -1;
+    }
+    move_node(from.nodes[root], to.nodes[new_root]);
+    // breadth first, the destination's nodes are the work list: every one of them
+    // still points at its edges in the source until it is visited here
+    for (int32_t node = new_root; node < to.nodes.size(); node++)
+    {
+        const int32_t n_edges = to.nodes[node].n_edges;
+        if (n_edges == 0)
+        {
+            continue;
+        }
+        const int32_t from_first = to.nodes[node].first_edge;
+        const int32_t to_first = to.edges.allocate(n_edges);
+        if (to_first < 0)
+        {
+            return -1;
+        }
+        to.nodes[node].first_edge = to_first;
+        for (int32_t i = 0; i < n_edges; i++)
+        {
+            Edge& from_edge = from.edges[from_first + i];
+            Edge& to_edge = to.edges[to_first + i];
+            move_edge(from_edge, to_edge);
+            const int32_t child = from_edge.child;
+            to_edge.child = -1;
+            if (child >= 0)
+            {
+                const int32_t new_child = to.nodes.allocate(1);
+                if (new_child < 0)
+                {
+                    return -1;
+                }
+                move_node(from.nodes[child], to.nodes[new_child]);
+                to_edge.child = new_child;
+            }
+        }
+    }
+    return new_root;
+}
+} // namespace rl::players
+
+#endif
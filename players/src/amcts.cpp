@@ -123,14 +123,14 @@ void Amcts::simulate_once(const rl::common::IState* state_ptr, std::vector<Amcts
         return;
     }
 
-    auto short_state = state_ptr->to_short();
+    auto state_hash = state_ptr->hash();
     int player = state_ptr->player_turn();
 
-    if (states_.find(short_state) == states_.end())
+    if (states_.find(state_hash) == states_.end())
     {
         // first visit ( short states are not in state )
-        expand_state(state_ptr, short_state);
-        std::vector<bool> actions_mask = masks_.at(short_state);
+        expand_state(state_ptr, state_hash);
+        std::vector<bool> actions_mask = masks_.at(state_hash);
 
         // check if it has more than  1 legal action
         int n_legal_actions{ 0 };
@@ -147,7 +147,7 @@ void Amcts::simulate_once(const rl::common::IState* state_ptr, std::vector<Amcts
             {
                 probs.emplace_back(float(m));
             }
-            psa_.at(short_state) = probs;
+            psa_.at(state_hash) = probs;
         }
         else
         {
@@ -158,37 +158,37 @@ void Amcts::simulate_once(const rl::common::IState* state_ptr, std::vector<Amcts
 
     // continue down the tree
 
-    int best_action = find_best_action(short_state);
+    int best_action = find_best_action(state_hash);
 
-    if (!edges_[short_state].at(best_action)) // check if edge of best action is null
+    if (!edges_[state_hash].at(best_action)) // check if edge of best action is null
     {
-        edges_[short_state].at(best_action) = state_ptr->step(best_action);
+        edges_[state_hash].at(best_action) = state_ptr->step(best_action);
     }
 
-    auto new_state_ptr = edges_[short_state].at(best_action).get();
+    auto new_state_ptr = edges_[state_hash].at(best_action).get();
 
     if (new_state_ptr == nullptr)
     {
         throw std::runtime_error("new state was found to be null");
     }
 
-    visited_path.push_back({ short_state, best_action, player });
-    nsa_.at(short_state).at(best_action) += default_n_;
-    ns_.at(short_state) += default_n_;
-    wsa_.at(short_state).at(best_action) += default_w_;
+    visited_path.push_back({ state_hash, best_action, player });
+    nsa_.at(state_hash).at(best_action) += default_n_;
+    ns_.at(state_hash) += default_n_;
+    wsa_.at(state_hash).at(best_action) += default_w_;
     simulate_once(new_state_ptr, visited_path);
 }
 
-int Amcts::find_best_action(std::string& short_state)
+int Amcts::find_best_action(uint64_t state_hash)
 {
     float max_u = -INFINITY;
     int best_action = -1;
 
-    const auto& wsa_vec = wsa_.at(short_state);
-    const auto& nsa_vec = nsa_.at(short_state);
-    const auto& psa_vec = psa_.at(short_state);
-    const auto& masks = masks_.at(short_state);
-    float current_state_visis = ns_.at(short_state);
+    const auto& wsa_vec = wsa_.at(state_hash);
+    const auto& nsa_vec = nsa_.at(state_hash);
+    const auto& psa_vec = psa_.at(state_hash);
+    const auto& masks = masks_.at(state_hash);
+    float current_state_visis = ns_.at(state_hash);
 
     for (int action{ 0 }; action < masks.size(); action++)
     {
@@ -230,21 +230,21 @@ int Amcts::find_best_action(std::string& short_state)
     }
     return best_action;
 }
-void Amcts::expand_state(const rl::common::IState* state_ptr, std::string& short_state)
+void Amcts::expand_state(const rl::common::IState* state_ptr, uint64_t state_hash)
 {
     if (state_ptr->is_terminal())
     {
         throw std::runtime_error("Expanding a terminal state");
     }
-    states_.insert(short_state);
+    states_.insert(state_hash);
 
     std::vector<bool> action_mask = state_ptr->actions_mask();
-    masks_[short_state] = action_mask;
-    ns_[short_state] = 0;
-    nsa_[short_state] = std::vector<float>(n_game_actions_, 0.0f);
-    wsa_[short_state] = std::vector<float>(n_game_actions_, 0.0f);
-    // edges_[short_state] = std::move(std::vector<std::unique_ptr<rl::common::State>>(n_game_actions_, std::unique_ptr<rl::common::State>(nullptr)));
-    auto& vec = edges_[short_state];
+    masks_[state_hash] = action_mask;
+    ns_[state_hash] = 0;
+    nsa_[state_hash] = std::vector<float>(n_game_actions_, 0.0f);
+    wsa_[state_hash] = std::vector<float>(n_game_actions_, 0.0f);
+    // edges_[state_hash] = std::move(std::vector<std::unique_ptr<rl::common::State>>(n_game_actions_, std::unique_ptr<rl::common::State>(nullptr)));
+    auto& vec = edges_[state_hash];
     vec.clear();
     for (int i{ 0 }; i < n_game_actions_; i++)
     {
@@ -261,7 +261,7 @@ void Amcts::expand_state(const rl::common::IState* state_ptr, std::string& short
     {
         probs.emplace_back(float(m) / n_legal_actions);
     }
-    psa_[short_state] = probs;
+    psa_[state_hash] = probs;
 }
 
 void Amcts::add_to_rollouts(const rl::common::IState* state_ptr, std::vector<AmctsInfo> visited_path)
@@ -275,8 +275,8 @@ std::vector<float> Amcts::get_probs(const rl::common::IState* root_ptr)
     {
         std::runtime_error("Trying to get probabilities with nullptr state");
     }
-    std::string state_short = root_ptr->to_short();
-    const auto& actions_visits = nsa_.at(state_short);
+    uint64_t state_hash = root_ptr->hash();
+    const auto& actions_visits = nsa_.at(state_hash);
     if (temperature_ == 0.0f)
     {
         // find max action visits
@@ -376,10 +376,10 @@ void Amcts::evaluate_collected_states()
         auto state_ptr = states_ptrs.at(i);
 
         // check if we can use the visited_path;
-        auto state_short = state_ptr->to_short();
-        auto actions_mask = masks_.at(state_short);
+        auto state_hash = state_ptr->hash();
+        auto actions_mask = masks_.at(state_hash);
 
-        std::vector<float>& tree_probs_ref = psa_.at(state_short);
+        std::vector<float>& tree_probs_ref = psa_.at(state_hash);
         float probs_sum{ 0.0f };
         for (int j{ 0 }; j < n_game_actions_; j++)
         {
@@ -403,11 +403,11 @@ void Amcts::backpropogate(std::vector<AmctsInfo>& visited_path, float final_resu
     while (visited_path.size() != 0)
     {
         auto& info = visited_path.at(visited_path.size() - 1);
-        auto& state_short = info.state_short;
+        auto state_hash = info.state_hash;
         float score = info.player == final_player ? final_result : -final_result;
-        ns_.at(state_short) += 1 - default_n_;
-        nsa_.at(state_short).at(info.action) += 1 - default_n_;
-        wsa_.at(state_short).at(info.action) += score - default_w_;
+        ns_.at(state_hash) += 1 - default_n_;
+        nsa_.at(state_hash).at(info.action) += 1 - default_n_;
+        wsa_.at(state_hash).at(info.action) += score - default_w_;
         visited_path.pop_back();
     }
 }
@@ -1,5 +1,6 @@
 #include <players/amcts2_player.hpp>
 #include <players/bandits/amcts2/amcts2.hpp>
+#include <players/bandits/amcts2/concurrent_amcts.hpp>
 #include <common/random.hpp>
 #include <cassert>
 
@@ -16,7 +17,8 @@ Amcts2Player::Amcts2Player(
     float dirichlet_epsilon,
     float dirichlet_alpha,
     float default_visits,
-    float default_wins)
+    float default_wins,
+    int n_threads)
 
     : n_game_actions_{ n_game_actions },
     evaluator_ptr_{ std::move(evaluator_ptr) },
@@ -28,7 +30,8 @@ Amcts2Player::Amcts2Player(
     dirichlet_epsilon_{dirichlet_epsilon},
     dirichlet_alpha_{dirichlet_alpha},
     default_visits_{ default_visits },
-    default_wins_{ default_wins }
+    default_wins_{ default_wins },
+    n_threads_{ n_threads }
 {
 }
 
@@ -37,8 +40,11 @@ Amcts2Player::~Amcts2Player() = default;
 
 int Amcts2Player::choose_action(const std::unique_ptr<rl::common::IState>& state_ptr)
 {
-    auto mcts = Amcts2(n_game_actions_, evaluator_ptr_->copy(), cpuct_, temperature_, max_async_simulations_,dirichlet_epsilon_,dirichlet_alpha_, default_visits_, default_wins_);
-    std::vector<float> probs = mcts.search(state_ptr.get(), minimum_simulations_, duration_in_millis_);
+    if (!tree_ptr_)
+    {
+        tree_ptr_ = std::make_unique<Amcts2>(n_game_actions_, evaluator_ptr_->copy(), cpuct_, temperature_, max_async_simulations_, dirichlet_epsilon_, dirichlet_alpha_, default_visits_, default_wins_, n_threads_);
+    }
+    std::vector<float> probs = tree_ptr_->search(state_ptr.get(), minimum_simulations_, duration_in_millis_);
 
     float p = rl::common::get();
 
@@ -58,8 +64,6 @@ int Amcts2Player::choose_action(const std::unique_ptr<rl::common::IState>& state
 }
 } // namespace rl::players
 
-#include <players/bandits/amcts2/concurrent_amcts.hpp>
-
 namespace rl::players
 {
 ConcurrentPlayer::ConcurrentPlayer(
@@ -94,8 +98,12 @@ ConcurrentPlayer::~ConcurrentPlayer() = default;
 
 std::vector<int> ConcurrentPlayer::choose_actions(const std::vector<const rl::common::IState*>& states_ptrs_ref)
 {
-    auto amcts = ConcurrentAmcts(n_game_actions_, evaluator_ptr_->copy(), cpuct_, temperature_, max_async_simulations_, dirichlet_epsilon_,dirichlet_alpha_,default_visits_, default_wins_);
-    auto [all_probs, all_values] = amcts.search_multiple(states_ptrs_ref, minimum_simulations_, duration_in_millis_);
+    if (!tree_ptr_)
+    {
+        tree_ptr_ = std::make_unique<ConcurrentAmcts>(n_game_actions_, evaluator_ptr_->copy(), cpuct_, temperature_, max_async_simulations_, dirichlet_epsilon_, dirichlet_alpha_, default_visits_, default_wins_);
+        tree_ptr_->set_tree_reuse(true);
+    }
+    auto [all_probs, all_values] = tree_ptr_->search_multiple(states_ptrs_ref, minimum_simulations_, duration_in_millis_);
     const int n_states = states_ptrs_ref.size();
     std::vector<int> actions{};
     for (int i = 0;i < n_states;i++)
@@ -1,13 +1,21 @@
 #include <cassert>
 #include <players/bandits/amcts2/amcts2.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
 
 
 namespace rl::players
 {
 constexpr float EPS = 1e-8f;
+constexpr int MAX_REUSE_DEPTH = 2;
+// a simulation adds a node, freeing a few more keeps retired trees from piling up
+constexpr int32_t RELEASE_PER_SIMULATION = 64;
 
 Amcts2::Amcts2(
     int n_game_actions,
@@ -18,7 +26,8 @@ Amcts2::Amcts2(
     float dirichlet_epsilon,
     float dirichlet_alpha,
     float default_visits,
-    float default_wins)
+    float default_wins,
+    int n_threads)
     : n_game_actions_{ n_game_actions },
     evaluator_ptr_{ std::move(evaluator_ptr) },
     cpuct_{ cpuct },
@@ -27,11 +36,32 @@ Amcts2::Amcts2(
     dirichlet_epsilon_{dirichlet_epsilon},
     dirichlet_alpha_{dirichlet_alpha},
     default_n_{ default_visits },
-    default_w_{ default_wins }
+    default_w_{ default_wins },
+    n_threads_{ std::max(1, n_threads) },
+    memory_budget_bytes_{ memory_budget_bytes(DEFAULT_MEMORY_BUDGET_MB) }
 {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    // no threads to start in a browser build without pthreads
+    n_threads_ = 1;
+#endif
 }
 Amcts2::~Amcts2() = default;
 
+void Amcts2::set_memory_budget_mb(int megabytes)
+{
+    memory_budget_bytes_ = memory_budget_bytes(megabytes);
+    tree_.reset();
+    retired_trees_.clear();
+}
+
+void players::Amcts2::release_retired(int32_t max_nodes)
+{
+    if (!retired_trees_.empty() && retired_trees_.front()->release(max_nodes))
+    {
+        retired_trees_.erase(retired_trees_.begin());
+    }
+}
+
 std::vector<float> Amcts2::search(const rl::common::IState* state_ptr, int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration)
 {
     if (state_ptr == nullptr)
@@ -61,12 +91,18 @@ std::vector<float> Amcts2::search(const rl::common::IState* state_ptr, int minim
 
     set_root(state_ptr);
 
+    if (n_threads_ > 1)
+    {
+        search_parallel(minimum_no_simulations, minimum_duration);
+        return get_probs();
+    }
+
     auto t_start = std::chrono::high_resolution_clock::now();
     auto t_end = t_start + minimum_duration;
 
     int simulations_count{ 0 };
 
-    while (simulations_count <= minimum_no_simulations || t_end > std::chrono::high_resolution_clock::now())
+    while ((simulations_count <= minimum_no_simulations || t_end > std::chrono::high_resolution_clock::now()) && !tree_->is_full(1))
     {
         roll(dirichlet_epsilon_,dirichlet_alpha_);
         simulations_count++;
@@ -78,6 +114,7 @@ std::vector<float> Amcts2::search(const rl::common::IState* state_ptr, int minim
 
             evaluate_collected_states(evaluations);
             clear_rollout();
+            release_retired(RELEASE_PER_SIMULATION * max_async_simulations_);
         }
 
     }
@@ -90,17 +127,125 @@ std::vector<float> Amcts2::search(const rl::common::IState* state_ptr, int minim
     return get_probs();
 }
 
+void players::Amcts2::search_parallel(int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration)
+{
+    auto t_end = std::chrono::high_resolution_clock::now() + minimum_duration;
+    std::atomic<int> simulations_count{ 0 };
+    std::atomic<bool> stop{ false };
+
+    // Same loop as the single-threaded search, once per thread, all on the one
+    // root. Each thread keeps its own batch and its own evaluator, so nothing
+    // but the tree itself is shared.
+    auto worker = [&](IEvaluator& evaluator)
+    {
+        std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>> rollouts{};
+        std::vector<const rl::common::IState*> states{};
+        auto flush = [&]()
+        {
+            states.clear();
+            for (auto& rollout : rollouts)
+            {
+                states.push_back(rollout.first);
+            }
+            auto [probs, values] = evaluator.evaluate(states);
+            for (int i{ 0 }; i < static_cast<int>(rollouts.size()); i++)
+            {
+                std::vector<float> state_probs(probs.begin() + i * n_game_actions_, probs.begin() + (i + 1) * n_game_actions_);
+                backpropogate(rollouts.at(i).second, values.at(i), rollouts.at(i).first->player_turn(), state_probs);
+            }
+            rollouts.clear();
+        };
+
+        int local_count{ 0 };
+        // every thread may be about to add a node, hence n_threads_ in flight
+        while (!stop.load(std::memory_order_relaxed) && (simulations_count.load(std::memory_order_relaxed) <= minimum_no_simulations || t_end > std::chrono::high_resolution_clock::now()) && !tree_->is_full(n_threads_))
+        {
+            rollouts.push_back(std::make_pair<rl::common::IState*, std::vector<Amcts2Info>>(nullptr, {}));
+            tree_->simulate_once(rollouts.back(), dirichlet_epsilon_, dirichlet_alpha_, default_n_, default_w_);
+            if (rollouts.back().first == nullptr)
+            {
+                rollouts.pop_back();
+            }
+            simulations_count.fetch_add(1, std::memory_order_relaxed);
+            if (++local_count % max_async_simulations_ == 0 && !rollouts.empty())
+            {
+                flush();
+            }
+        }
+        if (!rollouts.empty())
+        {
+            flush();
+        }
+    };
+
+    // an exception must not escape a std::thread, so the first one is carried
+    // back and rethrown here once every worker has stopped
+    std::exception_ptr error{ nullptr };
+    std::mutex error_mutex{};
+    std::vector<std::thread> threads{};
+    for (int i = 0; i < n_threads_; i++)
+    {
+        threads.emplace_back([&, evaluator = evaluator_ptr_->copy()]() mutable
+            {
+                try
+                {
+                    worker(*evaluator);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                    stop.store(true, std::memory_order_relaxed);
+                }
+            });
+    }
+    // the workers have the tree, this thread lets go of the old ones meanwhile
+    while (!retired_trees_.empty())
+    {
+        release_retired(RELEASE_PER_SIMULATION);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    std::cout << "Amcts2: " << simulations_count.load() << " (" << n_threads_ << " threads)" << std::endl;
+}
+
 void players::Amcts2::set_root(const rl::common::IState* state_ptr)
 {
     rollouts_.clear();
     assert(state_ptr->is_terminal() == false);
-    root_node_ = std::make_unique<Amcts2Node>(state_ptr->clone(), state_ptr->get_n_actions(), cpuct_);
+    if (tree_)
+    {
+        // keep the part of the last search that is still relevant: the same
+        // position again, or one reached by our move and the opponent's reply
+        if (tree_->state()->equals(*state_ptr))
+        {
+            return;
+        }
+        int32_t reused_node = tree_->find_descendant(*state_ptr, MAX_REUSE_DEPTH);
+        std::unique_ptr<Amcts2Tree> reused_tree = reused_node >= 0 ? tree_->extract(reused_node, memory_budget_bytes_) : nullptr;
+        retired_trees_.push_back(std::move(tree_));
+        if (reused_tree)
+        {
+            tree_ = std::move(reused_tree);
+            return;
+        }
+    }
+    tree_ = std::make_unique<Amcts2Tree>(state_ptr->clone(), state_ptr->get_n_actions(), cpuct_, memory_budget_bytes_);
 }
 void players::Amcts2::roll(float dirichlet_epsilon, float dirichlet_alpha)
 {
     rollouts_.push_back(std::make_pair<rl::common::IState*, std::vector<Amcts2Info>>(nullptr, {}));
     auto& rollout_info = rollouts_.back();
-    root_node_->simulate_once(rollout_info, dirichlet_epsilon,dirichlet_alpha, default_n_, default_w_, root_node_.get());
+    tree_->simulate_once(rollout_info, dirichlet_epsilon,dirichlet_alpha, default_n_, default_w_);
     if (rollout_info.first == nullptr)
     {
         rollouts_.pop_back();
@@ -148,14 +293,14 @@ void players::Amcts2::evaluate_collected_states(std::tuple<std::vector<float>, s
 
 std::vector<float> players::Amcts2::get_probs()
 {
-    assert(root_node_ != nullptr);
-    return root_node_->get_probs(temperature_);
+    assert(tree_ != nullptr);
+    return tree_->get_probs(temperature_);
 }
 
 float players::Amcts2::get_evaluation()
 {
-    assert(root_node_ != nullptr);
-    return root_node_->get_evaluation();
+    assert(tree_ != nullptr);
+    return tree_->get_evaluation();
 }
 
 void players::Amcts2::clear_rollout()
@@ -165,7 +310,7 @@ void players::Amcts2::clear_rollout()
 
 void players::Amcts2::backpropogate(std::vector<Amcts2Info>& visited_path, float final_result, int final_player, std::vector<float>& probs)
 {
-    root_node_->backpropogate(visited_path, 0, final_result, final_player, probs, default_n_, default_w_);
+    tree_->backpropogate(visited_path, final_result, final_player, probs, default_n_, default_w_);
 }
 } // namespace rl::players
 
@@ -1,5 +1,7 @@
 #include <players/bandits/amcts2/amcts2_node.hpp>
 #include <stdexcept>
+#include <algorithm>
+#include <cmath>
 #include <common/utils.hpp>
 #include <common/random.hpp>
 #include <iostream>
@@ -7,135 +9,166 @@ namespace rl::players
 {
 
 constexpr float EPS = 1e-8f;
-Amcts2Node::Amcts2Node(std::unique_ptr<rl::common::IState> state_ptr, int n_game_actions, float cpuct)
-    :state_ptr_{ std::move(state_ptr) }, n_game_actions_{ n_game_actions }, cpuct_{ cpuct }, children_{}
-{
-}
-
-
 
-Amcts2Node::~Amcts2Node() = default;
-void Amcts2Node::simulate_once(std::pair<rl::common::IState*, std::vector<Amcts2Info>>& rollout_info_ref, float dirichlet_epsilon,float dirichlet_alpha, float default_n, float default_w, Amcts2Node* const root_node_ptr)
+// std::atomic<float> has no fetch_add before C++20.
+static void atomic_add(std::atomic<float>& target, float delta)
 {
-    if (state_ptr_->is_terminal())
+    float current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + delta, std::memory_order_relaxed))
     {
-        // state is terminal then get result
-        float result = state_ptr_->get_reward();
-        int player = state_ptr_->player_turn();
-        std::vector<float> emtpy_probs{};
-        root_node_ptr->backpropogate(std::get<1>(rollout_info_ref), 0, result, player, emtpy_probs, default_n, default_w);
-        return;
     }
+}
 
-    if (children_.size() == 0) // first visit , then expand node
-    {
-        expand_node();
-
-        rollout_info_ref.first = state_ptr_.get();
-        return;
-    }
+Amcts2Tree::Amcts2Tree(int n_game_actions, float cpuct, size_t memory_budget_bytes)
+    : n_game_actions_{ n_game_actions }, cpuct_{ cpuct }, memory_budget_bytes_{ memory_budget_bytes }, arenas_{ memory_budget_bytes }
+{
+}
 
-    // continue down the tree
+Amcts2Tree::Amcts2Tree(std::unique_ptr<rl::common::IState> root_state_ptr, int n_game_actions, float cpuct, size_t memory_budget_bytes)
+    : Amcts2Tree(n_game_actions, cpuct, memory_budget_bytes)
+{
+    add_node(std::move(root_state_ptr));
+}
 
-    int best_action = find_best_action(dirichlet_epsilon,dirichlet_alpha);
+Amcts2Tree::~Amcts2Tree() = default;
 
-    if (children_.at(best_action) == nullptr)
+int32_t Amcts2Tree::add_node(std::unique_ptr<rl::common::IState> state_ptr)
+{
+    // legal actions go into a thread's own buffer, only the edges are shared
+    thread_local std::vector<int> legal_actions{};
+    int32_t node_idx = arenas_.nodes.allocate(1);
+    if (node_idx < 0)
     {
-        children_.at(best_action) = std::make_unique<Amcts2Node>(state_ptr_->step(best_action), n_game_actions_, cpuct_);
+        throw std::runtime_error("Amcts2 tree is over its memory budget");
     }
-
-    auto& next_node_ptr = children_.at(best_action);
-
-    if (next_node_ptr == nullptr)
+    Amcts2Node& node = arenas_.nodes[node_idx];
+    node.is_terminal = state_ptr->is_terminal();
+    node.player_turn = state_ptr->player_turn();
+    if (node.is_terminal)
     {
-        throw std::runtime_error("new node was found to be null");
+        node.terminal_reward = state_ptr->get_reward();
     }
-
-    rollout_info_ref.second.push_back({ best_action,next_node_ptr->state_ptr_->player_turn() });
-
-
-    n_visits_ += default_n;
-    delta_wins += default_w;
-    actions_visits_.at(best_action) += default_n;
-    delta_actions_wins.at(best_action) += default_w;
-
-    next_node_ptr->simulate_once(rollout_info_ref, 0.0f, dirichlet_alpha,default_n, default_w, root_node_ptr);
+    else
+    {
+        state_ptr->legal_actions(legal_actions);
+        const int32_t n_legal_actions = static_cast<int32_t>(legal_actions.size());
+        const int32_t first_edge = arenas_.edges.allocate(n_legal_actions);
+        if (first_edge < 0)
+        {
+            throw std::runtime_error("Amcts2 tree is over its memory budget");
+        }
+        for (int32_t i = 0; i < n_legal_actions; i++)
+        {
+            Amcts2Edge& edge = arenas_.edges[first_edge + i];
+            edge.action = legal_actions[i];
+            edge.prob.store(1.0f / static_cast<float>(n_legal_actions), std::memory_order_relaxed);
+        }
+        node.first_edge = first_edge;
+        node.n_edges = n_legal_actions;
+    }
+    state_bytes_.fetch_add(state_ptr->memory_bytes(), std::memory_order_relaxed);
+    node.state_ptr = std::move(state_ptr);
+    return node_idx;
 }
 
-void players::Amcts2Node::backpropogate(std::vector<Amcts2Info>& visited_path, int depth, float final_result, int final_player, std::vector<float>& probs, float default_n, float default_w)
+void Amcts2Tree::simulate_once(std::pair<rl::common::IState*, std::vector<Amcts2Info>>& rollout_info_ref, float dirichlet_epsilon, float dirichlet_alpha, float default_n, float default_w)
 {
-    if (visited_path.size() == depth)
+    auto& visited_path = rollout_info_ref.second;
+    int32_t node_idx = 0;
+    while (true)
     {
-        if (probs.size() == 0)
+        Amcts2Node& node = arenas_.nodes[node_idx];
+        if (node.is_terminal)
+        {
+            // state is terminal then get result
+            visited_path.push_back({ node_idx, -1 });
+            std::vector<float> emtpy_probs{};
+            backpropogate(visited_path, node.terminal_reward, node.player_turn, emtpy_probs, default_n, default_w);
             return;
+        }
 
-        // probs_.clear();
-        probs_ = {};
-        probs_.reserve(n_game_actions_);
-        float probs_sum{ 0 };
-        for (int i = 0;i < n_game_actions_;i++)
+        // first visit, the node goes to the evaluator. Another thread may have got
+        // there first, in which case its evaluation is already on the way and we
+        // carry on down instead
+        if (!node.is_expanded.exchange(true, std::memory_order_acq_rel))
         {
-            float p = probs.at(i) * static_cast<float>(actions_mask_.at(i));
-            probs_.emplace_back(p);
-            probs_sum += p;
+            visited_path.push_back({ node_idx, -1 });
+            rollout_info_ref.first = node.state_ptr.get();
+            return;
         }
 
-        // normalize probs
-        rl::common::utils::normalize_vector(probs_);
-        return;
-    }
+        // continue down the tree
+        int32_t edge_idx = find_best_action(node, dirichlet_epsilon, dirichlet_alpha);
+        Amcts2Edge& edge = arenas_.edges[edge_idx];
+        int32_t next_node_idx = edge.child.load(std::memory_order_acquire);
+        if (next_node_idx < 0)
+        {
+            std::lock_guard<std::mutex> lock(node.mutex);
+            next_node_idx = edge.child.load(std::memory_order_relaxed);
+            if (next_node_idx < 0)
+            {
+                next_node_idx = add_node(node.state_ptr->step(edge.action));
+                edge.child.store(next_node_idx, std::memory_order_release);
+            }
+        }
 
-    int current_player = state_ptr_->player_turn();
-    int visited_action = visited_path.at(depth).action;
+        visited_path.push_back({ node_idx, edge_idx });
 
-    float score = current_player == final_player ? final_result : -final_result;
-    n_visits_ += 1 - default_n;
-    actions_visits_.at(visited_action) += 1 - default_n;
-    delta_wins += score - default_w;
-    delta_actions_wins.at(visited_action) += score - default_w;
-    auto& child = children_.at(visited_action);
-    child->backpropogate(visited_path, depth + 1, final_result, final_player, probs, default_n, default_w);
+        atomic_add(node.n_visits, default_n);
+        atomic_add(node.delta_wins, default_w);
+        atomic_add(edge.visits, default_n);
+        atomic_add(edge.wins, default_w);
+
+        node_idx = next_node_idx;
+        // noise is for the root only
+        dirichlet_epsilon = 0.0f;
+    }
 }
 
-void players::Amcts2Node::expand_node()
+void Amcts2Tree::backpropogate(const std::vector<Amcts2Info>& visited_path, float final_result, int final_player, const std::vector<float>& probs, float default_n, float default_w)
 {
-    if (state_ptr_->is_terminal())
+    for (const Amcts2Info& info : visited_path)
     {
-        throw std::runtime_error("Expanding a terminal state");
-    }
+        Amcts2Node& node = arenas_.nodes[info.node];
+        if (info.edge < 0)
+        {
+            if (probs.size() == 0)
+                return;
 
-    actions_mask_ = state_ptr_->actions_mask();
-    n_visits_ = 0;
-    actions_visits_.resize(n_game_actions_, 0.0f);
-    delta_actions_wins.resize(n_game_actions_, 0.0f);
-    probs_.clear();
-    probs_.reserve(n_game_actions_);
-    float n_legal_actions{ 0.0f };
-    for (bool m : actions_mask_)
-    {
-        n_legal_actions += m;
-    }
+            std::vector<float> normalized_probs{};
+            normalized_probs.reserve(node.n_edges);
+            for (int32_t idx = node.first_edge; idx < node.first_edge + node.n_edges; idx++)
+            {
+                normalized_probs.emplace_back(probs.at(arenas_.edges[idx].action));
+            }
 
-    for (bool m : actions_mask_)
-    {
-        probs_.emplace_back(static_cast<float>(m) / n_legal_actions);
-    }
+            // normalize probs
+            rl::common::utils::normalize_vector(normalized_probs);
+            for (int32_t i = 0; i < node.n_edges; i++)
+            {
+                arenas_.edges[node.first_edge + i].prob.store(normalized_probs[i], std::memory_order_relaxed);
+            }
+            return;
+        }
 
-    children_.clear();
-    for (int i = 0;i < n_game_actions_;i++)
-    {
-        children_.push_back(nullptr);
+        Amcts2Edge& edge = arenas_.edges[info.edge];
+        float score = node.player_turn == final_player ? final_result : -final_result;
+        atomic_add(node.n_visits, 1 - default_n);
+        atomic_add(edge.visits, 1 - default_n);
+        atomic_add(node.delta_wins, score - default_w);
+        atomic_add(edge.wins, score - default_w);
     }
 }
 
-std::vector<float> players::Amcts2Node::get_probs(float temperature)
+std::vector<float> Amcts2Tree::get_probs(float temperature)
 {
-    if (!state_ptr_)
+    std::vector<float> actions_visits(n_game_actions_, 0.0f);
+    const Amcts2Node& root = arenas_.nodes[0];
+    for (int32_t idx = root.first_edge; idx < root.first_edge + root.n_edges; idx++)
     {
-        std::runtime_error("Trying to get probabilities with nullptr state");
+        const Amcts2Edge& edge = arenas_.edges[idx];
+        actions_visits.at(edge.action) = edge.visits.load(std::memory_order_relaxed);
     }
-
-    const auto& actions_visits = actions_visits_;
     if (temperature == 0.0f)
     {
         // find max action visits
@@ -225,82 +258,179 @@ std::vector<float> players::Amcts2Node::get_probs(float temperature)
     }
 }
 
-float players::Amcts2Node::get_evaluation()
+float Amcts2Tree::get_evaluation()
 {
-    if (!state_ptr_)
+    const Amcts2Node& root = arenas_.nodes[0];
+    return root.delta_wins.load(std::memory_order_relaxed) / root.n_visits.load(std::memory_order_relaxed);
+}
+
+bool Amcts2Tree::is_full(int in_flight) const
+{
+    // a simulation adds at most one node, with a state of about the average size, and its edges
+    const size_t n_nodes = static_cast<size_t>(std::max(1, arenas_.nodes.size()));
+    const size_t per_simulation = sizeof(Amcts2Node) + state_bytes_.load(std::memory_order_relaxed) / n_nodes + n_game_actions_ * sizeof(Amcts2Edge);
+    return bytes_used() + in_flight * per_simulation > memory_budget_bytes_;
+}
+
+size_t Amcts2Tree::bytes_used() const
+{
+    return arenas_.bytes_used() + state_bytes_.load(std::memory_order_relaxed);
+}
+
+const rl::common::IState* Amcts2Tree::state(int32_t node) const
+{
+    return arenas_.nodes[node].state_ptr.get();
+}
+
+int32_t Amcts2Tree::find_descendant(const rl::common::IState& state, int max_depth) const
+{
+    return find_descendant(0, state, state.hash(), max_depth);
+}
+
+int32_t Amcts2Tree::find_descendant(int32_t node_idx, const rl::common::IState& state, uint64_t key, int max_depth) const
+{
+    if (max_depth <= 0)
     {
-        std::runtime_error("Trying to get evaluation of nullptr state");
+        return -1;
     }
+    const Amcts2Node& node = arenas_.nodes[node_idx];
+    // shallowest match first
+    for (int32_t idx = node.first_edge; idx < node.first_edge + node.n_edges; idx++)
+    {
+        int32_t child = arenas_.edges[idx].child.load(std::memory_order_relaxed);
+        if (child >= 0 && arenas_.nodes[child].state_ptr->hash() == key && arenas_.nodes[child].state_ptr->equals(state))
+        {
+            return child;
+        }
+    }
+    for (int32_t idx = node.first_edge; idx < node.first_edge + node.n_edges; idx++)
+    {
+        int32_t child = arenas_.edges[idx].child.load(std::memory_order_relaxed);
+        if (child >= 0)
+        {
+            int32_t found = find_descendant(child, state, key, max_depth - 1);
+            if (found >= 0)
+            {
+                return found;
+            }
+        }
+    }
+    return -1;
+}
 
-    return delta_wins / n_visits_;
+void Amcts2Tree::nodes_within(int max_depth, std::vector<int32_t>& out_nodes) const
+{
+    nodes_within(0, max_depth, out_nodes);
 }
 
-int players::Amcts2Node::find_best_action(float dirichlet_epsilon,float dirichlet_alpha)
+void Amcts2Tree::nodes_within(int32_t node_idx, int max_depth, std::vector<int32_t>& out_nodes) const
 {
-    float max_u = -INFINITY;
-    int best_action = -1;
-    const auto& wsa_vec = delta_actions_wins;
-    const auto& nsa_vec = actions_visits_;
-    const auto& psa_vec = probs_;
-    auto& dirichlet_noise = dirichlet_noise_;
-    const auto& masks = actions_mask_;
-    float current_state_visis = n_visits_;
-    const bool use_dirichlet_noise = dirichlet_epsilon > 0.0f;
-    if (use_dirichlet_noise && dirichlet_noise.size() != psa_vec.size())
+    out_nodes.push_back(node_idx);
+    if (max_depth <= 0)
+    {
+        return;
+    }
+    const Amcts2Node& node = arenas_.nodes[node_idx];
+    for (int32_t idx = node.first_edge; idx < node.first_edge + node.n_edges; idx++)
+    {
+        int32_t child = arenas_.edges[idx].child.load(std::memory_order_relaxed);
+        if (child >= 0)
+        {
+            nodes_within(child, max_depth - 1, out_nodes);
+        }
+    }
+}
+
+std::unique_ptr<Amcts2Tree> Amcts2Tree::extract(int32_t node_idx, size_t memory_budget_bytes)
+{
+    std::unique_ptr<Amcts2Tree> tree{ new Amcts2Tree(n_game_actions_, cpuct_, memory_budget_bytes) };
+    auto move_node = [&tree](Amcts2Node& from, Amcts2Node& to)
+    {
+        tree->state_bytes_.fetch_add(from.state_ptr->memory_bytes(), std::memory_order_relaxed);
+        to.state_ptr = std::move(from.state_ptr);
+        to.first_edge = from.first_edge;
+        to.n_edges = from.n_edges;
+        to.player_turn = from.player_turn;
+        to.terminal_reward = from.terminal_reward;
+        to.is_terminal = from.is_terminal;
+        to.is_expanded.store(from.is_expanded.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.n_visits.store(from.n_visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.delta_wins.store(from.delta_wins.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    };
+    auto move_edge = [](Amcts2Edge& from, Amcts2Edge& to)
     {
-        dirichlet_noise = rl::common::utils::get_dirichlet_noise(masks, dirichlet_alpha, rl::common::mt);
+        to.action = from.action;
+        to.prob.store(from.prob.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.visits.store(from.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.wins.store(from.wins.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    };
+    if (move_subtree(arenas_, node_idx, tree->arenas_, move_node, move_edge) < 0)
+    {
+        // the subtree is bigger than the new budget
+        return nullptr;
     }
+    return tree;
+}
 
-    for (int action{ 0 }; action < masks.size(); action++)
+bool Amcts2Tree::release(int32_t max_nodes)
+{
+    const bool is_empty = arenas_.clear_back(max_nodes, max_nodes * n_game_actions_);
+    if (is_empty)
     {
-        bool is_legal = masks.at(action);
-        if (!is_legal)
+        state_bytes_.store(0, std::memory_order_relaxed);
+    }
+    return is_empty;
+}
+
+int32_t Amcts2Tree::find_best_action(Amcts2Node& node, float dirichlet_epsilon, float dirichlet_alpha)
+{
+    float max_u = -INFINITY;
+    int32_t best_idx = -1;
+    const int32_t n_legal_actions = node.n_edges;
+    float current_state_visis = node.n_visits.load(std::memory_order_relaxed);
+    const bool use_dirichlet_noise = dirichlet_epsilon > 0.0f;
+    if (use_dirichlet_noise && !has_dirichlet_noise_.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(dirichlet_mutex_);
+        if (!has_dirichlet_noise_.load(std::memory_order_relaxed))
         {
-            continue;
+            // a negative alpha scales with the branching factor, as in the mask overload
+            float alpha = dirichlet_alpha < 0 ? 10.0f / n_legal_actions : dirichlet_alpha;
+            dirichlet_noise_ = rl::common::utils::get_dirichlet_noise(n_legal_actions, alpha, rl::common::mt);
+            has_dirichlet_noise_.store(true, std::memory_order_release);
         }
-        float action_prob = psa_vec.at(action);
+    }
+
+    for (int32_t i{ 0 }; i < n_legal_actions; i++)
+    {
+        const Amcts2Edge& edge = arenas_.edges[node.first_edge + i];
+        float action_prob = edge.prob.load(std::memory_order_relaxed);
         if (use_dirichlet_noise)
         {
             // constexpr float dirichlet_epsilon = 0.25f;
-            action_prob = (1 - dirichlet_epsilon) * action_prob + dirichlet_noise.at(action) * dirichlet_epsilon;
+            action_prob = (1 - dirichlet_epsilon) * action_prob + dirichlet_noise_.at(i) * dirichlet_epsilon;
         }
-        float action_visits = nsa_vec.at(action);
+        float action_visits = edge.visits.load(std::memory_order_relaxed);
         float qsa = 0.0f;
 
         if (action_visits > 0)
         {
-            qsa = wsa_vec.at(action) / (action_visits + EPS);
+            qsa = edge.wins.load(std::memory_order_relaxed) / (action_visits + EPS);
         }
         float u = qsa + cpuct_ * action_prob * sqrtf(current_state_visis + EPS) / (1.0f + action_visits);
 
         if (u > max_u)
         {
             max_u = u;
-            best_action = action;
+            best_idx = i;
         }
     }
-    if (best_action == -1)
+    if (best_idx == -1)
     {
-        std::vector<int> legal_actions;
-        for (int i = 0; i < this->n_game_actions_; i++)
-        {
-            if (masks.at(i))
-            {
-                legal_actions.push_back(i);
-            }
-        }
-        // int action_index = rand() % legal_actions.size();
-        int action_index = rl::common::get(static_cast<int>(legal_actions.size()));
-        best_action = legal_actions[action_index];
         // should not happen but somehow it did;
+        best_idx = rl::common::get(n_legal_actions);
     }
-    return best_action;
+    return node.first_edge + best_idx;
 }
 
-
-
 } // namespace rl::players
-
-
-
-
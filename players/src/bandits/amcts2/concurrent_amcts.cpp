@@ -1,10 +1,15 @@
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <future>
 #include <stdexcept>
 #include <players/bandits/amcts2/concurrent_amcts.hpp>
 
 namespace rl::players
 {
-ConcurrentAmcts::ConcurrentAmcts(int n_game_actions, std::unique_ptr<IEvaluator> evaluator_ptr, float cpuct, float temperature, int max_async_simulations_per_tree,float dirichlet_epsilon,float dirichlet_alpha,float default_visits, float default_wins)
+constexpr int MAX_REUSE_DEPTH = 2;
+
+ConcurrentAmcts::ConcurrentAmcts(int n_game_actions, std::unique_ptr<IEvaluator> evaluator_ptr, float cpuct, float temperature, int max_async_simulations_per_tree,float dirichlet_epsilon,float dirichlet_alpha,float default_visits, float default_wins, bool pipelined)
     :n_game_actions_{ n_game_actions },
     evaluator_ptr_{ std::move(evaluator_ptr) },
     cpuct_{ cpuct },
@@ -13,7 +18,9 @@ ConcurrentAmcts::ConcurrentAmcts(int n_game_actions, std::unique_ptr<IEvaluator>
     dirichlet_epsilon_{dirichlet_epsilon},
     dirichlet_alpha_{dirichlet_alpha},
     default_n_{ default_visits },
-    default_w_{ default_wins }
+    default_w_{ default_wins },
+    pipelined_{ pipelined },
+    memory_budget_bytes_{ memory_budget_bytes(DEFAULT_MEMORY_BUDGET_MB) }
 {
 }
 
@@ -75,87 +82,122 @@ std::pair<std::vector<std::vector<float>>, std::vector<float>> ConcurrentAmcts::
         //     }
         // }
     }
+    // every node up to MAX_REUSE_DEPTH plies below the kept roots, by state hash,
+    // as { tree, node }; the first node seen for a hash wins
+    std::unordered_map<uint64_t, std::pair<int, int32_t>> reusable{};
+    if (reuse_trees_)
+    {
+        std::vector<int32_t> nodes{};
+        for (int tree_id = 0; tree_id < static_cast<int>(trees_.size()); tree_id++)
+        {
+            nodes.clear();
+            trees_.at(tree_id)->nodes_within(MAX_REUSE_DEPTH, nodes);
+            for (int32_t node : nodes)
+            {
+                reusable.emplace(trees_.at(tree_id)->state(node)->hash(), std::make_pair(tree_id, node));
+            }
+        }
+    }
+
+    const size_t tree_budget_bytes = memory_budget_bytes_ / std::max(1, states_size);
     std::vector<std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>>> all_rollouts{};
-    std::vector<std::unique_ptr<Amcts2Node>> root_nodes{};
+    std::vector<std::unique_ptr<Amcts2Tree>> trees{};
     for (int i = 0;i < states_size;i++)
     {
-        root_nodes.push_back(std::make_unique<Amcts2Node>(state_ptrs.at(i)->clone(), n_game_actions_, cpuct_));
+        auto tree = reusable.empty() ? nullptr : take_reusable_tree(state_ptrs.at(i), reusable, tree_budget_bytes);
+        if (!tree)
+        {
+            tree = std::make_unique<Amcts2Tree>(state_ptrs.at(i)->clone(), n_game_actions_, cpuct_, tree_budget_bytes);
+        }
+        trees.push_back(std::move(tree));
         all_rollouts.push_back({});
     }
 
     auto t_start = std::chrono::high_resolution_clock::now();
     auto t_end = t_start + minimum_duration;
 
-    int iteration{ 0 };
-
+    std::vector<int> all_trees{};
+    for (int tree_id = 0; tree_id < current_n_trees; tree_id++)
+    {
+        if (!vec_is_state_forced.at(tree_id))
+        {
+            all_trees.push_back(tree_id);
+        }
+    }
 
-    while ((iteration * max_async_simulations_ <= minimum_sims) || (t_end > std::chrono::high_resolution_clock::now()))
+    if (!pipelined_ || all_trees.size() < 2)
     {
-        std::vector<const rl::common::IState*> rollout_states{};
-        std::vector<int> trees_idx{};
-        for (int tree_id = 0;tree_id < current_n_trees;tree_id++)
+        int iteration{ 0 };
+        while (((iteration * max_async_simulations_ <= minimum_sims) || (t_end > std::chrono::high_resolution_clock::now())) && !are_full(trees, all_trees))
         {
-            if (vec_is_state_forced.at(tree_id))continue;
-            auto& current_root_node = root_nodes.at(tree_id);
-            auto& current_tree_rollouts = all_rollouts.at(tree_id);
-            current_tree_rollouts.clear();
-            for (int async_roll = 0; async_roll < max_async_simulations_;async_roll++)
-            {
-                // roll root node using dirichlet noise
-                current_tree_rollouts.push_back(std::make_pair<rl::common::IState*, std::vector<Amcts2Info>>(nullptr, {}));
-                auto& rollout_info = current_tree_rollouts.back();
-                current_root_node->simulate_once(rollout_info, dirichlet_epsilon_, dirichlet_alpha_,default_n_, default_w_, current_root_node.get());
+            std::vector<const rl::common::IState*> rollout_states{};
+            std::vector<int> trees_idx{};
+            collect_rollouts(trees, all_rollouts, all_trees, rollout_states, trees_idx);
+            auto evaluations = evaluator_ptr_->evaluate(rollout_states);
+            backpropogate_evaluations(trees, all_rollouts, all_trees, trees_idx, evaluations);
+            iteration++;
+        } // end of simulations
+    }
+    else
+    {
+        // Double buffered: the trees are split in two halves, and while one
+        // half's leaves are being evaluated on a helper thread the other half
+        // is selecting its next batch. The halves never share a node, and only
+        // one evaluation is in flight at a time, so neither the trees nor the
+        // evaluator need locking. Each half runs the same number of batches
+        // the sequential loop would.
+        std::array<std::vector<int>, 2> halves{};
+        for (int i = 0; i < static_cast<int>(all_trees.size()); i++)
+        {
+            halves[i % 2].push_back(all_trees[i]);
+        }
+        std::array<std::vector<const rl::common::IState*>, 2> rollout_states{};
+        std::array<std::vector<int>, 2> trees_idx{};
+        std::array<int, 2> iterations{ 0, 0 };
 
-                // remove this rollout if no state is to be evaluated , Happens when the edge state is terminal 
-                if (rollout_info.first == nullptr)
+        auto select = [&](int half)
+        {
+            rollout_states[half].clear();
+            trees_idx[half].clear();
+            collect_rollouts(trees, all_rollouts, halves[half], rollout_states[half], trees_idx[half]);
+            iterations[half]++;
+        };
+        auto launch = [&](int half)
+        {
+            return std::async(std::launch::async, [this, &rollout_states, half]()
                 {
-                    current_tree_rollouts.pop_back();
-                }
-            }
+                    return evaluator_ptr_->evaluate(rollout_states[half]);
+                });
+        };
+        auto should_continue = [&](int half)
+        {
+            return ((iterations[half] * max_async_simulations_ <= minimum_sims) || (t_end > std::chrono::high_resolution_clock::now())) && !are_full(trees, halves[half]);
+        };
 
-            for (auto& a : current_tree_rollouts)
+        select(0);
+        auto pending = launch(0);
+        int half = 0;
+        while (true)
+        {
+            int other = 1 - half;
+            bool more = should_continue(other);
+            if (more)
             {
-                rollout_states.push_back(a.first);
-                trees_idx.push_back(tree_id);
+                select(other);
             }
-        }
-
-
-        std::vector<std::tuple<std::vector<float>, std::vector<float>>> trees_evaluations{};
-        for (int tree_idx = 0;tree_idx < current_n_trees;tree_idx++)
-        {
-            trees_evaluations.push_back(std::make_tuple<std::vector<float>, std::vector<float>>(
-                std::vector<float>(), std::vector<float>()));
-        }
-        auto [probs, vs] = evaluator_ptr_->evaluate(rollout_states);
-        int n_rollouts = rollout_states.size();
-        for (int rollout_id = 0; rollout_id < n_rollouts; rollout_id++)
-        {
-            int probs_start = rollout_id * n_game_actions_;
-            int probs_end = probs_start + n_game_actions_;
-            int current_tree_id = trees_idx.at(rollout_id);
-            std::vector<float>& current_probs_ref = std::get<0>(trees_evaluations.at(current_tree_id));
-            std::vector<float>& current_vs_ref = std::get<1>(trees_evaluations.at(current_tree_id));
-            for (int cell = probs_start; cell < probs_end; cell++)
+            auto evaluations = pending.get();
+            if (more)
             {
-                current_probs_ref.push_back(probs.at(cell));
+                pending = launch(other);
             }
-            current_vs_ref.push_back(vs.at(rollout_id));
-        }
-
-        for (int tree_id = 0; tree_id < current_n_trees; tree_id++)
-        {
-            auto& current_root_node = root_nodes.at(tree_id);
-            auto& current_evaluation_tuple = trees_evaluations.at(tree_id);
-            // evaluate collected states
-            auto& current_tree_rollout = all_rollouts.at(tree_id);
-            int n_states = current_tree_rollout.size();
-            evaluate_collected_states(current_root_node, current_evaluation_tuple, current_tree_rollout);
+            backpropogate_evaluations(trees, all_rollouts, halves[half], trees_idx[half], evaluations);
+            if (!more)
+            {
+                break;
+            }
+            half = other;
         }
-
-        iteration++;
-
-    } // end of simulations
+    }
 
 
     for (int tree_id = 0; tree_id < current_n_trees; tree_id++)
@@ -167,17 +209,136 @@ std::pair<std::vector<std::vector<float>>, std::vector<float>> ConcurrentAmcts::
         }
         else
         {
-            auto& root_node = root_nodes.at(tree_id);
-            probs_result.at(tree_id) = root_node->get_probs(temperature_);
-            values_result.at(tree_id) = root_node->get_evaluation();
+            auto& tree = trees.at(tree_id);
+            probs_result.at(tree_id) = tree->get_probs(temperature_);
+            values_result.at(tree_id) = tree->get_evaluation();
         }
 
     }
 
+    // the old trees that were not carried over go here
+    trees_.clear();
+    if (reuse_trees_)
+    {
+        trees_ = std::move(trees);
+    }
+
     return std::make_pair(std::move(probs_result), std::move(values_result));
 }
 
-void ConcurrentAmcts::evaluate_collected_states(std::unique_ptr<Amcts2Node>& root_node_ptr, std::tuple<std::vector<float>, std::vector<float>>& evaluations_tuple, std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>>& tree_rollouts)
+void ConcurrentAmcts::set_tree_reuse(bool reuse_trees)
+{
+    reuse_trees_ = reuse_trees;
+    if (!reuse_trees_)
+    {
+        trees_.clear();
+    }
+}
+
+void ConcurrentAmcts::set_memory_budget_mb(int megabytes)
+{
+    memory_budget_bytes_ = memory_budget_bytes(megabytes);
+    trees_.clear();
+}
+
+std::unique_ptr<Amcts2Tree> ConcurrentAmcts::take_reusable_tree(const rl::common::IState* state_ptr, const std::unordered_map<uint64_t, std::pair<int, int32_t>>& reusable, size_t tree_budget_bytes)
+{
+    auto it = reusable.find(state_ptr->hash());
+    if (it == reusable.end())
+    {
+        return nullptr;
+    }
+    auto [tree_id, node] = it->second;
+    auto& old_tree = trees_.at(tree_id);
+    // an old tree hands out one subtree at most, an earlier state may have taken it,
+    // and equal hashes may still be different positions
+    if (!old_tree || !old_tree->state(node)->equals(*state_ptr))
+    {
+        return nullptr;
+    }
+    if (node == 0)
+    {
+        return std::move(old_tree);
+    }
+    auto tree = old_tree->extract(node, tree_budget_bytes);
+    old_tree.reset();
+    return tree;
+}
+
+bool ConcurrentAmcts::are_full(std::vector<std::unique_ptr<Amcts2Tree>>& trees, const std::vector<int>& tree_ids)
+{
+    for (int tree_id : tree_ids)
+    {
+        if (!trees.at(tree_id)->is_full(max_async_simulations_))
+        {
+            return false;
+        }
+    }
+    return !tree_ids.empty();
+}
+
+void ConcurrentAmcts::collect_rollouts(std::vector<std::unique_ptr<Amcts2Tree>>& trees, std::vector<std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>>>& all_rollouts, const std::vector<int>& tree_ids, std::vector<const rl::common::IState*>& rollout_states, std::vector<int>& trees_idx)
+{
+    for (int tree_id : tree_ids)
+    {
+        auto& current_tree = trees.at(tree_id);
+        auto& current_tree_rollouts = all_rollouts.at(tree_id);
+        current_tree_rollouts.clear();
+        // a full tree sits the batch out, the others carry on
+        if (current_tree->is_full(max_async_simulations_))
+        {
+            continue;
+        }
+        for (int async_roll = 0; async_roll < max_async_simulations_;async_roll++)
+        {
+            // roll root node using dirichlet noise
+            current_tree_rollouts.push_back(std::make_pair<rl::common::IState*, std::vector<Amcts2Info>>(nullptr, {}));
+            auto& rollout_info = current_tree_rollouts.back();
+            current_tree->simulate_once(rollout_info, dirichlet_epsilon_, dirichlet_alpha_,default_n_, default_w_);
+
+            // remove this rollout if no state is to be evaluated , Happens when the edge state is terminal 
+            if (rollout_info.first == nullptr)
+            {
+                current_tree_rollouts.pop_back();
+            }
+        }
+
+        for (auto& a : current_tree_rollouts)
+        {
+            rollout_states.push_back(a.first);
+            trees_idx.push_back(tree_id);
+        }
+    }
+}
+
+void ConcurrentAmcts::backpropogate_evaluations(std::vector<std::unique_ptr<Amcts2Tree>>& trees, std::vector<std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>>>& all_rollouts, const std::vector<int>& tree_ids, const std::vector<int>& trees_idx, std::tuple<std::vector<float>, std::vector<float>>& evaluations)
+{
+    auto& [probs, vs] = evaluations;
+    int n_trees = static_cast<int>(trees.size());
+    std::vector<std::tuple<std::vector<float>, std::vector<float>>> trees_evaluations(n_trees);
+    int n_rollouts = static_cast<int>(trees_idx.size());
+    for (int rollout_id = 0; rollout_id < n_rollouts; rollout_id++)
+    {
+        int probs_start = rollout_id * n_game_actions_;
+        int probs_end = probs_start + n_game_actions_;
+        int current_tree_id = trees_idx.at(rollout_id);
+        std::vector<float>& current_probs_ref = std::get<0>(trees_evaluations.at(current_tree_id));
+        std::vector<float>& current_vs_ref = std::get<1>(trees_evaluations.at(current_tree_id));
+        for (int cell = probs_start; cell < probs_end; cell++)
+        {
+            current_probs_ref.push_back(probs.at(cell));
+        }
+        current_vs_ref.push_back(vs.at(rollout_id));
+    }
+
+    for (int tree_id : tree_ids)
+    {
+        // evaluate collected states
+        evaluate_collected_states(trees.at(tree_id), trees_evaluations.at(tree_id), all_rollouts.at(tree_id));
+    }
+}
+
+void ConcurrentAmcts::evaluate_collected_states(std::unique_ptr<Amcts2Tree>& tree_ptr, std::tuple<std::vector<float>, std::vector<float>>& evaluations_tuple, std::vector<std::pair<rl::common::IState*, std::vector<Amcts2Info>>>& tree_rollouts)
 {
     int n_states = static_cast<int>(tree_rollouts.size());
     std::vector<const rl::common::IState*> states_ptrs(n_states, nullptr);
@@ -201,14 +362,14 @@ void ConcurrentAmcts::evaluate_collected_states(std::unique_ptr<Amcts2Node>& roo
             state_probs.at(j) = probs.at(probs_start + j);
         }
 
-        backpropogate(root_node_ptr, visited_path, value, states_ptrs.at(i)->player_turn(), state_probs);
+        backpropogate(tree_ptr, visited_path, value, states_ptrs.at(i)->player_turn(), state_probs);
     }
 
 }
 
-void ConcurrentAmcts::backpropogate(std::unique_ptr<Amcts2Node>& root_node_ptr, std::vector<Amcts2Info>& visited_path, float final_result, int final_player, std::vector<float>& probs)
+void ConcurrentAmcts::backpropogate(std::unique_ptr<Amcts2Tree>& tree_ptr, std::vector<Amcts2Info>& visited_path, float final_result, int final_player, std::vector<float>& probs)
 {
-    root_node_ptr->backpropogate(visited_path, 0, final_result, final_player, probs, default_n_, default_w_);
+    tree_ptr->backpropogate(visited_path, final_result, final_player, probs, default_n_, default_w_);
 }
 } // namespace rl::players
 
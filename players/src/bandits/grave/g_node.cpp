@@ -1,6 +1,7 @@
 #include <players/bandits/grave/g_node.hpp>
 #include <common/exceptions.hpp>
 #include <common/random.hpp>
+#include <common/bits.hpp>
 namespace rl::players
 {
 GNode::GNode(std::unique_ptr<IState> state_ptr, int amaf_min_ref_count, float bias, bool save_illegal_actions_amaf)
@@ -12,12 +13,13 @@ GNode::GNode(std::unique_ptr<IState> state_ptr, int amaf_min_ref_count, float bi
     n_game_actions_{ state_ptr_->get_n_actions() },
     is_terminal_{},
     result_{},
-    actions_mask_{},
+    legal_actions_bits_{},
+    legal_actions_{},
     is_leaf_node_{ true },
     children_(),
     n_{ 0 },
-    wsa_(std::vector<float>(n_game_actions_)),
-    nsa_(std::vector<int>(n_game_actions_)),
+    wsa_(),
+    nsa_(),
     amaf_wsa_player_0_(std::vector<float>(n_game_actions_)),
     amaf_nsa_player_0_(std::vector<int>(n_game_actions_)),
     amaf_wsa_player_1_(std::vector<float>(n_game_actions_)),
@@ -38,18 +40,20 @@ void GNode::heuristic()
     {
         return;
     }
-    if (actions_mask_.size() == 0)
+    if (legal_actions_.size() == 0)
     {
-        actions_mask_ = state_ptr_->actions_mask();
+        legal_actions_bits_.resize(rl::common::bits::n_words(n_game_actions_));
+        state_ptr_->legal_actions_bitset(legal_actions_bits_.data());
+        rl::common::bits::for_each_bit(legal_actions_bits_.data(), static_cast<int>(legal_actions_bits_.size()), [this](int action)
+            { legal_actions_.push_back(action); });
     }
     if (children_.size() == 0)
     {
+        children_.resize(legal_actions_.size());
+        wsa_.assign(legal_actions_.size(), 0.0f);
+        nsa_.assign(legal_actions_.size(), 0);
         for (int action = 0; action < n_game_actions_; action++)
         {
-            children_.push_back(nullptr);
-
-            wsa_[action] = 0;
-            nsa_[action] = 0;
             amaf_wsa_player_0_[action] = 0;
             amaf_nsa_player_0_[action] = 50;
             amaf_wsa_player_1_[action] = 0;
@@ -65,23 +69,11 @@ std::pair<float, int> GNode::playout(std::vector<int>& player_0_actions, std::ve
         throw rl::common::UnreachableCodeException("state terminal is not calculate or it is done");
     }
     std::unique_ptr<IState> rollout_state_ptr{ state_ptr_->clone() };
+    std::vector<int> rollout_legal_actions{};
     while (rollout_state_ptr->is_terminal() == false)
     {
-        std::vector<bool> masks = rollout_state_ptr->actions_mask();
-
-        int n_legal_actions = 0;
-        for (int action = 0; action < n_game_actions_; action++)
-        {
-            n_legal_actions += masks[action];
-        }
-
-        int random_legal_action_idx = common::get(n_legal_actions);
-        int random_action = -1;
-        while (random_legal_action_idx >= 0)
-        {
-            if (masks[++random_action] == 1)
-                random_legal_action_idx--;
-        }
+        rollout_state_ptr->legal_actions(rollout_legal_actions);
+        int random_action = rollout_legal_actions[common::get(rollout_legal_actions.size())];
 
         if (rollout_state_ptr->player_turn() == 0)
         {
@@ -91,7 +83,7 @@ std::pair<float, int> GNode::playout(std::vector<int>& player_0_actions, std::ve
         {
             player_1_actions.push_back(random_action);
         }
-        rollout_state_ptr = rollout_state_ptr->step(random_action);
+        rollout_state_ptr->apply(random_action);
     }
     float reward = rollout_state_ptr->get_reward();
     return std::make_pair(reward, rollout_state_ptr->player_turn());
@@ -125,14 +117,15 @@ std::pair<float, int> GNode::simulate_one(const GNode* amaf_node_ptr, std::vecto
         {
             amaf_node_ptr = this;
         }
-        int best_action = choose_best_action(amaf_node_ptr);
+        int best_idx = choose_best_idx(amaf_node_ptr);
+        int best_action = legal_actions_[best_idx];
 
-        if (children_[best_action] == nullptr)
+        if (children_[best_idx] == nullptr)
         {
             auto new_state_ptr = state_ptr_->step(best_action);
-            children_[best_action] = std::make_unique<GNode>(std::move(new_state_ptr), amaf_min_ref_count_, bias_, save_illegal_actions_amaf_);
+            children_[best_idx] = std::make_unique<GNode>(std::move(new_state_ptr), amaf_min_ref_count_, bias_, save_illegal_actions_amaf_);
         }
-        auto& new_node = children_[best_action];
+        auto& new_node = children_[best_idx];
         auto playout_res = new_node->simulate_one(amaf_node_ptr, out_player_0_actions, out_player_1_actions);
         update_amf(playout_res, out_player_0_actions, out_player_1_actions);
         if (current_player_ == 0)
@@ -145,71 +138,54 @@ std::pair<float, int> GNode::simulate_one(const GNode* amaf_node_ptr, std::vecto
         }
         auto& [z, new_player] = playout_res;
         n_++;
-        nsa_[best_action]++;
-        wsa_[best_action] += current_player_ == new_player ? z : -z;
+        nsa_[best_idx]++;
+        wsa_[best_idx] += current_player_ == new_player ? z : -z;
         return playout_res;
     }
 }
 
 int GNode::choose_best_action(const GNode* amaf_ptr)
 {
-    int best_action = -1;
-    float best_value = -std::numeric_limits<float>::infinity();
-    for (int action = 0; action < n_game_actions_; action++)
-    {
-        if (actions_mask_[action] == false)
-            continue;
-
-        float w = wsa_[action];
-        float n = static_cast<float>(nsa_[action]) + 1e-8f;
-        float wa = current_player_ == 0 ? amaf_ptr->amaf_wsa_player_0_[action] : amaf_ptr->amaf_wsa_player_1_[action];
-        float na = static_cast<float>(current_player_ == 0 ? amaf_ptr->amaf_nsa_player_0_[action] : amaf_ptr->amaf_nsa_player_1_[action]) + 1e-8f;
-        float ba = na / (na + n + bias_ * na * n);
-        float amaf = wa / (na + 1e-8f);
-        float mean = w / (n + 1e-8f);
-        float value = (1.0f - ba) * mean + ba * amaf;
-        if (value > best_value)
-        {
-            best_value = value;
-            best_action = action;
-        }
-    }
-    if (best_action == -1)
-    {
-        throw rl::common::UnreachableCodeException("Best action of -1 in G-rave");
-    }
-    return best_action;
+    return legal_actions_[choose_best_idx(amaf_ptr)];
 }
 
-
 float GNode::get_best_action_value(const GNode* amaf_ptr)
 {
-    int best_action = -1;
+    return action_value(amaf_ptr, choose_best_idx(amaf_ptr));
+}
+
+int GNode::choose_best_idx(const GNode* amaf_ptr) const
+{
+    int best_idx = -1;
     float best_value = -std::numeric_limits<float>::infinity();
-    for (int action = 0; action < n_game_actions_; action++)
+    int n_legal_actions = static_cast<int>(legal_actions_.size());
+    for (int idx = 0; idx < n_legal_actions; idx++)
     {
-        if (actions_mask_[action] == false)
-            continue;
-
-        float w = wsa_[action];
-        float n = static_cast<float>(nsa_[action]) + 1e-8f;
-        float wa = current_player_ == 0 ? amaf_ptr->amaf_wsa_player_0_[action] : amaf_ptr->amaf_wsa_player_1_[action];
-        float na = static_cast<float>(current_player_ == 0 ? amaf_ptr->amaf_nsa_player_0_[action] : amaf_ptr->amaf_nsa_player_1_[action]) + 1e-8f;
-        float ba = na / (na + n + bias_ * na * n);
-        float amaf = wa / (na + 1e-8f);
-        float mean = w / (n + 1e-8f);
-        float value = (1.0f - ba) * mean + ba * amaf;
+        float value = action_value(amaf_ptr, idx);
         if (value > best_value)
         {
             best_value = value;
-            best_action = action;
+            best_idx = idx;
         }
     }
-    if (best_action == -1)
+    if (best_idx == -1)
     {
         throw rl::common::UnreachableCodeException("Best action of -1 in G-rave");
     }
-    return best_value;
+    return best_idx;
+}
+
+float GNode::action_value(const GNode* amaf_ptr, int idx) const
+{
+    int action = legal_actions_[idx];
+    float w = wsa_[idx];
+    float n = static_cast<float>(nsa_[idx]) + 1e-8f;
+    float wa = current_player_ == 0 ? amaf_ptr->amaf_wsa_player_0_[action] : amaf_ptr->amaf_wsa_player_1_[action];
+    float na = static_cast<float>(current_player_ == 0 ? amaf_ptr->amaf_nsa_player_0_[action] : amaf_ptr->amaf_nsa_player_1_[action]) + 1e-8f;
+    float ba = na / (na + n + bias_ * na * n);
+    float amaf = wa / (na + 1e-8f);
+    float mean = w / (n + 1e-8f);
+    return (1.0f - ba) * mean + ba * amaf;
 }
 
 void GNode::update_amf(const std::pair<const float, const int>& playout_res, const std::vector<int>& player_0_actions_ref, const std::vector<int>& player_1_actions_ref)
@@ -220,7 +196,7 @@ void GNode::update_amf(const std::pair<const float, const int>& playout_res, con
 
     for (int action : player_0_actions_ref)
     {
-        if (save_illegal_actions_amaf_ == false && actions_mask_[action] == false)
+        if (save_illegal_actions_amaf_ == false && !rl::common::bits::test_bit(legal_actions_bits_.data(), action))
             continue;
         amaf_nsa_player_0_[action]++;
         amaf_wsa_player_0_[action] += player_0_score;
@@ -228,7 +204,7 @@ void GNode::update_amf(const std::pair<const float, const int>& playout_res, con
     float player_1_score = player == 1 ? z : -z;
     for (int action : player_1_actions_ref)
     {
-        if (save_illegal_actions_amaf_ == false && actions_mask_[action] == false)
+        if (save_illegal_actions_amaf_ == false && !rl::common::bits::test_bit(legal_actions_bits_.data(), action))
             continue;
         amaf_nsa_player_1_[action]++;
         amaf_wsa_player_1_[action] += player_1_score;
@@ -1,6 +1,7 @@
 #include <players/bandits/grave/grave_node.hpp>
 #include <common/exceptions.hpp>
 #include <common/random.hpp>
+#include <common/bits.hpp>
 namespace rl::players
 {
 GraveNode::GraveNode(std::unique_ptr<IState> state_ptr, int n_game_actions)
@@ -11,18 +12,15 @@ GraveNode::GraveNode(std::unique_ptr<IState> state_ptr, int n_game_actions)
     is_leaf_node_(true),
     children_(),
     n_(0),
-    wsa_(std::vector<float>(n_game_actions)),
-    nsa_(std::vector<int>(n_game_actions)),
+    wsa_(),
+    nsa_(),
     amaf_wsa_player_0(std::vector<float>(n_game_actions)),
     amaf_nsa_player_0(std::vector<int>(n_game_actions)),
     amaf_wsa_player_1(std::vector<float>(n_game_actions)),
     amaf_nsa_player_1(std::vector<int>(n_game_actions)),
-    actions_legality_()
+    legal_actions_bits_(),
+    legal_actions_()
 {
-    for (int i = 0; i < n_game_actions; i++)
-    {
-        children_.push_back(nullptr);
-    }
     heuristic();
 }
 std::pair<float, int> GraveNode::simulateOne(GraveNode* amaf_node_ptr,
@@ -47,9 +45,9 @@ std::pair<float, int> GraveNode::simulateOne(GraveNode* amaf_node_ptr,
     }
     if (is_leaf_node_) // leaf node first non terminal visit
     {
-        if (actions_legality_.size() == 0)
+        if (legal_actions_.size() == 0)
         {
-            actions_legality_ = state_ptr_->actions_mask();
+            load_legal_actions();
         }
         auto [z, p] = playout(out_our_actions, out_opponent_actions);
         if (p != current_player_)
@@ -65,14 +63,15 @@ std::pair<float, int> GraveNode::simulateOne(GraveNode* amaf_node_ptr,
     {
         amaf_node_ptr = this;
     }
-    int best_action = selectMove(amaf_node_ptr, depth, b_square_ref);
+    int best_idx = selectMoveIdx(amaf_node_ptr, depth, b_square_ref);
+    int best_action = legal_actions_[best_idx];
 
-    if (children_[best_action] == nullptr)
+    if (children_[best_idx] == nullptr)
     {
         std::unique_ptr<IState> new_state_ptr = state_ptr_->step(best_action);
-        children_[best_action] = std::make_unique<GraveNode>(std::move(new_state_ptr), n_game_actions_);
+        children_[best_idx] = std::make_unique<GraveNode>(std::move(new_state_ptr), n_game_actions_);
     }
-    std::unique_ptr<GraveNode>& new_node_ptr = children_[best_action];
+    std::unique_ptr<GraveNode>& new_node_ptr = children_[best_idx];
     int new_player = new_node_ptr->current_player_;
     std::pair<float, int> pair;
     if (current_player_ != new_player)
@@ -92,23 +91,26 @@ std::pair<float, int> GraveNode::simulateOne(GraveNode* amaf_node_ptr,
 
     out_our_actions.push_back(best_action);
     n_++;
-    nsa_[best_action]++;
-    wsa_[best_action] += z;
+    nsa_[best_idx]++;
+    wsa_[best_idx] += z;
     return std::make_pair(z, current_player_);
 }
 
 int GraveNode::selectMove(GraveNode* amaf_node_ptr, int depth, const float& b_square_ref)
 {
-    int best_action = -1;
+    return legal_actions_[selectMoveIdx(amaf_node_ptr, depth, b_square_ref)];
+}
+
+int GraveNode::selectMoveIdx(GraveNode* amaf_node_ptr, int depth, const float& b_square_ref)
+{
+    int best_idx = -1;
     float best_value = -std::numeric_limits<float>::infinity();
-    for (int action = 0; action < n_game_actions_; action++)
+    int n_legal_actions = static_cast<int>(legal_actions_.size());
+    for (int idx = 0; idx < n_legal_actions; idx++)
     {
-        if (actions_legality_[action] == 0)
-        {
-            continue;
-        }
-        float w = wsa_[action];
-        float p = float(nsa_[action]);
+        int action = legal_actions_[idx];
+        float w = wsa_[idx];
+        float p = float(nsa_[idx]);
         float wa = 0.0f;
         float pa = 1e-8f;
         if (amaf_node_ptr != nullptr)
@@ -123,10 +125,10 @@ int GraveNode::selectMove(GraveNode* amaf_node_ptr, int depth, const float& b_sq
         if (value > best_value)
         {
             best_value = value;
-            best_action = action;
+            best_idx = idx;
         }
     }
-    return best_action;
+    return best_idx;
 }
 
 std::pair<float, int> GraveNode::playout(std::vector<int>& out_our_actions, std::vector<int>& out_opponent_actions)
@@ -139,23 +141,11 @@ std::pair<float, int> GraveNode::playout(std::vector<int>& out_our_actions, std:
     // pick legal action
     int iter = 0;
     std::unique_ptr<IState> rollout_state_ptr = state_ptr_->clone();
+    std::vector<int> rollout_legal_actions{};
     while (!rollout_state_ptr->is_terminal())
     {
-        std::vector<bool> rollout_actions_legality = rollout_state_ptr->actions_mask();
-
-        int n_legal_actions = 0;
-        for (int action = 0; action < n_game_actions_; action++)
-        {
-            n_legal_actions += rollout_actions_legality[action];
-        }
-
-        int random_legal_action_idx = common::get(n_legal_actions);
-        int random_action = -1;
-        while (random_legal_action_idx >= 0)
-        {
-            if (rollout_actions_legality[++random_action] == 1)
-                random_legal_action_idx--;
-        }
+        rollout_state_ptr->legal_actions(rollout_legal_actions);
+        int random_action = rollout_legal_actions[common::get(rollout_legal_actions.size())];
         if (rollout_state_ptr->player_turn() == current_player_)
         {
             out_our_actions.push_back(random_action);
@@ -164,7 +154,7 @@ std::pair<float, int> GraveNode::playout(std::vector<int>& out_our_actions, std:
         {
             out_opponent_actions.push_back(random_action);
         }
-        rollout_state_ptr = rollout_state_ptr->step(random_action);
+        rollout_state_ptr->apply(random_action);
         iter++;
     }
     float final_result = rollout_state_ptr->get_reward();
@@ -185,18 +175,16 @@ void GraveNode::heuristic()
     {
         return;
     }
-    if (actions_legality_.size() == 0)
+    if (legal_actions_.size() == 0)
     {
-        actions_legality_ = state_ptr_->actions_mask();
+        load_legal_actions();
     }
+    wsa_.assign(legal_actions_.size(), 0.0f);
+    nsa_.assign(legal_actions_.size(), 0);
+    children_.resize(legal_actions_.size());
 
     for (int action = 0; action < n_game_actions_; action++)
     {
-        // if (actions_legality_[action] == 0)
-        //         continue;
-
-        wsa_[action] = 0;
-        nsa_[action] = 0;
         amaf_wsa_player_0[action] = 0;
         amaf_nsa_player_0[action] = 50;
         amaf_wsa_player_1[action] = 0;
@@ -204,11 +192,19 @@ void GraveNode::heuristic()
     }
 }
 
+void GraveNode::load_legal_actions()
+{
+    legal_actions_bits_.resize(rl::common::bits::n_words(n_game_actions_));
+    state_ptr_->legal_actions_bitset(legal_actions_bits_.data());
+    rl::common::bits::for_each_bit(legal_actions_bits_.data(), static_cast<int>(legal_actions_bits_.size()), [this](int action)
+        { legal_actions_.push_back(action); });
+}
+
 void GraveNode::update_amaf(float our_score, const std::vector<int>& our_actions_ref, const std::vector<int>& opponent_actions_ref, int depth, bool save_illegal_amaf_actions)
 {
     for (int action : our_actions_ref)
     {
-        if (!save_illegal_amaf_actions && actions_legality_[action] == 0)
+        if (!save_illegal_amaf_actions && !rl::common::bits::test_bit(legal_actions_bits_.data(), action))
             continue;
         if (current_player_ == 0)
         {
@@ -224,7 +220,7 @@ void GraveNode::update_amaf(float our_score, const std::vector<int>& our_actions
 
     for (int action : opponent_actions_ref)
     {
-        if (!save_illegal_amaf_actions && actions_legality_[action] == 0)
+        if (!save_illegal_amaf_actions && !rl::common::bits::test_bit(legal_actions_bits_.data(), action))
             continue;
         if (current_player_ == 0)
         {
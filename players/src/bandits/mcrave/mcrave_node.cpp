@@ -2,6 +2,7 @@
 #include <common/exceptions.hpp>
 #include <chrono>
 #include <common/random.hpp>
+#include <common/bits.hpp>
 namespace rl::players
 {
 McraveNode::McraveNode(std::unique_ptr<IState> state_ptr, int n_game_actions)
@@ -13,16 +14,13 @@ McraveNode::McraveNode(std::unique_ptr<IState> state_ptr, int n_game_actions)
     game_result_(),
     children_(),
     n_sa_(std::vector<int>(n_game_actions)),
-    nsa_(std::vector<int>(n_game_actions)),
+    nsa_(),
     q_sa_(std::vector<float>(n_game_actions)),
-    qsa_(std::vector<float>(n_game_actions)),
-    actions_legality_()
+    qsa_(),
+    legal_actions_bits_(),
+    legal_actions_()
 {
     heuristic();
-    for (int i = 0; i < n_game_actions; i++)
-    {
-        children_.push_back(nullptr);
-    }
 }
 void McraveNode::search(int minimum_simulations_count, std::chrono::duration<int, std::milli> minimum_duration, float b, std::vector<float>& out_actions_probs)
 {
@@ -56,7 +54,7 @@ void McraveNode::search(int minimum_simulations_count, std::chrono::duration<int
         i++;
     }
 
-    int action = selectMove(b);
+    int action = legal_actions_[selectMove(b)];
     out_actions_probs.resize(n_game_actions_);
     out_actions_probs[action] = 1;
 }
@@ -79,9 +77,9 @@ std::pair<float, int> McraveNode::simulateOne(float b, std::vector<int>& out_our
 
     if (is_leaf_node) // leaf node -> first visit
     {
-        if (actions_legality_.size() == 0)
+        if (legal_actions_.size() == 0)
         {
-            actions_legality_ = state_ptr_->actions_mask();
+            load_legal_actions();
         }
         auto [z, p] = simDefault(out_our_actions, out_their_actions);
         is_leaf_node = false;
@@ -92,7 +90,7 @@ std::pair<float, int> McraveNode::simulateOne(float b, std::vector<int>& out_our
         }
         for (int& action : out_our_actions)
         {
-            if (actions_legality_[action] == 0)
+            if (!rl::common::bits::test_bit(legal_actions_bits_.data(), action))
                 continue;
             n_sa_[action]++;
             q_sa_[action] += (z - q_sa_[action]) / n_sa_[action];
@@ -100,14 +98,15 @@ std::pair<float, int> McraveNode::simulateOne(float b, std::vector<int>& out_our
         return std::make_pair(z, player_);
     }
 
-    int best_action = selectMove(b);
+    int best_idx = selectMove(b);
+    int best_action = legal_actions_[best_idx];
 
-    if (children_[best_action] == nullptr)
+    if (children_[best_idx] == nullptr)
     {
         auto new_state_ptr = state_ptr_->step(best_action);
-        children_[best_action] = std::make_unique<McraveNode>(std::move(new_state_ptr), n_game_actions_);
+        children_[best_idx] = std::make_unique<McraveNode>(std::move(new_state_ptr), n_game_actions_);
     }
-    auto& new_node_ptr = children_[best_action];
+    auto& new_node_ptr = children_[best_idx];
     int new_player = new_node_ptr->player();
     std::pair<float, int> pair;
     if (new_player != player_)
@@ -126,41 +125,40 @@ std::pair<float, int> McraveNode::simulateOne(float b, std::vector<int>& out_our
 
     for (int& action : out_our_actions)
     {
-        if (actions_legality_[action] == 0)
+        if (!rl::common::bits::test_bit(legal_actions_bits_.data(), action))
             continue;
         n_sa_[action]++;
         q_sa_[action] += (z - q_sa_[action]) / n_sa_[action];
     }
     out_our_actions.push_back(best_action);
 
-    nsa_[best_action]++;
-    qsa_[best_action] += (z - qsa_[best_action]) / nsa_[best_action];
+    nsa_[best_idx]++;
+    qsa_[best_idx] += (z - qsa_[best_idx]) / nsa_[best_idx];
     return std::make_pair(z, player_);
 }
 
 int McraveNode::selectMove(float b)
 {
     float max_eval = -std::numeric_limits<float>::infinity();
-    int best_action = -1;
-    for (int action = 0; action < n_game_actions_; action++)
+    int best_idx = -1;
+    int n_legal_actions = static_cast<int>(legal_actions_.size());
+    for (int idx = 0; idx < n_legal_actions; idx++)
     {
-        if (actions_legality_[action] == 0)
-            continue;
-
-        float beta = n_sa_[action] / static_cast<float>(nsa_[action] + n_sa_[action] + 4 * b * b * nsa_[action] * n_sa_[action] + 1e-8f);
+        int action = legal_actions_[idx];
+        float beta = n_sa_[action] / static_cast<float>(nsa_[idx] + n_sa_[action] + 4 * b * b * nsa_[idx] * n_sa_[action] + 1e-8f);
 
-        float eval = (1 - beta) * qsa_[action] + beta * q_sa_[action];
+        float eval = (1 - beta) * qsa_[idx] + beta * q_sa_[action];
         if (eval > max_eval)
         {
             max_eval = eval;
-            best_action = action;
+            best_idx = idx;
         }
     }
-    if (best_action == -1)
+    if (best_idx == -1)
     {
         throw "best action is -1";
     }
-    return best_action;
+    return best_idx;
 }
 
 std::pair<float, int> McraveNode::simDefault(std::vector<int>& out_our_actions, std::vector<int>& out_their_actions)
@@ -178,24 +176,11 @@ std::pair<float, int> McraveNode::simDefault(std::vector<int>& out_our_actions,
     int iter = 0;
     int our_player = state_ptr_->player_turn();
     std::unique_ptr<IState> rollout_state_ptr = state_ptr_->clone();
+    std::vector<int> rollout_legal_actions{};
     while (!rollout_state_ptr->is_terminal())
     {
-        std::vector<bool> rollout_actions_legality = rollout_state_ptr->actions_mask();
-
-        int n_legal_actions = 0;
-        for (int i = 0; i < n_game_actions_; i++)
-        {
-            n_legal_actions += rollout_actions_legality[i];
-        }
-
-        int random_legal_action_idx = rl::common::get(n_legal_actions);
-        // int random_legal_action_idx = rand() % n_legal_actions;
-        int random_action = -1;
-        while (random_legal_action_idx >= 0)
-        {
-            if (rollout_actions_legality[++random_action] == 1)
-                random_legal_action_idx--;
-        }
+        rollout_state_ptr->legal_actions(rollout_legal_actions);
+        int random_action = rollout_legal_actions[rl::common::get(rollout_legal_actions.size())];
         if (rollout_state_ptr->player_turn() == our_player)
         {
             out_our_actions.push_back(random_action);
@@ -204,7 +189,7 @@ std::pair<float, int> McraveNode::simDefault(std::vector<int>& out_our_actions,
         {
             out_their_actions.push_back(random_action);
         }
-        rollout_state_ptr = rollout_state_ptr->step(random_action);
+        rollout_state_ptr->apply(random_action);
         iter++;
     }
     float last_result = rollout_state_ptr->get_reward();
@@ -226,22 +211,28 @@ void McraveNode::heuristic()
     {
         return;
     }
-    if (actions_legality_.size() == 0)
+    if (legal_actions_.size() == 0)
     {
-        actions_legality_ = state_ptr_->actions_mask();
+        load_legal_actions();
     }
-    for (int action = 0; action < n_game_actions_; action++)
+    children_.resize(legal_actions_.size());
+    nsa_.assign(legal_actions_.size(), 0);
+    qsa_.assign(legal_actions_.size(), 0.0f);
+    for (int action : legal_actions_)
     {
-        if (actions_legality_[action] == 0)
-            continue;
-
         // TODO: change these
-        qsa_[action] = 0;
-        n_sa_[action] = 0;
         q_sa_[action] = 0;
         n_sa_[action] = 50;
     }
 }
+
+void McraveNode::load_legal_actions()
+{
+    legal_actions_bits_.resize(rl::common::bits::n_words(n_game_actions_));
+    state_ptr_->legal_actions_bitset(legal_actions_bits_.data());
+    rl::common::bits::for_each_bit(legal_actions_bits_.data(), static_cast<int>(legal_actions_bits_.size()), [this](int action)
+        { legal_actions_.push_back(action); });
+}
 int McraveNode::player()
 {
     return player_;
@@ -6,13 +6,18 @@ namespace rl::players
 UctSearchTree::UctSearchTree(int n_game_actions, float cuct, float temperature)
     : n_game_actions_(n_game_actions),
     cuct_(cuct),
-    temperature_(temperature)
+    temperature_(temperature),
+    tree_(std::make_unique<UctTree>(n_game_actions, cuct, memory_budget_bytes(DEFAULT_MEMORY_BUDGET_MB)))
 {}
+UctSearchTree::~UctSearchTree() = default;
 std::vector<float> UctSearchTree::search(const rl::common::IState* state_ptr, int simulation_count, std::chrono::duration<int, std::milli> duration)
 {
-    UctNode node{ state_ptr->clone(), n_game_actions_, cuct_ };
     std::vector<float> actions_probs(n_game_actions_);
-    node.search(simulation_count, duration, cuct_, temperature_, actions_probs);
+    tree_->search(state_ptr, simulation_count, duration, temperature_, actions_probs);
     return actions_probs;
 }
+void UctSearchTree::set_memory_budget_mb(int megabytes)
+{
+    tree_ = std::make_unique<UctTree>(n_game_actions_, cuct_, memory_budget_bytes(megabytes));
+}
 } // namespace rl::players
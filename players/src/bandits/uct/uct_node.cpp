@@ -2,115 +2,161 @@
 #include <common/exceptions.hpp>
 #include <chrono>
 #include <algorithm>
+#include <limits>
+#include <cmath>
+#include <tuple>
 #include <common/random.hpp>
 namespace rl::players
 {
-UctNode::UctNode(std::unique_ptr<const rl::common::IState> state_ptr, int n_game_actions, float cuct)
-    : state_ptr_(std::move(state_ptr)),
-    n_game_actions_(n_game_actions),
+UctTree::UctTree(int n_game_actions, float cuct, size_t memory_budget_bytes)
+    : n_game_actions_(n_game_actions),
     cuct_(cuct),
-    terminal_(),
-    game_result_(),
-    actions_legality_(),
-    children_(),
-    n_(0),
-    qsa_(n_game_actions),
-    nsa_(n_game_actions)
+    memory_budget_bytes_(memory_budget_bytes),
+    arenas_(memory_budget_bytes)
 {
-    for (int i = 0; i < n_game_actions; i++)
-    {
-        children_.push_back(nullptr);
-    }
 }
 
-void UctNode::search(int minimum_simulations, std::chrono::duration<int, std::milli> minimum_duration, float uct, float temperature, std::vector<float>& out_actions_probs)
+void UctTree::search(const rl::common::IState* state_ptr, int minimum_simulations, std::chrono::duration<int, std::milli> minimum_duration, float temperature, std::vector<float>& out_actions_probs)
 {
-    if (terminal_.has_value() == false)
-    {
-        terminal_.emplace(state_ptr_->is_terminal());
-    }
-    if (terminal_.value())
+    if (state_ptr->is_terminal())
     {
         throw rl::common::SteppingTerminalStateException("");
     }
+    arenas_.clear();
+    arenas_.nodes.allocate(1);
+    out_of_budget_ = false;
 
     auto t_end = std::chrono::high_resolution_clock::now() + minimum_duration;
-    for (int i = 0; i < minimum_simulations; i++)
+    for (int i = 0; i < minimum_simulations && !is_full(); i++)
     {
-        simulateOne();
+        simulateOne(state_ptr);
     }
 
-    while (t_end > std::chrono::high_resolution_clock::now())
+    while (t_end > std::chrono::high_resolution_clock::now() && !is_full())
     {
-        simulateOne();
+        simulateOne(state_ptr);
     }
 
     getFinalProbabilities(temperature, out_actions_probs);
 }
 
-std::pair<float, int> UctNode::simulateOne()
+bool UctTree::is_full() const
 {
-    if (terminal_.has_value() == false)
-    {
-        terminal_.emplace(state_ptr_->is_terminal());
-    }
+    // a simulation adds at most one node and expands at most one
+    return out_of_budget_ || bytes_used() + sizeof(UctNode) + n_game_actions_ * sizeof(UctEdge) > memory_budget_bytes_;
+}
 
-    if (terminal_.value())
-    {
-        if (game_result_.has_value() == false)
+size_t UctTree::bytes_used() const
+{
+    return arenas_.bytes_used();
+}
+
+std::pair<float, int> UctTree::simulateOne(const rl::common::IState* root_state_ptr)
+{
+    auto state_ptr = root_state_ptr->clone();
+    path_.clear();
+    int32_t node_idx = 0;
+    float z;
+    int p;
+    while (true)
+    {
+        UctNode& node = arenas_.nodes[node_idx];
+        if (!node.is_visited)
         {
-            game_result_.emplace(state_ptr_->get_reward());
+            node.is_terminal = state_ptr->is_terminal();
+            if (node.is_terminal)
+            {
+                node.game_result = state_ptr->get_reward();
+            }
+            else
+            {
+                // first none terminal visit
+                if (!expand(node_idx, state_ptr.get()))
+                {
+                    // the node stays a leaf and nothing on the path is counted
+                    out_of_budget_ = true;
+                    return std::make_pair(0.0f, state_ptr->player_turn());
+                }
+                node.is_visited = true;
+                std::tie(z, p) = rollout(std::move(state_ptr));
+                break;
+            }
+            node.is_visited = true;
         }
-        return std::make_pair(game_result_.value(), state_ptr_->player_turn());
+
+        if (node.is_terminal)
+        {
+            z = node.game_result;
+            p = state_ptr->player_turn();
+            break;
+        }
+
+        int32_t edge_idx = findBestAction(node);
+        path_.push_back({ node_idx, edge_idx, state_ptr->player_turn() });
+        state_ptr->apply(arenas_.edges[edge_idx].action);
+
+        if (arenas_.edges[edge_idx].child == -1)
+        {
+            int32_t child = arenas_.nodes.allocate(1);
+            if (child < 0)
+            {
+                out_of_budget_ = true;
+                return std::make_pair(0.0f, state_ptr->player_turn());
+            }
+            arenas_.edges[edge_idx].child = child;
+        }
+        node_idx = arenas_.edges[edge_idx].child;
     }
 
-    if (actions_legality_.size() == 0) // if size is 0 then this is the first none terminal visit
+    for (auto it = path_.rbegin(); it != path_.rend(); ++it)
     {
-        actions_legality_ = state_ptr_->actions_mask();
-        auto tp = rollout(state_ptr_->clone());
-        return tp;
+        if (p != it->player)
+        {
+            z = -z;
+        }
+        p = it->player;
+        UctEdge& edge = arenas_.edges[it->edge];
+        arenas_.nodes[it->node].n++;
+        edge.nsa++;
+        edge.qsa += (z - edge.qsa) / float(edge.nsa);
     }
+    return std::make_pair(z, p);
+}
 
-    int best_action = findBestAction();
-
-    if (children_[best_action] == nullptr)
+bool UctTree::expand(int32_t node_idx, const rl::common::IState* state_ptr)
+{
+    state_ptr->legal_actions(legal_actions_);
+    const int32_t n_legal_actions = static_cast<int32_t>(legal_actions_.size());
+    const int32_t first_edge = arenas_.edges.allocate(n_legal_actions);
+    if (first_edge < 0)
     {
-        std::unique_ptr<rl::common::IState> new_state_ptr = state_ptr_->step(best_action);
-        std::unique_ptr<UctNode> new_node_ptr = std::make_unique<UctNode>(std::move(new_state_ptr), n_game_actions_, cuct_);
-        children_[best_action] = std::move(new_node_ptr);
+        return false;
     }
-
-    auto& new_node_ptr = children_[best_action];
-    auto [z, p] = new_node_ptr->simulateOne();
-    if (p != state_ptr_->player_turn())
+    for (int32_t i = 0; i < n_legal_actions; i++)
     {
-        z = -z;
+        arenas_.edges[first_edge + i].action = legal_actions_[i];
     }
-    n_++;
-    nsa_[best_action]++;
-    qsa_[best_action] += (z - qsa_[best_action]) / float(nsa_[best_action]);
-    return std::make_pair(z, state_ptr_->player_turn());
+    UctNode& node = arenas_.nodes[node_idx];
+    node.first_edge = first_edge;
+    node.n_edges = n_legal_actions;
+    return true;
 }
 
-int UctNode::findBestAction()
+int32_t UctTree::findBestAction(const UctNode& node)
 {
-    if (actions_legality_.size() == 0)
+    if (node.n_edges == 0)
     {
-        throw "Exception actions legality size should not be 0";
+        throw "Exception legal actions size should not be 0";
     }
 
     float max_u = -std::numeric_limits<float>::infinity();
-    int best_action = -1;
+    int32_t best_idx = -1;
+    const float log_n = logf(float(node.n));
 
-    for (int action = 0; action < n_game_actions_; action++)
+    for (int32_t idx = node.first_edge; idx < node.first_edge + node.n_edges; idx++)
     {
-        if (actions_legality_[action] == 0)
-        {
-            continue;
-        }
-
-        float qsa = qsa_[action];
-        float nsa = float(nsa_[action]);
+        const UctEdge& edge = arenas_.edges[idx];
+        float nsa = float(edge.nsa);
         float u;
         if (nsa == 0)
         {
@@ -118,112 +164,79 @@ int UctNode::findBestAction()
         }
         else
         {
-            u = qsa + cuct_ * sqrtf(logf(float(n_)) / nsa);
+            u = edge.qsa + cuct_ * sqrtf(log_n / nsa);
         }
         if (u > max_u)
         {
             max_u = u;
-            best_action = action;
+            best_idx = idx;
         }
     }
 
-    if (best_action != -1)
+    if (best_idx != -1)
     {
-        return best_action;
+        return best_idx;
     }
 
     // Should not reach this code unless something went wrong
     // Pick random action instead
-    std::vector<int> best_actions{};
-    for (int action = 0; action < n_game_actions_; action++)
-    {
-        if (actions_legality_[action] == 1)
-        {
-            best_actions.push_back(action);
-        }
-    }
-
-    best_action = rl::common::get(best_actions.size());
-    return best_actions[best_action];
+    return node.first_edge + rl::common::get(node.n_edges);
 }
 
-void UctNode::getFinalProbabilities(float temperature, std::vector<float>& out_actions_probs)
+void UctTree::getFinalProbabilities(float temperature, std::vector<float>& out_actions_probs)
 {
+    std::fill(out_actions_probs.begin(), out_actions_probs.begin() + n_game_actions_, 0.0f);
+    const UctNode& root = arenas_.nodes[0];
+    const int32_t begin = root.first_edge;
+    const int32_t end = root.first_edge + root.n_edges;
+
     if (temperature == 0.0f)
     {
-        int max_visits_count = *std::max_element(nsa_.begin(), nsa_.end());
+        int max_visits_count = 0;
+        for (int32_t idx = begin; idx < end; idx++)
+        {
+            max_visits_count = std::max(max_visits_count, arenas_.edges[idx].nsa);
+        }
 
         std::vector<int> best_actions{};
-        for (int action = 0; action < n_game_actions_; action++)
+        for (int32_t idx = begin; idx < end; idx++)
         {
-            if (nsa_[action] == max_visits_count)
+            if (arenas_.edges[idx].nsa == max_visits_count)
             {
-                best_actions.push_back(action);
+                best_actions.push_back(arenas_.edges[idx].action);
             }
         }
 
         int best_action_idx = rl::common::get(best_actions.size());
-        int best_action = best_actions[best_action_idx];
-
-        for (int action = 0; action < n_game_actions_; action++)
-        {
-            out_actions_probs[action] = action == best_action ? 1.0f : 0.0f;
-        }
+        out_actions_probs[best_actions[best_action_idx]] = 1.0f;
         return;
     }
 
     float sum_probs = 0;
-    for (int action = 0; action < n_game_actions_; action++)
+    for (int32_t idx = begin; idx < end; idx++)
     {
-        float prob = float(nsa_[action]) / n_;
+        float prob = float(arenas_.edges[idx].nsa) / root.n;
         float new_prob = powf(prob, 1.0f / temperature);
         sum_probs += new_prob;
-        out_actions_probs[action] = new_prob;
+        out_actions_probs[arenas_.edges[idx].action] = new_prob;
     }
 
-    for (int action = 0; action < n_game_actions_; action++)
+    for (int32_t idx = begin; idx < end; idx++)
     {
-        out_actions_probs[action] /= sum_probs;
+        out_actions_probs[arenas_.edges[idx].action] /= sum_probs;
     }
 }
 
-std::pair<float, int> UctNode::rollout(std::unique_ptr<rl::common::IState> rollout_state_ptr)
+std::pair<float, int> UctTree::rollout(std::unique_ptr<rl::common::IState> rollout_state_ptr)
 {
-    int depth = 0;
+    std::vector<int> rollout_legal_actions{};
     while (!rollout_state_ptr->is_terminal())
     {
-        std::vector<bool> rollout_actions_legality = rollout_state_ptr->actions_mask();
-
-        int n_legal_actions = 0;
-        for (int i = 0; i < n_game_actions_; i++)
-        {
-            n_legal_actions += rollout_actions_legality[i];
-        }
-
-        int random_legal_action_idx = rl::common::get(n_legal_actions);
-        int random_action = -1;
-        while (random_legal_action_idx >= 0)
-        {
-            if (rollout_actions_legality[++random_action] == 1)
-                random_legal_action_idx--;
-        }
-        rollout_state_ptr = rollout_state_ptr->step(random_action);
-        depth++;
+        rollout_state_ptr->legal_actions(rollout_legal_actions);
+        int random_action = rollout_legal_actions[rl::common::get(rollout_legal_actions.size())];
+        rollout_state_ptr->apply(random_action);
     }
     float result = rollout_state_ptr->get_reward();
     return std::make_pair(result, rollout_state_ptr->player_turn());
 }
-
-UctNode::~UctNode()
-{
-    children_.clear();
-    actions_legality_.clear();
-    nsa_.clear();
-    qsa_.clear();
-
-    children_.shrink_to_fit();
-    actions_legality_.shrink_to_fit();
-    nsa_.shrink_to_fit();
-    qsa_.shrink_to_fit();
-}
 } // namespace searchTrees
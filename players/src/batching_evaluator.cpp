@@ -0,0 +1,218 @@
+#include <players/batching_evaluator.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+namespace rl::players
+{
+BatchingEvaluatorServer::BatchingEvaluatorServer(std::unique_ptr<IEvaluator> evaluator_ptr, int max_batch_size, std::chrono::microseconds max_delay)
+    : evaluator_ptr_{ std::move(evaluator_ptr) }, max_batch_size_{ std::max(1, max_batch_size) }, max_delay_{ max_delay }
+{
+    if (!evaluator_ptr_)
+    {
+        throw std::invalid_argument("BatchingEvaluatorServer needs an evaluator");
+    }
+    worker_ = std::thread(&BatchingEvaluatorServer::run, this);
+}
+
+BatchingEvaluatorServer::~BatchingEvaluatorServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    // whatever is still queued is evaluated before the thread exits, so no
+    // future is ever left without a value
+    worker_.join();
+}
+
+std::future<BatchedEvaluation> BatchingEvaluatorServer::submit(const rl::common::IState* state_ptr)
+{
+    std::promise<BatchedEvaluation> promise{};
+    auto future = promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back({ state_ptr, std::move(promise), std::chrono::steady_clock::now() });
+    }
+    cv_.notify_one();
+    return future;
+}
+
+std::vector<std::future<BatchedEvaluation>> BatchingEvaluatorServer::submit(const std::vector<const rl::common::IState*>& state_ptrs)
+{
+    std::vector<std::future<BatchedEvaluation>> futures{};
+    futures.reserve(state_ptrs.size());
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto state_ptr : state_ptrs)
+        {
+            std::promise<BatchedEvaluation> promise{};
+            futures.push_back(promise.get_future());
+            queue_.push_back({ state_ptr, std::move(promise), now });
+        }
+    }
+    cv_.notify_one();
+    return futures;
+}
+
+void BatchingEvaluatorServer::run()
+{
+    std::vector<Request> batch{};
+    batch.reserve(max_batch_size_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+        if (queue_.empty())
+        {
+            return;
+        }
+
+        // wait for the batch to fill, but not past the oldest request's deadline
+        auto deadline = queue_.front().submitted_at + max_delay_;
+        cv_.wait_until(lock, deadline, [this]() { return stop_ || static_cast<int>(queue_.size()) >= max_batch_size_; });
+
+        int n_states = std::min(max_batch_size_, static_cast<int>(queue_.size()));
+        for (int i = 0; i < n_states; i++)
+        {
+            batch.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        n_batches_++;
+        n_evaluated_states_ += n_states;
+
+        lock.unlock();
+        evaluate_batch(batch);
+        batch.clear();
+        lock.lock();
+    }
+}
+
+void BatchingEvaluatorServer::evaluate_batch(std::vector<Request>& batch)
+{
+    std::vector<const rl::common::IState*> state_ptrs{};
+    state_ptrs.reserve(batch.size());
+    for (auto& request : batch)
+    {
+        state_ptrs.push_back(request.state_ptr);
+    }
+
+    try
+    {
+        auto [probs, values] = evaluator_ptr_->evaluate(state_ptrs);
+        int n_states = static_cast<int>(batch.size());
+        if (values.size() != batch.size() || probs.size() % batch.size() != 0)
+        {
+            throw std::runtime_error("BatchingEvaluatorServer evaluator returned a mismatched batch");
+        }
+        int n_game_actions = static_cast<int>(probs.size() / batch.size());
+        for (int i = 0; i < n_states; i++)
+        {
+            batch[i].promise.set_value({
+                std::vector<float>(probs.begin() + i * n_game_actions, probs.begin() + (i + 1) * n_game_actions),
+                values[i] });
+        }
+    }
+    catch (...)
+    {
+        // the whole batch failed; every waiter gets the exception
+        auto error = std::current_exception();
+        for (auto& request : batch)
+        {
+            try
+            {
+                request.promise.set_exception(error);
+            }
+            catch (const std::future_error&)
+            {
+                // already satisfied before the failure
+            }
+        }
+    }
+}
+
+const IEvaluator& BatchingEvaluatorServer::evaluator() const
+{
+    return *evaluator_ptr_;
+}
+
+int BatchingEvaluatorServer::max_batch_size() const
+{
+    return max_batch_size_;
+}
+
+std::chrono::microseconds BatchingEvaluatorServer::max_delay() const
+{
+    return max_delay_;
+}
+
+long long BatchingEvaluatorServer::n_batches() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return n_batches_;
+}
+
+long long BatchingEvaluatorServer::n_evaluated_states() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return n_evaluated_states_;
+}
+
+BatchingEvaluator::BatchingEvaluator(std::unique_ptr<IEvaluator> evaluator_ptr, int max_batch_size, std::chrono::microseconds max_delay)
+    : server_ptr_{ std::make_shared<BatchingEvaluatorServer>(std::move(evaluator_ptr), max_batch_size, max_delay) }
+{
+}
+
+BatchingEvaluator::BatchingEvaluator(std::shared_ptr<BatchingEvaluatorServer> server_ptr)
+    : server_ptr_{ std::move(server_ptr) }
+{
+}
+
+BatchingEvaluator::~BatchingEvaluator() = default;
+
+std::tuple<std::vector<float>, std::vector<float>> BatchingEvaluator::evaluate(const std::vector<const rl::common::IState*>& state_ptrs)
+{
+    std::vector<float> probs{};
+    std::vector<float> values{};
+    values.reserve(state_ptrs.size());
+
+    // every state goes in before the first wait, so one call can fill a batch
+    auto futures = server_ptr_->submit(state_ptrs);
+    for (auto& future : futures)
+    {
+        auto evaluation = future.get();
+        probs.insert(probs.end(), evaluation.probs.begin(), evaluation.probs.end());
+        values.emplace_back(evaluation.value);
+    }
+    return std::make_tuple(probs, values);
+}
+
+std::tuple<std::vector<float>, std::vector<float>> BatchingEvaluator::evaluate(const rl::common::IState* state_ptrs)
+{
+    auto evaluation = server_ptr_->submit(state_ptrs).get();
+    return std::make_tuple(std::move(evaluation.probs), std::vector<float>{ evaluation.value });
+}
+
+std::tuple<std::vector<float>, std::vector<float>> BatchingEvaluator::evaluate(const std::unique_ptr<rl::common::IState>& state_ptrs)
+{
+    return evaluate(state_ptrs.get());
+}
+
+std::unique_ptr<IEvaluator> BatchingEvaluator::clone() const
+{
+    return std::make_unique<BatchingEvaluator>(server_ptr_->evaluator().clone(), server_ptr_->max_batch_size(), server_ptr_->max_delay());
+}
+
+std::unique_ptr<IEvaluator> BatchingEvaluator::copy() const
+{
+    return std::make_unique<BatchingEvaluator>(server_ptr_);
+}
+
+const std::shared_ptr<BatchingEvaluatorServer>& BatchingEvaluator::server() const
+{
+    return server_ptr_;
+}
+} // namespace rl::players
@@ -0,0 +1,334 @@
+#include <players/caching_evaluator.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <common/zobrist.hpp>
+
+namespace rl::players
+{
+namespace
+{
+constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+uint64_t mix(uint64_t hash, uint64_t value)
+{
+    return (hash ^ value) * FNV_PRIME;
+}
+
+size_t round_up_to_power_of_two(size_t n)
+{
+    size_t power = 1;
+    while (power < n)
+    {
+        power <<= 1;
+    }
+    return power;
+}
+} // namespace
+
+double EvaluationCacheStats::hit_rate() const
+{
+    return n_lookups == 0 ? 0.0 : static_cast<double>(n_hits) / static_cast<double>(n_lookups);
+}
+
+EvaluationCache::EvaluationCache(size_t n_entries, int n_actions)
+    : n_actions_{ n_actions },
+    n_sets_{ round_up_to_power_of_two(std::max<size_t>(1, (n_entries + N_WAYS - 1) / N_WAYS)) },
+    stripe_ticks_(N_STRIPES, 0),
+    stripes_{ new std::mutex[N_STRIPES] }
+{
+    if (n_actions_ <= 0)
+    {
+        throw std::invalid_argument("an evaluation cache needs the number of actions");
+    }
+    keys_.resize(n_sets_ * N_WAYS);
+    last_used_.resize(n_sets_ * N_WAYS);
+    probs_.resize(n_sets_ * N_WAYS * n_actions_);
+    values_.resize(n_sets_ * N_WAYS);
+}
+
+size_t EvaluationCache::set_of(uint64_t key) const
+{
+    // the low bits of IState::hash() can be weak, the high ones pick the set
+    uint64_t state = key;
+    return static_cast<size_t>(rl::common::zobrist::splitmix64(state)) & (n_sets_ - 1);
+}
+
+bool EvaluationCache::lookup(uint64_t key, float* out_probs, float& out_value)
+{
+    n_lookups_.fetch_add(1, std::memory_order_relaxed);
+    const size_t set = set_of(key);
+    const size_t stripe = set % N_STRIPES;
+    std::lock_guard<std::mutex> lock(stripes_[stripe]);
+    for (size_t entry = set * N_WAYS; entry < (set + 1) * N_WAYS; entry++)
+    {
+        if (last_used_[entry] != 0 && keys_[entry] == key)
+        {
+            last_used_[entry] = ++stripe_ticks_[stripe];
+            std::memcpy(out_probs, probs_.data() + entry * n_actions_, n_actions_ * sizeof(float));
+            out_value = values_[entry];
+            n_hits_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void EvaluationCache::insert(uint64_t key, const float* probs, float value)
+{
+    const size_t set = set_of(key);
+    const size_t stripe = set % N_STRIPES;
+    std::lock_guard<std::mutex> lock(stripes_[stripe]);
+    // the key itself if another thread got there first, otherwise the least recently used way
+    size_t victim = set * N_WAYS;
+    for (size_t entry = set * N_WAYS; entry < (set + 1) * N_WAYS; entry++)
+    {
+        if (last_used_[entry] != 0 && keys_[entry] == key)
+        {
+            victim = entry;
+            break;
+        }
+        if (last_used_[entry] < last_used_[victim])
+        {
+            victim = entry;
+        }
+    }
+    if (last_used_[victim] != 0 && keys_[victim] != key)
+    {
+        n_evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    keys_[victim] = key;
+    last_used_[victim] = ++stripe_ticks_[stripe];
+    std::memcpy(probs_.data() + victim * n_actions_, probs, n_actions_ * sizeof(float));
+    values_[victim] = value;
+    n_inserts_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EvaluationCache::clear()
+{
+    for (int stripe = 0; stripe < N_STRIPES; stripe++)
+    {
+        std::lock_guard<std::mutex> lock(stripes_[stripe]);
+        for (size_t set = stripe; set < n_sets_; set += N_STRIPES)
+        {
+            std::fill(last_used_.begin() + set * N_WAYS, last_used_.begin() + (set + 1) * N_WAYS, 0);
+        }
+    }
+}
+
+EvaluationCacheStats EvaluationCache::stats() const
+{
+    EvaluationCacheStats stats{};
+    stats.n_lookups = n_lookups_.load(std::memory_order_relaxed);
+    stats.n_hits = n_hits_.load(std::memory_order_relaxed);
+    stats.n_inserts = n_inserts_.load(std::memory_order_relaxed);
+    stats.n_evictions = n_evictions_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+size_t EvaluationCache::capacity() const
+{
+    return n_sets_ * N_WAYS;
+}
+
+int EvaluationCache::n_actions() const
+{
+    return n_actions_;
+}
+
+size_t EvaluationCache::bytes() const
+{
+    return keys_.size() * sizeof(uint64_t) + last_used_.size() * sizeof(uint64_t) + probs_.size() * sizeof(float) + values_.size() * sizeof(float);
+}
+
+CachingEvaluator::CachingEvaluator(std::unique_ptr<IEvaluator> evaluator_ptr, size_t n_entries, int n_actions, bool use_symmetries)
+    : CachingEvaluator(std::move(evaluator_ptr), std::make_shared<EvaluationCache>(n_entries, n_actions), use_symmetries)
+{
+}
+
+CachingEvaluator::CachingEvaluator(std::unique_ptr<IEvaluator> evaluator_ptr, std::shared_ptr<EvaluationCache> cache_ptr, bool use_symmetries)
+    : evaluator_ptr_{ std::move(evaluator_ptr) }, cache_ptr_{ std::move(cache_ptr) }, use_symmetries_{ use_symmetries }
+{
+    if (!evaluator_ptr_ || !cache_ptr_)
+    {
+        throw std::invalid_argument("CachingEvaluator needs an evaluator and a cache");
+    }
+}
+
+CachingEvaluator::~CachingEvaluator() = default;
+
+uint64_t CachingEvaluator::key_of(const rl::common::IState* state_ptr, std::vector<int>& permutation)
+{
+    permutation.clear();
+    if (!use_symmetries_)
+    {
+        return state_ptr->hash();
+    }
+    const int n_actions = cache_ptr_->n_actions();
+    auto shape = state_ptr->get_observation_shape();
+    observation_.resize(static_cast<size_t>(shape[0]) * shape[1] * shape[2]);
+    symmetric_observation_.resize(observation_.size());
+    state_ptr->write_observation(observation_.data());
+    state_ptr->legal_actions(legal_actions_);
+    is_legal_.assign(n_actions, 0);
+    for (int action : legal_actions_)
+    {
+        is_legal_.at(action) = 1;
+    }
+    if (identity_actions_.size() != static_cast<size_t>(n_actions))
+    {
+        identity_actions_.resize(n_actions);
+        symmetric_actions_.resize(n_actions);
+        for (int action = 0; action < n_actions; action++)
+        {
+            identity_actions_[action] = static_cast<float>(action);
+        }
+    }
+
+    // what the evaluator sees of a position: its observation, legal actions and player
+    auto hash_image = [&](const std::vector<float>& observation, const std::vector<int>* image_permutation)
+        {
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            for (float cell : observation)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &cell, sizeof(bits));
+                hash = mix(hash, bits);
+            }
+            uint64_t word = 0;
+            for (int action = 0; action < n_actions; action++)
+            {
+                int source = image_permutation == nullptr ? action : (*image_permutation)[action];
+                word |= static_cast<uint64_t>(is_legal_[source]) << (action % 64);
+                if (action % 64 == 63 || action == n_actions - 1)
+                {
+                    hash = mix(hash, word);
+                    word = 0;
+                }
+            }
+            hash = mix(hash, static_cast<uint64_t>(state_ptr->player_turn()));
+            return rl::common::zobrist::splitmix64(hash);
+        };
+
+    uint64_t best_key = hash_image(observation_, nullptr);
+    std::vector<int>& candidate = candidate_permutation_;
+    std::vector<uint8_t>& is_taken = is_taken_;
+    candidate.resize(n_actions);
+    is_taken.resize(n_actions);
+    if (n_symmetries_ < 0)
+    {
+        n_symmetries_ = state_ptr->n_symmetries();
+    }
+    for (int symmetry = 0; symmetry < n_symmetries_; symmetry++)
+    {
+        state_ptr->write_symmetrical_obs_and_actions(observation_.data(), identity_actions_.data(), symmetry, symmetric_observation_.data(), symmetric_actions_.data());
+        // a symmetry that does not permute the actions cannot map a policy back
+        std::fill(is_taken.begin(), is_taken.end(), 0);
+        bool is_permutation = true;
+        for (int action = 0; action < n_actions && is_permutation; action++)
+        {
+            int source = static_cast<int>(symmetric_actions_[action]);
+            is_permutation = source >= 0 && source < n_actions && !is_taken[source];
+            if (is_permutation)
+            {
+                is_taken[source] = 1;
+                candidate[action] = source;
+            }
+        }
+        if (!is_permutation)
+        {
+            continue;
+        }
+        uint64_t key = hash_image(symmetric_observation_, &candidate);
+        if (key < best_key)
+        {
+            best_key = key;
+            permutation = candidate;
+        }
+    }
+    return best_key;
+}
+
+std::tuple<std::vector<float>, std::vector<float>> CachingEvaluator::evaluate(const std::vector<const rl::common::IState*>& state_ptrs)
+{
+    const int n_actions = cache_ptr_->n_actions();
+    const size_t n_states = state_ptrs.size();
+    std::vector<float> probs(n_states * n_actions);
+    std::vector<float> values(n_states);
+    canonical_probs_.resize(n_actions);
+
+    std::vector<const rl::common::IState*> missed_states{};
+    std::vector<size_t> missed_indices{};
+    std::vector<uint64_t> missed_keys{};
+    std::vector<std::vector<int>> missed_permutations{};
+    std::vector<int> permutation{};
+    for (size_t i = 0; i < n_states; i++)
+    {
+        uint64_t key = key_of(state_ptrs[i], permutation);
+        float* state_probs = probs.data() + i * n_actions;
+        if (!cache_ptr_->lookup(key, permutation.empty() ? state_probs : canonical_probs_.data(), values[i]))
+        {
+            missed_states.push_back(state_ptrs[i]);
+            missed_indices.push_back(i);
+            missed_keys.push_back(key);
+            missed_permutations.push_back(permutation);
+            continue;
+        }
+        for (int action = 0; action < static_cast<int>(permutation.size()); action++)
+        {
+            state_probs[permutation[action]] = canonical_probs_[action];
+        }
+    }
+    if (missed_states.empty())
+    {
+        return std::make_tuple(std::move(probs), std::move(values));
+    }
+
+    auto [missed_probs, missed_values] = evaluator_ptr_->evaluate(missed_states);
+    for (size_t j = 0; j < missed_states.size(); j++)
+    {
+        const float* evaluated_probs = missed_probs.data() + j * n_actions;
+        std::copy(evaluated_probs, evaluated_probs + n_actions, probs.data() + missed_indices[j] * n_actions);
+        values[missed_indices[j]] = missed_values.at(j);
+        const std::vector<int>& missed_permutation = missed_permutations[j];
+        if (missed_permutation.empty())
+        {
+            cache_ptr_->insert(missed_keys[j], evaluated_probs, missed_values.at(j));
+            continue;
+        }
+        for (int action = 0; action < n_actions; action++)
+        {
+            canonical_probs_[action] = evaluated_probs[missed_permutation[action]];
+        }
+        cache_ptr_->insert(missed_keys[j], canonical_probs_.data(), missed_values.at(j));
+    }
+    return std::make_tuple(std::move(probs), std::move(values));
+}
+
+std::tuple<std::vector<float>, std::vector<float>> CachingEvaluator::evaluate(const rl::common::IState* state_ptrs)
+{
+    return evaluate(std::vector<const rl::common::IState*>{ state_ptrs });
+}
+
+std::tuple<std::vector<float>, std::vector<float>> CachingEvaluator::evaluate(const std::unique_ptr<rl::common::IState>& state_ptrs)
+{
+    return evaluate(std::vector<const rl::common::IState*>{ state_ptrs.get() });
+}
+
+std::unique_ptr<IEvaluator> CachingEvaluator::clone() const
+{
+    return std::make_unique<CachingEvaluator>(evaluator_ptr_->clone(), cache_ptr_->capacity(), cache_ptr_->n_actions(), use_symmetries_);
+}
+
+std::unique_ptr<IEvaluator> CachingEvaluator::copy() const
+{
+    return std::make_unique<CachingEvaluator>(evaluator_ptr_->copy(), cache_ptr_, use_symmetries_);
+}
+
+const std::shared_ptr<EvaluationCache>& CachingEvaluator::cache() const
+{
+    return cache_ptr_;
+}
+
+} // namespace rl::players
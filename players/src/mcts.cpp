@@ -7,120 +7,189 @@
 
 namespace rl::players
 {
+constexpr int MAX_REUSE_DEPTH = 2;
+// a simulation adds a node, freeing a few more keeps retired trees from piling up
+constexpr int32_t RELEASE_PER_SIMULATION = 64;
 
-MCTSNode::MCTSNode(std::unique_ptr<rl::common::IState> state_ptr, int n_game_actions, float cpuct)
-    : state_ptr_{ std::move(state_ptr) },
-    n_game_actions_{ n_game_actions },
-    cpuct_{ cpuct },
-    probs_(n_game_actions, 0.0f),
-    n_visits{ 0 },
-    actions_visits_(n_game_actions, 0.0f),
-    delta_wins_(n_game_actions, 0.0f),
-    is_terminal_{},
-    game_result_{},
-    children_{}
+MCTS::MCTS(std::unique_ptr<IEvaluator> evaluator_ptr, int n_game_actions, float cpuct, float temperature)
+    : evaluator_ptr_{ std::move(evaluator_ptr) }, cpuct_{ cpuct }, temperature_{ temperature }, n_game_actions_{ n_game_actions },
+    memory_budget_bytes_{ memory_budget_bytes(DEFAULT_MEMORY_BUDGET_MB) },
+    tree_{ std::make_unique<Arenas>(memory_budget_bytes_) },
+    spare_{ std::make_unique<Arenas>(memory_budget_bytes_) }
 {
 }
+MCTS::~MCTS() = default;
 
-MCTSNode::~MCTSNode() = default;
+void MCTS::set_memory_budget_mb(int megabytes)
+{
+    memory_budget_bytes_ = memory_budget_bytes(megabytes);
+    tree_ = std::make_unique<Arenas>(memory_budget_bytes_);
+    spare_ = std::make_unique<Arenas>(memory_budget_bytes_);
+    retired_trees_.clear();
+    state_bytes_ = 0;
+}
 
-std::pair<float, int> MCTSNode::search(std::unique_ptr<IEvaluator>& evaluator_ptr)
+void MCTS::retire_tree()
 {
-    if (is_terminal_.has_value() == false)
+    retired_trees_.push_back(std::move(tree_));
+    tree_ = spare_ ? std::move(spare_) : std::make_unique<Arenas>(memory_budget_bytes_);
+}
+
+void MCTS::release_retired(int32_t max_items)
+{
+    if (retired_trees_.empty() || !retired_trees_.front()->clear_back(max_items, max_items * n_game_actions_))
     {
-        is_terminal_.emplace(state_ptr_->is_terminal());
+        return;
     }
-
-    if (is_terminal_.value())
+    // empty now, its chunks are kept for the next subtree unless there are spare ones already
+    if (!spare_)
     {
-        if (game_result_.has_value() == false)
-        {
-            game_result_.emplace(state_ptr_->get_reward());
-        }
-        return std::make_pair(game_result_.value(), state_ptr_->player_turn());
+        spare_ = std::move(retired_trees_.front());
     }
+    retired_trees_.erase(retired_trees_.begin());
+}
 
-    if (actions_mask_.size() == 0)
+bool MCTS::is_full() const
+{
+    // a simulation adds at most one node, with a state about the root's size, and expands at most one
+    const size_t next_simulation = sizeof(MCTSNode) + tree_->nodes[0].state_ptr->memory_bytes() + n_game_actions_ * sizeof(MCTSEdge);
+    return out_of_budget_ || tree_->bytes_used() + state_bytes_ + next_simulation > memory_budget_bytes_;
+}
+
+void MCTS::reset_root(const rl::common::IState* state_ptr)
+{
+    tree_->clear();
+    tree_->nodes.allocate(1);
+    tree_->nodes[0].key = state_ptr->hash();
+    tree_->nodes[0].state_ptr = state_ptr->clone();
+    state_bytes_ = 0;
+}
+
+void MCTS::simulate_once()
+{
+    path_.clear();
+    int32_t node_idx = 0;
+    float next_result;
+    int new_player;
+    while (true)
     {
-        // first visit => rollout
-        actions_mask_ = state_ptr_->actions_mask();
-        for (int action{ 0 }; action < n_game_actions_; action++)
+        MCTSNode& node = tree_->nodes[node_idx];
+        const rl::common::IState* state_ptr = node.state_ptr.get();
+        if (!node.is_visited)
         {
-            children_.push_back(std::unique_ptr<MCTSNode>(nullptr));
+            node.is_terminal = state_ptr->is_terminal();
+            if (node.is_terminal)
+            {
+                node.game_result = state_ptr->get_reward();
+            }
+            else
+            {
+                // first visit => evaluate
+                state_ptr->legal_actions(legal_actions_);
+                const int32_t n_legal_actions = static_cast<int32_t>(legal_actions_.size());
+                const int32_t first_edge = tree_->edges.allocate(n_legal_actions);
+                if (first_edge < 0)
+                {
+                    // the node stays a leaf and nothing on the path is counted
+                    out_of_budget_ = true;
+                    return;
+                }
+                auto [probs, wdl] = evaluator_ptr_->evaluate(state_ptr);
+                for (int32_t i = 0; i < n_legal_actions; i++)
+                {
+                    MCTSEdge& edge = tree_->edges[first_edge + i];
+                    edge.action = legal_actions_[i];
+                    edge.prob = probs.at(legal_actions_[i]);
+                }
+                node.first_edge = first_edge;
+                node.n_edges = n_legal_actions;
+                node.is_visited = true;
+                state_bytes_ += state_ptr->memory_bytes();
+                next_result = wdl.at(0);
+                new_player = state_ptr->player_turn();
+                break;
+            }
+            node.is_visited = true;
+            state_bytes_ += state_ptr->memory_bytes();
         }
 
-        auto [probs, wdl] = evaluator_ptr->evaluate(state_ptr_);
-        float wins = wdl.at(0);
-        probs_ = probs;
-        return std::make_pair(wins, state_ptr_->player_turn());
-    }
-
-    int best_action = get_best_action();
+        if (node.is_terminal)
+        {
+            next_result = node.game_result;
+            new_player = state_ptr->player_turn();
+            break;
+        }
 
-    if (children_.at(best_action).get() == nullptr)
-    {
-        auto new_state_ptr = state_ptr_->step(best_action);
-        children_.at(best_action) = std::make_unique<MCTSNode>(std::move(new_state_ptr), n_game_actions_, cpuct_);
+        int32_t edge_idx = get_best_action(node);
+        MCTSEdge& edge = tree_->edges[edge_idx];
+        if (edge.child == -1)
+        {
+            int32_t child = tree_->nodes.allocate(1);
+            if (child < 0)
+            {
+                out_of_budget_ = true;
+                return;
+            }
+            tree_->nodes[child].state_ptr = state_ptr->step(edge.action);
+            tree_->nodes[child].key = tree_->nodes[child].state_ptr->hash();
+            edge.child = child;
+        }
+        path_.push_back({ node_idx, edge_idx, state_ptr->player_turn() });
+        node_idx = edge.child;
     }
-    const auto& new_node = children_.at(best_action);
-    assert(new_node.get() != nullptr);
-
-    auto [next_result, new_player] = new_node->search(evaluator_ptr);
 
-    if (new_player != state_ptr_->player_turn())
+    for (auto it = path_.rbegin(); it != path_.rend(); ++it)
     {
-        next_result = -next_result;
+        if (new_player != it->player)
+        {
+            next_result = -next_result;
+        }
+        new_player = it->player;
+        MCTSEdge& edge = tree_->edges[it->edge];
+        edge.delta_wins += next_result;
+        edge.visits += 1;
+        tree_->nodes[it->node].n_visits += 1;
     }
-    delta_wins_.at(best_action) += next_result;
-    actions_visits_.at(best_action) += 1;
-    n_visits += 1;
-    return std::make_pair(next_result, state_ptr_->player_turn());
 }
 
-int MCTSNode::get_best_action()
+int32_t MCTS::get_best_action(const MCTSNode& node)
 {
-    assert(actions_mask_.size() != 0);
+    assert(node.n_edges != 0);
     float max_u = -INFINITY;
-    int best_a = -1;
-    for (int action{ 0 }; action < n_game_actions_; action++)
+    int32_t best_idx = -1;
+    for (int32_t idx = node.first_edge; idx < node.first_edge + node.n_edges; idx++)
     {
-        if (actions_mask_.at(action) == false)
-        {
-            continue;
-        }
-        float action_visits = actions_visits_.at(action);
+        const MCTSEdge& edge = tree_->edges[idx];
+        float action_visits = edge.visits;
         float qsa = 0;
         if (action_visits > 0)
         {
-            qsa = delta_wins_.at(action) / action_visits;
+            qsa = edge.delta_wins / action_visits;
         }
-        float u = qsa + cpuct_ * probs_.at(action) * sqrtf(n_visits + 1e-8f) / (1 + action_visits);
+        float u = qsa + cpuct_ * edge.prob * sqrtf(node.n_visits + 1e-8f) / (1 + action_visits);
         if (u > max_u)
         {
             max_u = u;
-            best_a = action;
+            best_idx = idx;
         }
     }
 
-    if (best_a == -1)
+    if (best_idx == -1)
     {
-        std::vector<int> legal_actions;
-        for (int i = 0; i < this->n_game_actions_; i++)
-        {
-            if (actions_mask_.at(i))
-            {
-                legal_actions.push_back(i);
-            }
-        }
-        int action_index = rl::common::get(static_cast<int>(legal_actions.size()));
-        best_a = legal_actions[action_index];
+        best_idx = node.first_edge + rl::common::get(node.n_edges);
     }
-    return best_a;
+    return best_idx;
 }
 
-std::vector<float> MCTSNode::get_probs(float temperature)
+std::vector<float> MCTS::get_probs(float temperature)
 {
-    const auto& actions_visits = actions_visits_;
+    // illegal actions were never visited
+    std::vector<float> actions_visits(n_game_actions_, 0.0f);
+    const MCTSNode& root = tree_->nodes[0];
+    for (int32_t idx = root.first_edge; idx < root.first_edge + root.n_edges; idx++)
+    {
+        actions_visits[tree_->edges[idx].action] = tree_->edges[idx].visits;
+    }
     if (temperature == 0.0f)
     {
         // find max action visits
@@ -189,49 +258,105 @@ std::vector<float> MCTSNode::get_probs(float temperature)
     }
     return probs_with_temperature;
 }
-std::vector<float> MCTSNode::search_and_get_probs(std::unique_ptr<IEvaluator>& evaluator_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration, float temperature)
+
+int32_t MCTS::find_descendant(int32_t node_idx, const rl::common::IState& state, uint64_t key, int max_depth) const
 {
-    if (is_terminal_.has_value() == false)
+    auto is_match = [this, &state, key](int32_t idx)
+        {
+            return tree_->nodes[idx].key == key && tree_->nodes[idx].state_ptr->equals(state);
+        };
+    if (is_match(node_idx))
     {
-        is_terminal_.emplace(state_ptr_->is_terminal());
+        return node_idx;
     }
-    if (is_terminal_.value())
+    if (max_depth <= 0)
     {
-        throw rl::common::SteppingTerminalStateException("MCTS Node is searching a terminal state which cannot be stepped.");
+        return -1;
     }
+    const MCTSNode& node = tree_->nodes[node_idx];
+    // shallowest match first
+    for (int32_t idx = node.first_edge; idx < node.first_edge + node.n_edges; idx++)
+    {
+        int32_t child = tree_->edges[idx].child;
+        if (child >= 0 && is_match(child))
+        {
+            return child;
+        }
+    }
+    for (int32_t idx = node.first_edge; idx < node.first_edge + node.n_edges; idx++)
+    {
+        int32_t child = tree_->edges[idx].child;
+        if (child >= 0)
+        {
+            int32_t found = find_descendant(child, state, key, max_depth - 1);
+            if (found >= 0)
+            {
+                return found;
+            }
+        }
+    }
+    return -1;
+}
+
+std::vector<float> MCTS::search(const rl::common::IState* state_ptr, int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration)
+{
+    assert(state_ptr->is_terminal() == false);
+    uint64_t key = state_ptr->hash();
+    int32_t reused_node = tree_->nodes.size() > 0 ? find_descendant(0, *state_ptr, key, MAX_REUSE_DEPTH) : -1;
+    if (reused_node > 0)
+    {
+        // the subtree is packed at the front of empty arenas, the rest of the old tree is retired
+        auto move_node = [this](MCTSNode& from, MCTSNode& to)
+        {
+            to = std::move(from);
+            if (to.is_visited)
+            {
+                state_bytes_ += to.state_ptr->memory_bytes();
+            }
+        };
+        auto move_edge = [](const MCTSEdge& from, MCTSEdge& to) { to = from; };
+        std::unique_ptr<Arenas> subtree = spare_ ? std::move(spare_) : std::make_unique<Arenas>(memory_budget_bytes_);
+        state_bytes_ = 0;
+        const bool is_moved = move_subtree(*tree_, reused_node, *subtree, move_node, move_edge) >= 0;
+        retired_trees_.push_back(std::move(tree_));
+        tree_ = std::move(subtree);
+        if (!is_moved)
+        {
+            // out of budget halfway, what was moved is gone from the old tree
+            reused_node = -1;
+        }
+    }
+    if (reused_node < 0)
+    {
+        if (tree_->nodes.size() > 0)
+        {
+            retire_tree();
+        }
+        reset_root(state_ptr);
+    }
+    out_of_budget_ = false;
 
     auto t_start = std::chrono::high_resolution_clock::now();
     auto t_end = t_start + minimum_duration;
 
     int simulation_count{ 0 };
 
-    while (simulation_count <= n_sims)
+    while (simulation_count <= minimum_no_simulations && !is_full())
     {
-        search(evaluator_ptr);
+        simulate_once();
+        release_retired(RELEASE_PER_SIMULATION);
         simulation_count++;
     }
 
-    while (t_end > std::chrono::high_resolution_clock::now())
+    while (t_end > std::chrono::high_resolution_clock::now() && !is_full())
     {
-        search(evaluator_ptr);
+        simulate_once();
+        release_retired(RELEASE_PER_SIMULATION);
         simulation_count++;
     }
 
     std::cout << "MCTS " << simulation_count << std::endl;
-    return get_probs(temperature);
-}
-
-MCTS::MCTS(std::unique_ptr<IEvaluator> evaluator_ptr, int n_game_actions, float cpuct, float temperature)
-    : evaluator_ptr_{ std::move(evaluator_ptr) }, n_game_actions_{ n_game_actions }, cpuct_{ cpuct }, temperature_{ temperature }
-{
-}
-MCTS::~MCTS() = default;
-
-std::vector<float> MCTS::search(const rl::common::IState* state_ptr, int minimum_no_simulations, std::chrono::duration<int, std::milli> minimum_duration)
-{
-    assert(state_ptr->is_terminal() == false);
-    root_node = std::make_unique<MCTSNode>(state_ptr->clone(), state_ptr->get_n_actions(), cpuct_);
-    return root_node->search_and_get_probs(evaluator_ptr_, minimum_no_simulations, minimum_duration, temperature_);
+    return get_probs(temperature_);
 }
 
 } // namespace rl::search_trees
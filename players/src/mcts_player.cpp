@@ -22,9 +22,12 @@ MctsPlayer::~MctsPlayer() = default;
 
 int MctsPlayer::choose_action(const std::unique_ptr<rl::common::IState>& state_ptr)
 {
-    auto mcts = MCTS(evaluator_ptr_->copy(), n_game_actions_, cpuct_, temperature_);
+    if (!mcts_ptr_)
+    {
+        mcts_ptr_ = std::make_unique<MCTS>(evaluator_ptr_->copy(), n_game_actions_, cpuct_, temperature_);
+    }
 
-    std::vector<float> probs = mcts.search(state_ptr.get(), minimum_simulations_, duration_in_millis_);
+    std::vector<float> probs = mcts_ptr_->search(state_ptr.get(), minimum_simulations_, duration_in_millis_);
 
     float p = rl::common::get();
 
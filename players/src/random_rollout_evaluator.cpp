@@ -65,17 +65,18 @@ void RandomRolloutEvaluator::evaluate(const rl::common::IState* state_ptr, std::
         probs.emplace_back(masks.at(action) ? legal_action_prob : 0.0f);
     }
 
-    auto unique_state_ptr = std::unique_ptr<rl::common::IState>(nullptr);
+    // one copy for the whole rollout, advanced in place
+    auto rollout_state_ptr = state_ptr->clone();
+    std::vector<int> legal_actions{};
     do
     {
-        masks = state_ptr->actions_mask();
-        int action = choose_action(masks);
-        unique_state_ptr = state_ptr->step(action);
-        state_ptr = unique_state_ptr.get();
-    } while (!state_ptr->is_terminal());
+        rollout_state_ptr->legal_actions(legal_actions);
+        int action = legal_actions[rl::common::get(static_cast<int>(legal_actions.size()))];
+        rollout_state_ptr->apply(action);
+    } while (!rollout_state_ptr->is_terminal());
 
-    auto result = unique_state_ptr->get_reward();
-    int last_player = unique_state_ptr->player_turn();
+    auto result = rollout_state_ptr->get_reward();
+    int last_player = rollout_state_ptr->player_turn();
     if (last_player != starting_player)
     {
         result = -result;
@@ -4,30 +4,46 @@
 //   bench_migoyugo_bb perft  [depth]           node counts from the empty board, both engines
 //   bench_migoyugo_bb speed  [depth]           make/unmake throughput of the bitboard engine
 //   bench_migoyugo_bb search [depth] [weights] NNUE search nodes/second
+//   bench_migoyugo_bb smp    [ms] [weights]    Lazy SMP scaling at 1/2/4/8/16 threads
 //   bench_migoyugo_bb forced [depth] [weights] forced-move rule claims verified exhaustively
-//   bench_migoyugo_bb determinism [depth] [weights] two identical searches must agree exactly
+//   bench_migoyugo_bb determinism [depth] [weights] identical searches must agree exactly, at every SIMD level
 //   bench_migoyugo_bb match [ms] [games]       v1 vs v2 head to head at equal time
+//   bench_migoyugo_bb refresh [games] [weights] refresh cache vs build_accumulator
+//   bench_migoyugo_bb tt     [depth] [weights] search speed, TT of 16 MB to 4 GB, huge pages on/off
 //   bench_migoyugo_bb all                      diff 20000, perft 4, speed 5
 //
 // MigoyugoLightState is the reference implementation of the rules. Nothing
 // downstream should trust the bitboard engine until `diff` reports zero
 // mismatches.
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <new>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <games/migoyugo_bb.hpp>
 #include <games/migoyugo_light.hpp>
+#include <nnue/nnue_eval_v2_kernels.hpp>
+#include <nnue/nnue_layerstacks_eval_v2.hpp>
 #include <nnue/nnue_layerstacks_model.hpp>
 #include <nnue/nnue_layerstacks_player.hpp>
 #include <nnue/nnue_layerstacks_model_v2.hpp>
 #include <nnue/nnue_layerstacks_player_v2.hpp>
+#include <nnue/nnue_refresh_cache_v2.hpp>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
 
 using rl::games::MigoyugoLightState;
 using namespace rl::games::mgbb;
@@ -404,6 +420,154 @@ std::vector<MigoyugoBB> sample_positions(int count, int min_ply, int max_ply)
     return out;
 }
 
+// The head of the network as plain loops, the way evaluate_accumulator
+// computed it before the L3 and output kernels. Every kernel level must match
+// it exactly.
+int32_t reference_l3(const NNUELayerStacksModelV2& model, int bucket, const int32_t* l2_out, int32_t* l3_out)
+{
+    for (int i = 0; i < 32; ++i)
+    {
+        int32_t total = model.l3_bias[bucket][i];
+        for (int j = 0; j < 16; ++j) total += model.l3_weights[bucket][i][j] * l2_out[j];
+        l3_out[i] = std::clamp(total >> 7, 0, 127);
+    }
+    return 0;
+}
+
+int32_t reference_output(const NNUELayerStacksModelV2& model, int bucket, const int32_t* l3_out)
+{
+    int32_t final_sum = model.out_bias[bucket];
+    for (int i = 0; i < 32; ++i) final_sum += model.out_weights[bucket][i] * l3_out[i];
+    return final_sum;
+}
+
+int32_t reference_evaluate(const NNUELayerStacksModelV2& model, const int16_t* accumulator, int bucket)
+{
+    int32_t l2_out[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        int32_t total = model.l2_bias[bucket][i];
+        for (int j = 0; j < 256; ++j)
+            total += model.l2_weights[bucket][i][j] * std::clamp<int32_t>(accumulator[j], 0, 127);
+        l2_out[i] = std::clamp(total >> 7, 0, 127);
+    }
+    int32_t l3_out[32];
+    reference_l3(model, bucket, l2_out, l3_out);
+    return reference_output(model, bucket, l3_out);
+}
+
+// Random accumulators, wide enough to exercise both ends of every clamp,
+// through every bucket at the active kernel level.
+int check_evaluation(const NNUELayerStacksModelV2& model, int n_accumulators)
+{
+    std::uniform_int_distribution<int> value(-400, 400);
+    alignas(64) int16_t accumulator[256];
+    int mismatches = 0;
+    for (int n = 0; n < n_accumulators; ++n)
+    {
+        for (int j = 0; j < 256; ++j) accumulator[j] = static_cast<int16_t>(value(rng));
+        for (int bucket = 0; bucket < NNUELayerStacksModelV2::NUM_BUCKETS; ++bucket)
+        {
+            const int32_t expected = reference_evaluate(model, accumulator, bucket);
+            const int32_t got = rl::nnue::evaluate_accumulator(model, accumulator, bucket);
+            if (expected != got)
+            {
+                if (mismatches < 5)
+                    std::printf("  accumulator %d bucket %d: %d vs reference %d\n", n, bucket, got, expected);
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Best of a few passes of `calls` calls of fn(i) for i cycling through
+// [0, n_inputs), in TSC cycles per call. The TSC ticks at the nominal clock,
+// so with turbo these are ratios between layers more than core cycles.
+template <typename F>
+double cycles_per_call(int n_inputs, F&& fn)
+{
+    constexpr int REPEATS = 2000;
+    double best = 1e30;
+    for (int pass = 0; pass < 5; ++pass)
+    {
+        const uint64_t t0 = __rdtsc();
+        for (int r = 0; r < REPEATS; ++r)
+            for (int i = 0; i < n_inputs; ++i) fn(i);
+        const uint64_t t1 = __rdtsc();
+        best = std::min(best, static_cast<double>(t1 - t0) / (static_cast<double>(REPEATS) * n_inputs));
+    }
+    return best;
+}
+
+// Where an evaluation's time goes, layer by layer, over the side-to-move
+// accumulators of the given positions. The scalar columns are the reference
+// loops above.
+void print_layer_breakdown(const NNUELayerStacksModelV2& model, const std::vector<MigoyugoBB>& positions)
+{
+    const int n = static_cast<int>(positions.size());
+    struct Input
+    {
+        alignas(64) int16_t perspective[2][256];
+        alignas(32) int32_t l2_out[16];
+        alignas(32) int32_t l3_out[32];
+        alignas(32) int16_t l3_out16[32];
+        int stm;
+        int bucket;
+    };
+    std::vector<Input> inputs(n);
+    const rl::nnue::EvalV2Kernels& kernels = rl::nnue::eval_v2_kernels();
+    for (int i = 0; i < n; ++i)
+    {
+        Input& in = inputs[i];
+        rl::nnue::build_accumulator(model, positions[i], in.perspective);
+        in.stm = positions[i].stm;
+        in.bucket = rl::nnue::compute_bucket_index(positions[i]);
+        kernels.l2(in.perspective[in.stm], model.l2_weights[in.bucket][0].data(), model.l2_bias[in.bucket].data(), in.l2_out);
+        reference_l3(model, in.bucket, in.l2_out, in.l3_out);
+        for (int j = 0; j < 32; ++j) in.l3_out16[j] = static_cast<int16_t>(in.l3_out[j]);
+    }
+
+    volatile int32_t sink = 0;
+    alignas(32) int32_t l2_scratch[16];
+    alignas(32) int32_t l3_scratch[32];
+    alignas(32) int16_t l3_scratch16[32];
+
+    const double l2 = cycles_per_call(n, [&](int i) {
+        const Input& in = inputs[i];
+        kernels.l2(in.perspective[in.stm], model.l2_weights[in.bucket][0].data(), model.l2_bias[in.bucket].data(), l2_scratch);
+        sink = sink + l2_scratch[0];
+    });
+    const double l3 = cycles_per_call(n, [&](int i) {
+        const Input& in = inputs[i];
+        kernels.l3(in.l2_out, model.l3_weights_interleaved[in.bucket].data(), model.l3_bias[in.bucket].data(), l3_scratch16);
+        sink = sink + l3_scratch16[0];
+    });
+    const double l3_scalar = cycles_per_call(n, [&](int i) {
+        const Input& in = inputs[i];
+        reference_l3(model, in.bucket, in.l2_out, l3_scratch);
+        sink = sink + l3_scratch[0];
+    });
+    const double out = cycles_per_call(n, [&](int i) {
+        const Input& in = inputs[i];
+        sink = sink + kernels.output(in.l3_out16, model.out_weights[in.bucket].data(), model.out_bias[in.bucket]);
+    });
+    const double out_scalar = cycles_per_call(n, [&](int i) {
+        const Input& in = inputs[i];
+        sink = sink + reference_output(model, in.bucket, in.l3_out);
+    });
+    const double total = cycles_per_call(n, [&](int i) {
+        const Input& in = inputs[i];
+        sink = sink + rl::nnue::evaluate_accumulator(model, in.perspective[in.stm], in.bucket);
+    });
+
+    std::printf("  per evaluation, TSC cycles:\n");
+    std::printf("    l2     crelu + 256 -> 16  %7.1f\n", l2);
+    std::printf("    l3     16 -> 32           %7.1f   (scalar %.1f)\n", l3, l3_scalar);
+    std::printf("    output 32 -> 1            %7.1f   (scalar %.1f)\n", out, out_scalar);
+    std::printf("    evaluate_accumulator      %7.1f\n", total);
+}
+
 int run_search(int depth, const std::string& weights)
 {
     auto model = load_nnue_layerstacks_v2(weights);
@@ -426,10 +590,57 @@ int run_search(int depth, const std::string& weights)
         total_nodes += player->nodes();
     }
 
-    std::printf("\nNNUE search, depth %d over %zu positions\n", depth, positions.size());
+    std::printf("\nNNUE search, depth %d over %zu positions, %s kernels\n", depth, positions.size(),
+        rl::nnue::simd_level_name(rl::nnue::eval_v2_kernels().level));
     std::printf("  %llu nodes in %.3fs = %.0f nodes/s\n",
         (unsigned long long)total_nodes, total_secs,
         total_secs > 0 ? total_nodes / total_secs : 0.0);
+    print_layer_breakdown(*model, positions);
+    return 0;
+}
+
+// Lazy SMP scaling. Fixed-depth search is single-threaded by design, so this
+// runs the timed search instead and reports what threads actually buy: total
+// nodes per second across all of them, and the depth the main thread reached
+// in the same budget. Every thread count sees the same positions from an
+// empty table.
+int run_smp(int ms_per_position, const std::string& weights)
+{
+    auto model = load_nnue_layerstacks_v2(weights);
+    if (!model) return 1;
+
+    auto player = std::make_unique<rl::players::NNUELayerStacksPlayerV2>(
+        model, std::chrono::duration<int, std::milli>(ms_per_position), 64, false);
+
+    const auto positions = sample_positions(12, 8, 40);
+
+    std::printf("\nLazy SMP, %d ms per position over %zu positions (%u hardware threads)\n",
+        ms_per_position, positions.size(), std::thread::hardware_concurrency());
+    std::printf("  threads        nodes/s   speedup   mean depth\n");
+
+    double base_nps = 0;
+    for (int threads : { 1, 2, 4, 8, 16 })
+    {
+        player->set_threads(threads);
+
+        uint64_t total_nodes = 0;
+        double total_secs = 0;
+        int total_depth = 0;
+        for (const auto& pos : positions)
+        {
+            player->clear_tt();
+            player->search_position(pos);
+            total_nodes += player->nodes();
+            total_secs += player->last_elapsed_s();
+            total_depth += player->last_depth();
+        }
+
+        const double nps = total_secs > 0 ? total_nodes / total_secs : 0.0;
+        if (threads == 1) base_nps = nps;
+        std::printf("  %7d  %13.0f   %6.2fx   %10.2f\n", threads, nps,
+            base_nps > 0 ? nps / base_nps : 0.0,
+            static_cast<double>(total_depth) / positions.size());
+    }
     return 0;
 }
 
@@ -520,7 +731,9 @@ int run_forced(int depth, const std::string& weights)
 
 // Two identically configured searches must return identical scores and visit
 // identical node counts; anything else means hidden state is leaking between
-// searches and every other comparison in this file is meaningless.
+// searches and every other comparison in this file is meaningless. The same
+// then holds across the evaluation kernels: every SIMD level this CPU has must
+// reproduce the SSE search exactly.
 int run_determinism(int depth, const std::string& weights)
 {
     auto model = load_nnue_layerstacks_v2(weights);
@@ -532,28 +745,224 @@ int run_determinism(int depth, const std::string& weights)
         model, std::chrono::duration<int, std::milli>(3600000), 32, false);
 
     const auto positions = sample_positions(200, 6, 60);
-    int mismatches = 0;
+
+    rl::nnue::set_simd_level(rl::nnue::SimdLevel::SSE);
+    std::vector<int> ref_scores(positions.size());
+    std::vector<uint64_t> ref_nodes(positions.size());
     for (size_t i = 0; i < positions.size(); ++i)
     {
         a->clear_tt();
-        b->clear_tt();
-        const int sa = a->search_fixed_depth(positions[i], depth);
-        const uint64_t na = a->nodes();
-        const int sb = b->search_fixed_depth(positions[i], depth);
-        const uint64_t nb = b->nodes();
-        if (sa != sb || na != nb)
+        ref_scores[i] = a->search_fixed_depth(positions[i], depth);
+        ref_nodes[i] = a->nodes();
+    }
+
+    int failures = 0;
+    const rl::nnue::SimdLevel levels[] = {
+        rl::nnue::SimdLevel::SSE, rl::nnue::SimdLevel::AVX2, rl::nnue::SimdLevel::AVX512 };
+    for (const auto level : levels)
+    {
+        if (!rl::nnue::set_simd_level(level))
+        {
+            std::printf("\n%s: not supported here, skipped\n", rl::nnue::simd_level_name(level));
+            continue;
+        }
+        int mismatches = 0;
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            b->clear_tt();
+            const int sb = b->search_fixed_depth(positions[i], depth);
+            const uint64_t nb = b->nodes();
+            if (ref_scores[i] != sb || ref_nodes[i] != nb)
+            {
+                if (mismatches < 5)
+                    std::printf("  position %zu: %d/%llu vs %d/%llu\n", i, ref_scores[i],
+                        (unsigned long long)ref_nodes[i], sb, (unsigned long long)nb);
+                ++mismatches;
+            }
+        }
+        std::printf("\ndeterminism at depth %d over %zu positions, %s vs sse: %s (%d mismatches)\n",
+            depth, positions.size(), rl::nnue::simd_level_name(level),
+            mismatches ? "FAILED" : "PASSED", mismatches);
+        failures += mismatches ? 1 : 0;
+
+        const int n_accumulators = 2000;
+        const int eval_mismatches = check_evaluation(*model, n_accumulators);
+        std::printf("evaluation of %d random accumulators x %d buckets, %s vs scalar reference: %s (%d mismatches)\n",
+            n_accumulators, NNUELayerStacksModelV2::NUM_BUCKETS, rl::nnue::simd_level_name(level),
+            eval_mismatches ? "FAILED" : "PASSED", eval_mismatches);
+        failures += eval_mismatches ? 1 : 0;
+    }
+    rl::nnue::set_simd_level(rl::nnue::detected_simd_level());
+    return failures ? 1 : 0;
+}
+
+
+// AccumulatorRefreshCache against build_accumulator on the same positions:
+// every other position of random games, in game order as a player's search
+// roots arrive, then the same positions shuffled, where consecutive positions
+// have nothing in common. The cache must match the full rebuild exactly.
+int run_refresh(int n_games, const std::string& weights)
+{
+    auto model = load_nnue_layerstacks_v2(weights);
+    if (!model) return 1;
+
+    std::vector<MigoyugoBB> in_order;
+    for (int g = 0; g < n_games; ++g)
+    {
+        MigoyugoBB s = MigoyugoBB::initial();
+        for (int ply = 0; s.legal_moves() != 0; ++ply)
         {
-            if (mismatches < 5)
-                std::printf("  position %zu: %d/%llu vs %d/%llu\n", i, sa,
-                    (unsigned long long)na, sb, (unsigned long long)nb);
-            ++mismatches;
+            if ((ply & 1) == 0) in_order.push_back(s);
+            std::vector<int> moves;
+            for (uint64_t b = s.legal_moves(); b; b &= b - 1) moves.push_back(ctz64(b));
+            Undo u;
+            if (s.do_move(moves[rng() % moves.size()], u)) break;
         }
     }
-    std::printf("\ndeterminism at depth %d over %zu positions: %s (%d mismatches)\n",
-        depth, positions.size(), mismatches ? "FAILED" : "PASSED", mismatches);
+    std::vector<MigoyugoBB> shuffled = in_order;
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+
+    alignas(64) int16_t expected[2][256];
+    alignas(64) int16_t got[2][256];
+    int mismatches = 0;
+    const auto measure = [&](const char* name, const std::vector<MigoyugoBB>& positions)
+    {
+        constexpr int REPEATS = 20;
+        volatile int16_t sink = 0;
+
+        long long n_features = 0;
+        const auto t0 = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < REPEATS; ++r)
+            for (const auto& pos : positions)
+            {
+                rl::nnue::build_accumulator(*model, pos, expected);
+                sink = sink + expected[pos.stm][0];
+            }
+        const auto t1 = std::chrono::high_resolution_clock::now();
+        uint16_t features[192];
+        for (const auto& pos : positions) n_features += pos.active_features(features);
+
+        rl::nnue::AccumulatorRefreshCache cache;
+        const auto t2 = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < REPEATS; ++r)
+            for (const auto& pos : positions)
+            {
+                cache.refresh(*model, pos, got);
+                sink = sink + got[pos.stm][0];
+            }
+        const auto t3 = std::chrono::high_resolution_clock::now();
+
+        for (const auto& pos : positions)
+        {
+            rl::nnue::build_accumulator(*model, pos, expected);
+            cache.refresh(*model, pos, got);
+            if (std::memcmp(expected, got, sizeof(expected)) != 0) ++mismatches;
+        }
+
+        const double calls = static_cast<double>(REPEATS) * positions.size();
+        const double full_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / calls;
+        const double cache_ns = std::chrono::duration<double, std::nano>(t3 - t2).count() / calls;
+        const long long served = cache.updates() + cache.rebuilds();
+        std::printf("  %-9s build_accumulator %7.1f ns, %5.1f rows | refresh cache %7.1f ns, %5.1f rows, "
+            "%4.1f%% from an entry | %.2fx\n",
+            name, full_ns, static_cast<double>(n_features) / positions.size(),
+            cache_ns, static_cast<double>(cache.rows()) / served,
+            100.0 * cache.updates() / served, cache_ns > 0 ? full_ns / cache_ns : 0.0);
+    };
+
+    std::printf("\nrefresh cache over %zu positions from %d games (rows per perspective):\n",
+        in_order.size(), n_games);
+    measure("in order", in_order);
+    measure("shuffled", shuffled);
+
+    // New weights written into the same model, at the same address: the cache
+    // must notice through the generation and not serve the old accumulators.
+    {
+        auto reloaded = make_nnue_layerstacks_v2();
+        *reloaded = *model;
+        rl::nnue::AccumulatorRefreshCache cache;
+        for (const auto& pos : in_order) cache.refresh(*reloaded, pos, got);
+        for (auto& bias : reloaded->l1_bias) bias = static_cast<int16_t>(bias + 1);
+        prepare_nnue_layerstacks_v2(*reloaded);
+        for (const auto& pos : in_order)
+        {
+            rl::nnue::build_accumulator(*reloaded, pos, expected);
+            cache.refresh(*reloaded, pos, got);
+            if (std::memcmp(expected, got, sizeof(expected)) != 0) ++mismatches;
+        }
+    }
+    std::printf("refresh cache vs build_accumulator: %s (%d mismatches)\n",
+        mismatches ? "FAILED" : "PASSED", mismatches);
     return mismatches ? 1 : 0;
 }
 
+// Anonymous memory the kernel currently backs with huge pages, in MB, or -1
+// where /proc/self/smaps_rollup does not exist.
+long long anon_huge_pages_mb()
+{
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string field;
+    while (smaps >> field)
+    {
+        if (field == "AnonHugePages:")
+        {
+            long long kb = 0;
+            smaps >> kb;
+            return kb / 1024;
+        }
+    }
+    return -1;
+}
+
+// The same fixed-depth searches with transposition tables from 16 MB to 4 GB,
+// on huge pages and on ordinary ones. Each table is cleared once before the
+// clock starts, which also faults every page in, and is then shared by all the
+// positions, so the larger tables do see probes spread over all of them.
+int run_tt(int depth, const std::string& weights)
+{
+    auto model = load_nnue_layerstacks_v2(weights);
+    if (!model) return 1;
+
+    const auto positions = sample_positions(24, 8, 40);
+    const size_t sizes_mb[] = { 16, 64, 256, 1024, 4096 };
+
+    std::printf("\nNNUE search, depth %d over %zu positions, by TT size\n", depth, positions.size());
+    for (const size_t mb : sizes_mb)
+    {
+        for (const bool huge : { false, true })
+        {
+            std::unique_ptr<rl::players::NNUELayerStacksPlayerV2> player;
+            try
+            {
+                player = std::make_unique<rl::players::NNUELayerStacksPlayerV2>(
+                    model, std::chrono::duration<int, std::milli>(3600000), 16, false);
+                player->resize_tt(mb, huge);
+            }
+            catch (const std::bad_alloc&)
+            {
+                std::printf("  %5zu MB %-10s  not enough memory, skipped\n", mb, huge ? "huge" : "4 KB");
+                continue;
+            }
+            player->clear_tt();
+
+            uint64_t total_nodes = 0;
+            double total_secs = 0;
+            for (const auto& pos : positions)
+            {
+                const auto t0 = std::chrono::high_resolution_clock::now();
+                player->search_fixed_depth(pos, depth);
+                const auto t1 = std::chrono::high_resolution_clock::now();
+                total_secs += std::chrono::duration<double>(t1 - t0).count();
+                total_nodes += player->nodes();
+            }
+            std::printf("  %5zu MB %-10s %10llu nodes  %9.0f nodes/s   %lld MB on huge pages\n",
+                mb, huge ? (player->tt_huge_pages() ? "huge" : "huge (n/a)") : "4 KB",
+                (unsigned long long)total_nodes, total_secs > 0 ? total_nodes / total_secs : 0.0,
+                anon_huge_pages_mb());
+        }
+    }
+    return 0;
+}
 
 // Head to head between the old layer-stacks player and the new one, at equal
 // time per move, colours alternating, from randomised short openings so the
@@ -663,8 +1072,11 @@ int main(int argc, char** argv)
     else if (mode == "perft") failures += run_perft(arg ? arg : 4);
     else if (mode == "speed") run_speed(arg ? arg : 5);
     else if (mode == "search") failures += run_search(arg ? arg : 6, weights);
+    else if (mode == "smp") failures += run_smp(arg ? arg : 1000, weights);
     else if (mode == "forced") failures += run_forced(arg ? arg : 5, weights);
     else if (mode == "determinism") failures += run_determinism(arg ? arg : 5, weights);
+    else if (mode == "tt") failures += run_tt(arg ? arg : 6, weights);
+    else if (mode == "refresh") failures += run_refresh(arg ? arg : 200, weights);
     else if (mode == "match")
     {
         const int games = argc > 3 ? std::atoi(argv[3]) : 40;
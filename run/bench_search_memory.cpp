@@ -0,0 +1,104 @@
+// Tree build time and peak memory of the generic searches.
+//
+//   bench_search_memory <uct|mcts|amcts2> [sims] [game] [budget_mb]
+//
+// Builds one tree of `sims` simulations from the opening of `game` (othello,
+// santorini, walls, uttt; othello by default) and prints the time it took and
+// the process's peak resident set. Peak RSS only ever goes up, so it is one
+// search per process: run the modes one by one. MCTS and Amcts2 get a
+// RandomEvaluator, which costs next to nothing, so what is timed is the tree
+// itself; UCT always pays for its rollouts. `budget_mb` caps the tree, 0 keeps
+// the search's default; a capped search may stop short of `sims`, and the count
+// it prints itself is the one to go by.
+//
+// Torch-free, like the other bench_* targets.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include <sys/resource.h>
+
+#include <games/othello.hpp>
+#include <games/santorini.hpp>
+#include <games/ultimate_tictactoe.hpp>
+#include <games/walls.hpp>
+#include <players/bandits/amcts2/amcts2.hpp>
+#include <players/bandits/uct/uct.hpp>
+#include <players/mcts.hpp>
+#include <players/random_evaluator.hpp>
+
+namespace
+{
+
+using Milliseconds = std::chrono::duration<int, std::milli>;
+
+long peak_rss_kb()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+std::unique_ptr<rl::common::IState> initial_state(const std::string& game)
+{
+    if (game == "santorini") return rl::games::SantoriniState::initialize_state();
+    if (game == "walls") return rl::games::WallsState::initialize_state();
+    if (game == "uttt") return rl::games::UltimateTicTacToeState::initialize_state();
+    return rl::games::OthelloState::initialize_state();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::printf("usage: bench_search_memory <uct|mcts|amcts2> [sims] [game] [budget_mb]\n");
+        return 2;
+    }
+    const std::string mode = argv[1];
+    const int sims = argc > 2 ? std::atoi(argv[2]) : 100000;
+    const std::string game = argc > 3 ? argv[3] : "othello";
+    const int budget_mb = argc > 4 ? std::atoi(argv[4]) : 0;
+
+    auto state = initial_state(game);
+    const int n_actions = state->get_n_actions();
+
+    std::unique_ptr<rl::players::ISearchTree> tree{};
+    if (mode == "uct")
+    {
+        auto uct = std::make_unique<rl::players::UctSearchTree>(n_actions, 1.41f, 1.0f);
+        if (budget_mb > 0) uct->set_memory_budget_mb(budget_mb);
+        tree = std::move(uct);
+    }
+    else if (mode == "mcts")
+    {
+        auto mcts = std::make_unique<rl::players::MCTS>(std::make_unique<rl::players::RandomEvaluator>(n_actions), n_actions, 2.0f, 1.0f);
+        if (budget_mb > 0) mcts->set_memory_budget_mb(budget_mb);
+        tree = std::move(mcts);
+    }
+    else if (mode == "amcts2")
+    {
+        auto amcts2 = std::make_unique<rl::players::Amcts2>(n_actions, std::make_unique<rl::players::RandomEvaluator>(n_actions), 2.0f, 1.0f, 16, 0.0f, 0.3f, 1.0f, 0.0f);
+        if (budget_mb > 0) amcts2->set_memory_budget_mb(budget_mb);
+        tree = std::move(amcts2);
+    }
+    else
+    {
+        std::printf("unknown search %s\n", mode.c_str());
+        return 2;
+    }
+
+    const long rss_before = peak_rss_kb();
+    const auto t0 = std::chrono::steady_clock::now();
+    tree->search(state.get(), sims, Milliseconds(0));
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const long rss_after = peak_rss_kb();
+
+    std::printf("%-7s %-10s %8d sims %8.3f s %10.0f sims/s  peak RSS %8ld KB (+%ld KB for the tree)\n",
+        mode.c_str(), game.c_str(), sims, seconds, sims / seconds, rss_after, rss_after - rss_before);
+    return 0;
+}
@@ -0,0 +1,226 @@
+// Correctness and throughput harness for the compile-time searches in
+// players/bandits/static_mcts and the value-type games they run on.
+//
+//   bench_static_mcts diff  [games]          value games vs their IState, move by move
+//   bench_static_mcts speed [sims] [game]    sims/s, StaticUct vs UctSearchTree
+//   bench_static_mcts all                    diff + speed
+//
+// Torch-free like bench_migoyugo_bb. `game` is one of othello, santorini,
+// walls, uttt, migoyugo; all of them when left out.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <common/state.hpp>
+#include <games/migoyugo_bb.hpp>
+#include <games/migoyugo_light.hpp>
+#include <games/othello.hpp>
+#include <games/othello_bb.hpp>
+#include <games/santorini.hpp>
+#include <games/santorini_bb.hpp>
+#include <games/ultimate_tictactoe.hpp>
+#include <games/ultimate_tictactoe_bb.hpp>
+#include <games/walls.hpp>
+#include <games/walls_bb.hpp>
+#include <players/bandits/static_mcts/static_puct.hpp>
+#include <players/bandits/static_mcts/static_search_tree.hpp>
+#include <players/bandits/static_mcts/static_uct.hpp>
+#include <players/bandits/uct/uct.hpp>
+
+using rl::common::IState;
+
+namespace
+{
+
+using Milliseconds = std::chrono::duration<int, std::milli>;
+
+constexpr float CUCT = 1.41f;
+constexpr float TEMPERATURE = 1.0f;
+
+std::mt19937_64 rng(0x57a71cULL);
+
+int random_index(int n)
+{
+    return static_cast<int>(rng() % static_cast<uint64_t>(n));
+}
+
+// ------------------------------------------------------------------- diff ---
+
+template <class Game>
+bool same_moves(const Game& game, const IState& state, std::vector<int>& state_actions)
+{
+    int actions[Game::N_ACTIONS];
+    const int n_actions = game.legal_actions(actions);
+    state.legal_actions(state_actions);
+    return std::vector<int>(actions, actions + n_actions) == state_actions;
+}
+
+// Plays random games on both representations and checks that they agree on
+// everything the searches ask for, and that from_short reads every non
+// terminal position back into one that plays the same.
+template <class Game>
+int diff_game(const char* name, std::unique_ptr<IState> initial, int n_games)
+{
+    int mismatches = 0;
+    long long plies = 0;
+    std::vector<int> state_actions{};
+    for (int g = 0; g < n_games; g++)
+    {
+        std::unique_ptr<IState> state = initial->clone();
+        Game game = Game::initial();
+        while (true)
+        {
+            plies++;
+            bool ok = game.is_terminal() == state->is_terminal() && game.player_turn() == state->player_turn();
+            if (ok && game.is_terminal())
+            {
+                ok = game.get_reward() == state->get_reward();
+            }
+            if (ok && !game.is_terminal())
+            {
+                ok = same_moves(game, *state, state_actions);
+                const Game parsed = Game::from_short(state->to_short());
+                ok = ok && !parsed.is_terminal() && parsed.player_turn() == state->player_turn() && same_moves(parsed, *state, state_actions);
+            }
+            if (!ok)
+            {
+                if (mismatches++ < 5)
+                {
+                    std::printf("  %s game %d ply %lld mismatch at\n%s\n", name, g, plies, state->to_short().c_str());
+                }
+                break;
+            }
+            if (game.is_terminal())
+            {
+                break;
+            }
+            const int action = state_actions[random_index(static_cast<int>(state_actions.size()))];
+            state->apply(action);
+            game.apply(action);
+        }
+    }
+    std::printf("%-10s %6d games %8lld plies %d mismatches\n", name, n_games, plies, mismatches);
+    return mismatches;
+}
+
+// ------------------------------------------------------------------ speed ---
+
+// Non terminal positions reached by random play, so the searches are timed on
+// middlegames as well as on the opening.
+std::vector<std::unique_ptr<IState>> sample_positions(const IState& initial, int count, int max_ply)
+{
+    std::vector<std::unique_ptr<IState>> positions{};
+    std::vector<int> actions{};
+    while (static_cast<int>(positions.size()) < count)
+    {
+        std::unique_ptr<IState> state = initial.clone();
+        const int plies = random_index(max_ply + 1);
+        for (int ply = 0; ply < plies && !state->is_terminal(); ply++)
+        {
+            state->legal_actions(actions);
+            state->apply(actions[random_index(static_cast<int>(actions.size()))]);
+        }
+        if (!state->is_terminal())
+        {
+            positions.push_back(std::move(state));
+        }
+    }
+    return positions;
+}
+
+// sims/s over all positions; also checks the probabilities only cover legal actions
+double time_search(rl::players::ISearchTree& tree, const std::vector<std::unique_ptr<IState>>& positions, int sims, bool& legal)
+{
+    std::vector<int> actions{};
+    const auto t0 = std::chrono::steady_clock::now();
+    for (const auto& state : positions)
+    {
+        const std::vector<float> probs = tree.search(state.get(), sims, Milliseconds(0));
+        std::vector<bool> mask = state->actions_mask();
+        float sum = 0.0f;
+        for (size_t a = 0; a < probs.size(); a++)
+        {
+            sum += probs[a];
+            legal = legal && (probs[a] == 0.0f || mask[a]);
+        }
+        legal = legal && std::fabs(sum - 1.0f) < 1e-3f;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return double(sims) * positions.size() / seconds;
+}
+
+template <class Game>
+void speed_game(const char* name, std::unique_ptr<IState> initial, int sims, int max_ply)
+{
+    constexpr int N_POSITIONS = 20;
+    const auto positions = sample_positions(*initial, N_POSITIONS, max_ply);
+
+    rl::players::UctSearchTree uct{ initial->get_n_actions(), CUCT, TEMPERATURE };
+    rl::players::StaticSearchTree<rl::players::StaticUct<Game>> static_uct{ CUCT, TEMPERATURE };
+    rl::players::StaticSearchTree<rl::players::StaticPuct<Game>> static_puct{ CUCT, TEMPERATURE };
+
+    bool legal = true;
+    const double uct_rate = time_search(uct, positions, sims, legal);
+    const double static_uct_rate = time_search(static_uct, positions, sims, legal);
+    const double static_puct_rate = time_search(static_puct, positions, sims, legal);
+    std::printf("%-10s UctSearchTree %10.0f sims/s  StaticUct %10.0f sims/s (x%.2f)  StaticPuct %10.0f sims/s%s\n",
+        name, uct_rate, static_uct_rate, static_uct_rate / uct_rate, static_puct_rate, legal ? "" : "  ILLEGAL PROBABILITIES");
+}
+
+// -------------------------------------------------------------------- run ---
+
+bool selected(const char* filter, const char* name)
+{
+    return filter == nullptr || std::strcmp(filter, name) == 0;
+}
+
+int run_diff(int n_games)
+{
+    int mismatches = 0;
+    mismatches += diff_game<rl::games::OthelloBB>("othello", rl::games::OthelloState::initialize_state(), n_games);
+    mismatches += diff_game<rl::games::SantoriniBB>("santorini", rl::games::SantoriniState::initialize_state(), n_games);
+    mismatches += diff_game<rl::games::WallsBB>("walls", rl::games::WallsState::initialize_state(), n_games);
+    mismatches += diff_game<rl::games::UltimateTicTacToeBB>("uttt", rl::games::UltimateTicTacToeState::initialize_state(), n_games);
+    mismatches += diff_game<rl::games::mgbb::MigoyugoGame>("migoyugo", rl::games::MigoyugoLightState::initialize_state(), n_games);
+    return mismatches;
+}
+
+void run_speed(int sims, const char* filter)
+{
+    if (selected(filter, "othello")) speed_game<rl::games::OthelloBB>("othello", rl::games::OthelloState::initialize_state(), sims, 40);
+    if (selected(filter, "santorini")) speed_game<rl::games::SantoriniBB>("santorini", rl::games::SantoriniState::initialize_state(), sims, 20);
+    if (selected(filter, "walls")) speed_game<rl::games::WallsBB>("walls", rl::games::WallsState::initialize_state(), sims, 12);
+    if (selected(filter, "uttt")) speed_game<rl::games::UltimateTicTacToeBB>("uttt", rl::games::UltimateTicTacToeState::initialize_state(), sims, 30);
+    if (selected(filter, "migoyugo")) speed_game<rl::games::mgbb::MigoyugoGame>("migoyugo", rl::games::MigoyugoLightState::initialize_state(), sims, 30);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::string mode = argc > 1 ? argv[1] : "all";
+    if (mode == "diff")
+    {
+        return run_diff(argc > 2 ? std::atoi(argv[2]) : 200) == 0 ? 0 : 1;
+    }
+    if (mode == "speed")
+    {
+        run_speed(argc > 2 ? std::atoi(argv[2]) : 2000, argc > 3 ? argv[3] : nullptr);
+        return 0;
+    }
+    if (mode == "all")
+    {
+        const int mismatches = run_diff(200);
+        run_speed(2000, nullptr);
+        return mismatches == 0 ? 0 : 1;
+    }
+    std::printf("usage: bench_static_mcts diff [games] | speed [sims] [game] | all\n");
+    return 2;
+}
@@ -0,0 +1,126 @@
+// Checks that a RoundRobin spread over worker threads ends with the same table
+// as one played on the calling thread.
+//
+//   check_round_robin [sets] [threads]
+//
+// Five players, so every round has a bye, play othello from the initial state
+// and then from a small opening suite. Each player picks its move from the
+// position's hash alone, so a game's result does not depend on which thread
+// plays it, and with the schedule seeded the same way the serial and threaded
+// runs must agree on every win, draw and loss. Exits non-zero when they don't.
+//
+// Torch-free, like the bench_* targets.
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <common/opening_suite.hpp>
+#include <common/player.hpp>
+#include <common/random.hpp>
+#include <common/round_robin.hpp>
+#include <games/othello.hpp>
+
+using rl::common::IPlayer;
+using rl::common::IState;
+
+namespace
+{
+
+constexpr int N_PLAYERS = 5;
+constexpr uint32_t SCHEDULE_SEED = 0x5eed;
+
+// Deterministic and stateless: the same position always gets the same move.
+class HashPlayer : public IPlayer
+{
+public:
+    explicit HashPlayer(uint64_t salt)
+        : salt_{ salt }
+    {
+    }
+
+    int choose_action(const std::unique_ptr<IState>& state_ptr) override
+    {
+        state_ptr->legal_actions(legal_actions_);
+        uint64_t mixed = (state_ptr->hash() ^ salt_) * 0x9e3779b97f4a7c15ULL;
+        return legal_actions_.at(static_cast<size_t>((mixed >> 32) % legal_actions_.size()));
+    }
+
+private:
+    uint64_t salt_;
+    std::vector<int> legal_actions_{};
+};
+
+rl::common::OpeningSuite make_suite(int n_openings, int n_plies)
+{
+    rl::common::OpeningSuite suite(rl::games::OthelloState::initialize()->game_name());
+    std::vector<int> legal_actions{};
+    for (int opening = 0; opening < n_openings; opening++)
+    {
+        auto state_ptr = rl::games::OthelloState::initialize();
+        std::vector<int> actions{};
+        for (int ply = 0; ply < n_plies; ply++)
+        {
+            state_ptr->legal_actions(legal_actions);
+            int action = legal_actions.at(static_cast<size_t>(opening * 7 + ply * 3) % legal_actions.size());
+            actions.push_back(action);
+            state_ptr->apply(action);
+        }
+        suite.add(actions);
+    }
+    return suite;
+}
+
+std::pair<std::vector<std::array<int, 3>>, std::vector<int>> play(int n_sets, int n_threads, const rl::common::OpeningSuite* suite)
+{
+    std::vector<std::unique_ptr<IPlayer>> players{};
+    std::vector<rl::common::PlayerInfo> players_info{};
+    for (int i = 0; i < N_PLAYERS; i++)
+    {
+        const uint64_t salt = 0x1000u + i;
+        players.push_back(std::make_unique<HashPlayer>(salt));
+        players_info.push_back({ players.back().get(), "hash_" + std::to_string(i),
+            [salt]() -> std::unique_ptr<IPlayer> { return std::make_unique<HashPlayer>(salt); } });
+    }
+    // the constructor shuffles the seeding with the calling thread's engine
+    rl::common::mt.seed(SCHEDULE_SEED);
+    rl::common::RoundRobin round_robin(rl::games::OthelloState::initialize(), players_info, n_sets, false, n_threads);
+    round_robin.set_opening_suite(suite);
+    return round_robin.start();
+}
+
+bool same_table(const char* label, int n_sets, int n_threads, const rl::common::OpeningSuite* suite)
+{
+    auto [serial_scores, serial_rankings] = play(n_sets, 1, suite);
+    auto [threaded_scores, threaded_rankings] = play(n_sets, n_threads, suite);
+    bool ok = serial_scores == threaded_scores && serial_rankings == threaded_rankings;
+    std::printf("%-10s %d sets, 1 vs %d threads\n", label, n_sets, n_threads);
+    for (int i = 0; i < N_PLAYERS; i++)
+    {
+        const auto& s = serial_scores.at(i);
+        const auto& t = threaded_scores.at(i);
+        std::printf("  hash_%d  %3d/%3d/%3d rank %d   %3d/%3d/%3d rank %d%s\n", i,
+            s[0], s[1], s[2], serial_rankings.at(i), t[0], t[1], t[2], threaded_rankings.at(i),
+            s == t && serial_rankings.at(i) == threaded_rankings.at(i) ? "" : "   <-- differs");
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int n_sets = argc > 1 ? std::atoi(argv[1]) : 2;
+    const int n_threads = argc > 2 ? std::atoi(argv[2]) : 2;
+
+    const rl::common::OpeningSuite suite = make_suite(6, 4);
+    bool ok = same_table("initial", n_sets, n_threads, nullptr);
+    ok = same_table("openings", n_sets, n_threads, &suite) && ok;
+
+    std::printf("check_round_robin %s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -1,4 +1,5 @@
 #include "concurrent_match_console.hpp"
+#include <algorithm>
 #include <iostream>
 #include <filesystem>
 #include <deeplearning/alphazero/networks/shared_res_nn.hpp>
@@ -11,7 +12,11 @@
 #include <games/gobblet_goblers.hpp>
 #include <games/migoyugo.hpp>
 #include <players/players.hpp>
+#include <players/batching_evaluator.hpp>
+#include <players/caching_evaluator.hpp>
 #include <common/concurrent_match.hpp>
+#include <common/sprt_match.hpp>
+#include <common/opening_suite.hpp>
 namespace rl::run
 {
 ConcurrentMatchConsole::~ConcurrentMatchConsole() = default;
@@ -46,15 +51,76 @@ void ConcurrentMatchConsole::run()
 void ConcurrentMatchConsole::start_match()
 {
     auto state_ptr = get_state_ptr();
+    std::unique_ptr<rl::common::OpeningSuite> opening_suite_ptr{ nullptr };
+    if (openings_path_ != "none")
+    {
+        opening_suite_ptr = std::make_unique<rl::common::OpeningSuite>(rl::common::OpeningSuite::load(openings_path_));
+        // before the networks load, a suite for another game fails fast
+        opening_suite_ptr->check_game(*state_ptr);
+        std::cout << "Playing " << opening_suite_ptr->size() << " " << opening_suite_ptr->game_name() << " openings from both sides" << std::endl;
+    }
     auto network_1_ptr = get_network_ptr(player_1_n_filters, player_1_fc_dims, player_1_blocks, player_1_load_name);
     auto evaluator_1_ptr = get_network_evaluator_ptr(network_1_ptr);
-    auto p1_ptr = get_concurrent_player(evaluator_1_ptr, player_1_n_sims, player_1_duration);
 
     auto network_2_ptr = get_network_ptr(player_2_n_filters, player_2_fc_dims, player_2_blocks, player_2_load_name);
     auto evaluator_2_ptr = get_network_evaluator_ptr(network_2_ptr);
-    auto p2_ptr = get_concurrent_player(evaluator_2_ptr, player_2_n_sims, player_2_duration);
+    if (n_threads_ > 1)
+    {
+        // the workers' players share one batching server per network. About half the games
+        // wait on each network at a time, with 8 async simulations apiece
+        int games_in_flight = use_sprt_ ? 2 * SPRT_PAIRS_PER_ROUND * n_threads_ : n_sets_;
+        evaluator_1_ptr = std::make_unique<rl::players::BatchingEvaluator>(std::move(evaluator_1_ptr), games_in_flight * 4, BATCH_DELAY);
+        evaluator_2_ptr = std::make_unique<rl::players::BatchingEvaluator>(std::move(evaluator_2_ptr), games_in_flight * 4, BATCH_DELAY);
+    }
+    // in front of the batching server, a hit never waits for a batch
+    std::vector<std::shared_ptr<rl::players::EvaluationCache>> caches{};
+    if (cache_entries_ > 0)
+    {
+        for (auto* evaluator_ptr : { &evaluator_1_ptr, &evaluator_2_ptr })
+        {
+            auto caching_ptr = std::make_unique<rl::players::CachingEvaluator>(std::move(*evaluator_ptr), cache_entries_, state_ptr->get_n_actions(), true);
+            caches.push_back(caching_ptr->cache());
+            *evaluator_ptr = std::move(caching_ptr);
+        }
+    }
+    auto print_cache_stats = [&caches]()
+        {
+            for (size_t i = 0; i < caches.size(); i++)
+            {
+                rl::players::EvaluationCacheStats stats = caches.at(i)->stats();
+                std::cout << "Player " << i + 1 << " evaluation cache: " << stats.n_hits << " hits of " << stats.n_lookups << " lookups ("
+                    << 100.0 * stats.hit_rate() << "%), " << stats.n_evictions << " evictions" << std::endl;
+            }
+        };
+    rl::common::ConcurrentPlayerFactory player_1_factory = [&]()
+        { return get_concurrent_player(evaluator_1_ptr, player_1_n_sims, player_1_duration); };
+    rl::common::ConcurrentPlayerFactory player_2_factory = [&]()
+        { return get_concurrent_player(evaluator_2_ptr, player_2_n_sims, player_2_duration); };
+
+    if (use_sprt_)
+    {
+        rl::common::SprtMatchConfig config{};
+        config.elo0 = sprt_elo0_;
+        config.elo1 = sprt_elo1_;
+        config.alpha = sprt_alpha_;
+        config.beta = sprt_beta_;
+        // n_sets is the most games the test may take
+        config.max_pairs = std::max(1, n_sets_ / 2);
+        config.pairs_per_round = SPRT_PAIRS_PER_ROUND;
+        config.n_threads = n_threads_;
+        rl::common::SprtMatch sprt_match(state_ptr, player_1_factory, player_2_factory, config);
+        sprt_match.set_opening_suite(opening_suite_ptr.get());
+        std::cout << "Starting the SPRT match ..." << std::endl;
+        rl::common::SprtMatchResult result = sprt_match.start();
+        std::cout << "Player 1 scored " << result.score << " over " << 2 * result.n_pairs << " games, elo " << result.elo
+            << " [" << result.elo_lower << ", " << result.elo_upper << "]" << std::endl;
+        std::cout << result.to_json() << std::endl;
+        print_cache_stats();
+        return;
+    }
 
-    auto match = rl::common::ConcurrentMatch(state_ptr, p1_ptr.get(), p2_ptr.get(), n_sets_, n_sets_);
+    auto match = rl::common::ConcurrentMatch(state_ptr, player_1_factory, player_2_factory, n_sets_, n_sets_, n_threads_);
+    match.set_opening_suite(opening_suite_ptr.get());
 
     std::cout << "Starting the match ..." << std::endl;
     auto p1_score_average = match.start();
@@ -63,6 +129,11 @@ void ConcurrentMatchConsole::start_match()
 
     std::cout << "1st Player inside game win ratio is " << match.get_ingame_p0_winrate() << std::endl;
 
+    const rl::common::ConcurrentMatchStats& stats = match.get_stats();
+    std::cout << stats.games_per_second << " games/s, move latency p50 " << stats.move_latency_p50_ms << " ms, p90 " << stats.move_latency_p90_ms
+        << " ms, p99 " << stats.move_latency_p99_ms << " ms over " << stats.n_moves << " moves" << std::endl;
+    print_cache_stats();
+
 
 }
 
@@ -102,6 +173,17 @@ void ConcurrentMatchConsole::print_current_settings()
     }
 
     std::cout << "[Number of sets] " << n_sets_ << std::endl;
+    std::cout << "[Number of threads] " << n_threads_ << std::endl;
+    if (use_sprt_)
+    {
+        std::cout << "[SPRT] elo0 " << sprt_elo0_ << " elo1 " << sprt_elo1_ << " alpha " << sprt_alpha_ << " beta " << sprt_beta_ << ", stops after " << n_sets_ << " games at most" << std::endl;
+    }
+    else
+    {
+        std::cout << "[SPRT] off" << std::endl;
+    }
+    std::cout << "[Openings] " << openings_path_ << std::endl;
+    std::cout << "[Evaluation cache entries] " << cache_entries_ << std::endl;
 
 }
 
@@ -114,6 +196,10 @@ void ConcurrentMatchConsole::edit_settings()
     constexpr int PLAYER_1_SETTINGS = 3;
     constexpr int PLAYER_2_SETTINGS = 4;
     constexpr int SETS_SETTINGS = 5;
+    constexpr int THREADS_SETTINGS = 6;
+    constexpr int SPRT_SETTINGS = 7;
+    constexpr int OPENINGS_SETTINGS = 8;
+    constexpr int CACHE_SETTINGS = 9;
     while (choice != 0)
     {
         std::cout << "What do you want to edit?\n";
@@ -123,6 +209,10 @@ void ConcurrentMatchConsole::edit_settings()
         std::cout << "[" << PLAYER_1_SETTINGS << "] Player 1 settings\n";
         std::cout << "[" << PLAYER_2_SETTINGS << "] Player 2 settings\n";
         std::cout << "[" << SETS_SETTINGS << "] Number of sets\n";
+        std::cout << "[" << THREADS_SETTINGS << "] Number of threads\n";
+        std::cout << "[" << SPRT_SETTINGS << "] SPRT early stopping\n";
+        std::cout << "[" << OPENINGS_SETTINGS << "] Opening suite\n";
+        std::cout << "[" << CACHE_SETTINGS << "] Evaluation cache\n";
 
         std::cin >> choice;
         switch (choice)
@@ -145,6 +235,33 @@ void ConcurrentMatchConsole::edit_settings()
             std::cout << "Number of sets (" << n_sets_ << ") :";
             std::cin >> n_sets_;
             break;
+        case THREADS_SETTINGS:
+            std::cout << "Number of threads (" << n_threads_ << ") :";
+            std::cin >> n_threads_;
+            break;
+        case SPRT_SETTINGS:
+            std::cout << "Use SPRT, 0 or 1 (" << use_sprt_ << ") :";
+            std::cin >> use_sprt_;
+            if (use_sprt_)
+            {
+                std::cout << "elo0 (" << sprt_elo0_ << ") :";
+                std::cin >> sprt_elo0_;
+                std::cout << "elo1 (" << sprt_elo1_ << ") :";
+                std::cin >> sprt_elo1_;
+                std::cout << "alpha (" << sprt_alpha_ << ") :";
+                std::cin >> sprt_alpha_;
+                std::cout << "beta (" << sprt_beta_ << ") :";
+                std::cin >> sprt_beta_;
+            }
+            break;
+        case OPENINGS_SETTINGS:
+            std::cout << "Opening suite file, none for the initial state (" << openings_path_ << ") :";
+            std::cin >> openings_path_;
+            break;
+        case CACHE_SETTINGS:
+            std::cout << "Evaluation cache entries per network, 0 for none (" << cache_entries_ << ") :";
+            std::cin >> cache_entries_;
+            break;
         default:
             break;
         }
@@ -36,6 +36,20 @@ private:
 
     int state_index_{ OTHELLO_GAME };
     int n_sets_{ 32 };
+    int n_threads_{ 1 };
+    // how long a shared evaluator holds a batch open for the other workers
+    static constexpr std::chrono::microseconds BATCH_DELAY{ 2000 };
+    // SPRT mode plays game pairs until the test decides, n_sets_ games at most
+    static constexpr int SPRT_PAIRS_PER_ROUND = 8;
+    bool use_sprt_{ false };
+    double sprt_elo0_{ 0.0 };
+    double sprt_elo1_{ 10.0 };
+    double sprt_alpha_{ 0.05 };
+    double sprt_beta_{ 0.05 };
+    // an opening suite from generate_openings, every opening is played from both sides
+    std::string openings_path_{ "none" };
+    // entries of the evaluation cache each network gets, 0 for none
+    int cache_entries_{ 0 };
     void start_match();
     void print_current_settings();
     void edit_settings();
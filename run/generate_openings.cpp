@@ -0,0 +1,188 @@
+// Builds a suite of balanced openings for ConcurrentMatch, SprtMatch and
+// RoundRobin, so deterministic players stop replaying one game.
+//
+//   generate_openings <game> <output> [count] [min_plies] [max_plies] [threshold] [rollouts] [nnue]
+//
+// An opening is min_plies to max_plies uniformly random moves from the initial
+// state. It is kept when its position is new, by IState::hash(), and when a
+// quick evaluation puts it within threshold of a draw, on the [-1, 1] scale of
+// the game's rewards. The evaluation is the mean of `rollouts` random playouts,
+// the same value a UCT leaf backs up; for migoyugo, an NNUE v2 file as `nnue`
+// replaces them. Defaults: 1000 openings of 4 to 8 plies within 0.2, 64 rollouts.
+//
+// `game` is one of tictactoe, othello, english_draughts, walls, damma,
+// santorini, gobblet, migoyugo, uttt. Torch-free like bench_static_mcts.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <common/opening_suite.hpp>
+#include <common/state.hpp>
+#include <games/damma.hpp>
+#include <games/english_draughts.hpp>
+#include <games/gobblet_goblers.hpp>
+#include <games/migoyugo.hpp>
+#include <games/othello.hpp>
+#include <games/santorini.hpp>
+#include <games/tictactoe.hpp>
+#include <games/ultimate_tictactoe.hpp>
+#include <games/walls.hpp>
+#include <nnue/nnue_layerstacks_eval_v2.hpp>
+#include <players/random_rollout_evaluator.hpp>
+
+using rl::common::IState;
+
+namespace
+{
+
+// positions drawn before giving up on filling the suite, per opening asked for
+constexpr int MAX_TRIES_PER_OPENING = 100;
+
+std::mt19937_64 rng(0x0be41175ULL);
+
+std::unique_ptr<IState> make_game(const std::string& name)
+{
+    if (name == "tictactoe") return rl::games::TicTacToeState::initialize();
+    if (name == "othello") return rl::games::OthelloState::initialize();
+    if (name == "english_draughts") return rl::games::EnglishDraughtState::initialize();
+    if (name == "walls") return rl::games::WallsState::initialize();
+    if (name == "damma") return rl::games::DammaState::initialize();
+    if (name == "santorini") return rl::games::SantoriniState::initialize();
+    if (name == "gobblet") return rl::games::GobbletGoblersState::initialize();
+    if (name == "migoyugo") return rl::games::MigoyugoState::initialize();
+    if (name == "uttt") return rl::games::UltimateTicTacToeState::initialize();
+    return nullptr;
+}
+
+// random plies from the initial state into actions, nullptr when the game ended on the way
+std::unique_ptr<IState> random_opening(const IState& initial, int n_plies, std::vector<int>& actions)
+{
+    std::unique_ptr<IState> state_ptr = initial.clone();
+    std::vector<int> legal{};
+    actions.clear();
+    for (int ply = 0; ply < n_plies && !state_ptr->is_terminal(); ply++)
+    {
+        state_ptr->legal_actions(legal);
+        int action = legal.at(rng() % legal.size());
+        state_ptr->apply(action);
+        actions.push_back(action);
+    }
+    if (state_ptr->is_terminal())
+    {
+        return nullptr;
+    }
+    return state_ptr;
+}
+
+// the side to move's expected reward, in [-1, 1]
+float rollout_value(rl::players::RandomRolloutEvaluator& evaluator, const IState* state_ptr, int n_rollouts)
+{
+    float total = 0.0f;
+    for (int i = 0; i < n_rollouts; i++)
+    {
+        total += std::get<1>(evaluator.evaluate(state_ptr)).at(0);
+    }
+    return total / static_cast<float>(n_rollouts);
+}
+
+float nnue_value(const NNUELayerStacksModelV2& model, const IState* state_ptr)
+{
+    const auto board = rl::nnue::mgbb::MigoyugoBB::from_short(state_ptr->to_short());
+    alignas(64) int16_t perspective[2][256];
+    rl::nnue::build_accumulator(model, board, perspective);
+    return rl::nnue::evaluate_position(model, perspective, board);
+}
+
+int usage()
+{
+    std::fprintf(stderr,
+        "usage: generate_openings <game> <output> [count] [min_plies] [max_plies] [threshold] [rollouts] [nnue]\n"
+        "  game: tictactoe othello english_draughts walls damma santorini gobblet migoyugo uttt\n");
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        return usage();
+    }
+    const std::string game = argv[1];
+    const std::string output = argv[2];
+    const int count = argc > 3 ? std::atoi(argv[3]) : 1000;
+    const int min_plies = argc > 4 ? std::atoi(argv[4]) : 4;
+    const int max_plies = argc > 5 ? std::atoi(argv[5]) : 8;
+    const float threshold = argc > 6 ? static_cast<float>(std::atof(argv[6])) : 0.2f;
+    const int n_rollouts = argc > 7 ? std::atoi(argv[7]) : 64;
+    const std::string nnue_path = argc > 8 ? argv[8] : "";
+
+    std::unique_ptr<IState> initial = make_game(game);
+    if (initial == nullptr || count <= 0 || min_plies < 0 || max_plies < min_plies || n_rollouts <= 0)
+    {
+        return usage();
+    }
+    std::shared_ptr<const NNUELayerStacksModelV2> model{ nullptr };
+    if (!nnue_path.empty())
+    {
+        if (game != "migoyugo")
+        {
+            std::fprintf(stderr, "an nnue evaluation only exists for migoyugo\n");
+            return 1;
+        }
+        model = load_nnue_layerstacks_v2(nnue_path);
+        if (model == nullptr)
+        {
+            return 1;
+        }
+    }
+
+    rl::players::RandomRolloutEvaluator evaluator(initial->get_n_actions());
+    rl::common::OpeningSuite suite(initial->game_name());
+    std::unordered_set<uint64_t> seen{};
+    long long n_tries = 0;
+    long long n_duplicates = 0;
+    long long n_unbalanced = 0;
+    const long long max_tries = static_cast<long long>(count) * MAX_TRIES_PER_OPENING;
+    std::vector<int> actions{};
+    while (static_cast<int>(suite.size()) < count && n_tries < max_tries)
+    {
+        n_tries++;
+        const int n_plies = min_plies + static_cast<int>(rng() % (max_plies - min_plies + 1));
+        std::unique_ptr<IState> state_ptr = random_opening(*initial, n_plies, actions);
+        if (state_ptr == nullptr)
+        {
+            continue;
+        }
+        if (!seen.insert(state_ptr->hash()).second)
+        {
+            n_duplicates++;
+            continue;
+        }
+        const float value = model != nullptr ? nnue_value(*model, state_ptr.get()) : rollout_value(evaluator, state_ptr.get(), n_rollouts);
+        if (std::fabs(value) > threshold)
+        {
+            n_unbalanced++;
+            continue;
+        }
+        suite.add(actions);
+    }
+
+    suite.save(output);
+    std::printf("%s: %zu openings to %s, %lld positions drawn, %lld duplicates, %lld unbalanced\n",
+        game.c_str(), suite.size(), output.c_str(), n_tries, n_duplicates, n_unbalanced);
+    if (static_cast<int>(suite.size()) < count)
+    {
+        std::fprintf(stderr, "stopped short of %d openings, try more plies or a larger threshold\n", count);
+        return 1;
+    }
+    return 0;
+}
@@ -32,7 +32,8 @@ MctsNNUEDataGeneratorV2::MctsNNUEDataGeneratorV2(
         dirichlet_epsilon,
         dirichlet_alpha,
         default_visits,
-        default_wins);
+        default_wins,
+        true); // select on half the games while the other half is on the network
 }
 
 MctsNNUEDataGeneratorV2::~MctsNNUEDataGeneratorV2() = default;
@@ -188,33 +188,48 @@ void PerformanceTest::print_current_settings()
 void PerformanceTest::start()
 {
     auto state_ptr = get_state_ptr();
-    int n_game_actions = state_ptr->get_n_actions();
     if (state_ptr->is_terminal())
     {
         rl::common::SteppingTerminalStateException("Evaluator trying to step a terminal state");
     }
 
+    // random rollouts from the initial state, first advancing one state in place
+    // then allocating a new state every ply, as the rollout players did before
+    int duration_s = 30;
+    auto [apply_rollouts, apply_steps] = run_rollouts(true, duration_s);
+    auto [step_rollouts, step_steps] = run_rollouts(false, duration_s);
+
+    std::cout << "[Test Ended] apply: " << apply_rollouts / duration_s << " rollouts/second, " << apply_steps / duration_s << " steps/second\n";
+    std::cout << "[Test Ended] step : " << step_rollouts / duration_s << " rollouts/second, " << step_steps / duration_s << " steps/second" << std::endl;
+}
+
+std::pair<long long, long long> PerformanceTest::run_rollouts(bool in_place, int duration_s)
+{
+    auto initial_state_ptr = get_state_ptr();
+    long long rollouts = 0;
     long long steps = 0;
-    int starting_player = state_ptr->player_turn();
-    std::vector<bool> masks = state_ptr->actions_mask();
-    int duration_s = 60;
     auto min_duration = std::chrono::milliseconds(duration_s * 1000);
     auto t_start = std::chrono::high_resolution_clock::now();
     auto t_end = t_start + min_duration;
     while (std::chrono::high_resolution_clock::now() < t_end)
     {
-        masks = state_ptr->actions_mask();
-        int action = choose_action(masks);
-        state_ptr = state_ptr->step(action);
-        steps++;
-        if (state_ptr->is_terminal()) {
-            state_ptr = get_state_ptr();
+        auto state_ptr = initial_state_ptr->clone();
+        while (!state_ptr->is_terminal())
+        {
+            int action = choose_action(state_ptr->actions_mask());
+            if (in_place)
+            {
+                state_ptr->apply(action);
+            }
+            else
+            {
+                state_ptr = state_ptr->step(action);
+            }
+            steps++;
         }
+        rollouts++;
     }
-
-    long long steps_per_second = steps / duration_s;
-    std::cout << "[Test Ended] Environment stepped " << steps_per_second << " steps/second" << std::endl;
-
+    return std::make_pair(rollouts, steps);
 }
 
 int PerformanceTest::choose_action(const std::vector<bool>& masks) const
@@ -4,6 +4,7 @@
 #include <chrono>
 #include <memory>
 #include <iostream>
+#include <utility>
 #include <vector>
 #include <common/state.hpp>
 #include "console.hpp"
@@ -30,6 +31,9 @@ private:
     int state_index_{ OTHELLO_GAME };
     IStatePtr get_state_ptr();
     int choose_action(const std::vector<bool>& masks) const;
+    /// @brief plays random games from the initial state for duration_s seconds
+    /// @return the number of finished rollouts and of steps taken
+    std::pair<long long, long long> run_rollouts(bool in_place, int duration_s);
     
     void edit_game_settings();
     void print_current_settings();
@@ -31,6 +31,11 @@ ABSL_FLAG(int, n_train_subtree_async_steps, AZ_N_TRAINING_SUBTREE_ASYNC_STEPS, "
 ABSL_FLAG(float, complete_to_end_ratio, AZ_COMPLETE_TO_END_RATIO, "");
 ABSL_FLAG(float, no_resign_threshold, AZ_NO_RESIGN_THRESHOLD, "");
 ABSL_FLAG(int, no_resign_steps, AZ_NO_RESIGN_STEPS, "");
+ABSL_FLAG(int, n_collection_threads, AZ_N_COLLECTION_THREADS, "");
+ABSL_FLAG(int, replay_capacity, AZ_REPLAY_CAPACITY, "");
+ABSL_FLAG(int, replay_window_iterations, AZ_REPLAY_WINDOW_ITERATIONS, "");
+ABSL_FLAG(bool, replay_half_observations, AZ_REPLAY_HALF_OBSERVATIONS, "");
+ABSL_FLAG(int, gating_interval, AZ_GATING_INTERVAL, "");
 int main(int argc, char** argv)
 {
     absl::lts_20240722::ParseCommandLine(argc, argv);
@@ -57,6 +62,11 @@ int main(int argc, char** argv)
     config.complete_to_end_ratio = absl::GetFlag(FLAGS_complete_to_end_ratio);
     config.no_resign_threshold = absl::GetFlag(FLAGS_no_resign_threshold);
     config.no_resign_steps = absl::GetFlag(FLAGS_no_resign_steps);
+    config.n_collection_threads = absl::GetFlag(FLAGS_n_collection_threads);
+    config.replay_capacity = absl::GetFlag(FLAGS_replay_capacity);
+    config.replay_window_iterations = absl::GetFlag(FLAGS_replay_window_iterations);
+    config.replay_half_observations = absl::GetFlag(FLAGS_replay_half_observations);
+    config.gating_interval = absl::GetFlag(FLAGS_gating_interval);
 
     train_alphazero(config);
 
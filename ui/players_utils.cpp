@@ -2,6 +2,7 @@
 #include <deeplearning/alphazero/networks/shared_res_nn.hpp>
 #include <deeplearning/alphazero/networks/tinynn.hpp>
 #include <deeplearning/network_evaluator.hpp>
+#include <cmath>
 #include <filesystem>
 #include <players/random_rollout_evaluator.hpp>
 #include <nnue/nnue_player.hpp>
@@ -26,6 +27,17 @@ std::unique_ptr<PlayerInfoFull> get_default_g_player(rl::common::IState* state_p
     return std::make_unique<PlayerInfoFull>(std::move(std::make_unique<rl::players::GPlayer>(n_sims, minimum_duration, 15, 0.04f)), "G_player");
 }
 
+std::unique_ptr<PlayerInfoFull> get_uct_player(rl::common::IState* state_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration)
+{
+    auto make_player = [n_sims, minimum_duration]() -> std::unique_ptr<rl::common::IPlayer>
+        {
+            return std::make_unique<rl::players::UctPlayer>(n_sims, minimum_duration, 1.0f, std::sqrt(2.0f));
+        };
+    auto info_ptr = std::make_unique<PlayerInfoFull>(make_player(), "UCT");
+    info_ptr->factory_ = make_player;
+    return info_ptr;
+}
+
 std::unique_ptr<PlayerInfoFull> get_random_rollout_player_ptr(rl::common::IState* state_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration)
 {
     auto ev_ptr = std::make_unique<rl::players::RandomRolloutEvaluator>(state_ptr->get_n_actions());
@@ -70,7 +82,14 @@ std::unique_ptr<PlayerInfoFull> get_network_amcts2_player(rl::common::IState* st
     auto player_ptr = std::make_unique<rl::players::Amcts2Player>(state_ptr->get_n_actions(), std::move(ev_ptr), n_sims, minimum_duration, 0.5f, 1.25f, 8, 0.0f, -1.0f);
     ss << "AMCTS2 NN " << load_name;
     std::cout << "Loading " << load_name << std::endl;
-    return std::make_unique<PlayerInfoFull>(std::move(player_ptr), ss.str());
+    auto info_ptr = std::make_unique<PlayerInfoFull>(std::move(player_ptr), ss.str());
+    // every copy loads its own network, the evaluators are not shared between threads
+    std::shared_ptr<rl::common::IState> factory_state_ptr = state_ptr->clone();
+    info_ptr->factory_ = [factory_state_ptr, n_sims, minimum_duration, load_name]()
+        {
+            return std::move(get_network_amcts2_player(factory_state_ptr.get(), n_sims, minimum_duration, load_name)->player_ptr_);
+        };
+    return info_ptr;
 }
 
 std::unique_ptr<PlayerInfoFull> get_long_network_amcts2_player(rl::common::IState* state_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration, std::string load_name)
@@ -199,8 +218,14 @@ std::unique_ptr<PlayerInfoFull> get_nnue_player(rl::common::IState* state_ptr, s
         std::cerr << "Could not open model file at " << nnue_path
             << ". The player will evaluate garbage." << std::endl;
     }
-    auto player_ptr = std::make_unique<rl::players::NNUEPlayer>(nnue_model, minimum_duration);
-    return std::make_unique<PlayerInfoFull>(std::move(player_ptr), "NNUE");
+    auto shared_model = std::make_shared<const NNUEModel>(nnue_model);
+    auto make_player = [shared_model, minimum_duration]() -> std::unique_ptr<rl::common::IPlayer>
+        {
+            return std::make_unique<rl::players::NNUEPlayer>(*shared_model, minimum_duration);
+        };
+    auto info_ptr = std::make_unique<PlayerInfoFull>(make_player(), "NNUE");
+    info_ptr->factory_ = make_player;
+    return info_ptr;
 
 }
 
@@ -255,8 +280,14 @@ std::unique_ptr<PlayerInfoFull> get_nnue_layerstacks_player(rl::common::IState*
         std::cerr << "Could not open model file at " << nnue_path
             << ". The player will evaluate garbage." << std::endl;
     }
-    auto player_ptr = std::make_unique<rl::players::NNUELayerStacksPlayer>(nnue_model, minimum_duration);
-    return std::make_unique<PlayerInfoFull>(std::move(player_ptr), "NNUE-LayerStacks");
+    auto shared_model = std::make_shared<const NNUELayerStacksModel>(nnue_model);
+    auto make_player = [shared_model, minimum_duration]() -> std::unique_ptr<rl::common::IPlayer>
+        {
+            return std::make_unique<rl::players::NNUELayerStacksPlayer>(*shared_model, minimum_duration);
+        };
+    auto info_ptr = std::make_unique<PlayerInfoFull>(make_player(), "NNUE-LayerStacks");
+    info_ptr->factory_ = make_player;
+    return info_ptr;
 
 }
 std::unique_ptr<PlayerInfoFull> get_nnue_layerstacks_v2_player(rl::common::IState* state_ptr, std::chrono::duration<int, std::milli> minimum_duration, std::string load_name) {
@@ -275,8 +306,15 @@ std::unique_ptr<PlayerInfoFull> get_nnue_layerstacks_v2_player(rl::common::IStat
         model = std::make_shared<NNUELayerStacksModelV2>();
     }
 
-    auto player_ptr = std::make_unique<rl::players::NNUELayerStacksPlayerV2>(model, minimum_duration);
-    return std::make_unique<PlayerInfoFull>(std::move(player_ptr), "NNUE-LayerStacks-v2");
+    // the model is read only during a search, the copies share it
+    std::shared_ptr<const NNUELayerStacksModelV2> shared_model = model;
+    auto make_player = [shared_model, minimum_duration]() -> std::unique_ptr<rl::common::IPlayer>
+        {
+            return std::make_unique<rl::players::NNUELayerStacksPlayerV2>(shared_model, minimum_duration);
+        };
+    auto info_ptr = std::make_unique<PlayerInfoFull>(make_player(), "NNUE-LayerStacks-v2");
+    info_ptr->factory_ = make_player;
+    return info_ptr;
 
 }
 
@@ -296,21 +334,25 @@ std::unique_ptr<PlayerInfoFull> get_migoyugo_grave_player(rl::common::IState* st
             std::cerr << "GRAVE: continuing with the even-game heuristic instead." << std::endl;
     }
 
-    auto player_ptr = std::make_unique<rl::players::MigoyugoGravePlayer>(
-        minimum_duration, 2, model);
-
     // The two network heuristics are independent. The action-value priors are
     // the paper-faithful one but cost an evaluation per legal move per node
     // expansion; the leaf blend costs one per simulation. Start with the cheap
     // one - see run/bench_migoyugo_grave.cpp `match` for the numbers.
+    auto make_player = [model, minimum_duration]() -> std::unique_ptr<rl::common::IPlayer>
+        {
+            auto player_ptr = std::make_unique<rl::players::MigoyugoGravePlayer>(
+                minimum_duration, 2, model);
+            if (model)
+                player_ptr->set_leaf_value_weight(0.5f);
+            return player_ptr;
+        };
     std::string name = "GRAVE-BB";
     if (model)
-    {
-        player_ptr->set_leaf_value_weight(0.5f);
         name += " (nnue leaf 0.5)";
-    }
 
-    return std::make_unique<PlayerInfoFull>(std::move(player_ptr), name);
+    auto info_ptr = std::make_unique<PlayerInfoFull>(make_player(), name);
+    info_ptr->factory_ = make_player;
+    return info_ptr;
 }
 
 } // namespace rl::ui::players_utils
@@ -1,6 +1,7 @@
 #ifndef RL_UI_PLAYERS_UTILS_HPP_
 #define RL_UI_PLAYERS_UTILS_HPP_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <players/players.hpp>
@@ -15,9 +16,13 @@ public:
     ~PlayerInfoFull();
     std::unique_ptr<rl::common::IPlayer> player_ptr_;
     std::string name_;
+    // builds another player like player_ptr_ for a tournament worker thread,
+    // empty for the players that cannot be copied
+    std::function<std::unique_ptr<rl::common::IPlayer>()> factory_{};
 };
 
 std::unique_ptr<PlayerInfoFull> get_default_g_player(rl::common::IState* state_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration);
+std::unique_ptr<PlayerInfoFull> get_uct_player(rl::common::IState* state_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration);
 std::unique_ptr<PlayerInfoFull> get_random_rollout_player_ptr(rl::common::IState* state_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration);
 std::unique_ptr<PlayerInfoFull> get_network_amcts_player(rl::common::IState* state_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration, std::string load_name);
 std::unique_ptr<PlayerInfoFull> get_network_amcts2_player(rl::common::IState* state_ptr, int n_sims, std::chrono::duration<int, std::milli> minimum_duration, std::string load_name);
@@ -7,10 +7,11 @@
 #include <cstring>
 namespace rl::ui
 {
-SantoriniTournamentUI::SantoriniTournamentUI(int width, int height)
+SantoriniTournamentUI::SantoriniTournamentUI(int width, int height, int n_threads)
 	: board_width_{ width * 4 / 5 }, board_height_{ height * 4 / 5 }, padding_{ 2 },
 	secondary_tap_width_{ width * 1 / 5 }, secondary_tap_height_{ height },
 	footing_width_{ width * 4 / 5 }, footing_height_{ height * 1 / 5 },
+	n_threads_{ n_threads },
 	round_robin_ptr_(nullptr),
 	state_ptr_(rl::games::SantoriniState::initialize_state()),
 	players_{},
@@ -80,9 +81,9 @@ std::unique_ptr<rl::common::RoundRobin> SantoriniTournamentUI::get_new_round_rob
 	std::vector<rl::common::PlayerInfo> players_info{};
 	for (auto& pi : players_)
 	{
-		players_info.push_back({ pi->player_ptr_.get(), pi->name_ });
+		players_info.push_back({ pi->player_ptr_.get(), pi->name_, pi->factory_ });
 	}
-	auto round_robin = std::make_unique<rl::common::RoundRobin>(state_ptr_->clone(), players_info, n_games_per_opponent, false);
+	auto round_robin = std::make_unique<rl::common::RoundRobin>(state_ptr_->clone(), players_info, n_games_per_opponent, false, n_threads_);
 	return round_robin;
 }
 
@@ -22,7 +22,8 @@ class SantoriniTournamentUI : public IGameui
     using StateObserver = rl::common::Observer<rl::common::MatchInfo>;
 
 public:
-    SantoriniTournamentUI(int width, int height);
+    /// @param n_threads games played at once, every player gets a copy per thread
+    SantoriniTournamentUI(int width, int height, int n_threads = 1);
     ~SantoriniTournamentUI();
     void draw_game() override;
     void handle_events() override;
@@ -35,6 +36,7 @@ private:
     int footing_width_, footing_height_;
     int player1_ = -1;
     int player2_ = -1;
+    int n_threads_;
     std::unique_ptr<std::thread> t_ptr_{ nullptr };
     bool paused_{ false };
     double pause_until_{};